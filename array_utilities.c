@@ -13,6 +13,19 @@
 
 #define RAND_NUM_SEED 32899
 
+void* alloc_aligned_array(const size_t num_bytes) {
+  void* aligned_array = NULL;
+  // Round up to whole multiples of the alignment, and allocate at least once
+  const size_t aligned_num_bytes =
+      ((num_bytes + ZERO_COPY_ALIGNMENT - 1) / ZERO_COPY_ALIGNMENT) *
+      ZERO_COPY_ALIGNMENT;
+  const int alloc_result = posix_memalign(
+      &aligned_array, ZERO_COPY_ALIGNMENT,
+      (aligned_num_bytes > 0) ? aligned_num_bytes : ZERO_COPY_ALIGNMENT);
+  assert(alloc_result == 0);
+  return aligned_array;
+}
+
 struct Array_With_Length_Padded* get_rand_padded_array(
     const unsigned int array_len) {
   // Array length has to be greater than zero
@@ -20,11 +33,11 @@ struct Array_With_Length_Padded* get_rand_padded_array(
   // Variable declarations
   struct Array_With_Length_Padded* array_w_len_padded =
       malloc(sizeof(*array_w_len_padded));
-  unsigned int padded_2n_length = (unsigned int)exp2(ceil(log2(array_len)));
-  // Edge case handling where array_len = 1
-  if (array_len == 1) {
-    ++padded_2n_length;
-  }
+  /*
+   * The sorting engines handle arrays of any length, so the array is
+   * allocated with exactly as many elements as requested.
+   */
+  const unsigned int padded_2n_length = array_len;
   const float range_min_val = -1.0f;
   const float range_interval = 2.0f;
   const int even_test_num = 2;
@@ -37,26 +50,24 @@ struct Array_With_Length_Padded* get_rand_padded_array(
   srand(RAND_NUM_SEED);
 
   /*
-   * Generate the appropriate random array of characters/numbers and then
-   * pad the array with extra depending on the ARRAY_TYPE
+   * Generate the appropriate random array of characters/numbers depending
+   * on the ARRAY_TYPE
    */
 #if (ARRAY_TYPE == CHAR)
 
-  char* rand_char_array = malloc(padded_2n_length * sizeof(*rand_char_array));
+  char* rand_char_array =
+      alloc_aligned_array(padded_2n_length * sizeof(*rand_char_array));
 
   for (unsigned int curr_entry = 0; curr_entry < array_len; ++curr_entry) {
     rand_char_array[curr_entry] = (char)(rand() % UCHAR_MAX);
   }
-  for (unsigned int curr_entry = array_len; curr_entry < padded_2n_length;
-       ++curr_entry) {
-    rand_char_array[curr_entry] = CHAR_MAX;
-  }
 
   array_w_len_padded->contents = rand_char_array;
 
 #elif (ARRAY_TYPE == INT)
 
-  int* rand_int_array = malloc(padded_2n_length * sizeof(*rand_int_array));
+  int* rand_int_array =
+      alloc_aligned_array(padded_2n_length * sizeof(*rand_int_array));
 
   for (unsigned int curr_entry = 0; curr_entry < array_len; ++curr_entry) {
     rand_int_array[curr_entry] =
@@ -68,16 +79,13 @@ struct Array_With_Length_Padded* get_rand_padded_array(
       ++rand_int_array[curr_entry];
     }
   }
-  for (unsigned int curr_entry = array_len; curr_entry < padded_2n_length;
-       ++curr_entry) {
-    rand_int_array[curr_entry] = INT_MAX;
-  }
 
   array_w_len_padded->contents = rand_int_array;
 
 #elif (ARRAY_TYPE == LONG)
 
-  long* rand_long_array = malloc(padded_2n_length * sizeof(*rand_long_array));
+  long* rand_long_array =
+      alloc_aligned_array(padded_2n_length * sizeof(*rand_long_array));
 
   for (unsigned int curr_entry = 0; curr_entry < array_len; ++curr_entry) {
     rand_long_array[curr_entry] =
@@ -89,42 +97,30 @@ struct Array_With_Length_Padded* get_rand_padded_array(
       ++rand_long_array[curr_entry];
     }
   }
-  for (unsigned int curr_entry = array_len; curr_entry < padded_2n_length;
-       ++curr_entry) {
-    rand_long_array[curr_entry] = LONG_MAX;
-  }
 
   array_w_len_padded->contents = rand_long_array;
 
 #elif (ARRAY_TYPE == FLOAT)
 
   float* rand_float_array =
-      malloc(padded_2n_length * sizeof(*rand_float_array));
+      alloc_aligned_array(padded_2n_length * sizeof(*rand_float_array));
 
   for (unsigned int curr_entry = 0; curr_entry < array_len; ++curr_entry) {
     rand_float_array[curr_entry] =
         range_min_val + ((float)rand() * range_interval / (float)RAND_MAX);
   }
-  for (unsigned int curr_entry = array_len; curr_entry < padded_2n_length;
-       ++curr_entry) {
-    rand_float_array[curr_entry] = FLT_MAX;
-  }
 
   array_w_len_padded->contents = rand_float_array;
 
 #elif (ARRAY_TYPE == DOUBLE)
 
   double* rand_double_array =
-      malloc(padded_2n_length * sizeof(*rand_double_array));
+      alloc_aligned_array(padded_2n_length * sizeof(*rand_double_array));
 
   for (unsigned int curr_entry = 0; curr_entry < array_len; ++curr_entry) {
     rand_double_array[curr_entry] =
         range_min_val + ((double)rand() * range_interval / (double)RAND_MAX);
   }
-  for (unsigned int curr_entry = array_len; curr_entry < padded_2n_length;
-       ++curr_entry) {
-    rand_double_array[curr_entry] = DBL_MAX;
-  }
 
   array_w_len_padded->contents = rand_double_array;
 
@@ -142,7 +138,7 @@ struct Array_With_Length_Padded* deep_cp_padded_array(
   const unsigned int array_with_padding_len = padded_array->padded_2n_length;
   struct Array_With_Length_Padded* padded_array_deep_cp =
       malloc(sizeof(*padded_array_deep_cp));
-  padded_array_deep_cp->contents = malloc(
+  padded_array_deep_cp->contents = alloc_aligned_array(
       array_with_padding_len * sizeof(*(padded_array_deep_cp->contents)));
 
   // Copy over non-pointer fields' values
@@ -190,11 +186,51 @@ void assert_padded_arrays_equality(
   assert(first_padded_array->padding_location_indicator ==
          second_padded_array->padding_location_indicator);
 
-  for (unsigned int curr_index = 0;
-       curr_index < first_padded_array->padded_2n_length; ++curr_index) {
-    assert(first_padded_array->contents[curr_index] ==
-           second_padded_array->contents[curr_index]);
+  // Only the actual elements of the arrays are compared, never any padding
+  const unsigned int index_begin =
+      first_padded_array->padding_location_indicator
+          ? first_padded_array->padded_2n_length -
+                first_padded_array->array_len_actual
+          : 0;
+  for (unsigned int curr_index = index_begin;
+       curr_index < index_begin + first_padded_array->array_len_actual;
+       ++curr_index) {
+    // NaNs never compare equal, even to themselves, so any two NaNs match
+    assert((first_padded_array->contents[curr_index] ==
+            second_padded_array->contents[curr_index]) ||
+           ((first_padded_array->contents[curr_index] !=
+             first_padded_array->contents[curr_index]) &&
+            (second_padded_array->contents[curr_index] !=
+             second_padded_array->contents[curr_index])));
   }
 
   printf(ASSERTION_PASSED_INFORM_USER);
 }
+
+void assert_padded_array_permutation(
+    struct Array_With_Length_Padded* sorted_array,
+    struct Array_With_Length_Padded* unsorted_array,
+    const unsigned int* permutation) {
+  assert(sorted_array != NULL);
+  assert(unsorted_array != NULL);
+  assert(permutation != NULL);
+  assert(sorted_array->array_len_actual == unsorted_array->array_len_actual);
+  assert(sorted_array->padding_location_indicator == PAD_ARRAY_AT_END);
+  assert(unsorted_array->padding_location_indicator == PAD_ARRAY_AT_END);
+
+  // Keeps track of which indices have been seen in the permutation so far
+  char* index_seen = calloc(unsorted_array->array_len_actual, sizeof(char));
+
+  for (unsigned int curr_index = 0;
+       curr_index < sorted_array->array_len_actual; ++curr_index) {
+    const unsigned int gathered_index = permutation[curr_index];
+    assert(gathered_index < unsorted_array->array_len_actual);
+    assert(!index_seen[gathered_index]);
+    index_seen[gathered_index] = 1;
+    assert(unsorted_array->contents[gathered_index] ==
+           sorted_array->contents[curr_index]);
+  }
+
+  free(index_seen);
+  printf(PERMUTATION_ASSERTION_PASSED_INFORM_USER);
+}
@@ -26,38 +26,48 @@
     #define DISPLAY_FORMAT_STR "%.12lf "
 #endif
 
+/*
+ * Alignment in bytes (i.e. a page) of the contents of every array allocated by
+ *   "alloc_aligned_array"; OpenCL implementations may only wrap host memory with
+ *   CL_MEM_USE_HOST_PTR without copying it if it's aligned this way (refer to
+ *   "load_array_bitonic_sort" within "naive_bitonic_sort_opencl.h").
+ */
+#define ZERO_COPY_ALIGNMENT 4096
+
+/*
+ * Returns a pointer to at least "num_bytes" bytes of uninitialized memory aligned to
+ *   ZERO_COPY_ALIGNMENT bytes, whose size is rounded up to a multiple of ZERO_COPY_ALIGNMENT
+ *   bytes as well; the memory is released with "free" like any other allocation.
+ */
+void* alloc_aligned_array(const size_t num_bytes);
+
 /* 
  * The pointer returned by this function points
  *   to an "Array_With_Length_Padded" struct
  *   where the "contents" field points to an
  *   array of numbers/characters (each element
  *   type is determined by the "ARRAY_TYPE" macro);
- *   The array is of length 2^ceil(log2(array_len)),
- *   and that length is stored in the "padded_2n_length"
- *   field in the struct. The value of this function's
- *   parameter is stored within "array_len_actual"
- *   in the struct. And for the first "array_len_actual"
- *   elements in the array, for integer types
- *   (e.g. int, long char) each value in the
- *   array is randomly generated and may range
+ *   The array is of length "array_len" (i.e. the
+ *   array is NOT padded, as the sorting engines
+ *   handle arrays of any length), and that length
+ *   is stored in both the "array_len_actual" and
+ *   "padded_2n_length" fields in the struct. For
+ *   integer types (e.g. int, long char) each value
+ *   in the array is randomly generated and may range
  *   from the minimum permitted to the maximum
  *   permitted value (e.g. INT_MIN to INT_MAX)
  *   of each type. As for floating point types
  *   (e.g. float, double), each value ranges
- *   from -1.0 to 1.0. For any additional elements
- *   up to the "padded_2n_length"-th element, each
- *   element is of the element's maximum value
- *   type (e.g. INT_MAX, DBL_MAX). Finally, 
- *   as this function always adds the additional
- *   elements at the end of the aforementioned array,
- *   "padding_location_indicator" will be set to the
- *   value of the macro "PAD_ARRAY_AT_END".
+ *   from -1.0 to 1.0. Finally, "padding_location_indicator"
+ *   will be set to the value of the macro "PAD_ARRAY_AT_END".
+ *   The array is allocated by "alloc_aligned_array".
  */
 struct Array_With_Length_Padded *get_rand_padded_array(const unsigned int array_len);
 
 /* 
  * Returns a pointer to a deep copy of the parameter;
  *   ONLY works with "Array_With_Length_Padded" types.
+ *   The array of the copy is allocated by "alloc_aligned_array".
  */
 struct Array_With_Length_Padded *deep_cp_padded_array(struct Array_With_Length_Padded* padded_array);
 
@@ -72,10 +82,26 @@ void print_array(struct Array_With_Length_Padded* array);
  */
 #define ASSERTION_PASSED_INFORM_USER "Congratulations, both of your padded arrays are identical in content!\n"
 /*
- * Asserts that two different instances of "Array_With_Length_Padded" are equal.
+ * Asserts that two different instances of "Array_With_Length_Padded" are equal;
+ *   only the actual elements of the arrays (i.e. not the padding) are compared.
  */
 void assert_padded_arrays_equality(struct Array_With_Length_Padded* first_padded_array,
                                     struct Array_With_Length_Padded* second_padded_array);
 
+/*
+ * Message informing user that a permutation reorders an "Array_With_Length_Padded" correctly
+ */
+#define PERMUTATION_ASSERTION_PASSED_INFORM_USER "Congratulations, your permutation reorders the"\
+                                                 " array into the sorted array!\n"
+/*
+ * Asserts that "permutation" (e.g. produced by sorting by key with indices as payloads) holds
+ *   every index of the actual elements of "unsorted_array" exactly once, and that gathering
+ *   the actual elements of "unsorted_array" in the order of "permutation" results in the actual
+ *   elements of "sorted_array"; both arrays MUST NOT be padded at the beginning.
+ */
+void assert_padded_array_permutation(struct Array_With_Length_Padded* sorted_array,
+                                       struct Array_With_Length_Padded* unsorted_array,
+                                                           const unsigned int* permutation);
+
 #endif // ARRAY_UTILITIES_H
 
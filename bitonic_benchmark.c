@@ -0,0 +1,773 @@
+// =================================================================================================
+// File Description:
+// Benchmark sweep executable (built by "make benchmark"), timing every sorting engine on
+// every combination of array length, data type, distribution of input data and workgroup
+// size given on the command line; each combination is run a number of untimed times
+// first, then timed over a number of repetitions, and the median, minimum and
+// BENCHMARK_PERCENTILE-th percentile of the times get written as CSV or JSON.
+//
+// =================================================================================================
+
+#include "bitonic_benchmark.h"
+#include <assert.h>
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "array_utilities.h"
+#include "bitonic_profile.h"
+#include "bitonic_sort_session.h"
+#include "hybrid_sort_cpu.h"
+#include "naive_bitonic_sort_serial.h"
+#include "opencl_devices.h"
+#include "parallel_bitonic_sort_cpu.h"
+#include "program_binary_cache.h"
+#include "radix_sort_opencl.h"
+#include "reference_sorts_cpu.h"
+#include "simd_bitonic_sort_cpu.h"
+#include "work_stealing_pool.h"
+
+// =================================================================================================
+
+// Names of the engines, distributions, directions of sort and output formats,
+// indexed by the value of each flag variable literal
+static const char* const engine_names[NUM_BENCHMARK_ENGINES] = {
+    "opencl_bitonic", "opencl_radix", "serial_bitonic", "parallel_bitonic_cpu",
+    "simd_bitonic",   "hybrid",       "introsort",      "radix_cpu"};
+static const char* const distribution_names[NUM_BENCHMARK_DISTRIBUTIONS] = {
+    "uniform", "sorted",     "reverse_sorted", "few_unique",
+    "zipf",    "organ_pipe", "all_equal",      "nans"};
+static const char* const sorting_direction_names[NUM_SORTING_DIRECTIONS] = {
+    "ascending", "descending"};
+static const char* const output_format_names[] = {"csv", "json"};
+
+// Long options on the command line, each given as "--option=value"
+enum Benchmark_Option {
+  SIZES_OPTION = 1,
+  TYPES_OPTION,
+  ENGINES_OPTION,
+  DISTRIBUTIONS_OPTION,
+  WORKGROUP_SIZES_OPTION,
+  DIRECTION_OPTION,
+  WARMUP_OPTION,
+  REPETITIONS_OPTION,
+  THREADS_OPTION,
+  PLATFORM_OPTION,
+  DEVICE_OPTION,
+  LIST_DEVICES_OPTION,
+  FORMAT_OPTION,
+  OUTPUT_OPTION,
+  PROFILE_OPTION,
+  AUTOTUNE_OPTION,
+  HELP_OPTION
+};
+static const struct option benchmark_options[] = {
+    {"sizes", required_argument, NULL, SIZES_OPTION},
+    {"types", required_argument, NULL, TYPES_OPTION},
+    {"engines", required_argument, NULL, ENGINES_OPTION},
+    {"distributions", required_argument, NULL, DISTRIBUTIONS_OPTION},
+    {"workgroup-sizes", required_argument, NULL, WORKGROUP_SIZES_OPTION},
+    {"direction", required_argument, NULL, DIRECTION_OPTION},
+    {"warmup", required_argument, NULL, WARMUP_OPTION},
+    {"repetitions", required_argument, NULL, REPETITIONS_OPTION},
+    {"threads", required_argument, NULL, THREADS_OPTION},
+    {"platform", required_argument, NULL, PLATFORM_OPTION},
+    {"device", required_argument, NULL, DEVICE_OPTION},
+    {"list-devices", no_argument, NULL, LIST_DEVICES_OPTION},
+    {"format", required_argument, NULL, FORMAT_OPTION},
+    {"output", required_argument, NULL, OUTPUT_OPTION},
+    {"profile", no_argument, NULL, PROFILE_OPTION},
+    {"autotune", no_argument, NULL, AUTOTUNE_OPTION},
+    {"help", no_argument, NULL, HELP_OPTION},
+    {NULL, 0, NULL, 0}};
+
+// Reports an invalid value of the option "option_name" and exits
+static void exit_invalid_option(const char* option_name, const char* value) {
+  fprintf(stderr, BENCHMARK_INVALID_OPTION_MESSAGE, option_name, value);
+  exit(EXIT_FAILURE);
+}
+
+// Returns the index of "name" within "names" of "num_names" names, exiting if not found
+static unsigned int find_name(const char* option_name, const char* name,
+                              const char* const* names,
+                              const unsigned int num_names) {
+  for (unsigned int name_index = 0; name_index < num_names; ++name_index) {
+    if (strcmp(name, names[name_index]) == 0) {
+      return name_index;
+    }
+  }
+  exit_invalid_option(option_name, name);
+  return num_names;
+}
+
+/*
+ * Marks which of the "num_names" names within "names" appear within the comma
+ * separated "list" by setting the element of the same index within "selected"
+ * to 1 (and all others to 0).
+ */
+static void parse_name_list(const char* option_name, const char* list,
+                            const char* const* names,
+                            const unsigned int num_names,
+                            unsigned char* selected) {
+  char* list_copy = strdup(list);
+  char* save_ptr = NULL;
+
+  memset(selected, 0, num_names);
+  for (char* name = strtok_r(list_copy, ",", &save_ptr); name != NULL;
+       name = strtok_r(NULL, ",", &save_ptr)) {
+    selected[find_name(option_name, name, names, num_names)] = 1;
+  }
+  free(list_copy);
+}
+
+// Returns the non-negative integer "text", exiting if it isn't one
+static unsigned int parse_number(const char* option_name, const char* text) {
+  char* number_end = NULL;
+  errno = 0;
+  const unsigned long number = strtoul(text, &number_end, 10);
+
+  if ((errno != 0) || (number_end == text) || (*number_end != '\0') ||
+      (text[0] == '-') || (number > UINT32_MAX)) {
+    exit_invalid_option(option_name, text);
+  }
+  return (unsigned int)number;
+}
+
+/*
+ * Stores the positive integers within the comma separated "list" into "values"
+ * and returns how many there are (at most MAX_BENCHMARK_LIST_LEN).
+ */
+static unsigned int parse_number_list(const char* option_name, const char* list,
+                                      unsigned int* values) {
+  char* list_copy = strdup(list);
+  char* save_ptr = NULL;
+  unsigned int num_values = 0;
+
+  for (char* text = strtok_r(list_copy, ",", &save_ptr); text != NULL;
+       text = strtok_r(NULL, ",", &save_ptr)) {
+    if (num_values == MAX_BENCHMARK_LIST_LEN) {
+      exit_invalid_option(option_name, list);
+    }
+    values[num_values] = parse_number(option_name, text);
+    if (values[num_values] == 0) {
+      exit_invalid_option(option_name, text);
+    }
+    ++num_values;
+  }
+  free(list_copy);
+  if (num_values == 0) {
+    exit_invalid_option(option_name, list);
+  }
+  return num_values;
+}
+
+// Fills "config" from the command line, starting from the default of every option
+static void parse_benchmark_options(int argc, char* argv[],
+                                    struct Benchmark_Config* config) {
+  const char* array_type_names[NUM_ARRAY_TYPES];
+  for (unsigned int array_type = 0; array_type < NUM_ARRAY_TYPES; ++array_type) {
+    array_type_names[array_type] = get_array_type_name(array_type);
+  }
+
+  config->num_sizes = parse_number_list("sizes", BENCHMARK_DEFAULT_SIZES,
+                                        config->sizes);
+  config->num_workgroup_sizes = parse_number_list(
+      "workgroup-sizes", BENCHMARK_DEFAULT_WORKGROUP_SIZES,
+      config->workgroup_sizes);
+  memset(config->types, 1, NUM_ARRAY_TYPES);
+  memset(config->engines, 1, NUM_BENCHMARK_ENGINES);
+  memset(config->distributions, 1, NUM_BENCHMARK_DISTRIBUTIONS);
+  config->sorting_direction = SORTING_DIRECTION;
+  config->warmup_runs = BENCHMARK_DEFAULT_WARMUP_RUNS;
+  config->repetitions = BENCHMARK_DEFAULT_REPETITIONS;
+  config->num_threads = NUM_POOL_THREADS_AUTO;
+  config->platform_selector = NULL;
+  config->device_selector = NULL;
+  config->output_format = BENCHMARK_CSV_OUTPUT;
+  config->output_path = NULL;
+  config->profile_opencl = 0;
+  config->autotune = 0;
+
+  int option;
+  while ((option = getopt_long(argc, argv, "", benchmark_options, NULL)) != -1) {
+    switch (option) {
+      case SIZES_OPTION:
+        config->num_sizes = parse_number_list("sizes", optarg, config->sizes);
+        break;
+      case TYPES_OPTION:
+        parse_name_list("types", optarg, array_type_names, NUM_ARRAY_TYPES,
+                        config->types);
+        break;
+      case ENGINES_OPTION:
+        parse_name_list("engines", optarg, engine_names, NUM_BENCHMARK_ENGINES,
+                        config->engines);
+        break;
+      case DISTRIBUTIONS_OPTION:
+        parse_name_list("distributions", optarg, distribution_names,
+                        NUM_BENCHMARK_DISTRIBUTIONS, config->distributions);
+        break;
+      case WORKGROUP_SIZES_OPTION:
+        config->num_workgroup_sizes = parse_number_list(
+            "workgroup-sizes", optarg, config->workgroup_sizes);
+        // The bitonic sort kernels need workgroups of powers of 2 work-items
+        for (unsigned int size_index = 0;
+             size_index < config->num_workgroup_sizes; ++size_index) {
+          const unsigned int workgroup_size =
+              config->workgroup_sizes[size_index];
+          if ((workgroup_size & (workgroup_size - 1)) != 0) {
+            exit_invalid_option("workgroup-sizes", optarg);
+          }
+        }
+        break;
+      case DIRECTION_OPTION:
+        config->sorting_direction =
+            find_name("direction", optarg, sorting_direction_names,
+                      NUM_SORTING_DIRECTIONS);
+        break;
+      case WARMUP_OPTION:
+        config->warmup_runs = parse_number("warmup", optarg);
+        break;
+      case REPETITIONS_OPTION:
+        config->repetitions = parse_number("repetitions", optarg);
+        if (config->repetitions == 0) {
+          exit_invalid_option("repetitions", optarg);
+        }
+        break;
+      case THREADS_OPTION:
+        config->num_threads = parse_number("threads", optarg);
+        break;
+      case PLATFORM_OPTION:
+        config->platform_selector = optarg;
+        break;
+      case DEVICE_OPTION:
+        config->device_selector = optarg;
+        break;
+      case LIST_DEVICES_OPTION:
+        list_opencl_devices(stdout);
+        exit(EXIT_SUCCESS);
+      case FORMAT_OPTION:
+        config->output_format = find_name("format", optarg, output_format_names,
+                                          BENCHMARK_JSON_OUTPUT + 1);
+        break;
+      case OUTPUT_OPTION:
+        config->output_path = optarg;
+        break;
+      case PROFILE_OPTION:
+        config->profile_opencl = 1;
+        break;
+      case AUTOTUNE_OPTION:
+        config->autotune = 1;
+        break;
+      case HELP_OPTION:
+        printf(BENCHMARK_USAGE_MESSAGE, argv[0]);
+        exit(EXIT_SUCCESS);
+      default:
+        fprintf(stderr, BENCHMARK_USAGE_MESSAGE, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+  }
+  if (optind < argc) {
+    fprintf(stderr, BENCHMARK_USAGE_MESSAGE, argv[0]);
+    exit(EXIT_FAILURE);
+  }
+}
+
+// Current time in seconds, as measured by the rest of this project
+static double get_current_seconds(void) {
+  struct timespec current_time;
+  timespec_get(&current_time, TIME_UTC);
+  return (double)current_time.tv_sec +
+         ((double)current_time.tv_nsec) / BENCHMARK_NANOSECS_IN_SEC;
+}
+
+// Next pseudorandom number of the sequence at "state" (i.e. SplitMix64)
+static uint64_t next_random(uint64_t* state) {
+  uint64_t random_bits = (*state += 0x9E3779B97F4A7C15ULL);
+  random_bits = (random_bits ^ (random_bits >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  random_bits = (random_bits ^ (random_bits >> 27)) * 0x94D049BB133111EBULL;
+  return random_bits ^ (random_bits >> 31);
+}
+
+// Pseudorandom number uniformly distributed within [0, 1)
+static double next_random_fraction(uint64_t* state) {
+  return (double)(next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ * Fills "zipf_cdf" with the cumulative probabilities of the BENCHMARK_ZIPF_NUM_VALUES
+ * ranks of the Zipf distribution, where the last one is exactly 1.
+ */
+static void init_zipf_cdf(double* zipf_cdf) {
+  double cumulative_weight = 0.0;
+  for (unsigned int rank = 0; rank < BENCHMARK_ZIPF_NUM_VALUES; ++rank) {
+    cumulative_weight += 1.0 / pow((double)(rank + 1), BENCHMARK_ZIPF_EXPONENT);
+    zipf_cdf[rank] = cumulative_weight;
+  }
+  for (unsigned int rank = 0; rank < BENCHMARK_ZIPF_NUM_VALUES; ++rank) {
+    zipf_cdf[rank] /= cumulative_weight;
+  }
+  zipf_cdf[BENCHMARK_ZIPF_NUM_VALUES - 1] = 1.0;
+}
+
+// Samples a rank of the Zipf distribution by searching "zipf_cdf" for a random fraction
+static unsigned int sample_zipf_rank(const double* zipf_cdf, uint64_t* state) {
+  const double fraction = next_random_fraction(state);
+  unsigned int lower = 0;
+  unsigned int upper = BENCHMARK_ZIPF_NUM_VALUES - 1;
+  while (lower < upper) {
+    const unsigned int middle = lower + (upper - lower) / 2;
+    if (zipf_cdf[middle] > fraction) {
+      upper = middle;
+    } else {
+      lower = middle + 1;
+    }
+  }
+  return lower;
+}
+
+/*
+ * Stores the 64-bit unsigned "ordinal" as the element at "element_index" of
+ * "data" of data type "array_type", such that larger ordinals never give smaller
+ * elements; integers keep the most significant bits of the ordinal, and floating
+ * point numbers are spread evenly between -BENCHMARK_FLOAT_RANGE and
+ * BENCHMARK_FLOAT_RANGE.
+ */
+static void store_ordinal(void* data, const size_t element_index,
+                          const uint64_t ordinal, const unsigned int array_type) {
+  const double fraction = (double)(ordinal >> 11) * (1.0 / 9007199254740992.0);
+
+  switch (array_type) {
+    case CHAR:
+      ((cl_char*)data)[element_index] = (cl_char)((int)(ordinal >> 56) - 128);
+      break;
+    case INT:
+      ((cl_int*)data)[element_index] =
+          (cl_int)((int64_t)(ordinal >> 32) - INT64_C(2147483648));
+      break;
+    case LONG:
+      ((cl_long*)data)[element_index] = (cl_long)(ordinal ^ (UINT64_C(1) << 63));
+      break;
+    case FLOAT:
+      ((cl_float*)data)[element_index] =
+          (cl_float)(BENCHMARK_FLOAT_RANGE * (2.0 * fraction - 1.0));
+      break;
+    case DOUBLE:
+      ((cl_double*)data)[element_index] =
+          BENCHMARK_FLOAT_RANGE * (2.0 * fraction - 1.0);
+      break;
+  }
+}
+
+/*
+ * Fills "data" with "array_length" elements of data type "array_type" following
+ * "distribution"; the same arguments always give the same elements.
+ */
+static void generate_distribution(void* data, const size_t array_length,
+                                  const unsigned int array_type,
+                                  const unsigned int distribution,
+                                  const double* zipf_cdf) {
+  uint64_t random_state = BENCHMARK_RANDOM_SEED;
+  // Distance between consecutive ordinals of sorted and organ pipe arrays
+  const uint64_t sorted_step = UINT64_MAX / array_length;
+  const uint64_t organ_pipe_step = UINT64_MAX / ((array_length + 1) / 2);
+
+  for (size_t element_index = 0; element_index < array_length; ++element_index) {
+    uint64_t ordinal = 0;
+    switch (distribution) {
+      case BENCHMARK_UNIFORM:
+        ordinal = next_random(&random_state);
+        break;
+      case BENCHMARK_SORTED:
+        ordinal = element_index * sorted_step;
+        break;
+      case BENCHMARK_REVERSE_SORTED:
+        ordinal = (array_length - 1 - element_index) * sorted_step;
+        break;
+      case BENCHMARK_FEW_UNIQUE:
+        ordinal = (next_random(&random_state) % BENCHMARK_FEW_UNIQUE_VALUES) *
+                  (UINT64_MAX / BENCHMARK_FEW_UNIQUE_VALUES);
+        break;
+      case BENCHMARK_ZIPF:
+        ordinal = sample_zipf_rank(zipf_cdf, &random_state) *
+                  (UINT64_MAX / BENCHMARK_ZIPF_NUM_VALUES);
+        break;
+      case BENCHMARK_ORGAN_PIPE:
+        ordinal = ((element_index < array_length / 2)
+                       ? element_index
+                       : (array_length - 1 - element_index)) *
+                  organ_pipe_step;
+        break;
+      case BENCHMARK_ALL_EQUAL:
+        ordinal = UINT64_C(1) << 63;
+        break;
+      case BENCHMARK_NANS:
+        ordinal = next_random(&random_state);
+        break;
+    }
+    store_ordinal(data, element_index, ordinal, array_type);
+    if ((distribution == BENCHMARK_NANS) &&
+        (next_random_fraction(&random_state) < BENCHMARK_NAN_FRACTION)) {
+      if (array_type == FLOAT) {
+        ((cl_float*)data)[element_index] = NAN;
+      } else if (array_type == DOUBLE) {
+        ((cl_double*)data)[element_index] = NAN;
+      }
+    }
+  }
+}
+
+/*
+ * Whether "engine" can sort arrays of data type "array_type"; engines sorting
+ * on the CPU other than introsort and LSD radix sort only sort ARRAY_TYPE.
+ */
+static int engine_sorts_type(const unsigned int engine,
+                             const unsigned int array_type) {
+  switch (engine) {
+    case BENCHMARK_SERIAL_BITONIC:
+    case BENCHMARK_PARALLEL_BITONIC_CPU:
+    case BENCHMARK_SIMD_BITONIC:
+    case BENCHMARK_HYBRID:
+      return array_type == ARRAY_TYPE;
+    default:
+      return 1;
+  }
+}
+
+/*
+ * Whether "engine" is benchmarked on arrays of data type "array_type" following
+ * "distribution"; arrays with NaNs are only floating point numbers, sorted by the
+ * engines putting NaNs last (the others give no order to NaNs at all).
+ */
+static int engine_sorts_distribution(const unsigned int engine,
+                                     const unsigned int array_type,
+                                     const unsigned int distribution) {
+  if (distribution != BENCHMARK_NANS) {
+    return 1;
+  }
+  return ((array_type == FLOAT) || (array_type == DOUBLE)) &&
+         ((engine == BENCHMARK_OPENCL_BITONIC) ||
+          (engine == BENCHMARK_OPENCL_RADIX) ||
+          (engine == BENCHMARK_RADIX_SORT_CPU));
+}
+
+/*
+ * Sorts the "array_length" elements of data type "array_type" at "data" in place
+ * with "engine" (sorting on the device of "session" if it's an OpenCL engine).
+ */
+static void run_engine(const unsigned int engine,
+                       struct Bitonic_Sort_Session* session, void* data,
+                       const unsigned int array_length,
+                       const unsigned int array_type,
+                       const struct Benchmark_Config* config) {
+  struct Array_With_Length_Padded padded_array = {
+      (ARRAY_TYPE_DECLARED*)data, array_length, array_length, PAD_ARRAY_AT_END};
+  const size_t data_size = array_length * get_array_type_size(array_type);
+  cl_mem* buffer_in;
+
+  switch (engine) {
+    case BENCHMARK_OPENCL_BITONIC:
+      bitonic_session_sort(session, data, array_length, array_type,
+                           config->sorting_direction);
+      break;
+    case BENCHMARK_OPENCL_RADIX:
+      buffer_in = get_session_buffer(session, KEY_BUFFER_SLOT, data_size);
+      clEnqueueWriteBuffer(session->queue, *buffer_in, CL_BLOCKING,
+                           CL_BUFFER_OFFSET, data_size, data, 0, NULL, NULL);
+      opencl_radix_sort(&session->queue, &session->program_cache, buffer_in,
+                        array_length, array_type, config->sorting_direction);
+      clEnqueueReadBuffer(session->queue, *buffer_in, CL_BLOCKING,
+                          CL_BUFFER_OFFSET, data_size, data, 0, NULL, NULL);
+      break;
+    case BENCHMARK_SERIAL_BITONIC:
+      serial_bitonic_sort(&padded_array, config->sorting_direction);
+      break;
+    case BENCHMARK_PARALLEL_BITONIC_CPU:
+      parallel_bitonic_sort_cpu(&padded_array, config->sorting_direction,
+                                config->num_threads);
+      break;
+    case BENCHMARK_SIMD_BITONIC:
+      simd_bitonic_sort_cpu(&padded_array, config->sorting_direction,
+                            SIMD_ISA_AUTO);
+      break;
+    case BENCHMARK_HYBRID:
+      hybrid_sort_cpu(&padded_array, config->sorting_direction,
+                      config->num_threads);
+      break;
+    case BENCHMARK_INTROSORT:
+      introsort_cpu(data, array_length, array_type, config->sorting_direction);
+      break;
+    case BENCHMARK_RADIX_SORT_CPU:
+      radix_sort_cpu(data, array_length, array_type, config->sorting_direction);
+      break;
+  }
+}
+
+// Comparison function for sorting times in seconds with qsort
+static int compare_seconds(const void* first_arg, const void* second_arg) {
+  const double first_seconds = *(const double*)first_arg;
+  const double second_seconds = *(const double*)second_arg;
+  return (first_seconds > second_seconds) - (first_seconds < second_seconds);
+}
+
+// Summarises the "num_runs" times at "run_seconds" (which get sorted) into "stats"
+static void get_benchmark_stats(double* run_seconds, const unsigned int num_runs,
+                                struct Benchmark_Stats* stats) {
+  qsort(run_seconds, num_runs, sizeof(double), compare_seconds);
+  stats->min_seconds = run_seconds[0];
+  stats->median_seconds =
+      (num_runs % 2 == 1)
+          ? run_seconds[num_runs / 2]
+          : (run_seconds[num_runs / 2 - 1] + run_seconds[num_runs / 2]) / 2.0;
+  // Nearest-rank percentile, i.e. the smallest time not exceeded by that share of runs
+  unsigned int percentile_rank =
+      (num_runs * BENCHMARK_PERCENTILE + 99) / 100;
+  stats->percentile_seconds = run_seconds[percentile_rank - 1];
+}
+
+// Opens the output file given by "config" and writes what comes before the results
+static FILE* open_benchmark_output(const struct Benchmark_Config* config) {
+  char default_output_path[sizeof(BENCHMARK_DEFAULT_OUTPUT_FILE) + 8];
+  const char* output_path = config->output_path;
+  if (output_path == NULL) {
+    snprintf(default_output_path, sizeof(default_output_path), "%s.%s",
+             BENCHMARK_DEFAULT_OUTPUT_FILE,
+             output_format_names[config->output_format]);
+    output_path = default_output_path;
+  }
+
+  FILE* output_file = fopen(output_path, "w");
+  if (output_file == NULL) {
+    int global_err_num = errno;
+    fprintf(stderr, BENCHMARK_OUTPUT_ERROR_MESSAGE, output_path,
+            strerror(global_err_num));
+    exit(global_err_num);
+  }
+  fputs((config->output_format == BENCHMARK_CSV_OUTPUT) ? BENCHMARK_CSV_HEADER
+                                                        : "[\n",
+        output_file);
+  return output_file;
+}
+
+// Writes the results of one combination of the sweep into "output_file"
+static void write_benchmark_row(FILE* output_file,
+                                const struct Benchmark_Config* config,
+                                const unsigned int num_rows_written,
+                                const unsigned int engine,
+                                const unsigned int array_type,
+                                const unsigned int distribution,
+                                const unsigned int array_length,
+                                const unsigned int workgroup_size,
+                                const struct Benchmark_Stats* stats) {
+  const char* row_format = BENCHMARK_CSV_ROW_FORMAT;
+  if (config->output_format == BENCHMARK_JSON_OUTPUT) {
+    row_format = BENCHMARK_JSON_ROW_FORMAT;
+    // Separate objects of the JSON array
+    if (num_rows_written > 0) {
+      fputs(",\n", output_file);
+    }
+  }
+  fprintf(output_file, row_format, engine_names[engine],
+          get_array_type_name(array_type), distribution_names[distribution],
+          array_length, workgroup_size,
+          sorting_direction_names[config->sorting_direction],
+          config->repetitions, stats->median_seconds, stats->min_seconds,
+          stats->percentile_seconds,
+          (stats->median_seconds > 0.0)
+              ? (double)array_length / stats->median_seconds
+              : 0.0);
+  fflush(output_file);
+}
+
+/*
+ * Autotunes the OpenCL bitonic sort for the device of "session" on the largest array
+ * length given on the command line, with ARRAY_TYPE if it's among the data types given
+ * (and the first data type given otherwise), and saves the fastest configuration found
+ * within the tuning file of PROGRAM_BINARY_CACHE_DIR.
+ */
+static void autotune_benchmark_device(struct Bitonic_Sort_Session* session,
+                                      const struct Benchmark_Config* config) {
+  unsigned int array_length = 1;
+  for (unsigned int size_index = 0; size_index < config->num_sizes;
+       ++size_index) {
+    if (config->sizes[size_index] > array_length) {
+      array_length = config->sizes[size_index];
+    }
+  }
+  unsigned int array_type = 0;
+  if (config->types[ARRAY_TYPE]) {
+    array_type = ARRAY_TYPE;
+  } else {
+    while ((array_type + 1 < NUM_ARRAY_TYPES) && !config->types[array_type]) {
+      ++array_type;
+    }
+  }
+
+  struct Bitonic_Tuning tuning;
+  autotune_bitonic_session(session, array_length, array_type,
+                           config->sorting_direction, &tuning);
+  store_bitonic_tuning(session->device, PROGRAM_BINARY_CACHE_DIR, &tuning);
+}
+
+// Sweeps every combination given on the command line.
+int main(int argc, char* argv[]) {
+  struct Benchmark_Config config;
+  struct Bitonic_Sort_Session session;
+  struct Bitonic_Profile profile;
+  double zipf_cdf[BENCHMARK_ZIPF_NUM_VALUES];
+
+  parse_benchmark_options(argc, argv, &config);
+  init_zipf_cdf(zipf_cdf);
+
+  // Only set up an OpenCL device if any engine sorts on one
+  const int uses_opencl = config.engines[BENCHMARK_OPENCL_BITONIC] ||
+                          config.engines[BENCHMARK_OPENCL_RADIX] ||
+                          config.autotune;
+  if (uses_opencl) {
+    init_bitonic_sort_session(&session, config.platform_selector,
+                              config.device_selector,
+                              bitonic_program_source, PROGRAM_BINARY_CACHE_DIR);
+  }
+  if (config.autotune) {
+    autotune_benchmark_device(&session, &config);
+    release_bitonic_sort_session(&session);
+    return 0;
+  }
+
+  if (config.profile_opencl) {
+    init_bitonic_profile(&profile);
+  }
+
+  FILE* output_file = open_benchmark_output(&config);
+  unsigned int num_rows_written = 0;
+  double* run_seconds = malloc(config.repetitions * sizeof(double));
+
+  for (unsigned int array_type = 0; array_type < NUM_ARRAY_TYPES; ++array_type) {
+    if (!config.types[array_type]) {
+      continue;
+    }
+    for (unsigned int size_index = 0; size_index < config.num_sizes;
+         ++size_index) {
+      const unsigned int array_length = config.sizes[size_index];
+      const size_t data_size = array_length * get_array_type_size(array_type);
+      void* input_data = alloc_aligned_array(data_size);
+      void* sorted_data = alloc_aligned_array(data_size);
+      void* reference_data = alloc_aligned_array(data_size);
+
+      for (unsigned int distribution = 0;
+           distribution < NUM_BENCHMARK_DISTRIBUTIONS; ++distribution) {
+        if (!config.distributions[distribution]) {
+          continue;
+        }
+        generate_distribution(input_data, array_length, array_type,
+                              distribution, zipf_cdf);
+        // Every engine is verified against the LSD radix sort on the CPU
+        memcpy(reference_data, input_data, data_size);
+        radix_sort_cpu(reference_data, array_length, array_type,
+                       config.sorting_direction);
+
+        for (unsigned int engine = 0; engine < NUM_BENCHMARK_ENGINES;
+             ++engine) {
+          if (!config.engines[engine] || !engine_sorts_type(engine, array_type) ||
+              !engine_sorts_distribution(engine, array_type, distribution)) {
+            continue;
+          }
+          /*
+           * Only the bitonic sort on the OpenCL device sweeps the workgroup
+           * sizes; the others are reported with the size they always use
+           * (zero on the CPU).
+           */
+          const unsigned int num_workgroup_sizes =
+              (engine == BENCHMARK_OPENCL_BITONIC) ? config.num_workgroup_sizes
+                                                   : 1;
+          for (unsigned int workgroup_index = 0;
+               workgroup_index < num_workgroup_sizes; ++workgroup_index) {
+            unsigned int workgroup_size = 0;
+            if (engine == BENCHMARK_OPENCL_BITONIC) {
+              workgroup_size = config.workgroup_sizes[workgroup_index];
+              const size_t max_workgroup_size = get_session_max_workgroup_size(
+                  &session, array_type, config.sorting_direction);
+              if (workgroup_size > max_workgroup_size) {
+                fprintf(stderr, BENCHMARK_SKIPPED_WORKGROUP_SIZE_MESSAGE,
+                        workgroup_size, get_array_type_name(array_type),
+                        max_workgroup_size);
+                continue;
+              }
+              session.program_cache.workgroup_size = workgroup_size;
+            } else if (engine == BENCHMARK_OPENCL_RADIX) {
+              workgroup_size = OPENCL_RADIX_WORKGROUP_SIZE;
+              // Compile the program ahead of time, so it's never timed
+              get_bitonic_program(&session.program_cache, array_type,
+                                  config.sorting_direction, NO_PAYLOAD);
+            }
+
+            const unsigned int num_runs =
+                config.warmup_runs + config.repetitions;
+            for (unsigned int run = 0; run < num_runs; ++run) {
+              // Only the last run gets profiled, as profiling may slow it down
+              const int profile_run = config.profile_opencl &&
+                                      (engine == BENCHMARK_OPENCL_BITONIC) &&
+                                      (run + 1 == num_runs);
+              if (profile_run) {
+                session.program_cache.profile = &profile;
+              }
+              memcpy(sorted_data, input_data, data_size);
+              const double sort_start_time = get_current_seconds();
+              run_engine(engine, &session, sorted_data, array_length,
+                         array_type, &config);
+              const double sort_end_time = get_current_seconds();
+              if (profile_run) {
+                session.program_cache.profile = NULL;
+                print_bitonic_profile(&profile, stdout);
+                reset_bitonic_profile(&profile);
+              }
+              if (run >= config.warmup_runs) {
+                run_seconds[run - config.warmup_runs] =
+                    sort_end_time - sort_start_time;
+              }
+              /*
+               * NaNs sorted by different engines may differ in their sign, so
+               * arrays with NaNs only get checked to hold every number of the
+               * input exactly once, by sorting them once more as the reference
+               */
+              if (distribution == BENCHMARK_NANS) {
+                radix_sort_cpu(sorted_data, array_length, array_type,
+                               config.sorting_direction);
+              }
+              assert(memcmp(sorted_data, reference_data, data_size) == 0);
+            }
+
+            struct Benchmark_Stats stats;
+            get_benchmark_stats(run_seconds, config.repetitions, &stats);
+            write_benchmark_row(output_file, &config, num_rows_written++,
+                                engine, array_type, distribution, array_length,
+                                workgroup_size, &stats);
+            printf(BENCHMARK_PROGRESS_MESSAGE, engine_names[engine],
+                   array_length, get_array_type_name(array_type),
+                   distribution_names[distribution], workgroup_size,
+                   stats.median_seconds);
+          }
+        }
+      }
+      free(input_data);
+      free(sorted_data);
+      free(reference_data);
+    }
+  }
+
+  if (config.output_format == BENCHMARK_JSON_OUTPUT) {
+    fputs((num_rows_written > 0) ? "\n]\n" : "]\n", output_file);
+  }
+  fclose(output_file);
+  free(run_seconds);
+  if (config.profile_opencl) {
+    release_bitonic_profile(&profile);
+  }
+  if (uses_opencl) {
+    release_bitonic_sort_session(&session);
+  }
+  return 0;
+}
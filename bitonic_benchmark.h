@@ -0,0 +1,170 @@
+// =================================================================================================
+// File Description:
+// Header file for the benchmark sweep executable, which times every sorting engine over
+// combinations of array lengths, data types, workgroup sizes and distributions of input data,
+// and writes summary statistics of the repeated runs as CSV or JSON for further analysis.
+// =================================================================================================
+
+#ifndef BITONIC_BENCHMARK_H
+#define BITONIC_BENCHMARK_H
+
+#include "naive_bitonic_sort_opencl.h"
+
+/*
+ * Flag variable literals of the sorting engines benchmarked; engines sorting on the CPU
+ * other than introsort and LSD radix sort are specialised for ARRAY_TYPE when compiling,
+ * so they're only benchmarked for that data type.
+ *  - BENCHMARK_OPENCL_BITONIC --- bitonic sort within a sorting session (see
+ *    "bitonic_sort_session.h"), once per workgroup size
+ *  - BENCHMARK_OPENCL_RADIX --- LSD radix sort on the device (see "radix_sort_opencl.h")
+ *  - all other engines sort in main memory
+ * Times of engines sorting on the OpenCL device include copying the array to and from it.
+ */
+#define BENCHMARK_OPENCL_BITONIC 0
+#define BENCHMARK_OPENCL_RADIX 1
+#define BENCHMARK_SERIAL_BITONIC 2
+#define BENCHMARK_PARALLEL_BITONIC_CPU 3
+#define BENCHMARK_SIMD_BITONIC 4
+#define BENCHMARK_HYBRID 5
+#define BENCHMARK_INTROSORT 6
+#define BENCHMARK_RADIX_SORT_CPU 7
+// Number of different sorting engines above
+#define NUM_BENCHMARK_ENGINES 8
+
+/*
+ * Flag variable literals of the distributions of the input data:
+ *  - BENCHMARK_UNIFORM --- independent numbers spread evenly over the whole range of the data type
+ *  - BENCHMARK_SORTED and BENCHMARK_REVERSE_SORTED --- already sorted ascending / descending
+ *  - BENCHMARK_FEW_UNIQUE --- BENCHMARK_FEW_UNIQUE_VALUES different numbers in random order
+ *  - BENCHMARK_ZIPF --- BENCHMARK_ZIPF_NUM_VALUES different numbers, where the frequency of the
+ *    k-th smallest number is proportional to 1 / k^BENCHMARK_ZIPF_EXPONENT
+ *  - BENCHMARK_ORGAN_PIPE --- ascending up to the middle of the array, then descending
+ *  - BENCHMARK_ALL_EQUAL --- the same number throughout
+ *  - BENCHMARK_NANS --- like BENCHMARK_UNIFORM, with a share of BENCHMARK_NAN_FRACTION of the
+ *    numbers replaced by NaNs; only floating point numbers are benchmarked, by the engines that
+ *    order NaNs (i.e. put them last), and the sorted arrays are checked to be permutations of
+ *    the input rather than compared with the sorted array as a whole
+ */
+#define BENCHMARK_UNIFORM 0
+#define BENCHMARK_SORTED 1
+#define BENCHMARK_REVERSE_SORTED 2
+#define BENCHMARK_FEW_UNIQUE 3
+#define BENCHMARK_ZIPF 4
+#define BENCHMARK_ORGAN_PIPE 5
+#define BENCHMARK_ALL_EQUAL 6
+#define BENCHMARK_NANS 7
+// Number of different distributions above
+#define NUM_BENCHMARK_DISTRIBUTIONS 8
+
+#define BENCHMARK_FEW_UNIQUE_VALUES 16
+#define BENCHMARK_ZIPF_NUM_VALUES 1024
+#define BENCHMARK_ZIPF_EXPONENT 1.0
+#define BENCHMARK_NAN_FRACTION 0.05
+// Seed of the pseudorandom numbers, so that every run benchmarks the same input data
+#define BENCHMARK_RANDOM_SEED 0x2545F4914F6CDD1DULL
+// Floating point numbers range from -BENCHMARK_FLOAT_RANGE to BENCHMARK_FLOAT_RANGE
+#define BENCHMARK_FLOAT_RANGE 1000000.0
+#define BENCHMARK_NANOSECS_IN_SEC 1000000000.0
+
+// Flag variable literals of the output formats
+#define BENCHMARK_CSV_OUTPUT 0
+#define BENCHMARK_JSON_OUTPUT 1
+
+// Default values of the command line options (refer to BENCHMARK_USAGE_MESSAGE)
+#define BENCHMARK_DEFAULT_SIZES "1024,65536,1048576"
+#define BENCHMARK_DEFAULT_TYPES "char,int,long,float,double"
+#define BENCHMARK_DEFAULT_WORKGROUP_SIZES "64,128,256"
+#define BENCHMARK_DEFAULT_WARMUP_RUNS 1
+#define BENCHMARK_DEFAULT_REPETITIONS 5
+#define BENCHMARK_DEFAULT_OUTPUT_FILE "bitonic_benchmark_results"
+// Percentile of the run times reported besides the median and the minimum
+#define BENCHMARK_PERCENTILE 95
+// Maximum number of values of each list given on the command line
+#define MAX_BENCHMARK_LIST_LEN 64
+
+#define BENCHMARK_USAGE_MESSAGE "Usage: %s [options]\n"\
+  "  --sizes=N,...             array lengths (default " BENCHMARK_DEFAULT_SIZES ")\n"\
+  "  --types=T,...             char, int, long, float and/or double (default all)\n"\
+  "  --engines=E,...           opencl_bitonic, opencl_radix, serial_bitonic, parallel_bitonic_cpu,\n"\
+  "                            simd_bitonic, hybrid, introsort and/or radix_cpu (default all)\n"\
+  "  --distributions=D,...     uniform, sorted, reverse_sorted, few_unique, zipf, organ_pipe,\n"\
+  "                            all_equal and/or nans (default all)\n"\
+  "  --workgroup-sizes=N,...   workgroup sizes of opencl_bitonic, powers of 2 (default\n"\
+  "                            " BENCHMARK_DEFAULT_WORKGROUP_SIZES "; sizes the device can't run are skipped)\n"\
+  "  --direction=D             ascending or descending (default SORTING_DIRECTION)\n"\
+  "  --warmup=N                untimed runs before the timed ones (default 1)\n"\
+  "  --repetitions=N           timed runs (default 5)\n"\
+  "  --threads=N               CPU threads, 0 for one per processor online (default 0)\n"\
+  "  --platform=P              index or part of the name of the OpenCL platform (default 0)\n"\
+  "  --device=D                index or part of the name of the OpenCL device (default: the\n"\
+  "                            platform's default device)\n"\
+  "  --list-devices            list every OpenCL platform and device, then exit\n"\
+  "  --format=F                csv or json (default csv)\n"\
+  "  --output=FILE             file to write to (default " BENCHMARK_DEFAULT_OUTPUT_FILE ".csv/.json)\n"\
+  "  --profile                 print a per-step profile of the last run of opencl_bitonic\n"\
+  "  --autotune                instead of benchmarking, find the fastest workgroup size and merge\n"\
+  "                            steps per launch of opencl_bitonic for the device on the largest\n"\
+  "                            of --sizes and save them for every later run to load\n"
+
+#define BENCHMARK_INVALID_OPTION_MESSAGE "Invalid value of option --%s: %s\n"
+#define BENCHMARK_SKIPPED_WORKGROUP_SIZE_MESSAGE ">>> Skipping workgroup size %u of %ss, which is larger"\
+                                                 " than the maximum of %zu for the device\n"
+#define BENCHMARK_PROGRESS_MESSAGE ">>> Benchmarked %s on %u %ss (%s, workgroup size %u):"\
+                                   " median %lf seconds\n"
+#define BENCHMARK_OUTPUT_ERROR_MESSAGE "Error opening %s: %s.\n"
+
+// CSV header line, and format of each line of results in CSV and JSON respectively
+#define BENCHMARK_CSV_HEADER "engine,type,distribution,size,workgroup_size,direction,repetitions,"\
+                             "median_seconds,min_seconds,p95_seconds,elements_per_second\n"
+#define BENCHMARK_CSV_ROW_FORMAT "%s,%s,%s,%u,%u,%s,%u,%.9f,%.9f,%.9f,%.1f\n"
+#define BENCHMARK_JSON_ROW_FORMAT "  {\"engine\": \"%s\", \"type\": \"%s\", \"distribution\": \"%s\","\
+                                  " \"size\": %u, \"workgroup_size\": %u, \"direction\": \"%s\","\
+                                  " \"repetitions\": %u, \"median_seconds\": %.9f, \"min_seconds\": %.9f,"\
+                                  " \"p95_seconds\": %.9f, \"elements_per_second\": %.1f}"
+
+/*
+ * Everything to benchmark, as given on the command line; fields are the following:
+ *  - array lengths and workgroup sizes, along with the number of each
+ *  - whether to benchmark each data type, engine and distribution (non-zero) or not
+ *    (zero), indexed by the macro value of each
+ *  - direction of sort, number of untimed and timed runs and number of CPU threads
+ *  - selectors of the OpenCL platform and device (refer to "select_opencl_device"
+ *    within "opencl_devices.h"), NULL for the defaults
+ *  - output format and path of the output file
+ *  - whether to profile the last timed run of the OpenCL bitonic sort (non-zero) or
+ *    not (zero), refer to "bitonic_profile.h"
+ *  - whether to autotune the OpenCL bitonic sort for the device (non-zero) instead of
+ *    benchmarking or not (zero), refer to "autotune_bitonic_session"
+ */
+struct Benchmark_Config {
+     unsigned int sizes[MAX_BENCHMARK_LIST_LEN];
+     unsigned int num_sizes;
+     unsigned int workgroup_sizes[MAX_BENCHMARK_LIST_LEN];
+     unsigned int num_workgroup_sizes;
+     unsigned char types[NUM_ARRAY_TYPES];
+     unsigned char engines[NUM_BENCHMARK_ENGINES];
+     unsigned char distributions[NUM_BENCHMARK_DISTRIBUTIONS];
+     unsigned int sorting_direction;
+     unsigned int warmup_runs;
+     unsigned int repetitions;
+     unsigned int num_threads;
+     const char* platform_selector;
+     const char* device_selector;
+     unsigned int output_format;
+     const char* output_path;
+     unsigned int profile_opencl;
+     unsigned int autotune;
+};
+
+/*
+ * Summary statistics of the times in seconds taken by the timed runs of one combination
+ * of engine, data type, distribution, array length and workgroup size.
+ */
+struct Benchmark_Stats {
+     double median_seconds;
+     double min_seconds;
+     double percentile_seconds;
+};
+
+#endif // BITONIC_BENCHMARK_H
+// =================================================================================================
@@ -0,0 +1,175 @@
+/*
+ * File description:
+ *   Profiling of the OpenCL bitonic sort one command at a time, using the timestamps
+ *   of the event of each command.
+ */
+
+#include "bitonic_profile.h"
+#include <stdlib.h>
+#include <assert.h>
+
+// Name of each kind of profiled command, indexed by the macro value of each kind
+static const char* const command_kind_names[NUM_PROFILED_COMMAND_KINDS] = {
+    "upload", "local_merge", "global_merge", "readback", "merge_path"
+};
+
+// Whether commands of "command_kind" sort the array on the device, as opposed to copying it over or back
+static int is_sorting_command_kind(const unsigned int command_kind) {
+    return (command_kind == PROFILED_LOCAL_MERGE_STEPS) || (command_kind == PROFILED_GLOBAL_MERGE_STEPS) ||
+             (command_kind == PROFILED_MERGE_PATH);
+}
+
+// Number of nanoseconds in a millisecond, as timestamps of events are in nanoseconds
+#define NANOSECS_IN_MILLISEC 1000000.0
+
+/*
+ * Total of the commands of a profile of the same kind, partition size, compare distance
+ * and number of merge steps; fields are the first command of the group (standing in for all
+ * of them), the totals of the time in nanoseconds and of the bytes, and the number of commands.
+ */
+struct Profiled_Command_Group {
+     const struct Profiled_Command* first_command;
+     cl_ulong total_nanosecs;
+     size_t total_bytes;
+     unsigned int num_commands;
+};
+
+void init_bitonic_profile(struct Bitonic_Profile* profile) {
+    // No null pointers allowed
+    assert(profile != NULL);
+
+    profile->commands = malloc(BITONIC_PROFILE_INITIAL_CAPACITY * sizeof(struct Profiled_Command));
+    profile->num_commands = 0;
+    profile->capacity = BITONIC_PROFILE_INITIAL_CAPACITY;
+}
+
+void reset_bitonic_profile(struct Bitonic_Profile* profile) {
+    // No null pointers allowed
+    assert(profile != NULL);
+
+    for (unsigned int command_index = 0; command_index < profile->num_commands; ++command_index) {
+        clReleaseEvent(profile->commands[command_index].event);
+    }
+    profile->num_commands = 0;
+}
+
+void release_bitonic_profile(struct Bitonic_Profile* profile) {
+    // No null pointers allowed
+    assert(profile != NULL);
+
+    reset_bitonic_profile(profile);
+    free(profile->commands);
+    profile->commands = NULL;
+    profile->capacity = 0;
+}
+
+cl_event* add_profiled_command(struct Bitonic_Profile* profile, const unsigned int command_kind,
+                                 const unsigned int partition_size, const unsigned int compare_distance,
+                                   const unsigned int num_merge_steps, const size_t num_bytes) {
+    if (profile == NULL) {
+        return NULL;
+    }
+    // Make sure kind of command is of valid value
+    assert(command_kind < NUM_PROFILED_COMMAND_KINDS);
+
+    if (profile->num_commands == profile->capacity) {
+        profile->capacity *= 2;
+        profile->commands = realloc(profile->commands, profile->capacity * sizeof(struct Profiled_Command));
+    }
+    struct Profiled_Command* command = &(profile->commands[profile->num_commands++]);
+    command->command_kind = command_kind;
+    command->partition_size = partition_size;
+    command->compare_distance = compare_distance;
+    command->num_merge_steps = num_merge_steps;
+    command->num_bytes = num_bytes;
+    command->event = NULL;
+
+    return &(command->event);
+}
+
+// Whether "first" and "second" belong to the same group of the report
+static int same_command_group(const struct Profiled_Command* first, const struct Profiled_Command* second) {
+    return (first->command_kind == second->command_kind) && (first->partition_size == second->partition_size) &&
+             (first->compare_distance == second->compare_distance) &&
+               (first->num_merge_steps == second->num_merge_steps);
+}
+
+void print_bitonic_profile(struct Bitonic_Profile* profile, FILE* output_file) {
+    // No null pointers allowed
+    assert(profile != NULL);
+    assert(output_file != NULL);
+
+    const unsigned int num_commands = profile->num_commands;
+    cl_ulong* start_times = malloc(num_commands * sizeof(cl_ulong));
+    cl_ulong* end_times = malloc(num_commands * sizeof(cl_ulong));
+    struct Profiled_Command_Group* groups = malloc(num_commands * sizeof(struct Profiled_Command_Group));
+    unsigned int num_groups = 0;
+    cl_ulong kind_nanosecs[NUM_PROFILED_COMMAND_KINDS] = {0};
+
+    for (unsigned int command_index = 0; command_index < num_commands; ++command_index) {
+        const struct Profiled_Command* command = &(profile->commands[command_index]);
+        cl_int func_error_code = clWaitForEvents(1, &(command->event));
+        assert(func_error_code == CL_SUCCESS);
+        clGetEventProfilingInfo(command->event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong),
+                                                                 &start_times[command_index], NULL);
+        clGetEventProfilingInfo(command->event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong),
+                                                                   &end_times[command_index], NULL);
+        const cl_ulong command_nanosecs = end_times[command_index] - start_times[command_index];
+        kind_nanosecs[command->command_kind] += command_nanosecs;
+
+        // Groups are listed in the order their first command was enqueued
+        unsigned int group_index = 0;
+        while ((group_index < num_groups) && !same_command_group(groups[group_index].first_command, command)) {
+            ++group_index;
+        }
+        if (group_index == num_groups) {
+            groups[num_groups].first_command = command;
+            groups[num_groups].total_nanosecs = 0;
+            groups[num_groups].total_bytes = 0;
+            groups[num_groups].num_commands = 0;
+            ++num_groups;
+        }
+        groups[group_index].total_nanosecs += command_nanosecs;
+        groups[group_index].total_bytes += command->num_bytes;
+        ++groups[group_index].num_commands;
+    }
+
+    fprintf(output_file, BITONIC_PROFILE_HEADER_MESSAGE, num_commands, "command", "partition", "distance",
+                                                                 "steps", "launches", "time (ms)", "GB/s");
+    for (unsigned int group_index = 0; group_index < num_groups; ++group_index) {
+        const struct Profiled_Command_Group* group = &groups[group_index];
+        // Bytes per nanosecond are the same as GB/s
+        const double gigabytes_per_sec = (group->total_nanosecs > 0) ?
+                                            (double)group->total_bytes / (double)group->total_nanosecs : 0.0;
+        fprintf(output_file, BITONIC_PROFILE_GROUP_MESSAGE, command_kind_names[group->first_command->command_kind],
+                  group->first_command->partition_size, group->first_command->compare_distance,
+                    group->first_command->num_merge_steps, group->num_commands,
+                      (double)group->total_nanosecs / NANOSECS_IN_MILLISEC, gigabytes_per_sec);
+    }
+
+    /*
+     * The device only sits idle between two consecutive launches of merge steps if the host
+     * hasn't enqueued the second launch by the time the first one finishes.
+     */
+    cl_ulong gap_nanosecs = 0;
+    unsigned int num_gaps = 0;
+    for (unsigned int command_index = 1; command_index < num_commands; ++command_index) {
+        const unsigned int previous_kind = profile->commands[command_index - 1].command_kind;
+        const unsigned int current_kind = profile->commands[command_index].command_kind;
+        const int both_merge_steps = is_sorting_command_kind(previous_kind) && is_sorting_command_kind(current_kind);
+        if (both_merge_steps && (start_times[command_index] > end_times[command_index - 1])) {
+            gap_nanosecs += start_times[command_index] - end_times[command_index - 1];
+            ++num_gaps;
+        }
+    }
+    fprintf(output_file, BITONIC_PROFILE_SUMMARY_MESSAGE,
+              (double)kind_nanosecs[PROFILED_UPLOAD] / NANOSECS_IN_MILLISEC,
+                (double)(kind_nanosecs[PROFILED_LOCAL_MERGE_STEPS] + kind_nanosecs[PROFILED_GLOBAL_MERGE_STEPS] +
+                                                kind_nanosecs[PROFILED_MERGE_PATH]) / NANOSECS_IN_MILLISEC,
+                  (double)kind_nanosecs[PROFILED_READBACK] / NANOSECS_IN_MILLISEC,
+                    (double)gap_nanosecs / NANOSECS_IN_MILLISEC, num_gaps);
+
+    free(start_times);
+    free(end_times);
+    free(groups);
+}
@@ -0,0 +1,100 @@
+/*
+ * File description:
+ *   Header file for profiling the OpenCL bitonic sort one command at a time: every
+ *   command enqueued while a profile is attached (refer to the "profile" field of
+ *   "Bitonic_Program_Cache") gets an event, whose timestamps are later turned into a
+ *   report of where the time went, grouped by partition size and compare distance.
+ *   Command queues MUST be created with CL_QUEUE_PROFILING_ENABLE.
+ */
+
+#ifndef BITONIC_PROFILE_H
+#define BITONIC_PROFILE_H
+
+#include <stdio.h>
+#include "naive_bitonic_sort_opencl.h"
+
+/*
+ * Flag variable literals of the kinds of commands profiled:
+ *  - PROFILED_UPLOAD and PROFILED_READBACK --- copies of arrays to and from the device
+ *  - PROFILED_LOCAL_MERGE_STEPS --- launches of the kernel performing merge steps
+ *    within tiles in local memory
+ *  - PROFILED_GLOBAL_MERGE_STEPS --- launches of the kernels performing merge steps
+ *    in global memory (i.e. within registers of each work-item)
+ *  - PROFILED_MERGE_PATH --- launches of the kernel merging pairs of sorted runs along
+ *    the merge path, and the copy of the merged array back into the buffer sorted
+ */
+#define PROFILED_UPLOAD 0
+#define PROFILED_LOCAL_MERGE_STEPS 1
+#define PROFILED_GLOBAL_MERGE_STEPS 2
+#define PROFILED_READBACK 3
+#define PROFILED_MERGE_PATH 4
+// Number of different kinds of commands above
+#define NUM_PROFILED_COMMAND_KINDS 5
+
+// Number of commands a profile makes room for at first; it doubles whenever full
+#define BITONIC_PROFILE_INITIAL_CAPACITY 64
+
+#define BITONIC_PROFILE_HEADER_MESSAGE ">>> Profile of %u OpenCL command(s), grouped by partition size"\
+                                       " and compare distance:\n"\
+                                       "%-14s %12s %12s %6s %9s %14s %10s\n"
+#define BITONIC_PROFILE_GROUP_MESSAGE "%-14s %12u %12u %6u %9u %14.6lf %10.3lf\n"
+#define BITONIC_PROFILE_SUMMARY_MESSAGE "Upload %.6lf ms, sort %.6lf ms, readback %.6lf ms,"\
+                                        " host launch gaps %.6lf ms (over %u gap(s))\n"
+
+/*
+ * A single profiled command; fields are the following:
+ *  - kind of command (one of the flag variable literals above)
+ *  - partition size and (first) compare distance of the merge steps performed, or 0
+ *    for copies
+ *  - number of consecutive merge steps performed by the launch, or 0 for copies
+ *  - number of bytes read and written by the command in global memory
+ *  - event of the command, holding its timestamps
+ */
+struct Profiled_Command {
+     unsigned int command_kind;
+     unsigned int partition_size;
+     unsigned int compare_distance;
+     unsigned int num_merge_steps;
+     size_t num_bytes;
+     cl_event event;
+};
+
+/*
+ * Every command profiled so far, in the order they were enqueued; fields are the
+ * commands themselves, how many there are and how many there's room for.
+ */
+struct Bitonic_Profile {
+     struct Profiled_Command* commands;
+     unsigned int num_commands;
+     unsigned int capacity;
+};
+
+// Prepares an empty "profile"
+void init_bitonic_profile(struct Bitonic_Profile* profile);
+
+// Releases the events of every command of "profile", leaving it empty for the next sort
+void reset_bitonic_profile(struct Bitonic_Profile* profile);
+
+// Releases "profile" and everything within it
+void release_bitonic_profile(struct Bitonic_Profile* profile);
+
+/*
+ * Adds a command of "command_kind" to "profile" (refer to "Profiled_Command" for the
+ * other parameters) and returns where the event of the command has to be stored when
+ * enqueueing it; returns NULL if "profile" is NULL, so that the result may always be
+ * passed as the event of the command.
+ */
+cl_event* add_profiled_command(struct Bitonic_Profile* profile, const unsigned int command_kind,
+                                 const unsigned int partition_size, const unsigned int compare_distance,
+                                   const unsigned int num_merge_steps, const size_t num_bytes);
+
+/*
+ * Waits for every command of "profile" to be finished, then prints into "output_file" the
+ * total time and achieved bandwidth (in GB/s) of the commands of each kind, partition size
+ * and compare distance, followed by the total time spent on uploading, sorting and reading
+ * back, and the time the device sat idle between consecutive merge step launches (i.e. the
+ * gaps the host didn't manage to fill by launching kernels fast enough).
+ */
+void print_bitonic_profile(struct Bitonic_Profile* profile, FILE* output_file);
+
+#endif // BITONIC_PROFILE_H
@@ -1,8 +1,66 @@
-
-
 // Enable 64-bit floating point compute
 #pragma OPENCL EXTENSION cl_khr_fp64 : enable
 
+/*
+ * Direction of sort built into the kernels of this program; non-zero value indicates to sort
+ * descending, zero indicates to sort ascending. Passed by the host as a compiler option
+ * (i.e. "-DSORT_DESCENDING=1") along with the data type "ARRAY_TYPE".
+ */
+#ifndef SORT_DESCENDING
+  #define SORT_DESCENDING 0
+#endif
+
+/*
+ * Notes on the variant of the bitonic sorting network implemented by the kernels in this file:
+ *
+ * Every comparator of the network moves the number that comes first in the sorting order to
+ * the smaller array index of the pair being compared, so that every partition is sorted in the
+ * same direction as the whole array. The first merge step of each partition size compares
+ * mirrored positions within each pair of partitions (i.e. "flips" the second partition of the
+ * pair), and all remaining merge steps of that partition size are regular half-cleaners.
+ *
+ * As a result, any array index at or beyond the length of the array can be treated as holding a
+ * "virtual" number coming after every real number in the sorting order; such a number would never
+ * move, so every comparator touching an index at or beyond the array length is simply skipped.
+ * This lets the network sort arrays of any length without padding them to a power of 2.
+ */
+
+/*
+ * Decides whether the two numbers being compared by a single comparator of the
+ * bitonic sorting network have to trade places; "lower_element" is the number
+ * at the smaller array index of the pair and "upper_element" is the number at
+ * the larger array index of the pair. If sorting in ascending order, the smaller
+ * number has to end up at the smaller index; if sorting in descending order, the
+ * larger number has to end up at the smaller index. NaNs (the only numbers not
+ * equal to themselves) come after every other number whichever the sorting
+ * direction, as with the keys of "sortable_keys.h", so that comparisons always
+ * agree with a single order; the merge path relies on that (refer to
+ * "merge_path_merge_runs").
+ */
+inline bool bitonic_elements_need_swap(const ARRAY_TYPE lower_element, const ARRAY_TYPE upper_element)
+{
+   const bool only_lower_is_nan = (lower_element != lower_element) && (upper_element == upper_element);
+#if (SORT_DESCENDING)
+   return (lower_element < upper_element) || only_lower_is_nan;
+#else
+   return (lower_element > upper_element) || only_lower_is_nan;
+#endif
+}
+
+/*
+ * Given the smaller index of a pair of numbers being compared, returns the larger index of the
+ * pair; "lower_index" MUST have the bit of "compare_distance" cleared. The first merge step of
+ * each partition size (i.e. the compare distance is half of the partition size) compares mirrored
+ * positions of the two halves of each bitonic sequence being created, while all other merge steps
+ * compare numbers that are exactly "compare_distance" apart.
+ */
+inline unsigned int bitonic_upper_index(const unsigned int lower_index, const unsigned int compare_distance,
+                                                                         const unsigned int partition_size)
+{
+   return (2 * compare_distance == partition_size) ? (lower_index ^ (partition_size - 1)) :
+                                                                  (lower_index | compare_distance);
+}
+
 /*
  * Bitonic sorting merge kernel operating on global memory in OpenCL.
  *  Implementation of Kernel and sorting method inspired by the following websites:
@@ -10,82 +68,999 @@
  *   - http://www.bealto.com/gpu-sorting_parallel-bitonic-1.html
  *   - https://github.com/microsoft/DirectX-Graphics-Samples/blob/master/MiniEngine/Core/BitonicSort.h
  *   - https://gist.github.com/mre/1392067
+ * Work-items at or beyond "array_length" do nothing, so the number of work-items launched may be
+ * rounded up to a multiple of the workgroup size.
  */
-__kernel void naive_bitonic_sort_merge_step(__global ARRAY_TYPE* input_array, const unsigned int compare_distance,
-                                                                                  const unsigned int partition_size,
-                                                                                   const unsigned int sort_direction)
+__kernel void naive_bitonic_sort_merge_step(__global ARRAY_TYPE* input_array, const unsigned int array_length,
+                                                                                const unsigned int compare_distance,
+                                                                                  const unsigned int partition_size)
 {
-   /* 
+   /*
     * Value representing the first work-item dimension in the OpenCL programming model, as arrays
     * are one-dimensional data structures and therefore we are only concerned with that first
     * dimension.
     */
    const unsigned int first_dimension_num = 0;
-   /*
-    * Constant flag variable representing the ascending part of a bitonic sequence if sorting
-    * elements in ascending order, the descending part if sorting in descending order.
-    */
-   const unsigned int monotonic_part_indicator = 0;
-   
    /* The current index of the array this kernel is performing a bitonic sorting step on. */
    unsigned int array_index = get_global_id(first_dimension_num);
-   
+
    /*
-    * Rotate the current array index using XOR to the index of the
-    * other number to compare to as specified by the bitonic sorting
-    * network.
+    * Only make comparisons and swap as necessary if the current array index is the smaller
+    * index of the pair of numbers being compared (i.e. the bit of the compare distance is
+    * cleared) to avoid double comparisons, and if the other number of the pair is within the
+    * array (see notes at top of file).
     */
-   unsigned int compare_distance_rotated_index = compare_distance ^ array_index;
+   if ((array_index & compare_distance) == 0) {
+       /*
+        * Get the index of the other number to compare to as specified
+        * by the bitonic sorting network.
+        */
+       unsigned int compare_distance_rotated_index = bitonic_upper_index(array_index, compare_distance,
+                                                                                        partition_size);
+       if (compare_distance_rotated_index < array_length) {
+           bool swap = bitonic_elements_need_swap(input_array[array_index],
+                                                   input_array[compare_distance_rotated_index]);
+
+           // Swap numbers as necessary
+           if (swap) {
+               ARRAY_TYPE temp_var = input_array[array_index];
+               input_array[array_index] = input_array[compare_distance_rotated_index];
+               input_array[compare_distance_rotated_index] = temp_var;
+           }
+       }
+   }
+
+}
+
+/*
+ * Same merge step as the "naive_bitonic_sort_merge_step" kernel, except that it only needs
+ * to be launched with half as many work-items as the array length rounded up to the next power
+ * of 2; each work-item maps directly onto the smaller index of the pair of numbers it compares,
+ * so that no work-item goes idle. Work-items whose pair of numbers isn't within the array do
+ * nothing, so the number of work-items launched may be rounded up to a multiple of the workgroup
+ * size.
+ */
+__kernel void half_bitonic_sort_merge_step(__global ARRAY_TYPE* input_array, const unsigned int array_length,
+                                                                               const unsigned int compare_distance,
+                                                                                 const unsigned int partition_size)
+{
+   // See "naive_bitonic_sort_merge_step" kernel for explanation of this value
+   const unsigned int first_dimension_num = 0;
+   const unsigned int work_item_index = get_global_id(first_dimension_num);
 
    /*
-    * Only make comparisons and swap as necessary if compare_distance_rotated_index
-    * is larger to avoid double comparisons; the contents of this "if" control structure
-    * is responsible for creating the monotonic halves of a bitonic sequence by using
-    * a bitmask (i.e. "bitonic_sequence_part_indicator") to determine which numbers
-    * should be swapped.  The bitmask partitions the array into ascending and descending
-    * halves. If the bitmask indicates to sort ascending, then sort ascending by
-    * swapping numbers which are in descending order, and vice versa for bitmasks
-    * indicating to sort descending.
+    * Insert a zero bit into the work-item index at the position of the compare distance to get the
+    * smaller index of the pair of numbers being compared.
     */
-   if (compare_distance_rotated_index > array_index) {
+   const unsigned int lower_index = ((work_item_index & ~(compare_distance - 1)) << 1) |
+                                               (work_item_index & (compare_distance - 1));
+   const unsigned int upper_index = bitonic_upper_index(lower_index, compare_distance, partition_size);
+
+   if (upper_index < array_length) {
+      const ARRAY_TYPE lower_element = input_array[lower_index];
+      const ARRAY_TYPE upper_element = input_array[upper_index];
+
+      // Swap numbers as necessary
+      if (bitonic_elements_need_swap(lower_element, upper_element)) {
+         input_array[lower_index] = upper_element;
+         input_array[upper_index] = lower_element;
+      }
+   }
+}
+
+/*
+ * Bitonic sorting merge kernel operating on local memory in OpenCL; performs, in a single launch,
+ * every merge step whose compare distance fits within a tile of the array that is loaded into the
+ * local memory of each workgroup. Each work-item is responsible for one pair of numbers per merge
+ * step, so each tile is twice as long as the number of work-items per workgroup (i.e. the
+ * "local_tile" buffer MUST be able to hold "2 * get_local_size(0)" numbers). The last tile of
+ * the array may extend beyond "array_length"; numbers beyond the array are never loaded.
+ *
+ * Merge steps are performed in the same order as if the merge step kernel above were launched
+ * repeatedly, starting with "compare_distance" at "partition_size", and then going through all
+ * compare distances of all remaining partition sizes up to and including "last_partition_size".
+ * E.g. sorting every tile from scratch uses a "compare_distance" of 1 with a "partition_size" of 2
+ * and a "last_partition_size" of the tile length, while finishing up a merge of partitions larger
+ * than a tile uses a "compare_distance" of half the tile length with a "last_partition_size" equal
+ * to "partition_size".
+ */
+__kernel void local_bitonic_sort_merge_steps(__global ARRAY_TYPE* input_array, __local ARRAY_TYPE* local_tile,
+                                                                            const unsigned int array_length,
+                                                                       const unsigned int compare_distance,
+                                                                          const unsigned int partition_size,
+                                                                      const unsigned int last_partition_size)
+{
+   // See "naive_bitonic_sort_merge_step" kernel for explanation of this value
+   const unsigned int first_dimension_num = 0;
+
+   /* Index of the work-item within the workgroup, and the number of work-items in the workgroup. */
+   const unsigned int local_index = get_local_id(first_dimension_num);
+   const unsigned int workgroup_size = get_local_size(first_dimension_num);
+   /* Index of the array at which the tile of the current workgroup starts. */
+   const unsigned int tile_offset = get_group_id(first_dimension_num) * 2 * workgroup_size;
+
+   // Each work-item copies up to two numbers from global memory into the tile in local memory
+   if (tile_offset + local_index < array_length) {
+      local_tile[local_index] = input_array[tile_offset + local_index];
+   }
+   if (tile_offset + local_index + workgroup_size < array_length) {
+      local_tile[local_index + workgroup_size] = input_array[tile_offset + local_index + workgroup_size];
+   }
+   barrier(CLK_LOCAL_MEM_FENCE);
+
+   unsigned int curr_compare_distance = compare_distance;
+   for (unsigned int curr_partition_size = partition_size; curr_partition_size <= last_partition_size;
+                                                                                curr_partition_size *= 2) {
+      for (; curr_compare_distance > 0; curr_compare_distance /= 2) {
+         /*
+          * Map the work-item directly onto the smaller index of the pair of numbers it compares,
+          * by inserting a zero bit into the work-item index at the position of the compare distance.
+          * As partition sizes never exceed the tile length here, both numbers are within the tile.
+          */
+         const unsigned int lower_index = ((local_index & ~(curr_compare_distance - 1)) << 1) |
+                                                     (local_index & (curr_compare_distance - 1));
+         const unsigned int upper_index = bitonic_upper_index(lower_index, curr_compare_distance,
+                                                                            curr_partition_size);
+
+         if (tile_offset + upper_index < array_length) {
+            const ARRAY_TYPE lower_element = local_tile[lower_index];
+            const ARRAY_TYPE upper_element = local_tile[upper_index];
+
+            // Swap numbers as necessary
+            if (bitonic_elements_need_swap(lower_element, upper_element)) {
+               local_tile[lower_index] = upper_element;
+               local_tile[upper_index] = lower_element;
+            }
+         }
+         barrier(CLK_LOCAL_MEM_FENCE);
+      }
+      // First compare distance of the next partition size is half of that partition size.
+      curr_compare_distance = curr_partition_size;
+   }
+
+   // Copy sorted tile back out to global memory
+   if (tile_offset + local_index < array_length) {
+      input_array[tile_offset + local_index] = local_tile[local_index];
+   }
+   if (tile_offset + local_index + workgroup_size < array_length) {
+      input_array[tile_offset + local_index + workgroup_size] = local_tile[local_index + workgroup_size];
+   }
+}
+
+/*
+ * Maximum number of consecutive merge steps (i.e. compare distance levels) performed by a single
+ * launch of any of the register-blocked merge kernels below; each work-item of such a kernel holds
+ * 2^(number of merge steps) numbers in its private memory.
+ */
+#define MAX_REGISTER_MERGE_LEVELS 4
+#define MAX_REGISTER_BLOCK_LENGTH (1 << MAX_REGISTER_MERGE_LEVELS)
+
+/*
+ * Performs "num_levels" consecutive merge steps of the same partition size, starting with
+ * "compare_distance" and halving the compare distance after each step, with each work-item loading
+ * every number it needs for all of those merge steps into private memory exactly once and writing
+ * them back exactly once. "compare_distance" MUST be less than half of "partition_size", i.e. the
+ * first merge step of each partition size can't be performed by this function.
+ *
+ * Each work-item handles the 2^num_levels numbers located at "block_offset + j * lowest_distance"
+ * (for j = 0 ... 2^num_levels - 1), where "lowest_distance" is the compare distance of the last
+ * merge step performed; the merge steps then only ever compare numbers held by the same work-item.
+ * Numbers located at or beyond "array_length" are never loaded nor compared.
+ */
+inline void register_bitonic_sort_merge_steps(__global ARRAY_TYPE* input_array, const unsigned int array_length,
+                                                                                   const unsigned int num_levels,
+                                                                             const unsigned int compare_distance)
+{
+   // See "naive_bitonic_sort_merge_step" kernel for explanation of this value
+   const unsigned int first_dimension_num = 0;
+   const unsigned int work_item_index = get_global_id(first_dimension_num);
+   const unsigned int block_length = 1 << num_levels;
+   const unsigned int lowest_distance = compare_distance >> (num_levels - 1);
+
+   /*
+    * Insert "num_levels" zero bits into the work-item index at the position of the lowest compare
+    * distance to get the smallest index of the numbers handled by the work-item.
+    */
+   const unsigned int block_offset = ((work_item_index & ~(lowest_distance - 1)) << num_levels) |
+                                                        (work_item_index & (lowest_distance - 1));
+   ARRAY_TYPE block_elements[MAX_REGISTER_BLOCK_LENGTH];
+
+   #pragma unroll
+   for (unsigned int block_index = 0; block_index < block_length; ++block_index) {
+      if (block_offset + block_index * lowest_distance < array_length) {
+         block_elements[block_index] = input_array[block_offset + block_index * lowest_distance];
+      }
+   }
+
+   /*
+    * Same merge steps as performed by the "naive_bitonic_sort_merge_step" kernel, but with
+    * compare distances expressed in terms of positions within "block_elements".
+    */
+   #pragma unroll
+   for (unsigned int block_distance = block_length / 2; block_distance > 0; block_distance /= 2) {
+      #pragma unroll
+      for (unsigned int block_index = 0; block_index < block_length; ++block_index) {
+         if (((block_index & block_distance) == 0) &&
+                  (block_offset + (block_index | block_distance) * lowest_distance < array_length)) {
+            const ARRAY_TYPE lower_element = block_elements[block_index];
+            const ARRAY_TYPE upper_element = block_elements[block_index | block_distance];
+            if (bitonic_elements_need_swap(lower_element, upper_element)) {
+               block_elements[block_index] = upper_element;
+               block_elements[block_index | block_distance] = lower_element;
+            }
+         }
+      }
+   }
+
+   #pragma unroll
+   for (unsigned int block_index = 0; block_index < block_length; ++block_index) {
+      if (block_offset + block_index * lowest_distance < array_length) {
+         input_array[block_offset + block_index * lowest_distance] = block_elements[block_index];
+      }
+   }
+}
+
+/*
+ * Register-blocked merge kernels performing 2, 3 and 4 consecutive merge steps per launch
+ * respectively (i.e. 4, 8 and 16 numbers per work-item); each kernel only needs to be launched
+ * with 1/4th, 1/8th and 1/16th as many work-items as the array length rounded up to the next
+ * power of 2 respectively. Same kernel arguments as the "naive_bitonic_sort_merge_step" kernel,
+ * where "compare_distance" is the compare distance of the first of the merge steps performed.
+ */
+__kernel void register_bitonic_sort_merge_steps_4(__global ARRAY_TYPE* input_array, const unsigned int array_length,
+                                                                                    const unsigned int compare_distance,
+                                                                                    const unsigned int partition_size)
+{
+   register_bitonic_sort_merge_steps(input_array, array_length, 2, compare_distance);
+}
+
+__kernel void register_bitonic_sort_merge_steps_8(__global ARRAY_TYPE* input_array, const unsigned int array_length,
+                                                                                    const unsigned int compare_distance,
+                                                                                    const unsigned int partition_size)
+{
+   register_bitonic_sort_merge_steps(input_array, array_length, 3, compare_distance);
+}
+
+__kernel void register_bitonic_sort_merge_steps_16(__global ARRAY_TYPE* input_array, const unsigned int array_length,
+                                                                                     const unsigned int compare_distance,
+                                                                                     const unsigned int partition_size)
+{
+   register_bitonic_sort_merge_steps(input_array, array_length, 4, compare_distance);
+}
+
+/*
+ * Merge path (i.e. co-rank) merge of sorted runs, an alternative to the merge steps of all partition
+ * sizes larger than a tile: every launch merges each pair of adjacent sorted runs of "run_length"
+ * numbers into a single sorted run of twice that length, reading from one buffer and writing into
+ * another, so that runs double in length with every launch instead of with every partition size's
+ * worth of merge steps. Refer to the following for the method:
+ *   - https://doi.org/10.1145/2304576.2304629 (Merge Path - A Visually Intuitive Approach to Parallel Merging)
+ *   - https://moderngpu.github.io/merge.html
+ */
+
+/*
+ * Returns the co-rank of "diagonal" within the merge of the sorted runs "first_run" of "first_length"
+ * numbers and "second_run" of "second_length" numbers, i.e. how many of the first "diagonal" numbers
+ * of the merged run come from "first_run"; numbers of "first_run" go before equal numbers of
+ * "second_run". Binary search along the cross diagonal of the merge path, reading O(log(diagonal))
+ * numbers.
+ */
+inline unsigned int merge_path_co_rank(__global const ARRAY_TYPE* first_run, const unsigned int first_length,
+                                         __global const ARRAY_TYPE* second_run, const unsigned int second_length,
+                                                                                 const unsigned int diagonal)
+{
+   unsigned int lower_rank = (diagonal > second_length) ? (diagonal - second_length) : 0;
+   unsigned int upper_rank = min(diagonal, first_length);
+   while (lower_rank < upper_rank) {
+      const unsigned int middle_rank = (lower_rank + upper_rank) / 2;
+      // The number of the first run goes before the number of the second run across the diagonal
+      if (!bitonic_elements_need_swap(first_run[middle_rank], second_run[diagonal - middle_rank - 1])) {
+         lower_rank = middle_rank + 1;
+      } else {
+         upper_rank = middle_rank;
+      }
+   }
+   return lower_rank;
+}
+
+// Same as "merge_path_co_rank" above, for runs held within local memory
+inline unsigned int local_merge_path_co_rank(__local const ARRAY_TYPE* first_run, const unsigned int first_length,
+                                               __local const ARRAY_TYPE* second_run,
+                                                 const unsigned int second_length, const unsigned int diagonal)
+{
+   unsigned int lower_rank = (diagonal > second_length) ? (diagonal - second_length) : 0;
+   unsigned int upper_rank = min(diagonal, first_length);
+   while (lower_rank < upper_rank) {
+      const unsigned int middle_rank = (lower_rank + upper_rank) / 2;
+      if (!bitonic_elements_need_swap(first_run[middle_rank], second_run[diagonal - middle_rank - 1])) {
+         lower_rank = middle_rank + 1;
+      } else {
+         upper_rank = middle_rank;
+      }
+   }
+   return lower_rank;
+}
+
+/*
+ * Merges every pair of adjacent sorted runs of "run_length" numbers (a power of 2) of "input_array"
+ * into "output_array"; the last pair may be partial, or only have a first run. Each workgroup writes
+ * a tile of "elements_per_work_item" numbers per work-item of the merged runs, where tiles MUST be a
+ * power of 2 no longer than twice the run length, so that no tile straddles two pairs of runs. The
+ * co-ranks of both ends of the tile within its pair of runs are found with binary searches first,
+ * which gives the parts of both runs that merge into the tile; those get copied into local memory,
+ * where every work-item then finds the co-rank of its own part of the tile and merges it sequentially.
+ * The "local_tile" buffer MUST be able to hold "2 * elements_per_work_item * get_local_size(0)"
+ * numbers (the parts of the runs, followed by the merged tile), and "tile_co_ranks" 2 indices.
+ * Workgroups whose tiles start at or beyond "array_length" do nothing, so the number of workgroups
+ * launched may be rounded up.
+ */
+__kernel void merge_path_merge_runs(__global const ARRAY_TYPE* input_array, __global ARRAY_TYPE* output_array,
+                                      __local ARRAY_TYPE* local_tile, __local unsigned int* tile_co_ranks,
+                                                                            const unsigned int array_length,
+                                                                              const unsigned int run_length,
+                                                                  const unsigned int elements_per_work_item)
+{
+   // See "naive_bitonic_sort_merge_step" kernel for explanation of this value
+   const unsigned int first_dimension_num = 0;
+
+   const unsigned int local_index = get_local_id(first_dimension_num);
+   const unsigned int workgroup_size = get_local_size(first_dimension_num);
+   const unsigned int tile_size = workgroup_size * elements_per_work_item;
+   const unsigned int tile_offset = get_group_id(first_dimension_num) * tile_size;
+   // Whole workgroups return at once, so every barrier below is reached by all work-items or none
+   if (tile_offset >= array_length) {
+      return;
+   }
+   const unsigned int tile_length = min(tile_size, array_length - tile_offset);
+
+   // Both runs of the pair the tile belongs to, and the diagonal at which the tile starts within them
+   const unsigned int pair_offset = tile_offset & ~(2 * run_length - 1);
+   const unsigned int first_length = min(run_length, array_length - pair_offset);
+   const unsigned int second_length = min(run_length, array_length - pair_offset - first_length);
+   __global const ARRAY_TYPE* first_run = input_array + pair_offset;
+   __global const ARRAY_TYPE* second_run = first_run + first_length;
+   const unsigned int tile_diagonal = tile_offset - pair_offset;
+
+   /*
+    * Both ends of the tile go through the same search, so the end of each tile is exactly the start of
+    * the next one and every number lands in exactly one tile. As every comparison agrees with a single
+    * order (NaNs included), co-ranks never decrease along the merge path, and so neither part of the
+    * tile can be of negative length.
+    */
+   for (unsigned int end_index = local_index; end_index < 2; end_index += workgroup_size) {
+      tile_co_ranks[end_index] = merge_path_co_rank(first_run, first_length, second_run, second_length,
+                                                      tile_diagonal + end_index * tile_length);
+   }
+   barrier(CLK_LOCAL_MEM_FENCE);
+   const unsigned int first_offset = tile_co_ranks[0];
+   const unsigned int tile_first_length = tile_co_ranks[1] - first_offset;
+   const unsigned int second_offset = tile_diagonal - first_offset;
+
+   // Copy the parts of both runs merging into the tile one after the other into local memory
+   for (unsigned int tile_index = local_index; tile_index < tile_length; tile_index += workgroup_size) {
+      local_tile[tile_index] = (tile_index < tile_first_length) ? first_run[first_offset + tile_index] :
+                                                 second_run[second_offset + tile_index - tile_first_length];
+   }
+   barrier(CLK_LOCAL_MEM_FENCE);
+
+   __local const ARRAY_TYPE* tile_first_run = local_tile;
+   __local const ARRAY_TYPE* tile_second_run = local_tile + tile_first_length;
+   const unsigned int tile_second_length = tile_length - tile_first_length;
+   __local ARRAY_TYPE* merged_tile = local_tile + tile_size;
+   const unsigned int merge_start = local_index * elements_per_work_item;
+   if (merge_start < tile_length) {
+      unsigned int first_index = local_merge_path_co_rank(tile_first_run, tile_first_length, tile_second_run,
+                                                            tile_second_length, merge_start);
+      unsigned int second_index = merge_start - first_index;
+      const unsigned int merge_end = min(merge_start + elements_per_work_item, tile_length);
+      for (unsigned int merged_index = merge_start; merged_index < merge_end; ++merged_index) {
+         // Numbers of the second run are only taken when they go strictly before those of the first run
+         if ((second_index < tile_second_length) && ((first_index == tile_first_length) ||
+                bitonic_elements_need_swap(tile_first_run[first_index], tile_second_run[second_index]))) {
+            merged_tile[merged_index] = tile_second_run[second_index++];
+         } else {
+            merged_tile[merged_index] = tile_first_run[first_index++];
+         }
+      }
+   }
+   barrier(CLK_LOCAL_MEM_FENCE);
+
+   // Copy the merged tile out to global memory, with consecutive work-items writing consecutive numbers
+   for (unsigned int tile_index = local_index; tile_index < tile_length; tile_index += workgroup_size) {
+      output_array[tile_offset + tile_index] = merged_tile[tile_index];
+   }
+}
+
+/*
+ * Segmented variants of the kernels above, sorting many independent segments of the same array at
+ * once; segment "i" consists of the numbers at indices "segment_offsets[i]" up to but not including
+ * "segment_offsets[i + 1]". Every launch only handles the "num_slots" segments listed within
+ * "segment_list" from "first_slot" onwards, all of which MUST be of lengths whose next power of 2
+ * is "slot_length". These segments are laid out one after another within a "virtual" array where
+ * each segment takes up a slot of "slot_length" positions, so the bitonic sorting network of each
+ * segment is the same as that of an array of "slot_length" numbers; as long as partition sizes
+ * never exceed "slot_length", no comparator ever crosses from one slot into another. Positions at
+ * or beyond the length of the segment of each slot are treated like indices at or beyond the array
+ * length (see notes at top of file), so segments are never padded.
+ */
+
+/*
+ * Writes the index within the array of the number at "virtual_index" into "array_index", and
+ * returns whether that number is within its segment (false for slots beyond the last one).
+ */
+inline bool segmented_array_index(__global const unsigned int* segment_offsets,
+                                    __global const unsigned int* segment_list, const unsigned int first_slot,
+                                      const unsigned int num_slots, const unsigned int slot_length,
+                                        const unsigned int virtual_index, unsigned int* array_index)
+{
+   const unsigned int slot = virtual_index / slot_length;
+   if (slot >= num_slots) {
+      return false;
+   }
+   const unsigned int segment = segment_list[first_slot + slot];
+   *array_index = segment_offsets[segment] + (virtual_index & (slot_length - 1));
+   return *array_index < segment_offsets[segment + 1];
+}
+
+/*
+ * Segmented variant of the "local_bitonic_sort_merge_steps" kernel, where each workgroup loads the
+ * tile of "2 * get_local_size(0)" positions of the virtual array above into local memory; a tile
+ * holds several whole slots if slots are shorter than a tile, so each workgroup sorts as many
+ * segments at once, and otherwise holds part of a single slot. "segment_lengths" MUST be able to
+ * hold the length of every slot within a tile (i.e. at least one, and "2 * get_local_size(0) /
+ * slot_length" if larger), and "last_partition_size" MUST NOT exceed "slot_length".
+ */
+__kernel void segmented_bitonic_sort_merge_steps(__global ARRAY_TYPE* input_array, __local ARRAY_TYPE* local_tile,
+                                                   __local unsigned int* segment_lengths,
+                                                     __global const unsigned int* segment_offsets,
+                                                       __global const unsigned int* segment_list,
+                                                         const unsigned int first_slot, const unsigned int num_slots,
+                                                           const unsigned int slot_length,
+                                                             const unsigned int compare_distance,
+                                                               const unsigned int partition_size,
+                                                                 const unsigned int last_partition_size)
+{
+   // See "naive_bitonic_sort_merge_step" kernel for explanation of this value
+   const unsigned int first_dimension_num = 0;
+
+   const unsigned int local_index = get_local_id(first_dimension_num);
+   const unsigned int workgroup_size = get_local_size(first_dimension_num);
+   const unsigned int tile_length = 2 * workgroup_size;
+   /* Position within the virtual array at which the tile of the current workgroup starts. */
+   const unsigned int tile_offset = get_group_id(first_dimension_num) * tile_length;
+   /* First slot within the tile, and number of slots within the tile. */
+   const unsigned int tile_first_slot = tile_offset / slot_length;
+   const unsigned int tile_num_slots = (slot_length < tile_length) ? (tile_length / slot_length) : 1;
+
+   // Lengths of the segments of the tile are needed by every merge step, so they get loaded once
+   if (local_index < tile_num_slots) {
+      const unsigned int slot = tile_first_slot + local_index;
+      segment_lengths[local_index] = 0;
+      if (slot < num_slots) {
+         const unsigned int segment = segment_list[first_slot + slot];
+         segment_lengths[local_index] = segment_offsets[segment + 1] - segment_offsets[segment];
+      }
+   }
+
+   // Each work-item copies up to two numbers from global memory into the tile in local memory
+   unsigned int array_indices[2];
+   bool within_segment[2];
+   for (unsigned int half = 0; half < 2; ++half) {
+      within_segment[half] = segmented_array_index(segment_offsets, segment_list, first_slot, num_slots,
+                                                     slot_length, tile_offset + local_index + half * workgroup_size,
+                                                                                             &array_indices[half]);
+      if (within_segment[half]) {
+         local_tile[local_index + half * workgroup_size] = input_array[array_indices[half]];
+      }
+   }
+   barrier(CLK_LOCAL_MEM_FENCE);
+
+   unsigned int curr_compare_distance = compare_distance;
+   for (unsigned int curr_partition_size = partition_size; curr_partition_size <= last_partition_size;
+                                                                                curr_partition_size *= 2) {
+      for (; curr_compare_distance > 0; curr_compare_distance /= 2) {
+         // See "local_bitonic_sort_merge_steps" kernel for how the pair of numbers gets chosen
+         const unsigned int lower_index = ((local_index & ~(curr_compare_distance - 1)) << 1) |
+                                                     (local_index & (curr_compare_distance - 1));
+         const unsigned int upper_index = bitonic_upper_index(lower_index, curr_compare_distance,
+                                                                            curr_partition_size);
+
+         /*
+          * Both numbers are within the same slot, and the lower one is within the segment
+          * whenever the upper one is.
+          */
+         const unsigned int upper_slot = (slot_length < tile_length) ? (upper_index / slot_length) : 0;
+         if (((tile_offset + upper_index) & (slot_length - 1)) < segment_lengths[upper_slot]) {
+            const ARRAY_TYPE lower_element = local_tile[lower_index];
+            const ARRAY_TYPE upper_element = local_tile[upper_index];
+
+            // Swap numbers as necessary
+            if (bitonic_elements_need_swap(lower_element, upper_element)) {
+               local_tile[lower_index] = upper_element;
+               local_tile[upper_index] = lower_element;
+            }
+         }
+         barrier(CLK_LOCAL_MEM_FENCE);
+      }
+      // First compare distance of the next partition size is half of that partition size.
+      curr_compare_distance = curr_partition_size;
+   }
+
+   // Copy sorted tile back out to global memory
+   for (unsigned int half = 0; half < 2; ++half) {
+      if (within_segment[half]) {
+         input_array[array_indices[half]] = local_tile[local_index + half * workgroup_size];
+      }
+   }
+}
+
+/*
+ * Segmented variant of the "half_bitonic_sort_merge_step" kernel for compare distances too large
+ * to fit within a tile, where several workgroups cooperate on each slot; launched with one work-item
+ * per pair of positions of the virtual array above (i.e. "num_slots * slot_length / 2" work-items,
+ * which may be rounded up to a multiple of the workgroup size). "partition_size" MUST NOT exceed
+ * "slot_length".
+ */
+__kernel void segmented_bitonic_sort_merge_step(__global ARRAY_TYPE* input_array,
+                                                  __global const unsigned int* segment_offsets,
+                                                    __global const unsigned int* segment_list,
+                                                      const unsigned int first_slot, const unsigned int num_slots,
+                                                        const unsigned int slot_length,
+                                                          const unsigned int compare_distance,
+                                                            const unsigned int partition_size)
+{
+   // See "naive_bitonic_sort_merge_step" kernel for explanation of this value
+   const unsigned int first_dimension_num = 0;
+   const unsigned int work_item_index = get_global_id(first_dimension_num);
+
+   // See "half_bitonic_sort_merge_step" kernel for how the pair of numbers gets chosen
+   const unsigned int lower_index = ((work_item_index & ~(compare_distance - 1)) << 1) |
+                                               (work_item_index & (compare_distance - 1));
+   const unsigned int upper_index = bitonic_upper_index(lower_index, compare_distance, partition_size);
+
+   /*
+    * Both numbers are within the same slot, and the lower one is within the segment whenever
+    * the upper one is.
+    */
+   const unsigned int slot = lower_index / slot_length;
+   if (slot < num_slots) {
+      const unsigned int segment = segment_list[first_slot + slot];
+      const unsigned int segment_start = segment_offsets[segment];
+      const unsigned int upper_array_index = segment_start + (upper_index & (slot_length - 1));
+
+      if (upper_array_index < segment_offsets[segment + 1]) {
+         const unsigned int lower_array_index = segment_start + (lower_index & (slot_length - 1));
+         const ARRAY_TYPE lower_element = input_array[lower_array_index];
+         const ARRAY_TYPE upper_element = input_array[upper_array_index];
+
+         // Swap numbers as necessary
+         if (bitonic_elements_need_swap(lower_element, upper_element)) {
+            input_array[lower_array_index] = upper_element;
+            input_array[upper_array_index] = lower_element;
+         }
+      }
+   }
+}
+
+/*
+ * Top-K reduction kernel: given an array of "array_length" numbers made up of blocks of "block_length"
+ * numbers (a power of 2) each sorted on its own (the last block may be partial), keeps the numbers
+ * coming first in the sorting order of each pair of blocks, writing them into "output_array" as one
+ * block per pair of blocks. This is the first merge step of the partition size twice as long as a
+ * block (i.e. comparing mirrored positions of both blocks), with the losing half of each partition
+ * thrown away instead of sorted; each block of the output is then a bitonic sequence, which the
+ * half-cleaners of the block length sort (see "local_bitonic_sort_merge_steps" kernel). One work-item
+ * per number of the output; work-items beyond the output do nothing, so the number of work-items may be
+ * rounded up to a multiple of the workgroup size. The output holds a whole block for every pair of
+ * blocks, except that a last block without a partner is copied over as it is.
+ */
+__kernel void top_k_bitonic_reduce(__global const ARRAY_TYPE* input_array, __global ARRAY_TYPE* output_array,
+                                                                         const unsigned int array_length,
+                                                                         const unsigned int block_length)
+{
+   // See "naive_bitonic_sort_merge_step" kernel for explanation of this value
+   const unsigned int first_dimension_num = 0;
+   const unsigned int output_index = get_global_id(first_dimension_num);
+
+   /*
+    * Index of the number of the first block of the pair, and index of the number mirroring it
+    * within the second block of the pair.
+    */
+   const unsigned int lower_index = ((output_index & ~(block_length - 1)) << 1) | (output_index & (block_length - 1));
+   const unsigned int upper_index = bitonic_upper_index(lower_index, block_length, 2 * block_length);
+
+   if (lower_index < array_length) {
+      ARRAY_TYPE winner = input_array[lower_index];
+      if (upper_index < array_length) {
+         const ARRAY_TYPE upper_element = input_array[upper_index];
+         if (bitonic_elements_need_swap(winner, upper_element)) {
+            winner = upper_element;
+         }
+      }
+      output_array[output_index] = winner;
+   }
+}
+
+/*
+ * Key-value variants of the kernels above, only compiled when the host asks for a payload type
+ * (i.e. "-DPAYLOAD_TYPE=uint" or "-DPAYLOAD_TYPE=ulong"). The array being sorted holds the keys,
+ * and "payload_array" is a separate array of the same length (i.e. structure of arrays) whose
+ * numbers are moved along with their keys, so that every swap of two keys also swaps the two
+ * numbers at the same indices of "payload_array". Kernel arguments are the same as the keys-only
+ * kernels, with the payload-related arguments appended at the end.
+ */
+#ifdef PAYLOAD_TYPE
+
+// Same as the "half_bitonic_sort_merge_step" kernel, except that payloads are moved along with keys
+__kernel void half_bitonic_sort_merge_step_by_key(__global ARRAY_TYPE* input_array,
+                                                      const unsigned int array_length,
+                                                       const unsigned int compare_distance,
+                                                         const unsigned int partition_size,
+                                                           __global PAYLOAD_TYPE* payload_array)
+{
+   // See "naive_bitonic_sort_merge_step" kernel for explanation of this value
+   const unsigned int first_dimension_num = 0;
+   const unsigned int work_item_index = get_global_id(first_dimension_num);
+
+   // See "half_bitonic_sort_merge_step" kernel for explanation of these values
+   const unsigned int lower_index = ((work_item_index & ~(compare_distance - 1)) << 1) |
+                                               (work_item_index & (compare_distance - 1));
+   const unsigned int upper_index = bitonic_upper_index(lower_index, compare_distance, partition_size);
+
+   if (upper_index < array_length) {
+      const ARRAY_TYPE lower_element = input_array[lower_index];
+      const ARRAY_TYPE upper_element = input_array[upper_index];
+
+      // Swap keys and their payloads as necessary; payloads are only loaded if they have to move
+      if (bitonic_elements_need_swap(lower_element, upper_element)) {
+         const PAYLOAD_TYPE lower_payload = payload_array[lower_index];
+         input_array[lower_index] = upper_element;
+         input_array[upper_index] = lower_element;
+         payload_array[lower_index] = payload_array[upper_index];
+         payload_array[upper_index] = lower_payload;
+      }
+   }
+}
+
+/*
+ * Same as the "local_bitonic_sort_merge_steps" kernel, except that payloads are moved along with
+ * keys; "local_payload_tile" MUST be able to hold as many payloads as "local_tile" holds keys.
+ * If "generate_indices" is non-zero, payloads aren't loaded from "payload_array"; instead each
+ * key gets its own array index as its payload (i.e. sorting from scratch with "generate_indices"
+ * set produces the permutation sorting the array in "payload_array").
+ */
+__kernel void local_bitonic_sort_merge_steps_by_key(__global ARRAY_TYPE* input_array,
+                                                      __local ARRAY_TYPE* local_tile,
+                                                        const unsigned int array_length,
+                                                          const unsigned int compare_distance,
+                                                            const unsigned int partition_size,
+                                                              const unsigned int last_partition_size,
+                                                                __global PAYLOAD_TYPE* payload_array,
+                                                                  __local PAYLOAD_TYPE* local_payload_tile,
+                                                                    const unsigned int generate_indices)
+{
+   // See "local_bitonic_sort_merge_steps" kernel for explanation of these values
+   const unsigned int first_dimension_num = 0;
+   const unsigned int local_index = get_local_id(first_dimension_num);
+   const unsigned int workgroup_size = get_local_size(first_dimension_num);
+   const unsigned int tile_offset = get_group_id(first_dimension_num) * 2 * workgroup_size;
+
+   // Each work-item copies up to two keys and their payloads into the tiles in local memory
+   for (unsigned int tile_index = local_index; tile_index < 2 * workgroup_size; tile_index += workgroup_size) {
+      if (tile_offset + tile_index < array_length) {
+         local_tile[tile_index] = input_array[tile_offset + tile_index];
+         local_payload_tile[tile_index] = generate_indices ? (PAYLOAD_TYPE)(tile_offset + tile_index) :
+                                                                 payload_array[tile_offset + tile_index];
+      }
+   }
+   barrier(CLK_LOCAL_MEM_FENCE);
+
+   unsigned int curr_compare_distance = compare_distance;
+   for (unsigned int curr_partition_size = partition_size; curr_partition_size <= last_partition_size;
+                                                                                curr_partition_size *= 2) {
+      for (; curr_compare_distance > 0; curr_compare_distance /= 2) {
+         const unsigned int lower_index = ((local_index & ~(curr_compare_distance - 1)) << 1) |
+                                                     (local_index & (curr_compare_distance - 1));
+         const unsigned int upper_index = bitonic_upper_index(lower_index, curr_compare_distance,
+                                                                            curr_partition_size);
+
+         if (tile_offset + upper_index < array_length) {
+            const ARRAY_TYPE lower_element = local_tile[lower_index];
+            const ARRAY_TYPE upper_element = local_tile[upper_index];
+
+            // Swap keys and their payloads as necessary
+            if (bitonic_elements_need_swap(lower_element, upper_element)) {
+               const PAYLOAD_TYPE lower_payload = local_payload_tile[lower_index];
+               local_tile[lower_index] = upper_element;
+               local_tile[upper_index] = lower_element;
+               local_payload_tile[lower_index] = local_payload_tile[upper_index];
+               local_payload_tile[upper_index] = lower_payload;
+            }
+         }
+         barrier(CLK_LOCAL_MEM_FENCE);
+      }
+      curr_compare_distance = curr_partition_size;
+   }
+
+   // Copy sorted tiles back out to global memory
+   for (unsigned int tile_index = local_index; tile_index < 2 * workgroup_size; tile_index += workgroup_size) {
+      if (tile_offset + tile_index < array_length) {
+         input_array[tile_offset + tile_index] = local_tile[tile_index];
+         payload_array[tile_offset + tile_index] = local_payload_tile[tile_index];
+      }
+   }
+}
+
+#endif // PAYLOAD_TYPE
+
+/*
+ * Kernels of the LSD radix sort engine, which sorts the array by one digit of RADIX_DIGIT_BITS bits
+ * at a time, starting with the least significant digit; each pass launches the three kernels below
+ * in turn, and moves every number from one buffer into another in a stable way (i.e. numbers with
+ * the same digit stay in the same order). Every workgroup is made up of exactly RADIX_DIGIT_VALUES
+ * work-items (i.e. one work-item per digit value), and goes through "tiles_per_group" consecutive
+ * tiles of as many numbers, so each workgroup is responsible for one contiguous part of the array.
+ *
+ * Numbers are sorted by unsigned integer keys ordered the same way as the numbers (see
+ * "radix_sort_key"), so the data type of the numbers, passed by the host as a compiler option
+ * "ARRAY_TYPE_INDEX" (0 for char, 1 for int, 2 for long, 3 for float and 4 for double, i.e. the
+ * same values as ARRAY_TYPE within the host program), decides the type of the keys.
+ */
+#define RADIX_DIGIT_BITS 8
+#define RADIX_DIGIT_VALUES (1 << RADIX_DIGIT_BITS)
+
+#if (ARRAY_TYPE_INDEX == 0)
+  #define RADIX_KEY_TYPE uchar
+#elif (ARRAY_TYPE_INDEX == 1) || (ARRAY_TYPE_INDEX == 3)
+  #define RADIX_KEY_TYPE uint
+#else
+  #define RADIX_KEY_TYPE ulong
+#endif
+
+#if (ARRAY_TYPE_INDEX == 3) || (ARRAY_TYPE_INDEX == 4)
+
+/*
+ * Floating point numbers get keys giving a total order, the same as on the host (refer to
+ * "sortable_keys.h"): NaNs are made positive when sorting ascending and negative when sorting
+ * descending, so that they come last either way, and -0.0 comes before +0.0 when ascending.
+ */
+#if (ARRAY_TYPE_INDEX == 3)
+  #define FLOAT_KEY_SIGN_BIT 0x80000000u
+  #define FLOAT_KEY_EXPONENT_BITS 0x7F800000u
+  #define SORTABLE_INT_TYPE int
+  #define AS_FLOAT_KEY_BITS as_uint
+  #define AS_SORTABLE_INT as_int
+  #define AS_FLOAT as_float
+#else
+  #define FLOAT_KEY_SIGN_BIT 0x8000000000000000ul
+  #define FLOAT_KEY_EXPONENT_BITS 0x7FF0000000000000ul
+  #define SORTABLE_INT_TYPE long
+  #define AS_FLOAT_KEY_BITS as_ulong
+  #define AS_SORTABLE_INT as_long
+  #define AS_FLOAT as_double
+#endif
+
+/*
+ * Returns the unsigned integer key of floating point number "element" ordered the same way as the
+ * numbers when sorting ascending, without any branches; the bits get flipped entirely if negative
+ * (as larger magnitudes come first) and only their sign bit otherwise.
+ */
+inline RADIX_KEY_TYPE float_ascending_key(const ARRAY_TYPE element)
+{
+   RADIX_KEY_TYPE bits = AS_FLOAT_KEY_BITS(element);
+   const RADIX_KEY_TYPE is_nan = (bits & ~FLOAT_KEY_SIGN_BIT) > FLOAT_KEY_EXPONENT_BITS;
+#if (SORT_DESCENDING)
+   bits |= is_nan * FLOAT_KEY_SIGN_BIT;
+#else
+   bits &= ~(is_nan * FLOAT_KEY_SIGN_BIT);
+#endif
+   const RADIX_KEY_TYPE sign_mask = (RADIX_KEY_TYPE)0 - (bits >> (sizeof(RADIX_KEY_TYPE) * 8 - 1));
+   return bits ^ (sign_mask | FLOAT_KEY_SIGN_BIT);
+}
+
+/*
+ * Turns every floating point number of "input_array" in place into a signed integer of the same
+ * size, such that sorting the integers in the direction of this program puts the numbers in the
+ * total order above; work-items at or beyond "array_length" do nothing.
+ */
+__kernel void float_keys_to_sortable(__global ARRAY_TYPE* input_array, const unsigned int array_length)
+{
+   const unsigned int array_index = get_global_id(0);
+   if (array_index < array_length) {
+      const RADIX_KEY_TYPE key = float_ascending_key(input_array[array_index]);
+      ((__global SORTABLE_INT_TYPE*)input_array)[array_index] = AS_SORTABLE_INT(key ^ FLOAT_KEY_SIGN_BIT);
+   }
+}
+
+// Turns the signed integers of the "float_keys_to_sortable" kernel back into floating point numbers
+__kernel void sortable_to_float_keys(__global ARRAY_TYPE* input_array, const unsigned int array_length)
+{
+   const unsigned int array_index = get_global_id(0);
+   if (array_index < array_length) {
+      const RADIX_KEY_TYPE key = AS_FLOAT_KEY_BITS(((__global SORTABLE_INT_TYPE*)input_array)[array_index]) ^
+                                                                                         FLOAT_KEY_SIGN_BIT;
+      // Keys with the top bit set belong to positive numbers
+      const RADIX_KEY_TYPE sign_mask = (RADIX_KEY_TYPE)0 - (key >> (sizeof(RADIX_KEY_TYPE) * 8 - 1));
+      const RADIX_KEY_TYPE bits = key ^ (~sign_mask | FLOAT_KEY_SIGN_BIT);
+      input_array[array_index] = AS_FLOAT(bits);
+   }
+}
+
+#endif
+
+/*
+ * Returns the unsigned integer key of "element", such that sorting keys in ascending order puts
+ * numbers in the sorting order. The sign bit of signed integers gets flipped, and floating point
+ * numbers get the keys of "float_ascending_key"; keys are inverted when sorting descending.
+ */
+inline RADIX_KEY_TYPE radix_sort_key(const ARRAY_TYPE element)
+{
+#if (ARRAY_TYPE_INDEX == 0)
+   const RADIX_KEY_TYPE key = as_uchar(element) ^ (uchar)0x80;
+#elif (ARRAY_TYPE_INDEX == 1)
+   const RADIX_KEY_TYPE key = as_uint(element) ^ 0x80000000u;
+#elif (ARRAY_TYPE_INDEX == 2)
+   const RADIX_KEY_TYPE key = as_ulong(element) ^ 0x8000000000000000ul;
+#else
+   const RADIX_KEY_TYPE key = float_ascending_key(element);
+#endif
+#if (SORT_DESCENDING)
+   return (RADIX_KEY_TYPE)~key;
+#else
+   return key;
+#endif
+}
+
+// Returns the digit of "element" sorted by the pass of the radix sort whose digit starts at bit "shift"
+inline uint radix_sort_digit(const ARRAY_TYPE element, const uint shift)
+{
+   return (uint)(radix_sort_key(element) >> shift) & (RADIX_DIGIT_VALUES - 1);
+}
+
+/*
+ * Turns the RADIX_DIGIT_VALUES numbers within "values" into their exclusive prefix sum; MUST be
+ * called by every work-item of the workgroup. Returns the total of all numbers.
+ */
+inline uint radix_local_exclusive_scan(__local uint* values, const uint local_index)
+{
+   const uint own_value = values[local_index];
+   for (uint offset = 1; offset < RADIX_DIGIT_VALUES; offset *= 2) {
+      const uint addend = (local_index >= offset) ? values[local_index - offset] : 0;
+      barrier(CLK_LOCAL_MEM_FENCE);
+      values[local_index] += addend;
+      barrier(CLK_LOCAL_MEM_FENCE);
+   }
+   const uint total = values[RADIX_DIGIT_VALUES - 1];
+   barrier(CLK_LOCAL_MEM_FENCE);
+   values[local_index] -= own_value;
+   barrier(CLK_LOCAL_MEM_FENCE);
+   return total;
+}
+
+/*
+ * First kernel of each pass, counting how many numbers of the part of the array of each workgroup
+ * have each digit value; the counts go into "digit_counts" digit by digit, i.e. the count of digit
+ * "d" of workgroup "g" is at index "d * get_num_groups(0) + g".
+ */
+__kernel void radix_sort_count_digits(__global const ARRAY_TYPE* input_array, const unsigned int array_length,
+                                                                               const unsigned int shift,
+                                                                                 const unsigned int tiles_per_group,
+                                                                                   __global uint* digit_counts)
+{
+   const uint local_index = get_local_id(0);
+   const uint group_index = get_group_id(0);
+   const uint group_offset = group_index * tiles_per_group * RADIX_DIGIT_VALUES;
+   const uint group_end = min(group_offset + tiles_per_group * RADIX_DIGIT_VALUES, array_length);
+   __local uint local_counts[RADIX_DIGIT_VALUES];
+
+   local_counts[local_index] = 0;
+   barrier(CLK_LOCAL_MEM_FENCE);
+   for (uint array_index = group_offset + local_index; array_index < group_end; array_index += RADIX_DIGIT_VALUES) {
+      atomic_inc(&local_counts[radix_sort_digit(input_array[array_index], shift)]);
+   }
+   barrier(CLK_LOCAL_MEM_FENCE);
+   digit_counts[local_index * get_num_groups(0) + group_index] = local_counts[local_index];
+}
+
+/*
+ * Second kernel of each pass, launched as a single workgroup; turns the "num_groups" counts of each
+ * digit value within "digit_counts" (refer to "radix_sort_count_digits") into their exclusive prefix
+ * sum, i.e. the array index to which each workgroup moves its first number of each digit value.
+ * Each work-item sums the counts of its own digit value, and the sums then get scanned in local memory.
+ */
+__kernel void radix_sort_scan_digits(__global uint* digit_counts, const unsigned int num_groups)
+{
+   const uint local_index = get_local_id(0);
+   __global uint* own_counts = digit_counts + local_index * num_groups;
+   __local uint digit_totals[RADIX_DIGIT_VALUES];
+
+   uint digit_total = 0;
+   for (uint group_index = 0; group_index < num_groups; ++group_index) {
+      digit_total += own_counts[group_index];
+   }
+   digit_totals[local_index] = digit_total;
+   radix_local_exclusive_scan(digit_totals, local_index);
+
+   uint digit_offset = digit_totals[local_index];
+   for (uint group_index = 0; group_index < num_groups; ++group_index) {
+      const uint group_count = own_counts[group_index];
+      own_counts[group_index] = digit_offset;
+      digit_offset += group_count;
+   }
+}
+
+/*
+ * Last kernel of each pass, moving every number of "input_array" to its place within "output_array"
+ * given the offsets computed by "radix_sort_scan_digits", with the same workgroups as
+ * "radix_sort_count_digits". Each tile gets sorted by digit within local memory first (one split by
+ * each bit of the digit, which keeps numbers in order), so that the rank of each number among the
+ * numbers of the tile with the same digit is simply its distance from the first of them.
+ */
+__kernel void radix_sort_scatter(__global const ARRAY_TYPE* input_array, __global ARRAY_TYPE* output_array,
+                                                                           const unsigned int array_length,
+                                                                             const unsigned int shift,
+                                                                               const unsigned int tiles_per_group,
+                                                                                 __global const uint* digit_offsets)
+{
+   const uint local_index = get_local_id(0);
+   const uint group_index = get_group_id(0);
+   const uint group_offset = group_index * tiles_per_group * RADIX_DIGIT_VALUES;
+   const uint group_end = min(group_offset + tiles_per_group * RADIX_DIGIT_VALUES, array_length);
+   // Array index to which the next number of each digit value is moved
+   __local uint next_offsets[RADIX_DIGIT_VALUES];
+   // Tile of numbers with their digits, and tile index of the first number of each digit value
+   __local ARRAY_TYPE tile_elements[RADIX_DIGIT_VALUES];
+   __local uint tile_digits[RADIX_DIGIT_VALUES];
+   __local uint split_ranks[RADIX_DIGIT_VALUES];
+   __local uint digit_starts[RADIX_DIGIT_VALUES];
+
+   next_offsets[local_index] = digit_offsets[local_index * get_num_groups(0) + group_index];
+
+   for (uint tile_offset = group_offset; tile_offset < group_end; tile_offset += RADIX_DIGIT_VALUES) {
+      const uint tile_length = min(group_end - tile_offset, (uint)RADIX_DIGIT_VALUES);
       /*
-       * The next three lines of code determine whether or not to swap
-       * the number at array_index with the number at compare_distance_rotated_index
-       * within the array by identifying which part of the bitonic sequence
-       * each number is supposed to be during the next sorting step (i.e. merging
-       * the ascending and descending halves of a bitonic sequence into a larger
-       * monotonic sequence). This is done through bit-masking the array_index by
-       * the partition_size and then making the appropriate swaps based on where
-       * each number falls under the bit-masked result.
+       * Numbers beyond the array get the largest digit value; as they're at the end of the tile,
+       * they stay after every number of the array throughout the splits, and are never moved.
        */
-       unsigned int bitonic_sequence_part_indicator = array_index & partition_size;
-       // Negate sequence part indicator if sorting elements in descending order.
-       if (sort_direction) {
-               bitonic_sequence_part_indicator = ! bitonic_sequence_part_indicator;
-       }
-       /*
-        * Once the partition_size equals the length of the array being sorted,
-        * then half of the conditional statement as written below (either the half
-        * before the "or" operator or after the "or" operator depending on whether
-        * the array is to be sorted in ascending or descending order respectively)
-        * no longer applies (i.e. gets "cancelled out") to the bitonic sorting
-        * procedure, and so the sorting procedure concludes with using ONLY the other
-        * half of the conditional statement to merge together the ascending and
-        * descending halves of the *final* bitonic sequence in the array into a
-        * sorted array.
-        */
-       bool swap = (bitonic_sequence_part_indicator == monotonic_part_indicator &&
-                         input_array[array_index] > input_array[compare_distance_rotated_index]) ||
-                     (bitonic_sequence_part_indicator != monotonic_part_indicator &&
-                         input_array[array_index] <= input_array[compare_distance_rotated_index]);
+      ARRAY_TYPE element = 0;
+      uint digit = RADIX_DIGIT_VALUES - 1;
+      if (local_index < tile_length) {
+         element = input_array[tile_offset + local_index];
+         digit = radix_sort_digit(element, shift);
+      }
+
+      // Move every number with a cleared bit ahead of every number with a set bit, one bit at a time
+      for (uint bit = 0; bit < RADIX_DIGIT_BITS; ++bit) {
+         const uint bit_set = (digit >> bit) & 1;
+         split_ranks[local_index] = !bit_set;
+         const uint num_cleared = radix_local_exclusive_scan(split_ranks, local_index);
+         const uint tile_index = bit_set ? (num_cleared + local_index - split_ranks[local_index]) :
+                                                                           split_ranks[local_index];
+         tile_elements[tile_index] = element;
+         tile_digits[tile_index] = digit;
+         barrier(CLK_LOCAL_MEM_FENCE);
+         element = tile_elements[local_index];
+         digit = tile_digits[local_index];
+         barrier(CLK_LOCAL_MEM_FENCE);
+      }
 
-       // Swap numbers as necessary
-       if (swap) {
-           ARRAY_TYPE temp_var = input_array[array_index];
-           input_array[array_index] = input_array[compare_distance_rotated_index];
-           input_array[compare_distance_rotated_index] = temp_var;
+      // Find the first number of each digit value within the now sorted tile
+      const bool run_start = (local_index == 0) || (tile_digits[local_index - 1] != digit);
+      const bool run_end = (local_index + 1 == tile_length) || ((local_index + 1 < tile_length) &&
+                                                                   (tile_digits[local_index + 1] != digit));
+      if (run_start) {
+         digit_starts[digit] = local_index;
+      }
+      barrier(CLK_LOCAL_MEM_FENCE);
+      const uint digit_rank = local_index - digit_starts[digit];
+      if (local_index < tile_length) {
+         output_array[next_offsets[digit] + digit_rank] = element;
       }
+      barrier(CLK_LOCAL_MEM_FENCE);
+      // The last number of each digit value moves the offset of that digit past the numbers of the tile
+      if (run_end) {
+         next_offsets[digit] += digit_rank + 1;
+      }
+      barrier(CLK_LOCAL_MEM_FENCE);
    }
-   
 }
-
@@ -0,0 +1,15 @@
+/*
+ * File description:
+ *   Embeds the OpenCL program file (i.e. PROGRAM_FILE) within the executable as the
+ *   null-terminated string "bitonic_program_source", so that running the executable
+ *   doesn't depend on the working directory. The bytes of the program file are
+ *   generated into "bitonic_program_source.inc" by the makefile, which regenerates
+ *   them whenever the program file changes.
+ */
+
+#include "naive_bitonic_sort_opencl.h"
+
+const char bitonic_program_source[] = {
+#include "bitonic_program_source.inc"
+    0x00
+};
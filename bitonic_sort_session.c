@@ -0,0 +1,604 @@
+/*
+ * File description:
+ *   Persistent OpenCL bitonic sorting session; every OpenCL object is created at most
+ *   once per session (device buffers excepted, which are recreated whenever they grow),
+ *   so that sorting many arrays one after another only enqueues commands.
+ */
+
+#include "bitonic_sort_session.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include "multiway_merge.h"
+#include "bitonic_profile.h"
+#include "opencl_devices.h"
+#include "segmented_sort_opencl.h"
+#include "top_k_opencl.h"
+
+void init_bitonic_sort_session_on_device(struct Bitonic_Sort_Session* session, cl_platform_id platform,
+                                           cl_device_id device, const char* program_source,
+                                                                 const char* binary_cache_dir) {
+    // No null pointers allowed
+    assert(session != NULL);
+    assert(program_source != NULL);
+
+    cl_queue_properties queue_properties[] = { CL_QUEUE_PROPERTIES, CL_QUEUE_PROFILING_ENABLE, 0 };
+    cl_int func_error_code;
+
+    session->platform = platform;
+    session->device = device;
+    session->context = clCreateContext(NULL, 1, &(session->device), NULL, NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    session->queue = clCreateCommandQueueWithProperties(session->context, session->device,
+                                                          queue_properties, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    session->transfer_queue = clCreateCommandQueueWithProperties(session->context, session->device,
+                                                                   queue_properties, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    func_error_code = clGetDeviceInfo(session->device, CL_DEVICE_MAX_MEM_ALLOC_SIZE,
+                                        sizeof(session->max_alloc_size), &(session->max_alloc_size), NULL);
+    assert(func_error_code == CL_SUCCESS);
+    func_error_code = clGetDeviceInfo(session->device, CL_DEVICE_GLOBAL_MEM_SIZE,
+                                        sizeof(session->global_mem_size), &(session->global_mem_size), NULL);
+    assert(func_error_code == CL_SUCCESS);
+    init_bitonic_program_cache(&(session->program_cache), session->context, session->device,
+                                                                program_source, binary_cache_dir);
+
+    // No kernels are created and no buffers are allocated until they're needed
+    for (unsigned int array_type = 0; array_type < NUM_ARRAY_TYPES; ++array_type) {
+        for (unsigned int sorting_direction = 0; sorting_direction < NUM_SORTING_DIRECTIONS; ++sorting_direction) {
+            for (unsigned int payload_kind = 0; payload_kind < NUM_PAYLOAD_KINDS; ++payload_kind) {
+                session->kernels[array_type][sorting_direction][payload_kind].local_kernel = NULL;
+            }
+        }
+    }
+    for (unsigned int slot = 0; slot < NUM_BUFFER_POOL_SLOTS; ++slot) {
+        session->pooled_buffers[slot] = NULL;
+        session->pooled_buffer_sizes[slot] = 0;
+    }
+    for (unsigned int queue_index = 0; queue_index < NUM_ASYNC_QUEUES; ++queue_index) {
+        session->async_queues[queue_index] = clCreateCommandQueueWithProperties(session->context, session->device,
+                                                                                  queue_properties, &func_error_code);
+        assert(func_error_code == CL_SUCCESS);
+        session->async_buffers[queue_index] = NULL;
+        session->async_buffer_sizes[queue_index] = 0;
+        session->async_merge_buffers[queue_index] = NULL;
+        session->async_merge_buffer_sizes[queue_index] = 0;
+    }
+    session->next_async_queue = 0;
+}
+
+void init_bitonic_sort_session(struct Bitonic_Sort_Session* session, const char* platform_selector,
+                                 const char* device_selector, const char* program_source,
+                                                               const char* binary_cache_dir) {
+    cl_platform_id platform;
+    cl_device_id device;
+    select_opencl_device(platform_selector, device_selector, &platform, &device);
+    init_bitonic_sort_session_on_device(session, platform, device, program_source, binary_cache_dir);
+}
+
+void release_bitonic_sort_session(struct Bitonic_Sort_Session* session) {
+    // No null pointers allowed
+    assert(session != NULL);
+
+    for (unsigned int array_type = 0; array_type < NUM_ARRAY_TYPES; ++array_type) {
+        for (unsigned int sorting_direction = 0; sorting_direction < NUM_SORTING_DIRECTIONS; ++sorting_direction) {
+            for (unsigned int payload_kind = 0; payload_kind < NUM_PAYLOAD_KINDS; ++payload_kind) {
+                struct Bitonic_Kernels* kernels = &(session->kernels[array_type][sorting_direction][payload_kind]);
+                if (kernels->local_kernel != NULL) {
+                    release_bitonic_kernels(kernels);
+                }
+            }
+        }
+    }
+    for (unsigned int slot = 0; slot < NUM_BUFFER_POOL_SLOTS; ++slot) {
+        if (session->pooled_buffers[slot] != NULL) {
+            clReleaseMemObject(session->pooled_buffers[slot]);
+            session->pooled_buffers[slot] = NULL;
+            session->pooled_buffer_sizes[slot] = 0;
+        }
+    }
+    // Asynchronous sorts still running need their queues and buffers until they're finished
+    for (unsigned int queue_index = 0; queue_index < NUM_ASYNC_QUEUES; ++queue_index) {
+        clFinish(session->async_queues[queue_index]);
+        if (session->async_buffers[queue_index] != NULL) {
+            clReleaseMemObject(session->async_buffers[queue_index]);
+            session->async_buffers[queue_index] = NULL;
+            session->async_buffer_sizes[queue_index] = 0;
+        }
+        if (session->async_merge_buffers[queue_index] != NULL) {
+            clReleaseMemObject(session->async_merge_buffers[queue_index]);
+            session->async_merge_buffers[queue_index] = NULL;
+            session->async_merge_buffer_sizes[queue_index] = 0;
+        }
+        clReleaseCommandQueue(session->async_queues[queue_index]);
+    }
+    release_bitonic_program_cache(&(session->program_cache));
+    clReleaseCommandQueue(session->transfer_queue);
+    clReleaseCommandQueue(session->queue);
+    clReleaseContext(session->context);
+}
+
+struct Bitonic_Kernels* get_session_kernels(struct Bitonic_Sort_Session* session, const unsigned int array_type,
+                                              const unsigned int sorting_direction, const unsigned int payload_kind) {
+    // No null pointers allowed
+    assert(session != NULL);
+    // Make sure data type, sort_direction and kind of payload are of valid values
+    assert(array_type < NUM_ARRAY_TYPES);
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+    assert(payload_kind < NUM_PAYLOAD_KINDS);
+
+    struct Bitonic_Kernels* kernels = &(session->kernels[array_type][sorting_direction][payload_kind]);
+
+    if (kernels->local_kernel == NULL) {
+        create_bitonic_kernels(get_bitonic_program(&(session->program_cache), array_type,
+                                                     sorting_direction, payload_kind),
+                                 array_type, payload_kind, session->program_cache.workgroup_size, kernels);
+    }
+    /*
+     * The workgroup size, number of merge steps per launch and profile of the program cache may
+     * have changed since the kernels were created, and the workgroup size may be too large for
+     * the tiles of this data type and kind of payload.
+     */
+    kernels->workgroup_size = fit_bitonic_workgroup_size(kernels, session->device, array_type,
+                                                           session->program_cache.workgroup_size);
+    kernels->merge_levels_per_launch = session->program_cache.merge_levels_per_launch;
+    kernels->profile = session->program_cache.profile;
+    // Each sort attaches the merge buffer belonging to the command queue it's enqueued into
+    kernels->merge_buffer = NULL;
+
+    return kernels;
+}
+
+/*
+ * Grows "buffer" of "session" (currently of "curr_buffer_size" bytes) to at least "buffer_size"
+ * bytes if it's smaller than that, by at least BUFFER_POOL_GROWTH_FACTOR without exceeding the
+ * maximum size of each buffer on the device. Commands already enqueued keep using the old buffer,
+ * which OpenCL only deletes once they're finished.
+ */
+static void grow_session_buffer(struct Bitonic_Sort_Session* session, cl_mem* buffer, size_t* curr_buffer_size,
+                                  const size_t buffer_size) {
+    if (*curr_buffer_size < buffer_size) {
+        size_t grown_buffer_size = BUFFER_POOL_GROWTH_FACTOR * (*curr_buffer_size);
+        if (grown_buffer_size > session->max_alloc_size) {
+            grown_buffer_size = session->max_alloc_size;
+        }
+        if (grown_buffer_size < buffer_size) {
+            grown_buffer_size = buffer_size;
+        }
+        if (*buffer != NULL) {
+            clReleaseMemObject(*buffer);
+            *buffer = NULL;
+            *curr_buffer_size = 0;
+        }
+        cl_int func_error_code;
+        *buffer = clCreateBuffer(session->context, CL_MEM_READ_WRITE, grown_buffer_size, NULL, &func_error_code);
+        assert(func_error_code == CL_SUCCESS);
+        // Only a buffer that has actually been allocated counts towards the size of the pool
+        if (func_error_code == CL_SUCCESS) {
+            *curr_buffer_size = grown_buffer_size;
+        } else {
+            *buffer = NULL;
+        }
+    }
+}
+
+cl_mem* get_session_buffer(struct Bitonic_Sort_Session* session, const unsigned int slot, const size_t buffer_size) {
+    // No null pointers allowed
+    assert(session != NULL);
+    // Make sure slot is of valid value and the buffer isn't empty nor too large for the device
+    assert(slot < NUM_BUFFER_POOL_SLOTS);
+    assert(buffer_size > 0);
+    assert(buffer_size <= session->max_alloc_size);
+
+    grow_session_buffer(session, &(session->pooled_buffers[slot]), &(session->pooled_buffer_sizes[slot]), buffer_size);
+
+    return &(session->pooled_buffers[slot]);
+}
+
+void bitonic_session_sort(struct Bitonic_Sort_Session* session, void* data, const unsigned int array_length,
+                            const unsigned int array_type, const unsigned int sorting_direction) {
+    // No null pointers allowed
+    assert(session != NULL);
+    assert(data != NULL);
+    // Array length HAS to be at least 1
+    assert(array_length >= 1);
+
+    struct Bitonic_Kernels* kernels = get_session_kernels(session, array_type, sorting_direction, NO_PAYLOAD);
+    const size_t data_size = array_length * get_array_type_size(array_type);
+    cl_mem* buffer_in = get_session_buffer(session, KEY_BUFFER_SLOT, data_size);
+    use_program_cache_merge_buffer(&(session->program_cache), kernels, array_length, array_type);
+
+    /*
+     * The command queue executes commands in order, so the blocking read at the end
+     * waits for the copy to the device and all sorting to be finished as well.
+     */
+    struct Bitonic_Profile* profile = session->program_cache.profile;
+    clEnqueueWriteBuffer(session->queue, *buffer_in, CL_NON_BLOCKING, CL_BUFFER_OFFSET, data_size, data, 0, NULL,
+                           add_profiled_command(profile, PROFILED_UPLOAD, 0, 0, 0, data_size));
+    enqueue_bitonic_sort(&(session->queue), kernels, buffer_in, NULL, array_length, array_type, 0);
+    clEnqueueReadBuffer(session->queue, *buffer_in, CL_BLOCKING, CL_BUFFER_OFFSET, data_size, data, 0, NULL,
+                          add_profiled_command(profile, PROFILED_READBACK, 0, 0, 0, data_size));
+}
+
+void bitonic_session_sort_by_key(struct Bitonic_Sort_Session* session, void* keys, void* payload,
+                                   const unsigned int array_length, const unsigned int array_type,
+                                     const unsigned int payload_kind, const unsigned int generate_indices,
+                                                                       const unsigned int sorting_direction) {
+    // No null pointers allowed
+    assert(session != NULL);
+    assert(keys != NULL);
+    assert(payload != NULL);
+    // Array length HAS to be at least 1
+    assert(array_length >= 1);
+    // Make sure there is a payload
+    assert((payload_kind == PAYLOAD_32_BIT) || (payload_kind == PAYLOAD_64_BIT));
+
+    struct Bitonic_Kernels* kernels = get_session_kernels(session, array_type, sorting_direction, payload_kind);
+    const size_t keys_size = array_length * get_array_type_size(array_type);
+    const size_t payload_size = array_length * get_payload_kind_size(payload_kind);
+    cl_mem* buffer_in = get_session_buffer(session, KEY_BUFFER_SLOT, keys_size);
+    cl_mem* buffer_payload = get_session_buffer(session, PAYLOAD_BUFFER_SLOT, payload_size);
+
+    // Generated indices overwrite the payloads, so the payloads don't need to be copied to the device
+    struct Bitonic_Profile* profile = session->program_cache.profile;
+    clEnqueueWriteBuffer(session->queue, *buffer_in, CL_NON_BLOCKING, CL_BUFFER_OFFSET, keys_size, keys, 0, NULL,
+                           add_profiled_command(profile, PROFILED_UPLOAD, 0, 0, 0, keys_size));
+    if (!generate_indices) {
+        clEnqueueWriteBuffer(session->queue, *buffer_payload, CL_NON_BLOCKING, CL_BUFFER_OFFSET, payload_size,
+                               payload, 0, NULL, add_profiled_command(profile, PROFILED_UPLOAD, 0, 0, 0, payload_size));
+    }
+    enqueue_bitonic_sort(&(session->queue), kernels, buffer_in, buffer_payload, array_length,
+                                                                  array_type, generate_indices);
+    clEnqueueReadBuffer(session->queue, *buffer_in, CL_NON_BLOCKING, CL_BUFFER_OFFSET, keys_size, keys, 0, NULL,
+                          add_profiled_command(profile, PROFILED_READBACK, 0, 0, 0, keys_size));
+    clEnqueueReadBuffer(session->queue, *buffer_payload, CL_BLOCKING, CL_BUFFER_OFFSET, payload_size, payload,
+                          0, NULL, add_profiled_command(profile, PROFILED_READBACK, 0, 0, 0, payload_size));
+}
+
+void bitonic_session_sort_segmented(struct Bitonic_Sort_Session* session, void* data,
+                                      const unsigned int* segment_offsets, const unsigned int num_segments,
+                                        const unsigned int array_type, const unsigned int sorting_direction) {
+    // No null pointers allowed
+    assert(session != NULL);
+    assert(data != NULL);
+    assert(segment_offsets != NULL);
+    // There HAS to be at least one segment, and at least one element in all segments together
+    assert(num_segments >= 1);
+    assert(segment_offsets[num_segments] >= 1);
+
+    const size_t data_size = segment_offsets[num_segments] * get_array_type_size(array_type);
+    cl_mem* buffer_in = get_session_buffer(session, KEY_BUFFER_SLOT, data_size);
+
+    // The segmented sort waits for all of its launches to finish, so only the read needs to block
+    struct Bitonic_Profile* profile = session->program_cache.profile;
+    clEnqueueWriteBuffer(session->queue, *buffer_in, CL_NON_BLOCKING, CL_BUFFER_OFFSET, data_size, data, 0, NULL,
+                           add_profiled_command(profile, PROFILED_UPLOAD, 0, 0, 0, data_size));
+    opencl_segmented_bitonic_sort(&(session->queue), &(session->program_cache), buffer_in, segment_offsets,
+                                    num_segments, array_type, sorting_direction);
+    clEnqueueReadBuffer(session->queue, *buffer_in, CL_BLOCKING, CL_BUFFER_OFFSET, data_size, data, 0, NULL,
+                          add_profiled_command(profile, PROFILED_READBACK, 0, 0, 0, data_size));
+}
+
+void bitonic_session_top_k(struct Bitonic_Sort_Session* session, const void* data, const unsigned int array_length,
+                             const unsigned int k, const unsigned int array_type,
+                               const unsigned int sorting_direction, void* top_k) {
+    // No null pointers allowed
+    assert(session != NULL);
+    assert(data != NULL);
+    assert(top_k != NULL);
+    // Array length and number of winners HAVE to be at least 1
+    assert(array_length >= 1);
+    assert(k >= 1);
+
+    const size_t data_size = array_length * get_array_type_size(array_type);
+    cl_mem* buffer_in = get_session_buffer(session, KEY_BUFFER_SLOT, data_size);
+
+    // The selection reads back its winners itself, blocking until it's finished
+    clEnqueueWriteBuffer(session->queue, *buffer_in, CL_NON_BLOCKING, CL_BUFFER_OFFSET, data_size, data, 0, NULL,
+                           add_profiled_command(session->program_cache.profile, PROFILED_UPLOAD, 0, 0, 0, data_size));
+    opencl_bitonic_top_k(&(session->queue), &(session->program_cache), buffer_in, array_length, k, array_type,
+                           sorting_direction, top_k);
+}
+
+cl_event bitonic_session_sort_async(struct Bitonic_Sort_Session* session, void* data,
+                                      const unsigned int array_length, const unsigned int array_type,
+                                        const unsigned int sorting_direction, const cl_uint num_wait_events,
+                                                                              const cl_event* wait_events) {
+    // No null pointers allowed, except for an empty list of events to wait for
+    assert(session != NULL);
+    assert(data != NULL);
+    assert((num_wait_events == 0) || (wait_events != NULL));
+    // Array length HAS to be at least 1
+    assert(array_length >= 1);
+
+    struct Bitonic_Kernels* kernels = get_session_kernels(session, array_type, sorting_direction, NO_PAYLOAD);
+    const size_t data_size = array_length * get_array_type_size(array_type);
+    assert(data_size <= session->max_alloc_size);
+
+    /*
+     * Each queue executes commands in order and has a buffer of its own, so sorts enqueued into the
+     * same queue never overwrite each other's data, while sorts in different queues may overlap.
+     */
+    const unsigned int queue_index = session->next_async_queue;
+    session->next_async_queue = (queue_index + 1) % NUM_ASYNC_QUEUES;
+    cl_command_queue* queue = &(session->async_queues[queue_index]);
+    cl_mem* buffer_in = &(session->async_buffers[queue_index]);
+    grow_session_buffer(session, buffer_in, &(session->async_buffer_sizes[queue_index]), data_size);
+    kernels->merge_buffer = grow_merge_buffer(session->context, &(session->async_merge_buffers[queue_index]),
+                                                &(session->async_merge_buffer_sizes[queue_index]),
+                                                  get_merge_buffer_size(kernels, array_length, array_type));
+
+    struct Bitonic_Profile* profile = session->program_cache.profile;
+    cl_event completion_event;
+    clEnqueueWriteBuffer(*queue, *buffer_in, CL_NON_BLOCKING, CL_BUFFER_OFFSET, data_size, data,
+                           num_wait_events, wait_events,
+                             add_profiled_command(profile, PROFILED_UPLOAD, 0, 0, 0, data_size));
+    enqueue_bitonic_sort(queue, kernels, buffer_in, NULL, array_length, array_type, 0);
+    clEnqueueReadBuffer(*queue, *buffer_in, CL_NON_BLOCKING, CL_BUFFER_OFFSET, data_size, data, 0, NULL,
+                          &completion_event);
+    // The event of the readback is returned to the caller, so the profile gets its own reference to it
+    cl_event* profiled_readback_event = add_profiled_command(profile, PROFILED_READBACK, 0, 0, 0, data_size);
+    if (profiled_readback_event != NULL) {
+        clRetainEvent(completion_event);
+        *profiled_readback_event = completion_event;
+    }
+    // Have the device start on the commands right away, instead of whenever the queue gets flushed next
+    clFlush(*queue);
+
+    return completion_event;
+}
+
+size_t get_session_max_run_length(struct Bitonic_Sort_Session* session, const unsigned int array_type) {
+    // No null pointers allowed
+    assert(session != NULL);
+
+    // Two buffers of runs are in use at the same time, along with the merge buffer of the merge path
+    cl_ulong max_run_size = session->global_mem_size / (UPPER_LEVELS_MERGE_PATH ? 3 : 2);
+    if (max_run_size > session->max_alloc_size) {
+        max_run_size = session->max_alloc_size;
+    }
+    size_t max_run_length = max_run_size / get_array_type_size(array_type);
+    if (max_run_length > MAX_CHUNKED_SORT_RUN_LENGTH) {
+        max_run_length = MAX_CHUNKED_SORT_RUN_LENGTH;
+    }
+    return max_run_length;
+}
+
+void bitonic_session_sort_chunked(struct Bitonic_Sort_Session* session, void* data, const size_t array_length,
+                                    const unsigned int array_type, const unsigned int sorting_direction,
+                                      const size_t max_run_length, const unsigned int num_merge_threads) {
+    // No null pointers allowed
+    assert(session != NULL);
+    assert(data != NULL);
+    // Array length HAS to be at least 1
+    assert(array_length >= 1);
+    // Runs can't be longer than the device can handle
+    assert(max_run_length <= get_session_max_run_length(session, array_type));
+
+    const size_t element_size = get_array_type_size(array_type);
+    const size_t run_length_limit = (max_run_length > 0) ? max_run_length :
+                                                get_session_max_run_length(session, array_type);
+    assert(run_length_limit >= 1);
+    const unsigned int num_runs = (array_length + run_length_limit - 1) / run_length_limit;
+
+    // No merging needed if the whole array fits within a single run
+    if (num_runs == 1) {
+        bitonic_session_sort(session, data, array_length, array_type, sorting_direction);
+        return;
+    }
+
+    // Spread elements evenly across all runs
+    const size_t run_length = (array_length + num_runs - 1) / num_runs;
+    size_t* run_offsets = malloc((num_runs + 1) * sizeof(size_t));
+    for (unsigned int run_index = 0; run_index <= num_runs; ++run_index) {
+        run_offsets[run_index] = (run_index * run_length < array_length) ? (run_index * run_length) : array_length;
+    }
+
+    struct Bitonic_Kernels* kernels = get_session_kernels(session, array_type, sorting_direction, NO_PAYLOAD);
+    cl_mem* run_buffers[2] = {
+        get_session_buffer(session, KEY_BUFFER_SLOT, run_length * element_size),
+        get_session_buffer(session, SECOND_KEY_BUFFER_SLOT, run_length * element_size)
+    };
+    // Runs are only ever sorted one after another, within the first command queue
+    use_program_cache_merge_buffer(&(session->program_cache), kernels, run_length, array_type);
+    // Events marking when each run has been uploaded to the device, and when it has been sorted
+    cl_event* uploaded_events = malloc(num_runs * sizeof(cl_event));
+    cl_event* sorted_events = malloc(num_runs * sizeof(cl_event));
+    char* data_bytes = (char*)data;
+
+    /*
+     * Both command queues execute commands in order. The transfer queue uploads run "i + 1" before
+     * reading back run "i", so that uploading run "i + 1" overlaps with sorting run "i"; the buffer
+     * of run "i + 1" was last used by run "i - 1", whose readback was enqueued into the transfer
+     * queue before the upload of run "i + 1".
+     */
+    clEnqueueWriteBuffer(session->transfer_queue, *run_buffers[0], CL_NON_BLOCKING, CL_BUFFER_OFFSET,
+                           run_offsets[1] * element_size, data_bytes, 0, NULL, &uploaded_events[0]);
+    for (unsigned int run_index = 0; run_index < num_runs; ++run_index) {
+        const size_t curr_run_length = run_offsets[run_index + 1] - run_offsets[run_index];
+        cl_mem* run_buffer = run_buffers[run_index % 2];
+
+        if (run_index + 1 < num_runs) {
+            const size_t next_run_length = run_offsets[run_index + 2] - run_offsets[run_index + 1];
+            clEnqueueWriteBuffer(session->transfer_queue, *run_buffers[(run_index + 1) % 2], CL_NON_BLOCKING,
+                                   CL_BUFFER_OFFSET, next_run_length * element_size,
+                                     data_bytes + run_offsets[run_index + 1] * element_size,
+                                                            0, NULL, &uploaded_events[run_index + 1]);
+        }
+
+        clEnqueueBarrierWithWaitList(session->queue, 1, &uploaded_events[run_index], NULL);
+        enqueue_bitonic_sort(&(session->queue), kernels, run_buffer, NULL, curr_run_length, array_type, 0);
+        clEnqueueMarkerWithWaitList(session->queue, 0, NULL, &sorted_events[run_index]);
+
+        clEnqueueReadBuffer(session->transfer_queue, *run_buffer, CL_NON_BLOCKING, CL_BUFFER_OFFSET,
+                              curr_run_length * element_size, data_bytes + run_offsets[run_index] * element_size,
+                                1, &sorted_events[run_index],
+                                  add_profiled_command(session->program_cache.profile, PROFILED_READBACK, 0, 0, 0,
+                                                         curr_run_length * element_size));
+        // The event of each upload is needed above, so the profile gets its own reference to it
+        cl_event* profiled_upload_event = add_profiled_command(session->program_cache.profile, PROFILED_UPLOAD,
+                                                                 0, 0, 0, curr_run_length * element_size);
+        if (profiled_upload_event != NULL) {
+            clRetainEvent(uploaded_events[run_index]);
+            *profiled_upload_event = uploaded_events[run_index];
+        }
+    }
+    clFinish(session->transfer_queue);
+    for (unsigned int run_index = 0; run_index < num_runs; ++run_index) {
+        clReleaseEvent(uploaded_events[run_index]);
+        clReleaseEvent(sorted_events[run_index]);
+    }
+
+    // Merge all sorted runs on the host
+    void* merged_data = malloc(array_length * element_size);
+    multiway_merge(data, run_offsets, num_runs, merged_data, array_type, sorting_direction, num_merge_threads);
+    memcpy(data, merged_data, array_length * element_size);
+
+    free(merged_data);
+    free(uploaded_events);
+    free(sorted_events);
+    free(run_offsets);
+}
+
+size_t get_session_max_workgroup_size(struct Bitonic_Sort_Session* session, const unsigned int array_type,
+                                        const unsigned int sorting_direction) {
+    // No null pointers allowed
+    assert(session != NULL);
+
+    struct Bitonic_Kernels* kernels = get_session_kernels(session, array_type, sorting_direction, NO_PAYLOAD);
+    size_t max_workgroup_size;
+    cl_int func_error_code = clGetDeviceInfo(session->device, CL_DEVICE_MAX_WORK_GROUP_SIZE,
+                                               sizeof(max_workgroup_size), &max_workgroup_size, NULL);
+    assert(func_error_code == CL_SUCCESS);
+
+    // Every register-blocked kernel may be launched, as well as the kernels working within tiles
+    for (unsigned int merge_levels = 0; merge_levels <= kernels->max_merge_levels + 1; ++merge_levels) {
+        cl_kernel kernel = (merge_levels == 0) ? kernels->local_kernel :
+                             (merge_levels <= kernels->max_merge_levels) ? kernels->register_kernels[merge_levels] :
+                                                                             kernels->merge_kernel;
+        if (kernel == NULL) {
+            continue;
+        }
+        size_t kernel_workgroup_size;
+        func_error_code = clGetKernelWorkGroupInfo(kernel, session->device, CL_KERNEL_WORK_GROUP_SIZE,
+                                                     sizeof(kernel_workgroup_size), &kernel_workgroup_size, NULL);
+        assert(func_error_code == CL_SUCCESS);
+        if (kernel_workgroup_size < max_workgroup_size) {
+            max_workgroup_size = kernel_workgroup_size;
+        }
+    }
+
+    // Tiles grow along with workgroups, so the tiles of larger workgroups may not fit within local memory
+    return fit_bitonic_workgroup_size(kernels, session->device, array_type, (unsigned int)max_workgroup_size);
+}
+
+// Returns the current time in seconds
+static double get_autotune_seconds(void) {
+    struct timespec current_time;
+    timespec_get(&current_time, TIME_UTC);
+    return current_time.tv_sec + current_time.tv_nsec / 1e9;
+}
+
+void autotune_bitonic_session(struct Bitonic_Sort_Session* session, const unsigned int array_length,
+                                const unsigned int array_type, const unsigned int sorting_direction,
+                                                                  struct Bitonic_Tuning* best_tuning) {
+    // No null pointers allowed
+    assert(session != NULL);
+    assert(best_tuning != NULL);
+    // Array length HAS to be at least 1
+    assert(array_length >= 1);
+
+    struct Bitonic_Kernels* kernels = get_session_kernels(session, array_type, sorting_direction, NO_PAYLOAD);
+    const size_t data_size = array_length * get_array_type_size(array_type);
+
+    // Upload random bits once; each timed sort sorts a fresh copy of them made on the device
+    unsigned char* random_data = malloc(data_size);
+    unsigned long long random_state = 0x9E3779B97F4A7C15ull;
+    for (size_t byte_index = 0; byte_index < data_size; ++byte_index) {
+        random_state ^= random_state << 13;
+        random_state ^= random_state >> 7;
+        random_state ^= random_state << 17;
+        random_data[byte_index] = (unsigned char)(random_state >> 56);
+    }
+    cl_mem* unsorted_buffer = get_session_buffer(session, SECOND_KEY_BUFFER_SLOT, data_size);
+    cl_mem* buffer_in = get_session_buffer(session, KEY_BUFFER_SLOT, data_size);
+    clEnqueueWriteBuffer(session->queue, *unsorted_buffer, CL_BLOCKING, CL_BUFFER_OFFSET, data_size,
+                           random_data, 0, NULL, NULL);
+    free(random_data);
+
+    /*
+     * Workgroup sizes smaller than the preferred multiple leave parts of each compute unit idle,
+     * so the smallest size tried is the preferred multiple (rounded up to a power of 2).
+     */
+    size_t preferred_multiple = 1;
+    clGetKernelWorkGroupInfo(kernels->local_kernel, session->device, CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE,
+                               sizeof(preferred_multiple), &preferred_multiple, NULL);
+    const size_t max_workgroup_size = get_session_max_workgroup_size(session, array_type, sorting_direction);
+    unsigned int min_workgroup_size = 1;
+    while ((min_workgroup_size < preferred_multiple) && (2 * min_workgroup_size <= max_workgroup_size)) {
+        min_workgroup_size *= 2;
+    }
+
+    double best_seconds = -1.0;
+    double run_seconds[AUTOTUNE_REPETITIONS];
+    struct Bitonic_Profile* profile = kernels->profile;
+    // Profiling would slow down every sort timed
+    kernels->profile = NULL;
+    for (unsigned int workgroup_size = min_workgroup_size; workgroup_size <= max_workgroup_size; workgroup_size *= 2) {
+        kernels->workgroup_size = workgroup_size;
+        // The runs the merge path starts off with grow along with the workgroup size
+        use_program_cache_merge_buffer(&(session->program_cache), kernels, array_length, array_type);
+        /*
+         * Along the merge path, every run sorted with the bitonic network fits within a single tile, so
+         * the merge steps per launch never come into play; only the default is timed (and stored) then.
+         */
+        const int uses_merge_path = (get_merge_buffer_size(kernels, array_length, array_type) > 0) &&
+                                      (kernels->merge_buffer != NULL);
+        const unsigned int min_merge_levels = uses_merge_path ? MAX_REGISTER_MERGE_LEVELS : 1;
+        const unsigned int max_merge_levels = uses_merge_path ? MAX_REGISTER_MERGE_LEVELS :
+                                                                  kernels->max_merge_levels;
+        for (unsigned int merge_levels = min_merge_levels; merge_levels <= max_merge_levels; ++merge_levels) {
+            kernels->merge_levels_per_launch = merge_levels;
+
+            // The first sort is untimed, so that the time of warming up the device isn't counted
+            for (int run = -1; run < AUTOTUNE_REPETITIONS; ++run) {
+                clEnqueueCopyBuffer(session->queue, *unsorted_buffer, *buffer_in, CL_BUFFER_OFFSET,
+                                      CL_BUFFER_OFFSET, data_size, 0, NULL, NULL);
+                clFinish(session->queue);
+                const double sort_start_time = get_autotune_seconds();
+                enqueue_bitonic_sort(&(session->queue), kernels, buffer_in, NULL, array_length, array_type, 0);
+                clFinish(session->queue);
+                if (run >= 0) {
+                    run_seconds[run] = get_autotune_seconds() - sort_start_time;
+                }
+            }
+
+            // Insertion sort of the few times measured, for their median
+            for (unsigned int run = 1; run < AUTOTUNE_REPETITIONS; ++run) {
+                const double curr_seconds = run_seconds[run];
+                unsigned int insert_index = run;
+                for (; (insert_index > 0) && (run_seconds[insert_index - 1] > curr_seconds); --insert_index) {
+                    run_seconds[insert_index] = run_seconds[insert_index - 1];
+                }
+                run_seconds[insert_index] = curr_seconds;
+            }
+            const double median_seconds = run_seconds[AUTOTUNE_REPETITIONS / 2];
+            printf(NOTIFY_USER_AUTOTUNE_PROGRESS, workgroup_size, merge_levels, median_seconds, AUTOTUNE_REPETITIONS);
+
+            if ((best_seconds < 0.0) || (median_seconds < best_seconds)) {
+                best_seconds = median_seconds;
+                best_tuning->workgroup_size = workgroup_size;
+                best_tuning->merge_levels_per_launch = merge_levels;
+            }
+        }
+    }
+    kernels->profile = profile;
+
+    // Every later sort of the session uses the fastest configuration
+    session->program_cache.workgroup_size = best_tuning->workgroup_size;
+    session->program_cache.merge_levels_per_launch = best_tuning->merge_levels_per_launch;
+    get_session_kernels(session, array_type, sorting_direction, NO_PAYLOAD);
+}
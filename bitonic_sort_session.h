@@ -0,0 +1,233 @@
+/*
+ * File description:
+ *   Header file for a persistent OpenCL bitonic sorting session, which owns every
+ *   OpenCL object needed for sorting (platform, device, context, command queue,
+ *   programs, kernels and device buffers) so that any number of arrays may be
+ *   sorted one after another without creating any OpenCL objects per sort.
+ */
+
+#ifndef BITONIC_SORT_SESSION_H
+#define BITONIC_SORT_SESSION_H
+
+#include "naive_bitonic_sort_opencl.h"
+#include "bitonic_tuning.h"
+
+/*
+ * Slots of the pool of device buffers owned by each session; each slot holds a
+ * single buffer which only ever grows, and is reused by every sort needing it.
+ */
+#define KEY_BUFFER_SLOT 0
+#define PAYLOAD_BUFFER_SLOT 1
+// Slot holding a second buffer of keys, so that one run may be uploaded while another is sorted
+#define SECOND_KEY_BUFFER_SLOT 2
+// Number of different slots of the pool of device buffers above
+#define NUM_BUFFER_POOL_SLOTS 3
+/*
+ * Number of in-order command queues across which "bitonic_session_sort_async" round-robins
+ * independent sorts, each queue with a device buffer of its own.
+ */
+#define NUM_ASYNC_QUEUES 2
+/*
+ * Factor by which buffers of the pool grow at least whenever they're too small,
+ * so that sorting arrays of slowly increasing lengths doesn't reallocate every time.
+ */
+#define BUFFER_POOL_GROWTH_FACTOR 2
+/*
+ * Maximum number of elements in each run sorted on the device by the chunked sort;
+ * the kernels index arrays with 32-bit unsigned integers, including the sorting
+ * network around each run (i.e. the run length rounded up to the next power of 2).
+ */
+#define MAX_CHUNKED_SORT_RUN_LENGTH (1u << 31)
+// Number of timed sorts of each configuration tried by "autotune_bitonic_session", after one untimed sort
+#define AUTOTUNE_REPETITIONS 5
+// Message to user after timing each configuration tried by "autotune_bitonic_session"
+#define NOTIFY_USER_AUTOTUNE_PROGRESS ">>> Autotuning: %u work-items per workgroup, up to %u merge steps"\
+                                      " per launch took %f seconds (median of %u sorts)\n"
+
+/*
+ * A persistent OpenCL bitonic sorting session; fields are the following:
+ *  - platform, device, context and command queue used for all sorting
+ *  - second command queue used for copying runs to and from the device while
+ *    the first command queue sorts (refer to "bitonic_session_sort_chunked")
+ *  - maximum size in bytes of each buffer and total size in bytes of global
+ *    memory on the device
+ *  - cache of programs compiled for the device
+ *  - kernels created from each program, indexed by data type, then by sorting
+ *    direction and then by kind of payload (with a NULL "local_kernel" if not
+ *    created yet); kernels are created the first time each one is needed
+ *  - pool of device buffers (NULL if not allocated yet) along with the size of
+ *    each buffer in bytes, indexed by slot
+ *  - command queues used by asynchronous sorts, each along with its own device
+ *    buffer and merge buffer for the merge path (NULL if not allocated yet) and
+ *    the sizes of those buffers in bytes, and the index of the queue the next
+ *    asynchronous sort gets enqueued into; sorts enqueued into the first command
+ *    queue use the merge buffer of the program cache instead
+ */
+struct Bitonic_Sort_Session {
+     cl_platform_id platform;
+     cl_device_id device;
+     cl_context context;
+     cl_command_queue queue;
+     cl_command_queue transfer_queue;
+     cl_ulong max_alloc_size;
+     cl_ulong global_mem_size;
+     struct Bitonic_Program_Cache program_cache;
+     struct Bitonic_Kernels kernels[NUM_ARRAY_TYPES][NUM_SORTING_DIRECTIONS][NUM_PAYLOAD_KINDS];
+     cl_mem pooled_buffers[NUM_BUFFER_POOL_SLOTS];
+     size_t pooled_buffer_sizes[NUM_BUFFER_POOL_SLOTS];
+     cl_command_queue async_queues[NUM_ASYNC_QUEUES];
+     cl_mem async_buffers[NUM_ASYNC_QUEUES];
+     size_t async_buffer_sizes[NUM_ASYNC_QUEUES];
+     cl_mem async_merge_buffers[NUM_ASYNC_QUEUES];
+     size_t async_merge_buffer_sizes[NUM_ASYNC_QUEUES];
+     unsigned int next_async_queue;
+};
+
+/*
+ * Sets up "session" to sort on "device" of the OpenCL "platform", with programs
+ * compiled from "program_source" (which gets copied) and program binaries cached
+ * within "binary_cache_dir" (NULL to always compile from source).
+ */
+void init_bitonic_sort_session_on_device(struct Bitonic_Sort_Session* session, cl_platform_id platform,
+                                           cl_device_id device, const char* program_source,
+                                                                 const char* binary_cache_dir);
+
+/*
+ * Sets up "session" as "init_bitonic_sort_session_on_device" does, on the device selected
+ * by "platform_selector" and "device_selector" (refer to "select_opencl_device" within
+ * "opencl_devices.h"; NULL for the default device of the first platform).
+ */
+void init_bitonic_sort_session(struct Bitonic_Sort_Session* session, const char* platform_selector,
+                                 const char* device_selector, const char* program_source,
+                                                               const char* binary_cache_dir);
+
+// Releases every OpenCL object owned by "session"
+void release_bitonic_sort_session(struct Bitonic_Sort_Session* session);
+
+/*
+ * Returns the kernels of "session" for sorting arrays of data type "array_type" in
+ * "sorting_direction" with payloads of kind "payload_kind", compiling the program and
+ * creating the kernels first if this is the first time they're needed. No merge buffer
+ * is attached to the kernels returned (refer to "use_program_cache_merge_buffer").
+ */
+struct Bitonic_Kernels* get_session_kernels(struct Bitonic_Sort_Session* session, const unsigned int array_type,
+                                              const unsigned int sorting_direction, const unsigned int payload_kind);
+
+/*
+ * Returns the buffer within "slot" of the pool of device buffers of "session",
+ * growing the buffer first if it's smaller than "buffer_size" bytes (which MUST NOT
+ * be larger than the maximum size of each buffer on the device); the contents of
+ * the buffer are undefined after growing.
+ */
+cl_mem* get_session_buffer(struct Bitonic_Sort_Session* session, const unsigned int slot, const size_t buffer_size);
+
+/*
+ * Sorts the array "data" of "array_length" (at least 1) elements of data type "array_type"
+ * in "sorting_direction" in place, by copying it into a pooled device buffer of "session",
+ * sorting it on the device and then copying it back; returns once "data" holds the sorted
+ * array. No OpenCL objects are created, except for the first sort of each data type and
+ * direction of sort and whenever the pooled device buffer has to grow. If a profile is attached
+ * to the program cache of "session", the copies to and from the device are added to it as well
+ * as every launch (refer to "bitonic_profile.h"); the same goes for every other sort below.
+ */
+void bitonic_session_sort(struct Bitonic_Sort_Session* session, void* data, const unsigned int array_length,
+                            const unsigned int array_type, const unsigned int sorting_direction);
+
+/*
+ * Key-value variant of "bitonic_session_sort", sorting the array "keys" in place while
+ * moving the payloads of kind "payload_kind" within "payload" (a separate array of the same
+ * length) along with each key; refer to "opencl_bitonic_sort_by_key" for the meaning of
+ * "generate_indices", in which case the initial contents of "payload" are ignored.
+ */
+void bitonic_session_sort_by_key(struct Bitonic_Sort_Session* session, void* keys, void* payload,
+                                   const unsigned int array_length, const unsigned int array_type,
+                                     const unsigned int payload_kind, const unsigned int generate_indices,
+                                                                       const unsigned int sorting_direction);
+
+/*
+ * Segmented variant of "bitonic_session_sort", sorting every one of the "num_segments" (at least 1)
+ * segments of the array "data" independently in place, where segment "i" consists of the elements at
+ * indices "segment_offsets[i]" up to but not including "segment_offsets[i + 1]"; the whole array of
+ * "segment_offsets[num_segments]" (at least 1) elements gets copied to the device and back only once,
+ * and all segments are sorted with a few launches in total (refer to "opencl_segmented_bitonic_sort").
+ */
+void bitonic_session_sort_segmented(struct Bitonic_Sort_Session* session, void* data,
+                                      const unsigned int* segment_offsets, const unsigned int num_segments,
+                                        const unsigned int array_type, const unsigned int sorting_direction);
+
+/*
+ * Top-K variant of "bitonic_session_sort", writing the "k" (at least 1) numbers of the array "data" of
+ * "array_length" (at least 1) elements that come first when sorting in "sorting_direction" into "top_k",
+ * sorted in "sorting_direction"; "data" is left untouched, and only the winners get copied back from
+ * the device (refer to "opencl_bitonic_top_k").
+ */
+void bitonic_session_top_k(struct Bitonic_Sort_Session* session, const void* data, const unsigned int array_length,
+                             const unsigned int k, const unsigned int array_type,
+                               const unsigned int sorting_direction, void* top_k);
+
+/*
+ * Asynchronous variant of "bitonic_session_sort", which returns as soon as the copy of "data"
+ * to the device, the sort and the copy back to "data" have been enqueued, instead of waiting for
+ * them to finish. The copy to the device waits for the "num_wait_events" events of "wait_events"
+ * (which may be NULL if there are none) first, e.g. for the event of an earlier sort whose result
+ * feeds "data". Successive calls round-robin across the NUM_ASYNC_QUEUES command queues of the
+ * session, so that independent sorts overlap on the device while the host prepares further data.
+ * Returns an event completing once "data" holds the sorted array, which the caller MUST release
+ * (clReleaseEvent); "data" MUST NOT be touched by the host until then.
+ */
+cl_event bitonic_session_sort_async(struct Bitonic_Sort_Session* session, void* data,
+                                      const unsigned int array_length, const unsigned int array_type,
+                                        const unsigned int sorting_direction, const cl_uint num_wait_events,
+                                                                              const cl_event* wait_events);
+
+/*
+ * Returns the maximum number of elements of data type "array_type" in each run sorted on the
+ * device by "bitonic_session_sort_chunked", such that the two buffers of runs (along with the
+ * merge buffer of the merge path, if UPPER_LEVELS_MERGE_PATH is enabled) fit within the global
+ * memory of the device and each of them within the maximum size of each buffer.
+ */
+size_t get_session_max_run_length(struct Bitonic_Sort_Session* session, const unsigned int array_type);
+
+/*
+ * Out-of-core variant of "bitonic_session_sort" for arrays larger than the memory of the device:
+ * splits "data" into runs of at most "max_run_length" elements (or the length returned by
+ * "get_session_max_run_length" if zero), sorts each run on the device and then merges all sorted
+ * runs on the host using "num_merge_threads" threads (refer to "multiway_merge"). Uploading each
+ * run to the device overlaps with sorting the previous run, as the copies to and from the device
+ * are enqueued into the second command queue of the session. Needs a temporary host array as
+ * large as "data" for merging, unless the whole array fits within a single run.
+ */
+void bitonic_session_sort_chunked(struct Bitonic_Sort_Session* session, void* data, const size_t array_length,
+                                    const unsigned int array_type, const unsigned int sorting_direction,
+                                      const size_t max_run_length, const unsigned int num_merge_threads);
+
+/*
+ * Returns the largest number of work-items per workgroup with which "session" may sort arrays of
+ * data type "array_type" in "sorting_direction", i.e. the smallest of CL_DEVICE_MAX_WORK_GROUP_SIZE
+ * of the device and CL_KERNEL_WORK_GROUP_SIZE of every kernel launched for such sorts (creating the
+ * kernels first if they haven't been created yet), halved until the tiles of every such kernel fit
+ * within CL_DEVICE_LOCAL_MEM_SIZE of the device.
+ */
+size_t get_session_max_workgroup_size(struct Bitonic_Sort_Session* session, const unsigned int array_type,
+                                        const unsigned int sorting_direction);
+
+/*
+ * Finds the fastest configuration of "session" for sorting arrays of "array_length" (at least 1)
+ * random elements of data type "array_type" in "sorting_direction" on its device, by timing the
+ * sort on the device (without copying to or from it) with every power of 2 workgroup size from
+ * CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE up to the largest one allowed (refer to
+ * "get_session_max_workgroup_size"), combined with every number of merge steps per launch the
+ * kernels support. Sorts are timed exactly as "opencl_bitonic_sort" and the sorts of "session"
+ * run them, i.e. along the merge path beyond the runs it starts off with (refer to
+ * "enqueue_bitonic_sort"); workgroup sizes sorting along the merge path are only timed with the
+ * default number of merge steps per launch (MAX_REGISTER_MERGE_LEVELS), which the runs within
+ * single tiles never use. The median of AUTOTUNE_REPETITIONS sorts is kept for each configuration;
+ * the fastest configuration gets written to "best_tuning" and set within the program cache of
+ * "session", so that every later sort of "session" uses it. Use "store_bitonic_tuning" to have
+ * later processes use the configuration as well.
+ */
+void autotune_bitonic_session(struct Bitonic_Sort_Session* session, const unsigned int array_length,
+                                const unsigned int array_type, const unsigned int sorting_direction,
+                                                                  struct Bitonic_Tuning* best_tuning);
+
+#endif // BITONIC_SORT_SESSION_H
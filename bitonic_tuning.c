@@ -0,0 +1,134 @@
+/*
+ * File description:
+ *   Saving and loading the configurations of the OpenCL bitonic sort tuned for each device.
+ *   The tuning file starts with TUNING_FILE_MAGIC on its own line, followed by one line per
+ *   device and driver version made up of the key of the device and its configuration.
+ */
+
+#include "bitonic_tuning.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "naive_bitonic_sort_opencl.h"
+#include "program_binary_cache.h"
+
+/*
+ * Writes the key of the lines of the tuning file belonging to "device" into "key" (MUST be
+ * able to hold MAX_TUNING_LINE_LEN characters), and the path of the tuning file within
+ * "tuning_dir" into "tuning_file_path" (MUST be able to hold MAX_TUNING_INFO_LEN characters).
+ */
+static void get_tuning_key(cl_device_id device, const char* tuning_dir, char* key, char* tuning_file_path) {
+    char device_name[MAX_TUNING_INFO_LEN];
+    char driver_version[MAX_TUNING_INFO_LEN];
+    clGetDeviceInfo(device, CL_DEVICE_NAME, MAX_TUNING_INFO_LEN, device_name, NULL);
+    clGetDeviceInfo(device, CL_DRIVER_VERSION, MAX_TUNING_INFO_LEN, driver_version, NULL);
+    // Keys have to fit on a single line of the tuning file
+    device_name[strcspn(device_name, "\n")] = '\0';
+    driver_version[strcspn(driver_version, "\n")] = '\0';
+
+    snprintf(key, MAX_TUNING_LINE_LEN, TUNING_KEY_FORMAT, device_name, driver_version);
+    snprintf(tuning_file_path, MAX_TUNING_INFO_LEN, TUNING_FILE_FORMAT, tuning_dir);
+}
+
+// Whether "tuning" is a configuration the OpenCL bitonic sort can run with on "device"
+static int is_valid_tuning(cl_device_id device, const struct Bitonic_Tuning* tuning) {
+    const unsigned int workgroup_size = tuning->workgroup_size;
+    size_t max_workgroup_size = 0;
+    clGetDeviceInfo(device, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(max_workgroup_size), &max_workgroup_size, NULL);
+    return (workgroup_size > 0) && ((workgroup_size & (workgroup_size - 1)) == 0) &&
+             (workgroup_size <= max_workgroup_size) && (tuning->merge_levels_per_launch >= 1) &&
+               (tuning->merge_levels_per_launch <= MAX_REGISTER_MERGE_LEVELS);
+}
+
+int load_bitonic_tuning(cl_device_id device, const char* tuning_dir, struct Bitonic_Tuning* tuning) {
+    // No null pointers allowed, except for the directory of the tuning file
+    assert(tuning != NULL);
+
+    if (tuning_dir == NULL) {
+        return 0;
+    }
+
+    char key[MAX_TUNING_LINE_LEN];
+    char tuning_file_path[MAX_TUNING_INFO_LEN];
+    get_tuning_key(device, tuning_dir, key, tuning_file_path);
+    const size_t key_len = strlen(key);
+    FILE* tuning_file = open_private_cache_file(tuning_file_path);
+    int tuning_found = 0;
+
+    if (tuning_file != NULL) {
+        char line[MAX_TUNING_LINE_LEN];
+        // Only use files of the expected format
+        if ((fgets(line, sizeof(line), tuning_file) != NULL) &&
+               (strncmp(line, TUNING_FILE_MAGIC "\n", sizeof(TUNING_FILE_MAGIC)) == 0)) {
+            while (!tuning_found && (fgets(line, sizeof(line), tuning_file) != NULL)) {
+                struct Bitonic_Tuning tuning_read;
+                if ((strncmp(line, key, key_len) == 0) &&
+                       (sscanf(line + key_len, TUNING_VALUES_FORMAT, &tuning_read.workgroup_size,
+                                                 &tuning_read.merge_levels_per_launch) == 2) &&
+                       is_valid_tuning(device, &tuning_read)) {
+                    *tuning = tuning_read;
+                    tuning_found = 1;
+                }
+            }
+        }
+        fclose(tuning_file);
+    }
+
+    if (tuning_found) {
+        printf(NOTIFY_USER_TUNING_LOADED, tuning->workgroup_size, tuning->merge_levels_per_launch,
+                                                                                  tuning_file_path);
+    }
+    return tuning_found;
+}
+
+void store_bitonic_tuning(cl_device_id device, const char* tuning_dir, const struct Bitonic_Tuning* tuning) {
+    // No null pointers allowed, except for the directory of the tuning file
+    assert(tuning != NULL);
+    // Only valid configurations may be saved
+    assert(is_valid_tuning(device, tuning));
+
+    if (tuning_dir == NULL) {
+        return;
+    }
+
+    char key[MAX_TUNING_LINE_LEN];
+    char tuning_file_path[MAX_TUNING_INFO_LEN];
+    char temp_file_path[MAX_PROGRAM_BINARY_INFO_LEN];
+    get_tuning_key(device, tuning_dir, key, tuning_file_path);
+    const size_t key_len = strlen(key);
+    /*
+     * Write to a temporary file first and then rename it, so that other processes
+     * never load a partially written tuning file.
+     */
+    FILE* temp_file = create_private_temp_file(tuning_file_path, temp_file_path);
+    if (temp_file == NULL) {
+        return;
+    }
+    int write_succeeded = (fprintf(temp_file, "%s\n", TUNING_FILE_MAGIC) > 0);
+
+    // Keep the configurations of every other device from the existing tuning file
+    FILE* tuning_file = open_private_cache_file(tuning_file_path);
+    if (tuning_file != NULL) {
+        char line[MAX_TUNING_LINE_LEN];
+        if ((fgets(line, sizeof(line), tuning_file) != NULL) &&
+               (strncmp(line, TUNING_FILE_MAGIC "\n", sizeof(TUNING_FILE_MAGIC)) == 0)) {
+            while (fgets(line, sizeof(line), tuning_file) != NULL) {
+                if (strncmp(line, key, key_len) != 0) {
+                    write_succeeded = write_succeeded && (fputs(line, temp_file) >= 0);
+                }
+            }
+        }
+        fclose(tuning_file);
+    }
+    write_succeeded = write_succeeded && (fprintf(temp_file, "%s" TUNING_VALUES_FORMAT "\n", key,
+                                                    tuning->workgroup_size, tuning->merge_levels_per_launch) > 0);
+
+    if ((fclose(temp_file) == 0) && write_succeeded) {
+        rename(temp_file_path, tuning_file_path);
+        printf(NOTIFY_USER_TUNING_STORED, tuning->workgroup_size, tuning->merge_levels_per_launch,
+                                                                                  tuning_file_path);
+    } else {
+        remove(temp_file_path);
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * File description:
+ *   Header file for the tuning file of the OpenCL bitonic sort, recording the best
+ *   workgroup size and number of merge steps per launch found for each device (refer
+ *   to "autotune_bitonic_session" within "bitonic_sort_session.h"), so that every
+ *   machine sorts with its best configuration without rebuilding the executable.
+ */
+
+#ifndef BITONIC_TUNING_H
+#define BITONIC_TUNING_H
+
+#define CL_TARGET_OPENCL_VERSION 220
+#include <CL/cl.h>
+
+/*
+ * Format of the path of the tuning file within the directory of cached program binaries
+ * (refer to PROGRAM_BINARY_CACHE_DIR within "program_binary_cache.h"); the same file holds
+ * the configurations of every device, one line per device and driver version. Like cached program
+ * binaries, the tuning file is only read if it's owned by the current user.
+ */
+#define TUNING_FILE_FORMAT "%s/bitonic_tuning.txt"
+// Marker on the first line of the tuning file identifying the format of the file
+#define TUNING_FILE_MAGIC "BITONIC_TUNING_V1"
+/*
+ * Format of each line of the tuning file, made up of the key of the line (the name and
+ * driver version of the device) followed by the tuned configuration. The configuration is
+ * shared by every data type and kind of payload, whose sorts shrink the workgroup size as far
+ * as their tiles need to fit within local memory.
+ */
+#define TUNING_KEY_FORMAT "device=%s;driver=%s;"
+#define TUNING_VALUES_FORMAT "workgroup_size=%u;merge_levels_per_launch=%u"
+// Maximum length of device names, driver versions, paths and lines of the tuning file
+#define MAX_TUNING_INFO_LEN 1024
+#define MAX_TUNING_LINE_LEN (3 * MAX_TUNING_INFO_LEN)
+// Message to user when the configuration of a device is loaded from the tuning file
+#define NOTIFY_USER_TUNING_LOADED ">>> Loaded tuned configuration (%u work-items per workgroup, up to %u"\
+                                  " merge steps per launch) from %s\n\n"
+// Message to user when the configuration of a device is saved to the tuning file
+#define NOTIFY_USER_TUNING_STORED ">>> Saved tuned configuration (%u work-items per workgroup, up to %u"\
+                                  " merge steps per launch) to %s\n\n"
+
+/*
+ * Configuration of the OpenCL bitonic sort tuned for one device; fields are the number
+ * of work-items per workgroup and the maximum number of merge steps per launch (refer to
+ * the fields of the same names of "Bitonic_Program_Cache" within "naive_bitonic_sort_opencl.h").
+ */
+struct Bitonic_Tuning {
+     unsigned int workgroup_size;
+     unsigned int merge_levels_per_launch;
+};
+
+/*
+ * Fills "tuning" with the configuration tuned for "device" (with its current driver version)
+ * found within the tuning file of "tuning_dir"; returns zero if there's none (or "tuning_dir"
+ * is NULL), or if the configuration found isn't valid, leaving "tuning" untouched.
+ */
+int load_bitonic_tuning(cl_device_id device, const char* tuning_dir, struct Bitonic_Tuning* tuning);
+
+/*
+ * Saves "tuning" as the configuration of "device" within the tuning file of "tuning_dir",
+ * replacing any configuration saved for the device before while keeping those of other
+ * devices; does nothing if "tuning_dir" is NULL. The tuning file gets replaced as a whole
+ * (by renaming a new file over it), so that processes reading it never see a partial file.
+ */
+void store_bitonic_tuning(cl_device_id device, const char* tuning_dir, const struct Bitonic_Tuning* tuning);
+
+#endif // BITONIC_TUNING_H
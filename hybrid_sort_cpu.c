@@ -0,0 +1,122 @@
+/*
+ * File description:
+ *   Hybrid sort on the CPU, combining the vectorised bitonic sort (for blocks small enough to stay
+ *   in cache, where its regular memory accesses and lack of branches pay off) with the parallel
+ *   multiway merge (whose O(n log n) work wins on anything larger).
+ */
+
+#include "hybrid_sort_cpu.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "array_utilities.h"
+#include "multiway_merge.h"
+#include "simd_bitonic_sort_cpu.h"
+
+// Name of each sorting direction, indexed by the macro value of each direction
+static const char* const sorting_direction_names[NUM_SORTING_DIRECTIONS] = {"ascending", "descending"};
+
+/*
+ * A single task sorting one block; fields are the following:
+ *  - beginning and length of the block
+ *  - direction of sort
+ */
+struct Block_Sort_Task {
+     ARRAY_TYPE_DECLARED* block;
+     unsigned int block_length;
+     unsigned int sorting_direction;
+};
+
+// Task function sorting a single block
+static void block_sort_task(void* task_arg) {
+    struct Block_Sort_Task* task = (struct Block_Sort_Task*)task_arg;
+    simd_bitonic_sort_block(task->block, task->block_length, task->sorting_direction, SIMD_ISA_AUTO);
+}
+
+void hybrid_sort_cpu(struct Array_With_Length_Padded* input_array, const unsigned int sorting_direction,
+                                                                       const unsigned int num_threads) {
+    // Parameter cannot be NULL
+    assert(input_array != NULL);
+    assert(input_array->contents != NULL);
+    // Array length has to be non-zero
+    assert(input_array->array_len_actual > 0);
+    assert(input_array->padded_2n_length >= input_array->array_len_actual);
+    // Make sure sort_direction is of valid value
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+
+    const size_t array_len = input_array->array_len_actual;
+    const size_t block_len = HYBRID_SORT_BLOCK_BYTES / sizeof(ARRAY_TYPE_DECLARED);
+    size_t num_runs = (array_len + block_len - 1) / block_len;
+
+    struct Work_Stealing_Pool pool;
+    init_work_stealing_pool(&pool, num_threads);
+    const unsigned int num_workers = pool.num_workers;
+
+    // Notify user hybrid sorting starts now
+    printf(NOTIFY_USER_SORT_HYBRID_START, num_workers, sorting_direction_names[sorting_direction]);
+
+    // Sort every block independently, i.e. one task per block
+    struct Block_Sort_Task* block_tasks = malloc(num_runs * sizeof(struct Block_Sort_Task));
+    size_t* run_offsets = malloc((num_runs + 1) * sizeof(size_t));
+    struct Task_Group task_group;
+    init_task_group(&task_group);
+    for (size_t run_index = 0; run_index < num_runs; ++run_index) {
+        run_offsets[run_index] = run_index * block_len;
+        block_tasks[run_index].block = input_array->contents + run_offsets[run_index];
+        block_tasks[run_index].block_length = (unsigned int)((run_index + 1 == num_runs) ?
+                                                  (array_len - run_offsets[run_index]) : block_len);
+        block_tasks[run_index].sorting_direction = sorting_direction;
+        if (run_index > 0) {
+            spawn_pool_task(&pool, &task_group, block_sort_task, &block_tasks[run_index]);
+        }
+    }
+    run_offsets[num_runs] = array_len;
+    block_sort_task(&block_tasks[0]);
+    wait_for_task_group(&pool, &task_group);
+    free(block_tasks);
+    // The merges run on threads of their own
+    release_work_stealing_pool(&pool);
+
+    if (num_runs == 1) {
+        free(run_offsets);
+        return;
+    }
+
+    /*
+     * Merge groups of up to HYBRID_SORT_MERGE_FANOUT runs at a time, back and forth between the
+     * array and a temporary array, until a single run is left.
+     */
+    ARRAY_TYPE_DECLARED* merge_source = input_array->contents;
+    ARRAY_TYPE_DECLARED* merge_destination = alloc_aligned_array(array_len * sizeof(ARRAY_TYPE_DECLARED));
+    ARRAY_TYPE_DECLARED* temp_array = merge_destination;
+    size_t group_offsets[HYBRID_SORT_MERGE_FANOUT + 1];
+    while (num_runs > 1) {
+        size_t num_groups = 0;
+        for (size_t first_run = 0; first_run < num_runs; first_run += HYBRID_SORT_MERGE_FANOUT) {
+            const size_t group_num_runs = (num_runs - first_run < HYBRID_SORT_MERGE_FANOUT) ?
+                                                 (num_runs - first_run) : HYBRID_SORT_MERGE_FANOUT;
+            const size_t group_start = run_offsets[first_run];
+            for (size_t run_index = 0; run_index <= group_num_runs; ++run_index) {
+                group_offsets[run_index] = run_offsets[first_run + run_index] - group_start;
+            }
+            multiway_merge(merge_source + group_start, group_offsets, (unsigned int)group_num_runs,
+                             merge_destination + group_start, ARRAY_TYPE, sorting_direction, num_workers);
+            // Each group becomes a single run of the next pass
+            run_offsets[num_groups++] = group_start;
+        }
+        run_offsets[num_groups] = array_len;
+        num_runs = num_groups;
+
+        ARRAY_TYPE_DECLARED* merged_array = merge_destination;
+        merge_destination = merge_source;
+        merge_source = merged_array;
+    }
+
+    // The sorted array ends up in the temporary array after an odd number of passes
+    if (merge_source != input_array->contents) {
+        memcpy(input_array->contents, merge_source, array_len * sizeof(ARRAY_TYPE_DECLARED));
+    }
+    free(temp_array);
+    free(run_offsets);
+}
@@ -0,0 +1,59 @@
+/*
+ * File description:
+ *   Header file for a hybrid sort on the CPU: cache-sized blocks of the array are sorted
+ *   with the vectorised bitonic sort on every core, and the sorted blocks are then combined
+ *   with the parallel multiway merge, so that only the work within each block grows with
+ *   the square of its logarithm.
+ */
+
+#ifndef HYBRID_SORT_CPU_H
+#define HYBRID_SORT_CPU_H
+
+#include "naive_bitonic_sort_opencl.h"
+#include "work_stealing_pool.h"
+
+/*
+ * Size in bytes of each block sorted with the bitonic sort, which should fit within
+ * the L2 cache of each core; MUST be a power of 2.
+ */
+#define HYBRID_SORT_BLOCK_BYTES (1 << 18)
+/*
+ * Maximum number of sorted runs combined by each multiway merge; blocks get merged in
+ * passes of merges of this many runs each, since finding splitters among too many runs
+ * costs more than an extra pass over the array.
+ */
+#define HYBRID_SORT_MERGE_FANOUT 64
+
+// Define message printed out to user signaling start of the hybrid sort
+#if (ARRAY_TYPE == CHAR)
+  #define NOTIFY_USER_SORT_HYBRID_START ">>> Starting sorting chars with bitonic block sort and"\
+                                        " multiway merge on %u CPU thread(s), sort %s...\n"
+#elif (ARRAY_TYPE == INT)
+  #define NOTIFY_USER_SORT_HYBRID_START ">>> Starting sorting ints with bitonic block sort and"\
+                                        " multiway merge on %u CPU thread(s), sort %s...\n"
+#elif (ARRAY_TYPE == LONG)
+  #define NOTIFY_USER_SORT_HYBRID_START ">>> Starting sorting longs with bitonic block sort and"\
+                                        " multiway merge on %u CPU thread(s), sort %s...\n"
+#elif (ARRAY_TYPE == FLOAT)
+  #define NOTIFY_USER_SORT_HYBRID_START ">>> Starting sorting floats with bitonic block sort and"\
+                                        " multiway merge on %u CPU thread(s), sort %s...\n"
+#elif (ARRAY_TYPE == DOUBLE)
+  #define NOTIFY_USER_SORT_HYBRID_START ">>> Starting sorting doubles with bitonic block sort and"\
+                                        " multiway merge on %u CPU thread(s), sort %s...\n"
+#endif
+
+/*
+ * Hybrid sort on the CPU.
+ * - "input_array" is the array to be sorted; a temporary array as large as it is needed for merging,
+ *   unless the whole array fits within a single block.
+ * - "sorting_direction" indicates whether or not to sort array in ascending or descending order;
+ *   refer to SORTING_DIRECTION macro within "naive_bitonic_sort_opencl.h" for more info.
+ * - "num_threads" is the number of threads sorting blocks and merging, including the calling thread
+ *   (or NUM_POOL_THREADS_AUTO for one thread per processor online). Blocks are sorted by tasks of a
+ *   work-stealing pool (refer to "work_stealing_pool.h"), each with "simd_bitonic_sort_block"; each
+ *   merge splits its output evenly across threads by searching for splitters (refer to "multiway_merge.h").
+ */
+void hybrid_sort_cpu(struct Array_With_Length_Padded* input_array, const unsigned int sorting_direction,
+                                                                       const unsigned int num_threads);
+
+#endif // HYBRID_SORT_CPU_H
@@ -0,0 +1,228 @@
+/*
+ * File description:
+ *   Sorting a single array across several OpenCL devices (or sub-devices of one device)
+ *   at once, with a sorting session per device and a multiway merge on the host.
+ */
+
+#include "multi_device_sort.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "multiway_merge.h"
+
+/*
+ * Partitions "device" into at most "max_num_devices" sub-devices with equal numbers of compute
+ * units, writing them into "sub_devices"; returns the number of sub-devices created, or zero
+ * if "device" can't be partitioned into at least two sub-devices.
+ */
+static unsigned int create_sub_devices(cl_device_id device, const unsigned int max_num_devices,
+                                         cl_device_id* sub_devices) {
+    cl_uint max_sub_devices = 0;
+    cl_uint num_compute_units = 0;
+    if ((clGetDeviceInfo(device, CL_DEVICE_PARTITION_MAX_SUB_DEVICES, sizeof(max_sub_devices),
+                           &max_sub_devices, NULL) != CL_SUCCESS) ||
+           (clGetDeviceInfo(device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(num_compute_units),
+                              &num_compute_units, NULL) != CL_SUCCESS)) {
+        return 0;
+    }
+    unsigned int num_sub_devices = (max_sub_devices < num_compute_units) ? max_sub_devices : num_compute_units;
+    if (num_sub_devices > max_num_devices) {
+        num_sub_devices = max_num_devices;
+    }
+    if (num_sub_devices < 2) {
+        return 0;
+    }
+
+    /*
+     * Partitioning equally may create a few more sub-devices than asked for (when the number of
+     * compute units isn't a multiple of the number of sub-devices), so the extra ones get released.
+     */
+    const cl_device_partition_property partition_properties[] = {
+        CL_DEVICE_PARTITION_EQUALLY, (cl_device_partition_property)(num_compute_units / num_sub_devices), 0
+    };
+    cl_uint num_created = 0;
+    if ((clCreateSubDevices(device, partition_properties, 0, NULL, &num_created) != CL_SUCCESS) ||
+           (num_created < 2)) {
+        return 0;
+    }
+    cl_device_id* created_devices = malloc(num_created * sizeof(cl_device_id));
+    if (clCreateSubDevices(device, partition_properties, num_created, created_devices, NULL) != CL_SUCCESS) {
+        free(created_devices);
+        return 0;
+    }
+    if (num_sub_devices > num_created) {
+        num_sub_devices = num_created;
+    }
+    for (cl_uint device_index = 0; device_index < num_created; ++device_index) {
+        if (device_index < num_sub_devices) {
+            sub_devices[device_index] = created_devices[device_index];
+        } else {
+            clReleaseDevice(created_devices[device_index]);
+        }
+    }
+    free(created_devices);
+    return num_sub_devices;
+}
+
+/*
+ * Writes at most "max_num_devices" devices of "platform" into "devices", with "device" first;
+ * returns the number of devices written.
+ */
+static unsigned int get_platform_sort_devices(cl_platform_id platform, cl_device_id device,
+                                                const unsigned int max_num_devices, cl_device_id* devices) {
+    cl_uint num_platform_devices = 0;
+    unsigned int num_devices = 0;
+    devices[num_devices++] = device;
+    if ((clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, 0, NULL, &num_platform_devices) != CL_SUCCESS) ||
+           (num_platform_devices == 0)) {
+        return num_devices;
+    }
+    cl_device_id* platform_devices = malloc(num_platform_devices * sizeof(cl_device_id));
+    clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, num_platform_devices, platform_devices, NULL);
+    for (cl_uint device_index = 0; (device_index < num_platform_devices) && (num_devices < max_num_devices);
+                                                                                         ++device_index) {
+        if (platform_devices[device_index] != device) {
+            devices[num_devices++] = platform_devices[device_index];
+        }
+    }
+    free(platform_devices);
+    return num_devices;
+}
+
+void init_multi_device_sort(struct Multi_Device_Sort* multi_sort, cl_platform_id platform, cl_device_id device,
+                              const unsigned int multi_device_mode, const unsigned int max_num_devices,
+                                const char* program_source, const char* binary_cache_dir) {
+    // No null pointers allowed
+    assert(multi_sort != NULL);
+    assert(program_source != NULL);
+    // Make sure the way of choosing devices is of valid value
+    assert(multi_device_mode < NUM_MULTI_DEVICE_MODES);
+
+    const unsigned int device_limit = ((max_num_devices == 0) || (max_num_devices > MAX_MULTI_SORT_DEVICES)) ?
+                                        MAX_MULTI_SORT_DEVICES : max_num_devices;
+    multi_sort->num_devices = 0;
+    multi_sort->uses_sub_devices = 0;
+    if (multi_device_mode != MULTI_DEVICE_PLATFORM_DEVICES) {
+        multi_sort->num_devices = create_sub_devices(device, device_limit, multi_sort->devices);
+        multi_sort->uses_sub_devices = (multi_sort->num_devices > 0);
+    }
+    if (multi_sort->num_devices == 0) {
+        // Devices which can't be partitioned are sorted on whole
+        multi_sort->num_devices = (multi_device_mode == MULTI_DEVICE_SUB_DEVICES) ? 1 :
+                                    get_platform_sort_devices(platform, device, device_limit, multi_sort->devices);
+        multi_sort->devices[0] = device;
+    }
+
+    cl_uint total_compute_units = 0;
+    multi_sort->sessions = malloc(multi_sort->num_devices * sizeof(struct Bitonic_Sort_Session));
+    for (unsigned int device_index = 0; device_index < multi_sort->num_devices; ++device_index) {
+        multi_sort->num_compute_units[device_index] = 1;
+        clGetDeviceInfo(multi_sort->devices[device_index], CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint),
+                          &(multi_sort->num_compute_units[device_index]), NULL);
+        if (multi_sort->num_compute_units[device_index] == 0) {
+            multi_sort->num_compute_units[device_index] = 1;
+        }
+        total_compute_units += multi_sort->num_compute_units[device_index];
+        init_bitonic_sort_session_on_device(&(multi_sort->sessions[device_index]), platform,
+                                              multi_sort->devices[device_index], program_source, binary_cache_dir);
+    }
+    printf(NOTIFY_USER_MULTI_DEVICES, multi_sort->num_devices,
+             multi_sort->uses_sub_devices ? "sub-device(s)" : "device(s)", total_compute_units);
+}
+
+void release_multi_device_sort(struct Multi_Device_Sort* multi_sort) {
+    // No null pointers allowed
+    assert(multi_sort != NULL);
+
+    for (unsigned int device_index = 0; device_index < multi_sort->num_devices; ++device_index) {
+        release_bitonic_sort_session(&(multi_sort->sessions[device_index]));
+        if (multi_sort->uses_sub_devices) {
+            clReleaseDevice(multi_sort->devices[device_index]);
+        }
+    }
+    free(multi_sort->sessions);
+    multi_sort->sessions = NULL;
+    multi_sort->num_devices = 0;
+}
+
+void multi_device_sort(struct Multi_Device_Sort* multi_sort, void* data, const size_t array_length,
+                         const unsigned int array_type, const unsigned int sorting_direction,
+                                                          const unsigned int num_merge_threads) {
+    // No null pointers allowed
+    assert(multi_sort != NULL);
+    assert(data != NULL);
+    // Array length HAS to be at least 1
+    assert(array_length >= 1);
+
+    const unsigned int num_devices = multi_sort->num_devices;
+    const size_t element_size = get_array_type_size(array_type);
+    char* data_bytes = (char*)data;
+
+    // Share out the array in proportion to the number of compute units of each device
+    cl_ulong total_compute_units = 0;
+    for (unsigned int device_index = 0; device_index < num_devices; ++device_index) {
+        total_compute_units += multi_sort->num_compute_units[device_index];
+    }
+    size_t share_offsets[MAX_MULTI_SORT_DEVICES + 1];
+    cl_ulong compute_units_before = 0;
+    for (unsigned int device_index = 0; device_index < num_devices; ++device_index) {
+        share_offsets[device_index] = (size_t)((double)array_length * compute_units_before / total_compute_units);
+        compute_units_before += multi_sort->num_compute_units[device_index];
+    }
+    share_offsets[num_devices] = array_length;
+
+    /*
+     * Enqueue the upload, sort and readback of every share before waiting on any of them, so
+     * that all devices work at the same time; devices whose shares are empty sit this one out.
+     * Shares too large for the memory of their devices are left for the chunked sort below.
+     */
+    size_t run_offsets[MAX_MULTI_SORT_DEVICES + 1];
+    unsigned int num_runs = 0;
+    unsigned int oversized_shares[MAX_MULTI_SORT_DEVICES];
+    unsigned int num_oversized_shares = 0;
+    run_offsets[0] = 0;
+    for (unsigned int device_index = 0; device_index < num_devices; ++device_index) {
+        struct Bitonic_Sort_Session* session = &(multi_sort->sessions[device_index]);
+        const size_t share_length = share_offsets[device_index + 1] - share_offsets[device_index];
+        if (share_length == 0) {
+            continue;
+        }
+        run_offsets[++num_runs] = share_offsets[device_index + 1];
+        if (share_length > get_session_max_run_length(session, array_type)) {
+            oversized_shares[num_oversized_shares++] = device_index;
+            continue;
+        }
+        const size_t share_size = share_length * element_size;
+        void* share_data = data_bytes + share_offsets[device_index] * element_size;
+
+        struct Bitonic_Kernels* kernels = get_session_kernels(session, array_type, sorting_direction, NO_PAYLOAD);
+        cl_mem* share_buffer = get_session_buffer(session, KEY_BUFFER_SLOT, share_size);
+        use_program_cache_merge_buffer(&(session->program_cache), kernels, share_length, array_type);
+        clEnqueueWriteBuffer(session->queue, *share_buffer, CL_NON_BLOCKING, CL_BUFFER_OFFSET, share_size,
+                               share_data, 0, NULL, NULL);
+        enqueue_bitonic_sort(&(session->queue), kernels, share_buffer, NULL, share_length, array_type, 0);
+        clEnqueueReadBuffer(session->queue, *share_buffer, CL_NON_BLOCKING, CL_BUFFER_OFFSET, share_size,
+                              share_data, 0, NULL, NULL);
+        clFlush(session->queue);
+    }
+    // Oversized shares are split into runs fitting their devices while the other devices sort theirs
+    for (unsigned int share_index = 0; share_index < num_oversized_shares; ++share_index) {
+        const unsigned int device_index = oversized_shares[share_index];
+        bitonic_session_sort_chunked(&(multi_sort->sessions[device_index]),
+                                       data_bytes + share_offsets[device_index] * element_size,
+                                         share_offsets[device_index + 1] - share_offsets[device_index],
+                                           array_type, sorting_direction, 0, num_merge_threads);
+    }
+    for (unsigned int device_index = 0; device_index < num_devices; ++device_index) {
+        clFinish(multi_sort->sessions[device_index].queue);
+    }
+
+    // Merge all sorted shares on the host
+    if (num_runs > 1) {
+        void* merged_data = malloc(array_length * element_size);
+        multiway_merge(data, run_offsets, num_runs, merged_data, array_type, sorting_direction, num_merge_threads);
+        memcpy(data, merged_data, array_length * element_size);
+        free(merged_data);
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ * File description:
+ *   Header file for sorting a single array across several OpenCL devices at once,
+ *   either every device of a platform (e.g. a machine with two GPUs) or the sub-devices
+ *   a device is partitioned into (e.g. a many-core CPU exposed through POCL). Each device
+ *   sorts its own share of the array with the bitonic sort within a sorting session of its
+ *   own, and the sorted shares are then merged on the host with the parallel multiway merge.
+ */
+
+#ifndef MULTI_DEVICE_SORT_H
+#define MULTI_DEVICE_SORT_H
+
+#include "bitonic_sort_session.h"
+
+/*
+ * Ways of choosing the devices to sort on:
+ *  - MULTI_DEVICE_SUB_DEVICES --- partition the given device into sub-devices with equal
+ *                                 numbers of compute units (refer to clCreateSubDevices)
+ *  - MULTI_DEVICE_PLATFORM_DEVICES --- every device of the platform of the given device
+ *  - MULTI_DEVICE_AUTO --- sub-devices if the given device can be partitioned, and every
+ *                          device of its platform otherwise
+ */
+#define MULTI_DEVICE_AUTO 0
+#define MULTI_DEVICE_SUB_DEVICES 1
+#define MULTI_DEVICE_PLATFORM_DEVICES 2
+#define NUM_MULTI_DEVICE_MODES 3
+// Largest number of devices any array is sorted across
+#define MAX_MULTI_SORT_DEVICES 64
+// Message to user naming the devices an array is sorted across
+#define NOTIFY_USER_MULTI_DEVICES ">>> Sorting across %u %s with %u compute unit(s) in total\n\n"
+
+/*
+ * Devices an array gets sorted across; fields are the following:
+ *  - number of devices, and whether they're sub-devices created by (and so released
+ *    along with) this struct (non-zero) or devices of a platform (zero)
+ *  - each device, along with its number of compute units, by which the array is
+ *    shared out between devices
+ *  - sorting session of each device, each with its own context and command queue
+ */
+struct Multi_Device_Sort {
+     unsigned int num_devices;
+     unsigned int uses_sub_devices;
+     cl_device_id devices[MAX_MULTI_SORT_DEVICES];
+     cl_uint num_compute_units[MAX_MULTI_SORT_DEVICES];
+     struct Bitonic_Sort_Session* sessions;
+};
+
+/*
+ * Sets up "multi_sort" to sort across at most "max_num_devices" devices (0 for as many as
+ * possible) chosen from "device" of "platform" in "multi_device_mode" (refer to the macros
+ * above), with programs compiled from "program_source" and program binaries cached within
+ * "binary_cache_dir" (refer to "init_bitonic_sort_session_on_device"). Ends up sorting on
+ * "device" alone if it can't be partitioned and is the only device of its platform.
+ */
+void init_multi_device_sort(struct Multi_Device_Sort* multi_sort, cl_platform_id platform, cl_device_id device,
+                              const unsigned int multi_device_mode, const unsigned int max_num_devices,
+                                const char* program_source, const char* binary_cache_dir);
+
+// Releases every OpenCL object owned by "multi_sort", including any sub-devices
+void release_multi_device_sort(struct Multi_Device_Sort* multi_sort);
+
+/*
+ * Sorts the array "data" of "array_length" (at least 1) elements of data type "array_type" in
+ * "sorting_direction" in place across every device of "multi_sort". Each device gets a share of
+ * the array proportional to its number of compute units; all devices upload, sort and read back
+ * their shares at the same time, each within its own command queue. Shares that don't fit within
+ * the memory of their devices (refer to "get_session_max_run_length") are sorted in runs by
+ * "bitonic_session_sort_chunked" instead, while the other devices sort. The sorted shares are
+ * then merged on the host using "num_merge_threads" threads (refer to "multiway_merge"), which
+ * needs a temporary host array as large as "data".
+ */
+void multi_device_sort(struct Multi_Device_Sort* multi_sort, void* data, const size_t array_length,
+                         const unsigned int array_type, const unsigned int sorting_direction,
+                                                          const unsigned int num_merge_threads);
+
+#endif // MULTI_DEVICE_SORT_H
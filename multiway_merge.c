@@ -0,0 +1,123 @@
+/*
+ * File description:
+ *   Parallel multiway merge on the host. The merged array is split into one contiguous part per
+ *   thread; each thread finds where its part begins and ends within every run by searching for
+ *   splitters (i.e. multisequence selection), and then merges its part of every run independently
+ *   of all other threads using a binary heap of runs.
+ */
+
+#include "multiway_merge.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "naive_bitonic_sort_opencl.h"
+
+/*
+ * The part of a multiway merge performed by a single thread; fields are the following:
+ *  - sorted runs being merged (refer to "multiway_merge" for "run_offsets")
+ *  - array into which the merged array is written
+ *  - direction in which every run is sorted
+ *  - positions within the merged array at which the part of the thread begins
+ *    and ends (not included)
+ */
+struct Multiway_Merge_Task {
+     const void* input_array;
+     const size_t* run_offsets;
+     unsigned int num_runs;
+     void* output_array;
+     unsigned int sorting_direction;
+     size_t rank_begin;
+     size_t rank_end;
+};
+
+// Specialisations of the multiway merge for each permitted data type
+#define MERGE_ELEMENT_TYPE cl_char
+#define MERGE_FUNC(func_name) func_name##_char
+#include "multiway_merge_impl.h"
+#define MERGE_ELEMENT_TYPE cl_int
+#define MERGE_FUNC(func_name) func_name##_int
+#include "multiway_merge_impl.h"
+#define MERGE_ELEMENT_TYPE cl_long
+#define MERGE_FUNC(func_name) func_name##_long
+#include "multiway_merge_impl.h"
+#define MERGE_ELEMENT_TYPE cl_float
+#define MERGE_FUNC(func_name) func_name##_float
+#include "multiway_merge_impl.h"
+#define MERGE_ELEMENT_TYPE cl_double
+#define MERGE_FUNC(func_name) func_name##_double
+#include "multiway_merge_impl.h"
+
+// Thread function of each data type, indexed by the macro value of each data type
+static void* (*const merge_task_funcs[NUM_ARRAY_TYPES])(void*) = {
+    merge_task_char, merge_task_int, merge_task_long, merge_task_float, merge_task_double
+};
+
+unsigned int get_num_merge_threads(const unsigned int num_threads) {
+    if (num_threads != NUM_MERGE_THREADS_AUTO) {
+        return num_threads;
+    }
+    const long num_processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return (num_processors > 0) ? (unsigned int)num_processors : 1;
+}
+
+void multiway_merge(const void* input_array, const size_t* run_offsets, const unsigned int num_runs,
+                      void* output_array, const unsigned int array_type,
+                        const unsigned int sorting_direction, const unsigned int num_threads) {
+    // No null pointers allowed
+    assert(input_array != NULL);
+    assert(run_offsets != NULL);
+    assert(output_array != NULL);
+    // There has to be at least one run, and the offsets of the runs can't decrease
+    assert(num_runs >= 1);
+    assert(run_offsets[0] == 0);
+    // Make sure data type and sort_direction are of valid values
+    assert(array_type < NUM_ARRAY_TYPES);
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+
+    const size_t total_length = run_offsets[num_runs];
+    // A single run is already merged
+    if (num_runs == 1) {
+        memcpy(output_array, input_array, total_length * get_array_type_size(array_type));
+        return;
+    }
+
+    // Don't use more threads than there are parts worth merging separately
+    unsigned int num_tasks = get_num_merge_threads(num_threads);
+    if (num_tasks > total_length / MIN_ELEMENTS_PER_MERGE_THREAD) {
+        num_tasks = total_length / MIN_ELEMENTS_PER_MERGE_THREAD;
+    }
+    if (num_tasks < 1) {
+        num_tasks = 1;
+    }
+
+    struct Multiway_Merge_Task* tasks = malloc(num_tasks * sizeof(struct Multiway_Merge_Task));
+    pthread_t* threads = malloc(num_tasks * sizeof(pthread_t));
+
+    for (unsigned int task_index = 0; task_index < num_tasks; ++task_index) {
+        tasks[task_index].input_array = input_array;
+        tasks[task_index].run_offsets = run_offsets;
+        tasks[task_index].num_runs = num_runs;
+        tasks[task_index].output_array = output_array;
+        tasks[task_index].sorting_direction = sorting_direction;
+        tasks[task_index].rank_begin = (total_length / num_tasks) * task_index;
+        tasks[task_index].rank_end = (task_index + 1 == num_tasks) ? total_length :
+                                              (total_length / num_tasks) * (task_index + 1);
+    }
+
+    // The calling thread merges the first part itself
+    for (unsigned int task_index = 1; task_index < num_tasks; ++task_index) {
+        const int create_result = pthread_create(&threads[task_index], NULL, merge_task_funcs[array_type],
+                                                                                 &tasks[task_index]);
+        assert(create_result == 0);
+    }
+    merge_task_funcs[array_type](&tasks[0]);
+    for (unsigned int task_index = 1; task_index < num_tasks; ++task_index) {
+        pthread_join(threads[task_index], NULL);
+    }
+
+    free(threads);
+    free(tasks);
+}
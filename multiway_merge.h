@@ -0,0 +1,46 @@
+/*
+ * File description:
+ *   Header file for a parallel multiway merge on the host, combining any number
+ *   of sorted runs stored one after another within an array into a single sorted
+ *   array using several threads.
+ */
+
+#ifndef MULTIWAY_MERGE_H
+#define MULTIWAY_MERGE_H
+
+#include <stddef.h>
+
+/*
+ * Flag macro value for "num_threads" indicating to use as many threads as
+ * there are processors online.
+ */
+#define NUM_MERGE_THREADS_AUTO 0
+/*
+ * Minimum number of elements merged by each thread; fewer threads than
+ * requested are used for merging short arrays.
+ */
+#define MIN_ELEMENTS_PER_MERGE_THREAD 65536
+
+/*
+ * Returns the number of threads to actually use when "num_threads" threads are
+ * requested, i.e. the number of processors online for NUM_MERGE_THREADS_AUTO.
+ */
+unsigned int get_num_merge_threads(const unsigned int num_threads);
+
+/*
+ * Merges the "num_runs" sorted runs within "input_array" into the sorted array "output_array"
+ * (which MUST NOT overlap with "input_array"), where run "i" consists of the elements at indices
+ * "run_offsets[i]" up to but not including "run_offsets[i + 1]" (i.e. "run_offsets" holds
+ * "num_runs + 1" offsets, starting at 0 and ending at the total number of elements).
+ * - "array_type" is the data type of each element (one of the permitted values of ARRAY_TYPE).
+ * - "sorting_direction" is the direction in which every run is sorted, and in which the output
+ *   array ends up sorted; refer to SORTING_DIRECTION within "naive_bitonic_sort_opencl.h".
+ * - "num_threads" is the number of threads merging (or NUM_MERGE_THREADS_AUTO); each thread
+ *   produces a contiguous part of "output_array", whose boundaries within each run are found by
+ *   searching for splitters, so no two threads ever touch the same element.
+ */
+void multiway_merge(const void* input_array, const size_t* run_offsets, const unsigned int num_runs,
+                      void* output_array, const unsigned int array_type,
+                        const unsigned int sorting_direction, const unsigned int num_threads);
+
+#endif // MULTIWAY_MERGE_H
@@ -0,0 +1,208 @@
+/*
+ * File description:
+ *   Type-specialised parts of the parallel multiway merge in "multiway_merge.c"; this file is
+ *   included once per permitted data type, with the following macros defined beforehand:
+ *   - MERGE_ELEMENT_TYPE --- data type of each element being merged
+ *   - MERGE_FUNC --- macro turning a function name into the name of its specialisation
+ *   Both macros are undefined again at the end of this file. Refer to "multiway_merge.c" for
+ *   the "Multiway_Merge_Task" struct shared by all specialisations.
+ */
+
+/*
+ * Whether "first" comes strictly before "second" in the sorting order; if sorting in ascending
+ * order, smaller numbers come first; if sorting in descending order, larger numbers come first.
+ * NaNs come after every other number either way, in the same order as the runs sorted on OpenCL
+ * devices, so that the binary searches splitting the merge always agree with the runs.
+ */
+static inline int MERGE_FUNC(precedes)(const MERGE_ELEMENT_TYPE first, const MERGE_ELEMENT_TYPE second,
+                                                                    const unsigned int sorting_direction) {
+    const int only_second_is_nan = (second != second) && (first == first);
+    return (sorting_direction ? (first > second) : (first < second)) || only_second_is_nan;
+}
+
+// Returns the number of elements of the sorted "run" of "run_length" elements coming before "value"
+static size_t MERGE_FUNC(count_preceding)(const MERGE_ELEMENT_TYPE* run, const size_t run_length,
+                                            const MERGE_ELEMENT_TYPE value, const unsigned int sorting_direction) {
+    size_t lower = 0;
+    size_t upper = run_length;
+    while (lower < upper) {
+        const size_t middle = lower + (upper - lower) / 2;
+        if (MERGE_FUNC(precedes)(run[middle], value, sorting_direction)) {
+            lower = middle + 1;
+        } else {
+            upper = middle;
+        }
+    }
+    return lower;
+}
+
+// Returns the number of elements of the sorted "run" of "run_length" elements not coming after "value"
+static size_t MERGE_FUNC(count_not_following)(const MERGE_ELEMENT_TYPE* run, const size_t run_length,
+                                                const MERGE_ELEMENT_TYPE value, const unsigned int sorting_direction) {
+    size_t lower = 0;
+    size_t upper = run_length;
+    while (lower < upper) {
+        const size_t middle = lower + (upper - lower) / 2;
+        if (MERGE_FUNC(precedes)(value, run[middle], sorting_direction)) {
+            upper = middle;
+        } else {
+            lower = middle + 1;
+        }
+    }
+    return lower;
+}
+
+/*
+ * Splitter search: finds how many elements of each run come before position "rank" of the merged
+ * array and writes them to "splits" (one entry per run, adding up to "rank"). Elements equal to the
+ * splitting value are taken from the runs in order, so that splits of increasing ranks never
+ * decrease within any run.
+ */
+static void MERGE_FUNC(find_splits)(const MERGE_ELEMENT_TYPE* input_array, const size_t* run_offsets,
+                                      const unsigned int num_runs, const size_t rank,
+                                        const unsigned int sorting_direction, size_t* splits) {
+    const size_t total_length = run_offsets[num_runs];
+
+    if (rank >= total_length) {
+        for (unsigned int run_index = 0; run_index < num_runs; ++run_index) {
+            splits[run_index] = run_offsets[run_index + 1] - run_offsets[run_index];
+        }
+        return;
+    }
+
+    /*
+     * The element at position "rank" of the merged array is the only value for which fewer than
+     * "rank + 1" elements come before it while more than "rank" elements don't come after it;
+     * look for it within each run by binary search over the number of elements coming before.
+     */
+    MERGE_ELEMENT_TYPE splitter = input_array[0];
+    int splitter_found = 0;
+    for (unsigned int run_index = 0; (run_index < num_runs) && !splitter_found; ++run_index) {
+        const MERGE_ELEMENT_TYPE* run = input_array + run_offsets[run_index];
+        const size_t run_length = run_offsets[run_index + 1] - run_offsets[run_index];
+        size_t lower = 0;
+        size_t upper = run_length;
+        // Find the last element of the run with at most "rank" elements coming before it
+        while (lower < upper) {
+            const size_t middle = lower + (upper - lower + 1) / 2;
+            size_t num_preceding = 0;
+            for (unsigned int other_index = 0; other_index < num_runs; ++other_index) {
+                num_preceding += MERGE_FUNC(count_preceding)(input_array + run_offsets[other_index],
+                                        run_offsets[other_index + 1] - run_offsets[other_index],
+                                                          run[middle - 1], sorting_direction);
+            }
+            if (num_preceding <= rank) {
+                lower = middle;
+            } else {
+                upper = middle - 1;
+            }
+        }
+        if (lower > 0) {
+            size_t num_not_following = 0;
+            for (unsigned int other_index = 0; other_index < num_runs; ++other_index) {
+                num_not_following += MERGE_FUNC(count_not_following)(input_array + run_offsets[other_index],
+                                              run_offsets[other_index + 1] - run_offsets[other_index],
+                                                                 run[lower - 1], sorting_direction);
+            }
+            if (num_not_following > rank) {
+                splitter = run[lower - 1];
+                splitter_found = 1;
+            }
+        }
+    }
+    assert(splitter_found);
+
+    // Take every element coming before the splitter, then elements equal to it until "rank" is reached
+    size_t num_remaining = rank;
+    for (unsigned int run_index = 0; run_index < num_runs; ++run_index) {
+        const MERGE_ELEMENT_TYPE* run = input_array + run_offsets[run_index];
+        const size_t run_length = run_offsets[run_index + 1] - run_offsets[run_index];
+        splits[run_index] = MERGE_FUNC(count_preceding)(run, run_length, splitter, sorting_direction);
+        num_remaining -= splits[run_index];
+    }
+    for (unsigned int run_index = 0; (run_index < num_runs) && (num_remaining > 0); ++run_index) {
+        const MERGE_ELEMENT_TYPE* run = input_array + run_offsets[run_index];
+        const size_t run_length = run_offsets[run_index + 1] - run_offsets[run_index];
+        const size_t num_equal = MERGE_FUNC(count_not_following)(run, run_length, splitter, sorting_direction) -
+                                                                                          splits[run_index];
+        const size_t num_taken = (num_equal < num_remaining) ? num_equal : num_remaining;
+        splits[run_index] += num_taken;
+        num_remaining -= num_taken;
+    }
+}
+
+/*
+ * Thread function merging the part of the merged array assigned to a single "Multiway_Merge_Task";
+ * runs are kept in a binary heap ordered by their next element, so each element takes
+ * O(log(number of runs)) comparisons.
+ */
+static void* MERGE_FUNC(merge_task)(void* task_arg) {
+    struct Multiway_Merge_Task* task = (struct Multiway_Merge_Task*)task_arg;
+    const MERGE_ELEMENT_TYPE* input_array = (const MERGE_ELEMENT_TYPE*)task->input_array;
+    MERGE_ELEMENT_TYPE* output_array = (MERGE_ELEMENT_TYPE*)task->output_array + task->rank_begin;
+    const unsigned int num_runs = task->num_runs;
+    const unsigned int sorting_direction = task->sorting_direction;
+    size_t* heads = malloc(num_runs * sizeof(size_t));
+    size_t* ends = malloc(num_runs * sizeof(size_t));
+    unsigned int* heap = malloc(num_runs * sizeof(unsigned int));
+    unsigned int heap_size = 0;
+
+    MERGE_FUNC(find_splits)(input_array, task->run_offsets, num_runs, task->rank_begin, sorting_direction, heads);
+    MERGE_FUNC(find_splits)(input_array, task->run_offsets, num_runs, task->rank_end, sorting_direction, ends);
+
+    // Turn split counts into absolute indices, and put every non-empty run into the heap
+    for (unsigned int run_index = 0; run_index < num_runs; ++run_index) {
+        heads[run_index] += task->run_offsets[run_index];
+        ends[run_index] += task->run_offsets[run_index];
+        if (heads[run_index] < ends[run_index]) {
+            // Sift the run up to its place within the heap
+            unsigned int child = heap_size++;
+            while (child > 0) {
+                const unsigned int parent = (child - 1) / 2;
+                if (!MERGE_FUNC(precedes)(input_array[heads[run_index]], input_array[heads[heap[parent]]],
+                                                                                   sorting_direction)) {
+                    break;
+                }
+                heap[child] = heap[parent];
+                child = parent;
+            }
+            heap[child] = run_index;
+        }
+    }
+
+    for (size_t output_index = 0; heap_size > 0; ++output_index) {
+        const unsigned int run_index = heap[0];
+        output_array[output_index] = input_array[heads[run_index]++];
+
+        // Remove exhausted runs, then sift the run at the top of the heap down to its place
+        const unsigned int sifted_run = (heads[run_index] < ends[run_index]) ? run_index : heap[--heap_size];
+        unsigned int parent = 0;
+        while (1) {
+            unsigned int child = 2 * parent + 1;
+            if (child >= heap_size) {
+                break;
+            }
+            if ((child + 1 < heap_size) && MERGE_FUNC(precedes)(input_array[heads[heap[child + 1]]],
+                                                      input_array[heads[heap[child]]], sorting_direction)) {
+                ++child;
+            }
+            if (!MERGE_FUNC(precedes)(input_array[heads[heap[child]]], input_array[heads[sifted_run]],
+                                                                                sorting_direction)) {
+                break;
+            }
+            heap[parent] = heap[child];
+            parent = child;
+        }
+        if (heap_size > 0) {
+            heap[parent] = sifted_run;
+        }
+    }
+
+    free(heads);
+    free(ends);
+    free(heap);
+    return NULL;
+}
+
+#undef MERGE_ELEMENT_TYPE
+#undef MERGE_FUNC
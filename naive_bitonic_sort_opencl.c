@@ -17,13 +17,237 @@
 // Libraries used by the functions in this file with custom headers
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 #include "naive_bitonic_sort_opencl.h"
+#include "program_binary_cache.h"
+#include "bitonic_profile.h"
+#include "bitonic_tuning.h"
+#include "sortable_keys.h"
+
+/*
+ * Names (as seen by OpenCL programs) and sizes of each data type permitted for ARRAY_TYPE,
+ * indexed by the macro value of each data type.
+ */
+static const char* const array_type_names[NUM_ARRAY_TYPES] = {
+    "char", "int", "long", "float", "double"
+};
+static const size_t array_type_sizes[NUM_ARRAY_TYPES] = {
+    sizeof(cl_char), sizeof(cl_int), sizeof(cl_long), sizeof(cl_float), sizeof(cl_double)
+};
+// Name of each sorting direction, indexed by the macro value of each sorting direction
+static const char* const sorting_direction_names[NUM_SORTING_DIRECTIONS] = {
+    "ascending", "descending"
+};
+/*
+ * Extra compiler options enabling the key-value kernels and sizes of each kind of payload
+ * permitted, indexed by the macro value of each kind of payload.
+ */
+static const char* const payload_kind_build_options[NUM_PAYLOAD_KINDS] = {
+    "", " -DPAYLOAD_TYPE=uint", " -DPAYLOAD_TYPE=ulong"
+};
+static const size_t payload_kind_sizes[NUM_PAYLOAD_KINDS] = {
+    0, sizeof(cl_uint), sizeof(cl_ulong)
+};
+
+/*
+ * Names of kernels collapsing as many consecutive merge steps as their index in this array
+ * into a single launch; a single merge step is performed by the KERNEL_FUNC_NAME kernel.
+ */
+static const char* const register_kernel_func_names[MAX_REGISTER_MERGE_LEVELS + 1] = {
+    NULL, KERNEL_FUNC_NAME, REGISTER_KERNEL_4_FUNC_NAME,
+       REGISTER_KERNEL_8_FUNC_NAME, REGISTER_KERNEL_16_FUNC_NAME
+};
 
 // =================================================================================================
 
-void load_array_bitonic_sort(cl_context *context, cl_command_queue* queue,
-                              struct Array_With_Length_Padded* input_array, cl_mem* buffer_in) {
+/*
+ * Returns the number of array indices below "array_length" whose "num_levels" consecutive bits,
+ * starting with the bit of "lowest_distance", are all cleared; i.e. the number of work-items of a
+ * kernel inserting "num_levels" zero bits at the position of "lowest_distance" into each work-item
+ * index whose smallest index handled is within the array.
+ */
+static size_t count_block_offsets(const unsigned int array_length, const unsigned int lowest_distance,
+                                                                     const unsigned int num_levels) {
+    const size_t block_span = (size_t)lowest_distance << num_levels;
+    const size_t last_block_length = array_length % block_span;
+
+    return (array_length / block_span) * lowest_distance +
+              ((last_block_length < lowest_distance) ? last_block_length : lowest_distance);
+}
+
+// Rounds a number of work-items up to a multiple of the workgroup size.
+static size_t round_up_to_workgroup(const size_t num_work_items, const size_t workgroup_size) {
+    return ((num_work_items + workgroup_size - 1) / workgroup_size) * workgroup_size;
+}
+
+void init_bitonic_program_cache(struct Bitonic_Program_Cache* program_cache, cl_context context,
+                                  cl_device_id device, const char* program_source,
+                                                          const char* binary_cache_dir) {
+    // No null pointers allowed
+    assert(program_cache != NULL);
+    assert(program_source != NULL);
+
+    program_cache->context = context;
+    program_cache->device = device;
+    program_cache->program_source = malloc((strlen(program_source) + 1) * sizeof(char));
+    strcpy(program_cache->program_source, program_source);
+    program_cache->binary_cache_dir = binary_cache_dir;
+    program_cache->workgroup_size = NUM_THREADS_IN_BLOCK;
+    program_cache->merge_levels_per_launch = MAX_REGISTER_MERGE_LEVELS;
+    program_cache->profile = NULL;
+    program_cache->merge_buffer = NULL;
+    program_cache->merge_buffer_size = 0;
+
+    // Use the configuration tuned for the device instead, if it has been tuned
+    struct Bitonic_Tuning tuning;
+    if (load_bitonic_tuning(device, binary_cache_dir, &tuning)) {
+        program_cache->workgroup_size = tuning.workgroup_size;
+        program_cache->merge_levels_per_launch = tuning.merge_levels_per_launch;
+    }
+    // No programs are compiled until they're needed
+    for (unsigned int array_type = 0; array_type < NUM_ARRAY_TYPES; ++array_type) {
+        for (unsigned int sorting_direction = 0; sorting_direction < NUM_SORTING_DIRECTIONS; ++sorting_direction) {
+            for (unsigned int payload_kind = 0; payload_kind < NUM_PAYLOAD_KINDS; ++payload_kind) {
+                program_cache->programs[array_type][sorting_direction][payload_kind] = NULL;
+            }
+        }
+    }
+}
+
+cl_program* get_bitonic_program(struct Bitonic_Program_Cache* program_cache,
+                                   const unsigned int array_type, const unsigned int sorting_direction,
+                                                                        const unsigned int payload_kind) {
+    // No null pointers allowed
+    assert(program_cache != NULL);
+    // Make sure data type, sort_direction and kind of payload are of valid values
+    assert(array_type < NUM_ARRAY_TYPES);
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+    assert(payload_kind < NUM_PAYLOAD_KINDS);
+
+    cl_program* program = &(program_cache->programs[array_type][sorting_direction][payload_kind]);
+
+    if (*program == NULL) {
+        /*
+         * Specialize the kernels for the data type, the sorting direction and the kind of
+         * payload by passing all three as macro definitions to the compiler.
+         */
+        char build_options[MAX_BUILD_OPTIONS_LEN];
+        snprintf(build_options, MAX_BUILD_OPTIONS_LEN, PROGRAM_BUILD_OPTIONS_FORMAT,
+                  array_type_names[array_type], array_type, sorting_direction,
+                                                      payload_kind_build_options[payload_kind]);
+        const char* program_source = program_cache->program_source;
+        char binary_file_path[MAX_PROGRAM_BINARY_INFO_LEN];
+
+        // Skip compilation if the same program has been compiled for the same device before
+        *program = load_cached_program_binary(program_cache->context, program_cache->device,
+                                                program_cache->binary_cache_dir, program_source,
+                                                              build_options, binary_file_path);
+        if (*program != NULL) {
+            printf(NOTIFY_USER_PROGRAM_BINARY_LOADED, array_type_names[array_type],
+                                sorting_direction_names[sorting_direction], binary_file_path);
+            return program;
+        }
+
+        // Compile the opencl_program
+        cl_int func_error_code;
+        *program = clCreateProgramWithSource(program_cache->context, 1, &program_source, NULL, &func_error_code);
+        assert(func_error_code == CL_SUCCESS);
+        const cl_int build_result = clBuildProgram(*program, 0, NULL, build_options, NULL, NULL);
+
+        // Get info generated by compiler and output any compiler-generated messages to user
+        size_t log_size;
+        clGetProgramBuildInfo(*program, program_cache->device, CL_PROGRAM_BUILD_LOG, 0, NULL, &log_size);
+        char* messages = malloc((1 + log_size) * sizeof(char));
+        clGetProgramBuildInfo(*program, program_cache->device, CL_PROGRAM_BUILD_LOG, log_size, messages, NULL);
+        messages[log_size] = '\0';
+        printf(NOTIFY_USER_PROGRAM_BUILD_LOG, array_type_names[array_type],
+                            sorting_direction_names[sorting_direction], messages);
+        free(messages);
+        // Any compiler errors have been shown above
+        assert(build_result == CL_SUCCESS);
+
+        // Save the compiled program so that later runs don't have to compile it again
+        if (build_result == CL_SUCCESS) {
+            store_cached_program_binary(*program, program_cache->device, program_cache->binary_cache_dir,
+                                                                          program_source, build_options);
+        }
+    }
+
+    return program;
+}
+
+void release_bitonic_program_cache(struct Bitonic_Program_Cache* program_cache) {
+    // No null pointers allowed
+    assert(program_cache != NULL);
+
+    for (unsigned int array_type = 0; array_type < NUM_ARRAY_TYPES; ++array_type) {
+        for (unsigned int sorting_direction = 0; sorting_direction < NUM_SORTING_DIRECTIONS; ++sorting_direction) {
+            for (unsigned int payload_kind = 0; payload_kind < NUM_PAYLOAD_KINDS; ++payload_kind) {
+                cl_program* program = &(program_cache->programs[array_type][sorting_direction][payload_kind]);
+                if (*program != NULL) {
+                    clReleaseProgram(*program);
+                    *program = NULL;
+                }
+            }
+        }
+    }
+    if (program_cache->merge_buffer != NULL) {
+        clReleaseMemObject(program_cache->merge_buffer);
+        program_cache->merge_buffer = NULL;
+        program_cache->merge_buffer_size = 0;
+    }
+    free(program_cache->program_source);
+    program_cache->program_source = NULL;
+}
+
+size_t get_array_type_size(const unsigned int array_type) {
+    // Make sure data type is of valid value
+    assert(array_type < NUM_ARRAY_TYPES);
+
+    return array_type_sizes[array_type];
+}
+
+const char* get_array_type_name(const unsigned int array_type) {
+    // Make sure data type is of valid value
+    assert(array_type < NUM_ARRAY_TYPES);
+
+    return array_type_names[array_type];
+}
+
+size_t get_payload_kind_size(const unsigned int payload_kind) {
+    // Make sure kind of payload is of valid value, and that there is a payload
+    assert((payload_kind == PAYLOAD_32_BIT) || (payload_kind == PAYLOAD_64_BIT));
+
+    return payload_kind_sizes[payload_kind];
+}
+
+unsigned int get_default_host_buffer_mode(cl_device_id device) {
+    cl_bool host_unified_memory = CL_FALSE;
+    const cl_int func_error_code = clGetDeviceInfo(device, CL_DEVICE_HOST_UNIFIED_MEMORY,
+                                                     sizeof(host_unified_memory), &host_unified_memory, NULL);
+    // Copying is always correct, so fall back to it if the device can't tell
+    if ((func_error_code == CL_SUCCESS) && host_unified_memory) {
+        return USE_HOST_PTR_BUFFER;
+    }
+    return COPY_HOST_BUFFER;
+}
+
+/*
+ * Returns a pointer to the first actual element of "padded_array" of data type "array_type",
+ * i.e. past any padding at the beginning of the array.
+ */
+static void* get_padded_array_elements(struct Array_With_Length_Padded* padded_array,
+                                         const unsigned int array_type) {
+    const size_t padding_length = (padded_array->padding_location_indicator == PAD_ARRAY_AT_BEGINNING) ?
+                                    padded_array->padded_2n_length - padded_array->array_len_actual : 0;
+    return (char*)(padded_array->contents) + padding_length * get_array_type_size(array_type);
+}
+
+unsigned int load_array_bitonic_sort(cl_context *context, cl_command_queue* queue,
+                                       struct Array_With_Length_Padded* input_array,
+                                         const unsigned int array_type, cl_mem* buffer_in,
+                                                                  const unsigned int host_buffer_mode) {
     
     // No null pointers allowed
     assert(context != NULL);
@@ -33,96 +257,779 @@ void load_array_bitonic_sort(cl_context *context, cl_command_queue* queue,
     assert(buffer_in != NULL);
     // Array length HAS to be at least 1
     assert(input_array->array_len_actual >= 1);
-    assert(input_array->padded_2n_length >= 1);
+    assert(input_array->padded_2n_length >= input_array->array_len_actual);
     // Check that padding location indicator is of valid value
     assert((input_array->padding_location_indicator == PAD_ARRAY_AT_BEGINNING) ||
                       (input_array->padding_location_indicator == PAD_ARRAY_AT_END));
+    assert(host_buffer_mode <= HOST_BUFFER_AUTO);
 
     cl_int func_error_code;
+    const size_t array_size = (input_array->array_len_actual) * get_array_type_size(array_type);
+    void* array_elements = get_padded_array_elements(input_array, array_type);
+    unsigned int resolved_mode = host_buffer_mode;
+
+    if (resolved_mode == HOST_BUFFER_AUTO) {
+        cl_device_id device;
+        func_error_code = clGetCommandQueueInfo(*queue, CL_QUEUE_DEVICE, sizeof(device), &device, NULL);
+        assert(func_error_code == CL_SUCCESS);
+        resolved_mode = get_default_host_buffer_mode(device);
+    }
 
-    // Create buffer to be filled on OpenCL device based on execution environment.
-    *(buffer_in) = clCreateBuffer(*context, CL_MEM_READ_WRITE, 
-                                                 (input_array->padded_2n_length)*
-                                                         sizeof(ARRAY_TYPE_DECLARED),
-                                                                      NULL, &func_error_code);
+    if (resolved_mode == USE_HOST_PTR_BUFFER) {
+        /*
+         * The buffer is the array itself, so there's nothing to copy; devices sharing
+         * memory with the host then sort the array right where it is.
+         */
+        *(buffer_in) = clCreateBuffer(*context, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, array_size,
+                                                                array_elements, &func_error_code);
+        assert(func_error_code == CL_SUCCESS);
+    } else if (resolved_mode == ALLOC_HOST_PTR_BUFFER) {
+        /*
+         * Fill the memory allocated by the OpenCL implementation through a mapping of the
+         * buffer, discarding its previous contents so the implementation needn't copy them.
+         */
+        *(buffer_in) = clCreateBuffer(*context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, array_size,
+                                                                          NULL, &func_error_code);
+        assert(func_error_code == CL_SUCCESS);
+        void* mapped_array = clEnqueueMapBuffer(*queue, *buffer_in, CL_BLOCKING, CL_MAP_WRITE_INVALIDATE_REGION,
+                                                  CL_BUFFER_OFFSET, array_size, 0, NULL, NULL, &func_error_code);
+        assert(func_error_code == CL_SUCCESS);
+        memcpy(mapped_array, array_elements, array_size);
+        func_error_code = clEnqueueUnmapMemObject(*queue, *buffer_in, mapped_array, 0, NULL, NULL);
+        assert(func_error_code == CL_SUCCESS);
+    } else {
+        // Create buffer to be filled on OpenCL device based on execution environment.
+        *(buffer_in) = clCreateBuffer(*context, CL_MEM_READ_WRITE, array_size, NULL, &func_error_code);
+        assert(func_error_code == CL_SUCCESS);
 
-    /*
-     * Copy array to the buffer created on the OpenCL device
-     * Note: if I try to do sizeof([insert variable here]), most of the contents of my arrays get eaten by an 
-     *    unknown force in my computer, not sure why but I thought that is something interesting to document
-     */
-    func_error_code = clEnqueueWriteBuffer(*queue, *buffer_in, CL_BLOCKING,
-                                              CL_BUFFER_OFFSET, (input_array->padded_2n_length) *
-                                                                        sizeof(ARRAY_TYPE_DECLARED),
-                                                                  input_array->contents, 0, NULL, NULL);
+        /*
+         * Copy array to the buffer created on the OpenCL device; only the actual elements of
+         * the array are copied over, as the device never needs any padding.
+         * Note: if I try to do sizeof([insert variable here]), most of the contents of my arrays get eaten by an 
+         *    unknown force in my computer, not sure why but I thought that is something interesting to document
+         */
+        func_error_code = clEnqueueWriteBuffer(*queue, *buffer_in, CL_BLOCKING,
+                                                  CL_BUFFER_OFFSET, array_size,
+                                                      array_elements, 0, NULL, NULL);
+        assert(func_error_code == CL_SUCCESS);
+    }
 
+    return resolved_mode;
 }
 
-void opencl_bitonic_sort(cl_command_queue *queue, cl_program *program,
-                            cl_kernel* kernel, struct Array_With_Length_Padded* input_array,
-                                       cl_mem* buffer_in, const unsigned int sorting_direction) {
+void read_array_bitonic_sort(cl_command_queue* queue, struct Array_With_Length_Padded* output_array,
+                               const unsigned int array_type, cl_mem* buffer_in,
+                                                const unsigned int host_buffer_mode) {
     // No null pointers allowed
-    assert(program != NULL);
     assert(queue != NULL);
-    assert(kernel != NULL);
-    assert(input_array != NULL);
+    assert(output_array != NULL);
+    assert(output_array->contents != NULL);
     assert(buffer_in != NULL);
-    assert(input_array->contents != NULL);
-    // Array length HAS to be at least 1
-    assert(input_array->array_len_actual >= 1);
-    assert(input_array->padded_2n_length >= 1);
-    // Check that padding location indicator is of valid value
-    assert((input_array->padding_location_indicator == PAD_ARRAY_AT_BEGINNING) ||
-                      (input_array->padding_location_indicator == PAD_ARRAY_AT_END));
-    // Make sure sort_direction is of valid value
-    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+    // The mode has to have been resolved by "load_array_bitonic_sort"
+    assert(host_buffer_mode < HOST_BUFFER_AUTO);
 
-    // The last event to be performed in the command queue on the OpenCL device
-    cl_event event;
+    cl_int func_error_code;
+    const size_t array_size = (output_array->array_len_actual) * get_array_type_size(array_type);
+    void* array_elements = get_padded_array_elements(output_array, array_type);
+
+    if (host_buffer_mode == COPY_HOST_BUFFER) {
+        func_error_code = clEnqueueReadBuffer(*queue, *buffer_in, CL_BLOCKING, CL_BUFFER_OFFSET, array_size,
+                                                                array_elements, 0, NULL, NULL);
+        assert(func_error_code == CL_SUCCESS);
+        return;
+    }
 
     /*
-     * Generate the kernel runtime and set 1st argument of kernel to address of loaded buffer
-     * and last argument to indicate direction of sort.
+     * Mapping a CL_MEM_USE_HOST_PTR buffer for reading makes the array it wraps up to date
+     * (and returns a pointer into it), so only CL_MEM_ALLOC_HOST_PTR buffers need a copy.
      */
-    *kernel = clCreateKernel(*program, KERNEL_FUNC_NAME, NULL);
-    clSetKernelArg(*kernel, 0, sizeof(*buffer_in), (void*)buffer_in);
-    clSetKernelArg(*kernel, 3, sizeof(sorting_direction), (void*)&sorting_direction);
-    
+    void* mapped_array = clEnqueueMapBuffer(*queue, *buffer_in, CL_BLOCKING, CL_MAP_READ, CL_BUFFER_OFFSET,
+                                                              array_size, 0, NULL, NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    if (host_buffer_mode == ALLOC_HOST_PTR_BUFFER) {
+        memcpy(array_elements, mapped_array, array_size);
+    }
+    func_error_code = clEnqueueUnmapMemObject(*queue, *buffer_in, mapped_array, 0, NULL, NULL);
+    assert(func_error_code == CL_SUCCESS);
+    // Make sure the buffer is unmapped before it gets released
+    clFinish(*queue);
+}
+
+/*
+ * Returns the length of the bitonic sorting network needed to sort an array of "array_length"
+ * elements, i.e. the array length rounded up to the next power of 2; the network never touches
+ * indices at or beyond the array length.
+ */
+static unsigned int get_network_length(const unsigned int array_length) {
+    unsigned int network_length = 1;
+    while (network_length < array_length) {
+        network_length *= 2;
+    }
+    return network_length;
+}
+
+/*
+ * Returns the number of elements of each tile sorted within local memory by workgroups of
+ * "workgroup_size" work-items; tiles can't be longer than the sorting network itself, so for
+ * arrays no longer than a tile the whole array gets sorted within a single tile.
+ */
+static unsigned int get_tile_size(const unsigned int network_length, const unsigned int workgroup_size) {
+    const unsigned int full_tile_size = LOCAL_TILE_ELEMENTS_PER_WORK_ITEM * workgroup_size;
+    return (network_length < full_tile_size) ? network_length : full_tile_size;
+}
+
+// Returns the number of merge steps of a bitonic sorting network of "network_length" (a power of 2) elements
+static unsigned int count_network_merge_steps(const unsigned int network_length) {
+    unsigned int num_merge_steps = 0;
+    for (unsigned int partition_size = 2; partition_size <= network_length; partition_size *= 2) {
+        for (unsigned int compare_distance = partition_size / 2; compare_distance > 0; compare_distance /= 2) {
+            ++num_merge_steps;
+        }
+    }
+    return num_merge_steps;
+}
+
+/*
+ * Returns the global and local number of work-items for launching the local memory kernel
+ * over an array of "array_length" elements with tiles of "tile_size" elements; each work-item
+ * handles a pair of elements, and there's one workgroup per tile of the array (the last tile
+ * may be partial).
+ */
+static void get_tile_work_sizes(const unsigned int array_length, const unsigned int tile_size,
+                                                    size_t* global_tile, size_t* local_tile) {
+    local_tile[0] = tile_size / 2;
+    global_tile[0] = ((array_length + tile_size - 1) / tile_size) * (tile_size / 2);
+}
+
+/*
+ * Enqueues into "queue" the first merge steps of the bitonic sorting network of "network_length"
+ * elements (a power of 2) for every block of that many elements of an array of "array_length"
+ * (at least 2) elements, sorting every tile of the array from scratch within local memory (i.e.
+ * performing all merge steps for all partition sizes up to and including the tile size at once)
+ * using "local_kernel", whose first 6 arguments match those of the keys-only local memory kernel;
+ * all of its arguments except for the compare distance and partition sizes have to be set already.
+ * Workgroups are made up of "workgroup_size" work-items. The launch is added to "profile" (unless
+ * NULL) as reading and writing "launch_bytes" bytes.
+ */
+static void enqueue_bitonic_sort_tiles(cl_command_queue *queue, const unsigned int array_length,
+                                         const unsigned int network_length, cl_kernel local_kernel,
+                                           const unsigned int workgroup_size, struct Bitonic_Profile* profile,
+                                                                                const size_t launch_bytes) {
+    const unsigned int tile_size = get_tile_size(network_length, workgroup_size);
+    size_t global_tile[OPERAND_DIMS];
+    size_t local_tile[OPERAND_DIMS];
+    get_tile_work_sizes(array_length, tile_size, global_tile, local_tile);
+
+    unsigned int first_compare_distance = 1;
+    unsigned int first_partition_size = 2;
+    clSetKernelArg(local_kernel, 3, sizeof(first_compare_distance), (void*)&first_compare_distance);
+    clSetKernelArg(local_kernel, 4, sizeof(first_partition_size), (void*)&first_partition_size);
+    clSetKernelArg(local_kernel, 5, sizeof(tile_size), (void*)&tile_size);
+    clEnqueueNDRangeKernel(*queue, local_kernel, OPERAND_DIMS, NULL, global_tile, local_tile, 0, NULL,
+                             add_profiled_command(profile, PROFILED_LOCAL_MERGE_STEPS, tile_size, tile_size / 2,
+                                                    count_network_merge_steps(tile_size), launch_bytes));
+}
+
+/*
+ * Enqueues into "queue" the merge steps of "partition_size" of the bitonic sorting network of an
+ * array of "array_length" elements, starting with "first_compare_distance" (half of "partition_size"
+ * for the first merge step, or less to only perform the remaining half-cleaners of a partition size);
+ * merge steps whose compare distances don't fit within a tile of "tile_size" elements are performed
+ * in global memory, and all others by a single launch of the local memory kernel. Kernels are those
+ * of "enqueue_bitonic_merge_network" below, with the same meaning for all other parameters.
+ */
+static void enqueue_partition_merge_steps(cl_command_queue *queue, const unsigned int array_length,
+                                            const unsigned int tile_size, const unsigned int partition_size,
+                                              const unsigned int first_compare_distance, cl_kernel local_kernel,
+                                                cl_kernel* register_kernels, const unsigned int max_merge_levels,
+                                                  const unsigned int half_launch, const unsigned int workgroup_size,
+                                                    struct Bitonic_Profile* profile, const size_t launch_bytes) {
     /* 
      * Specify size of each thread block and size of array to be sorted 
      * for each time the kernel is called.
      */
-    const size_t local[OPERAND_DIMS] = { NUM_THREADS_IN_BLOCK };
-    const size_t global[OPERAND_DIMS] = { input_array->padded_2n_length };
+    const size_t local[OPERAND_DIMS] = { workgroup_size };
+    size_t global_tile[OPERAND_DIMS];
+    size_t local_tile[OPERAND_DIMS];
+    get_tile_work_sizes(array_length, tile_size, global_tile, local_tile);
 
-    // Notify user sorting starts now
-    printf(NOTIFY_USER_SORT_OPENCL_START, NUM_THREADS_IN_BLOCK);
+    /*
+     * Iterate over all different compare distances too large to fit within a tile, where each
+     * compare distance is how far apart the numbers being compared are for constructing the
+     * bitonic sequences; up to "max_merge_levels" consecutive compare distances are
+     * handled by each kernel launch, except for the first compare distance of each partition
+     * size which always gets its own launch (see "bitonic_program.cl" for why).
+     */
+    for (unsigned int compare_distance = first_compare_distance; compare_distance >= tile_size; ) {
+         unsigned int num_levels = 1;
+         while ((2 * compare_distance < partition_size) && (num_levels < max_merge_levels) &&
+                                                        ((compare_distance >> num_levels) >= tile_size)) {
+             ++num_levels;
+         }
+         /*
+          * For each iteration, rearrange numbers in the array on device memory to create bitonic sequences of
+          * length = twice the partition size using all possible different compare distances, where
+          * each compare distance is a power of 2. Each work-item handles 2^num_levels numbers,
+          * except for a single merge step kernel launching one work-item per element; only
+          * work-items handling numbers within the array are needed.
+          */
+         const size_t num_work_items = ((num_levels == 1) && !half_launch) ? array_length :
+                                              count_block_offsets(array_length,
+                                                compare_distance >> (num_levels - 1), num_levels);
+         const size_t global[OPERAND_DIMS] = { round_up_to_workgroup(num_work_items, workgroup_size) };
+         clSetKernelArg(register_kernels[num_levels], 2, sizeof(compare_distance), (void*)&compare_distance);
+         clSetKernelArg(register_kernels[num_levels], 3, sizeof(partition_size), (void*)&partition_size);
+         clEnqueueNDRangeKernel(*queue, register_kernels[num_levels], OPERAND_DIMS, NULL, global, local, 0, NULL,
+                                  add_profiled_command(profile, PROFILED_GLOBAL_MERGE_STEPS, partition_size,
+                                                         compare_distance, num_levels, launch_bytes));
+         compare_distance >>= num_levels;
+    }
+
+    // Perform the remaining merge steps of the current partition size within local memory
+    const unsigned int tile_compare_distance = tile_size / 2;
+    clSetKernelArg(local_kernel, 3, sizeof(tile_compare_distance), (void*)&tile_compare_distance);
+    clSetKernelArg(local_kernel, 4, sizeof(partition_size), (void*)&partition_size);
+    clSetKernelArg(local_kernel, 5, sizeof(partition_size), (void*)&partition_size);
+    clEnqueueNDRangeKernel(*queue, local_kernel, OPERAND_DIMS, NULL, global_tile, local_tile, 0, NULL,
+                             add_profiled_command(profile, PROFILED_LOCAL_MERGE_STEPS, partition_size,
+                                                    tile_compare_distance, count_network_merge_steps(tile_size) -
+                                                      count_network_merge_steps(tile_size / 2), launch_bytes));
+}
+
+/*
+ * Enqueues into "queue" all remaining merge steps of the bitonic sorting network of "network_length"
+ * elements (i.e. those of partition sizes larger than a tile) after "enqueue_bitonic_sort_tiles",
+ * using kernels whose first 6 arguments (first 4 arguments for kernels performing merge steps in
+ * global memory) match those of the keys-only kernels; all of their arguments except for the compare
+ * distance and partition sizes have to be set already.
+ * - local_kernel --- kernel performing all merge steps that fit within a tile in local memory.
+ * - register_kernels --- kernels performing as many consecutive merge steps as their index within
+ *                        this array, for up to "max_merge_levels" merge steps per launch.
+ * - half_launch --- non-zero if the kernel performing a single merge step launches one work-item
+ *                   per pair of elements being compared, zero if one work-item per element.
+ * - workgroup_size --- number of work-items per workgroup of every launch.
+ * - profile --- profile to which every launch is added as reading and writing "launch_bytes"
+ *               bytes, or NULL.
+ */
+static void enqueue_bitonic_merge_network(cl_command_queue *queue, const unsigned int array_length,
+                                            const unsigned int network_length, cl_kernel local_kernel,
+                                              cl_kernel* register_kernels, const unsigned int max_merge_levels,
+                                                const unsigned int half_launch, const unsigned int workgroup_size,
+                                                  struct Bitonic_Profile* profile, const size_t launch_bytes) {
+    const unsigned int tile_size = get_tile_size(network_length, workgroup_size);
 
     /* 
-     * Iterate over all different partition sizes for array, where each partition is half of the
+     * Iterate over all remaining partition sizes for array, where each partition is half of the
      * subarray of each of the bitonic sequences being created during each iteration.
      */
-    for (unsigned int partition_size = 2; partition_size <= input_array->padded_2n_length;
-                                                                                 partition_size *= 2) {
-          /*
-           * Iterate over all different compare distances, where each compare distance is how far
-           * apart the numbers being compared are for constructing the bitonic sequences.
-           */     
-        for ( unsigned int compare_distance = partition_size / 2; compare_distance > 0; compare_distance /= 2) {
-             /*
-              * For each iteration, rearrange numbers in the array on device memory to create bitonic sequences of
-              * length = twice the partition size using all possible different compare distances, where
-              * each compare distance is a power of 2.
-              */
-             clSetKernelArg(*kernel, 1, sizeof(compare_distance), (void*)&compare_distance);
-             clSetKernelArg(*kernel, 2, sizeof(partition_size), (void*)&partition_size);
-             clEnqueueNDRangeKernel(*queue, *kernel, OPERAND_DIMS, NULL, global, local, 0, NULL, &event);
-        }
+    for (unsigned int partition_size = 2 * tile_size; partition_size <= network_length; partition_size *= 2) {
+        enqueue_partition_merge_steps(queue, array_length, tile_size, partition_size, partition_size / 2,
+                                        local_kernel, register_kernels, max_merge_levels, half_launch,
+                                          workgroup_size, profile, launch_bytes);
     }
+}
 
-    // Wait for all sorting to be finished
+// Waits for all commands enqueued into "queue" so far to be finished
+static void wait_for_queue(cl_command_queue *queue) {
+    // The last event to be performed in the command queue on the OpenCL device
+    cl_event event;
+
+    clEnqueueMarkerWithWaitList(*queue, 0, NULL, &event);
     clWaitForEvents(1, &event);
+    clReleaseEvent(event);
+}
+
+void create_bitonic_kernels(cl_program* program, const unsigned int array_type, const unsigned int payload_kind,
+                              const unsigned int workgroup_size, struct Bitonic_Kernels* kernels) {
+    // No null pointers allowed
+    assert(program != NULL);
+    assert(kernels != NULL);
+    // Make sure data type and kind of payload are of valid values
+    assert(array_type < NUM_ARRAY_TYPES);
+    assert(payload_kind < NUM_PAYLOAD_KINDS);
+
+    kernels->payload_kind = payload_kind;
+    kernels->workgroup_size = workgroup_size;
+    kernels->profile = NULL;
+    kernels->merge_kernel = NULL;
+    kernels->merge_buffer = NULL;
+    kernels->float_to_sortable_kernel = NULL;
+    kernels->sortable_to_float_kernel = NULL;
+    for (unsigned int num_levels = 0; num_levels <= MAX_REGISTER_MERGE_LEVELS; ++num_levels) {
+        kernels->register_kernels[num_levels] = NULL;
+    }
+
+    if (payload_kind == NO_PAYLOAD) {
+        kernels->local_kernel = clCreateKernel(*program, LOCAL_KERNEL_FUNC_NAME, NULL);
+        kernels->register_kernels[1] = clCreateKernel(*program, KERNEL_FUNC_NAME, NULL);
+        for (unsigned int num_levels = 2; num_levels <= MAX_REGISTER_MERGE_LEVELS; ++num_levels) {
+            kernels->register_kernels[num_levels] = clCreateKernel(*program,
+                                                        register_kernel_func_names[num_levels], NULL);
+        }
+        kernels->max_merge_levels = MAX_REGISTER_MERGE_LEVELS;
+        if (UPPER_LEVELS_MERGE_PATH) {
+            cl_int func_error_code;
+            kernels->merge_kernel = clCreateKernel(*program, MERGE_PATH_KERNEL_FUNC_NAME, &func_error_code);
+            assert(func_error_code == CL_SUCCESS);
+        }
+        // Only programs of floating point numbers turn their numbers into integers and back
+        if ((array_type == FLOAT) || (array_type == DOUBLE)) {
+            cl_int func_error_code;
+            kernels->float_to_sortable_kernel = clCreateKernel(*program, FLOAT_TO_SORTABLE_KERNEL_FUNC_NAME,
+                                                                 &func_error_code);
+            assert(func_error_code == CL_SUCCESS);
+            kernels->sortable_to_float_kernel = clCreateKernel(*program, SORTABLE_TO_FLOAT_KERNEL_FUNC_NAME,
+                                                                 &func_error_code);
+            assert(func_error_code == CL_SUCCESS);
+        }
+    } else {
+        /*
+         * Only single merge steps are performed in global memory when sorting by key, as holding
+         * both keys and payloads of several merge steps in private memory would be too much for
+         * most devices.
+         */
+        kernels->local_kernel = clCreateKernel(*program, LOCAL_KERNEL_BY_KEY_FUNC_NAME, NULL);
+        kernels->register_kernels[1] = clCreateKernel(*program, KERNEL_BY_KEY_FUNC_NAME, NULL);
+        kernels->max_merge_levels = 1;
+    }
+    kernels->merge_levels_per_launch = kernels->max_merge_levels;
+}
+
+void release_bitonic_kernels(struct Bitonic_Kernels* kernels) {
+    // No null pointers allowed
+    assert(kernels != NULL);
+
+    clReleaseKernel(kernels->local_kernel);
+    for (unsigned int num_levels = 1; num_levels <= kernels->max_merge_levels; ++num_levels) {
+        clReleaseKernel(kernels->register_kernels[num_levels]);
+        kernels->register_kernels[num_levels] = NULL;
+    }
+    if (kernels->merge_kernel != NULL) {
+        clReleaseKernel(kernels->merge_kernel);
+        kernels->merge_kernel = NULL;
+    }
+    if (kernels->float_to_sortable_kernel != NULL) {
+        clReleaseKernel(kernels->float_to_sortable_kernel);
+        clReleaseKernel(kernels->sortable_to_float_kernel);
+        kernels->float_to_sortable_kernel = NULL;
+        kernels->sortable_to_float_kernel = NULL;
+    }
+    kernels->local_kernel = NULL;
+}
+
+/*
+ * Sets every argument of "kernels" other than the compare distance and partition sizes for sorting
+ * the array of "array_length" elements of data type "array_type" within "buffer_in" (along with
+ * "buffer_payload" and "generate_indices" if the kernels move payloads, refer to
+ * "enqueue_bitonic_sort"), with tiles of "tile_size" elements in local memory.
+ */
+static void set_bitonic_kernel_args(struct Bitonic_Kernels* kernels, cl_mem* buffer_in, cl_mem* buffer_payload,
+                                      const unsigned int array_length, const unsigned int array_type,
+                                        const unsigned int tile_size, const unsigned int generate_indices) {
+    const unsigned int payload_kind = kernels->payload_kind;
+    const unsigned int has_payload = (payload_kind != NO_PAYLOAD);
+
+    /*
+     * Set 1st argument of each kernel performing merge steps in global memory to address of loaded
+     * buffer and 2nd argument to the array length (direction of sort is built into the program),
+     * followed by the buffer of payloads as the 5th argument when sorting by key.
+     */
+    for (unsigned int num_levels = 1; num_levels <= kernels->max_merge_levels; ++num_levels) {
+        clSetKernelArg(kernels->register_kernels[num_levels], 0, sizeof(*buffer_in), (void*)buffer_in);
+        clSetKernelArg(kernels->register_kernels[num_levels], 1, sizeof(array_length), (void*)&array_length);
+        if (has_payload) {
+            clSetKernelArg(kernels->register_kernels[num_levels], 4, sizeof(*buffer_payload),
+                                                                         (void*)buffer_payload);
+        }
+    }
+
+    /*
+     * Same for the local memory kernel, except that 2nd argument is the tile in local memory
+     * and the 3rd argument is the array length; when sorting by key, the buffer of payloads,
+     * the tile of payloads in local memory and whether to generate indices as payloads are
+     * the 7th, 8th and 9th arguments.
+     */
+    cl_kernel local_kernel = kernels->local_kernel;
+    clSetKernelArg(local_kernel, 0, sizeof(*buffer_in), (void*)buffer_in);
+    clSetKernelArg(local_kernel, 1, tile_size * get_array_type_size(array_type), NULL);
+    clSetKernelArg(local_kernel, 2, sizeof(array_length), (void*)&array_length);
+    if (has_payload) {
+        clSetKernelArg(local_kernel, 6, sizeof(*buffer_payload), (void*)buffer_payload);
+        clSetKernelArg(local_kernel, 7, tile_size * get_payload_kind_size(payload_kind), NULL);
+        clSetKernelArg(local_kernel, 8, sizeof(generate_indices), (void*)&generate_indices);
+    }
+}
+
+// Returns the number of merge steps each launch of "kernels" performs at most
+static unsigned int get_merge_levels_per_launch(const struct Bitonic_Kernels* kernels) {
+    return (kernels->merge_levels_per_launch < kernels->max_merge_levels) ?
+             kernels->merge_levels_per_launch : kernels->max_merge_levels;
+}
+
+/*
+ * Enqueues every merge step of the bitonic sorting network of "network_length" elements (a power
+ * of 2) for every block of that many elements of the array, so that every block ends up sorted on
+ * its own (i.e. the whole array if "network_length" is at least the array length); parameters are
+ * otherwise the same as those of "enqueue_bitonic_sort".
+ */
+static void enqueue_bitonic_network(cl_command_queue *queue, struct Bitonic_Kernels* kernels, cl_mem* buffer_in,
+                                      cl_mem* buffer_payload, const unsigned int array_length,
+                                        const unsigned int array_type, const unsigned int generate_indices,
+                                                                          const unsigned int network_length) {
+    // No null pointers allowed, except for the buffer of payloads when there are no payloads
+    assert(queue != NULL);
+    assert(kernels != NULL);
+    assert(buffer_in != NULL);
+    assert((kernels->payload_kind == NO_PAYLOAD) || (buffer_payload != NULL));
+    // Array length HAS to be at least 1
+    assert(array_length >= 1);
+    // Make sure data type is of valid value
+    assert(array_type < NUM_ARRAY_TYPES);
+    // Workgroup size HAS to be a power of 2, and at least one merge step has to be performed per launch
+    assert((kernels->workgroup_size > 0) && ((kernels->workgroup_size & (kernels->workgroup_size - 1)) == 0));
+    assert(kernels->merge_levels_per_launch >= 1);
+
+    const unsigned int payload_kind = kernels->payload_kind;
+    const unsigned int has_payload = (payload_kind != NO_PAYLOAD);
+    const unsigned int workgroup_size = kernels->workgroup_size;
+    // Every launch reads and writes every key (and payload) of the array once
+    const size_t launch_bytes = 2 * (size_t)array_length * (get_array_type_size(array_type) +
+                                                              (has_payload ? get_payload_kind_size(payload_kind) : 0));
+
+    // Arrays of a single element are always sorted, but their index may still need to be generated
+    if (array_length < 2) {
+        if (has_payload && generate_indices) {
+            const cl_ulong first_index = 0;
+            const size_t payload_size = get_payload_kind_size(payload_kind);
+            clEnqueueFillBuffer(*queue, *buffer_payload, &first_index, payload_size, CL_BUFFER_OFFSET,
+                                                                           payload_size, 0, NULL, NULL);
+        }
+        return;
+    }
+
+    const unsigned int tile_size = get_tile_size(network_length, workgroup_size);
+    cl_kernel local_kernel = kernels->local_kernel;
+    set_bitonic_kernel_args(kernels, buffer_in, buffer_payload, array_length, array_type, tile_size,
+                                                                                  generate_indices);
+
+    enqueue_bitonic_sort_tiles(queue, array_length, network_length, local_kernel, workgroup_size,
+                                                                    kernels->profile, launch_bytes);
+    // Indices only get generated once, when sorting each tile from scratch
+    if (has_payload) {
+        const unsigned int load_payloads = 0;
+        clSetKernelArg(local_kernel, 8, sizeof(load_payloads), (void*)&load_payloads);
+    }
+    enqueue_bitonic_merge_network(queue, array_length, network_length, local_kernel, kernels->register_kernels,
+                                    get_merge_levels_per_launch(kernels), has_payload || MERGE_STEP_HALF_LAUNCH,
+                                      workgroup_size, kernels->profile, launch_bytes);
+}
+
+
+void enqueue_bitonic_sort_blocks(cl_command_queue *queue, struct Bitonic_Kernels* kernels, cl_mem* buffer_in,
+                                   const unsigned int array_length, const unsigned int array_type,
+                                                                   const unsigned int block_length) {
+    // Only keys get sorted in blocks, and blocks HAVE to be a power of 2 long
+    assert(kernels != NULL);
+    assert(kernels->payload_kind == NO_PAYLOAD);
+    assert((block_length > 0) && ((block_length & (block_length - 1)) == 0));
+
+    // Blocks of a single element are always sorted
+    if (block_length < 2) {
+        return;
+    }
+    const unsigned int network_length = get_network_length(array_length);
+    enqueue_bitonic_network(queue, kernels, buffer_in, NULL, array_length, array_type, 0,
+                              (block_length < network_length) ? block_length : network_length);
+}
+
+void enqueue_bitonic_merge_blocks(cl_command_queue *queue, struct Bitonic_Kernels* kernels, cl_mem* buffer_in,
+                                    const unsigned int array_length, const unsigned int array_type,
+                                                                    const unsigned int block_length) {
+    // No null pointers allowed
+    assert(queue != NULL);
+    assert(kernels != NULL);
+    assert(buffer_in != NULL);
+    // Array length HAS to be at least 1, and only keys get merged in blocks which are a power of 2 long
+    assert(array_length >= 1);
+    assert(kernels->payload_kind == NO_PAYLOAD);
+    assert((block_length > 0) && ((block_length & (block_length - 1)) == 0));
+
+    if ((array_length < 2) || (block_length < 2)) {
+        return;
+    }
+    const unsigned int tile_size = get_tile_size(block_length, kernels->workgroup_size);
+    const size_t launch_bytes = 2 * (size_t)array_length * get_array_type_size(array_type);
+    set_bitonic_kernel_args(kernels, buffer_in, NULL, array_length, array_type, tile_size, 0);
+
+    /*
+     * The half-cleaners of a block are the merge steps of the partition size twice as large as the
+     * block, but without the first merge step of that partition size (which compares blocks pairwise).
+     */
+    enqueue_partition_merge_steps(queue, array_length, tile_size, 2 * block_length, block_length / 2,
+                                    kernels->local_kernel, kernels->register_kernels,
+                                      get_merge_levels_per_launch(kernels), MERGE_STEP_HALF_LAUNCH,
+                                        kernels->workgroup_size, kernels->profile, launch_bytes);
+}
+
+/*
+ * Returns the length of the sorted runs the merge path kernel starts off merging, for workgroups of
+ * "workgroup_size" work-items: a tile of the local memory kernel, unless each workgroup of the merge
+ * path kernel merges more than two such tiles at once (so that its tiles would straddle pairs of runs).
+ */
+static unsigned int get_merge_path_run_length(const unsigned int workgroup_size) {
+    const unsigned int bitonic_tile_size = LOCAL_TILE_ELEMENTS_PER_WORK_ITEM * workgroup_size;
+    const unsigned int merge_tile_size = MERGE_PATH_ELEMENTS_PER_WORK_ITEM * workgroup_size;
+    return (2 * bitonic_tile_size < merge_tile_size) ? (merge_tile_size / 2) : bitonic_tile_size;
+}
+
+/*
+ * Enqueues into "queue" the merges of pairs of sorted runs along the merge path using "merge_kernel",
+ * starting off with runs of "run_length" elements (a power of 2, at least "get_merge_path_run_length")
+ * of the array of "array_length" elements of data type "array_type" within "buffer_in", until the
+ * whole array is a single sorted run. Each launch reads from one of "buffer_in" and "temp_buffer" (at
+ * least as large as the array) and writes into the other, and the sorted array gets copied back into
+ * "buffer_in" if it ends up within "temp_buffer". Workgroups are made up of "workgroup_size" work-items;
+ * every command is added to "profile" (unless NULL). Returns zero if any launch fails to be enqueued,
+ * in which case the array (sorted or not) is left within "buffer_in" once the commands enqueued finish.
+ */
+static int enqueue_merge_path_merges(cl_command_queue *queue, cl_kernel merge_kernel, cl_mem* buffer_in,
+                                        cl_mem* temp_buffer, const unsigned int array_length,
+                                          const unsigned int array_type, const unsigned int run_length,
+                                            const unsigned int workgroup_size, struct Bitonic_Profile* profile) {
+    const unsigned int elements_per_work_item = MERGE_PATH_ELEMENTS_PER_WORK_ITEM;
+    const unsigned int tile_size = elements_per_work_item * workgroup_size;
+    const size_t element_size = get_array_type_size(array_type);
+    // Every launch (and the copy back) reads and writes every number of the array once
+    const size_t launch_bytes = 2 * (size_t)array_length * element_size;
+    const size_t local[OPERAND_DIMS] = { workgroup_size };
+    const size_t global[OPERAND_DIMS] = { ((array_length + (size_t)tile_size - 1) / tile_size) * workgroup_size };
+
+    // Tiles of each workgroup HAVE to be within a single pair of runs
+    assert(tile_size <= 2 * (size_t)run_length);
+
+    // Local memory holds the parts of both runs merging into the tile, followed by the merged tile
+    clSetKernelArg(merge_kernel, 2, 2 * tile_size * element_size, NULL);
+    clSetKernelArg(merge_kernel, 3, 2 * sizeof(cl_uint), NULL);
+    clSetKernelArg(merge_kernel, 4, sizeof(array_length), (void*)&array_length);
+    clSetKernelArg(merge_kernel, 6, sizeof(elements_per_work_item), (void*)&elements_per_work_item);
+
+    // Run lengths are counted in a wider type, as they may exceed the largest power of 2 of 32 bits
+    cl_mem* source_buffer = buffer_in;
+    cl_mem* destination_buffer = temp_buffer;
+    int merges_enqueued = 1;
+    for (size_t curr_run_length = run_length; merges_enqueued && (curr_run_length < array_length);
+                                                                           curr_run_length *= 2) {
+        const unsigned int kernel_run_length = (unsigned int)curr_run_length;
+        // Launches failing to be enqueued have no event, so they only get added to the profile otherwise
+        cl_event launch_event;
+        clSetKernelArg(merge_kernel, 0, sizeof(*source_buffer), (void*)source_buffer);
+        clSetKernelArg(merge_kernel, 1, sizeof(*destination_buffer), (void*)destination_buffer);
+        clSetKernelArg(merge_kernel, 5, sizeof(kernel_run_length), (void*)&kernel_run_length);
+        merges_enqueued = (clEnqueueNDRangeKernel(*queue, merge_kernel, OPERAND_DIMS, NULL, global, local, 0, NULL,
+                                                    (profile != NULL) ? &launch_event : NULL) == CL_SUCCESS);
+        if (merges_enqueued) {
+            cl_event* profiled_launch_event = add_profiled_command(profile, PROFILED_MERGE_PATH,
+                                                  2 * kernel_run_length, kernel_run_length, 1, launch_bytes);
+            if (profiled_launch_event != NULL) {
+                *profiled_launch_event = launch_event;
+            }
+
+            cl_mem* merged_buffer = destination_buffer;
+            destination_buffer = source_buffer;
+            source_buffer = merged_buffer;
+        }
+    }
+    // The last buffer written into holds the whole array, merged as far as the launches enqueued got
+    if (source_buffer != buffer_in) {
+        cl_int func_error_code = clEnqueueCopyBuffer(*queue, *source_buffer, *buffer_in, CL_BUFFER_OFFSET,
+                                                       CL_BUFFER_OFFSET, array_length * element_size, 0, NULL,
+                                                         add_profiled_command(profile, PROFILED_MERGE_PATH,
+                                                                                0, 0, 0, launch_bytes));
+        assert(func_error_code == CL_SUCCESS);
+    }
+    return merges_enqueued;
+}
+
+void enqueue_bitonic_sort(cl_command_queue *queue, struct Bitonic_Kernels* kernels, cl_mem* buffer_in,
+                            cl_mem* buffer_payload, const unsigned int array_length,
+                              const unsigned int array_type, const unsigned int generate_indices) {
+    /*
+     * Arrays longer than the runs the merge path starts off with get their runs sorted by the bitonic
+     * sorting network, and merged along the merge path from there on, if there's a buffer to merge into.
+     */
+    if ((get_merge_buffer_size(kernels, array_length, array_type) > 0) && (kernels->merge_buffer != NULL)) {
+        const unsigned int run_length = get_merge_path_run_length(kernels->workgroup_size);
+        enqueue_bitonic_sort_blocks(queue, kernels, buffer_in, array_length, array_type, run_length);
+        if (enqueue_merge_path_merges(queue, kernels->merge_kernel, buffer_in, kernels->merge_buffer,
+                                        array_length, array_type, run_length, kernels->workgroup_size,
+                                                                                  kernels->profile)) {
+            return;
+        }
+    }
+    enqueue_bitonic_network(queue, kernels, buffer_in, buffer_payload, array_length, array_type, generate_indices,
+                              get_network_length(array_length));
+}
+
+size_t get_bitonic_local_mem_size(const struct Bitonic_Kernels* kernels, const unsigned int array_type,
+                                    const unsigned int workgroup_size) {
+    // No null pointers allowed
+    assert(kernels != NULL);
+
+    // Tiles of the local memory kernel hold keys, along with their payloads when sorting by key
+    const size_t element_size = get_array_type_size(array_type);
+    const size_t payload_size = (kernels->payload_kind != NO_PAYLOAD) ? get_payload_kind_size(kernels->payload_kind) : 0;
+    size_t local_mem_size = LOCAL_TILE_ELEMENTS_PER_WORK_ITEM * (size_t)workgroup_size * (element_size + payload_size);
+
+    // Tiles of the merge path kernel hold the parts of both runs and the merged tile, plus two co-ranks
+    if (kernels->merge_kernel != NULL) {
+        const size_t merge_local_mem_size = 2 * MERGE_PATH_ELEMENTS_PER_WORK_ITEM * (size_t)workgroup_size *
+                                              element_size + 2 * sizeof(cl_uint);
+        if (merge_local_mem_size > local_mem_size) {
+            local_mem_size = merge_local_mem_size;
+        }
+    }
+    return local_mem_size;
+}
+
+unsigned int fit_bitonic_workgroup_size(const struct Bitonic_Kernels* kernels, cl_device_id device,
+                                          const unsigned int array_type, unsigned int workgroup_size) {
+    // No null pointers allowed
+    assert(kernels != NULL);
+
+    cl_ulong local_mem_size;
+    cl_int func_error_code = clGetDeviceInfo(device, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(local_mem_size),
+                                               &local_mem_size, NULL);
+    assert(func_error_code == CL_SUCCESS);
+    while ((workgroup_size > 1) && (get_bitonic_local_mem_size(kernels, array_type, workgroup_size) > local_mem_size)) {
+        workgroup_size /= 2;
+    }
+    return workgroup_size;
+}
+
+size_t get_merge_buffer_size(const struct Bitonic_Kernels* kernels, const unsigned int array_length,
+                               const unsigned int array_type) {
+    // No null pointers allowed
+    assert(kernels != NULL);
+
+    // Only keys get merged along the merge path, and only beyond the runs the merge path starts off with
+    if ((kernels->merge_kernel == NULL) || (array_length <= get_merge_path_run_length(kernels->workgroup_size))) {
+        return 0;
+    }
+    return array_length * get_array_type_size(array_type);
+}
+
+cl_mem* grow_merge_buffer(cl_context context, cl_mem* merge_buffer, size_t* merge_buffer_size,
+                            const size_t buffer_size) {
+    // No null pointers allowed
+    assert(merge_buffer != NULL);
+    assert(merge_buffer_size != NULL);
+
+    if (buffer_size == 0) {
+        return NULL;
+    }
+    if (*merge_buffer_size < buffer_size) {
+        if (*merge_buffer != NULL) {
+            clReleaseMemObject(*merge_buffer);
+        }
+        cl_int func_error_code;
+        *merge_buffer = clCreateBuffer(context, CL_MEM_READ_WRITE, buffer_size, NULL, &func_error_code);
+        if (func_error_code != CL_SUCCESS) {
+            *merge_buffer = NULL;
+            *merge_buffer_size = 0;
+            return NULL;
+        }
+        *merge_buffer_size = buffer_size;
+    }
+    return merge_buffer;
+}
+
+void use_program_cache_merge_buffer(struct Bitonic_Program_Cache* program_cache, struct Bitonic_Kernels* kernels,
+                                      const unsigned int array_length, const unsigned int array_type) {
+    // No null pointers allowed
+    assert(program_cache != NULL);
+    assert(kernels != NULL);
+
+    kernels->merge_buffer = grow_merge_buffer(program_cache->context, &(program_cache->merge_buffer),
+                                                &(program_cache->merge_buffer_size),
+                                                  get_merge_buffer_size(kernels, array_length, array_type));
+}
+
+void opencl_bitonic_sort(cl_command_queue *queue, struct Bitonic_Program_Cache* program_cache,
+                            cl_mem* buffer_in, const unsigned int array_length,
+                              const unsigned int array_type, const unsigned int sorting_direction) {
+    // No null pointers allowed
+    assert(queue != NULL);
+    assert(program_cache != NULL);
+    assert(buffer_in != NULL);
+    // Array length HAS to be at least 1
+    assert(array_length >= 1);
+    // Make sure data type and sort_direction are of valid values
+    assert(array_type < NUM_ARRAY_TYPES);
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+
+    // Program whose kernels are specialized for the data type and direction of sort
+    cl_program* program = get_bitonic_program(program_cache, array_type, sorting_direction, NO_PAYLOAD);
+    // Kernels performing merge steps
+    struct Bitonic_Kernels kernels;
+
+    // Generate the kernel runtime with workgroups whose tiles fit within local memory
+    create_bitonic_kernels(program, array_type, NO_PAYLOAD, program_cache->workgroup_size, &kernels);
+    kernels.workgroup_size = fit_bitonic_workgroup_size(&kernels, program_cache->device, array_type,
+                                                          program_cache->workgroup_size);
+
+    // Notify user sorting starts now
+    printf(NOTIFY_USER_SORT_OPENCL_START, array_type_names[array_type], kernels.workgroup_size,
+                                                  sorting_direction_names[sorting_direction]);
+
+    // Sort and wait for all sorting to be finished
+    kernels.merge_levels_per_launch = program_cache->merge_levels_per_launch;
+    kernels.profile = program_cache->profile;
+
+    // The sort is finished before returning, so the merge buffer of the program cache is free again afterwards
+    use_program_cache_merge_buffer(program_cache, &kernels, array_length, array_type);
+    enqueue_bitonic_sort(queue, &kernels, buffer_in, NULL, array_length, array_type, 0);
+    wait_for_queue(queue);
+    release_bitonic_kernels(&kernels);
 
 } 
 
+void opencl_bitonic_sort_by_key(cl_command_queue *queue, struct Bitonic_Program_Cache* program_cache,
+                                  cl_mem* buffer_in, cl_mem* buffer_payload, const unsigned int array_length,
+                                    const unsigned int array_type, const unsigned int payload_kind,
+                                      const unsigned int generate_indices, const unsigned int sorting_direction) {
+    // No null pointers allowed
+    assert(queue != NULL);
+    assert(program_cache != NULL);
+    assert(buffer_in != NULL);
+    assert(buffer_payload != NULL);
+    // Array length HAS to be at least 1
+    assert(array_length >= 1);
+    // Make sure data type, kind of payload and sort_direction are of valid values
+    assert(array_type < NUM_ARRAY_TYPES);
+    assert((payload_kind == PAYLOAD_32_BIT) || (payload_kind == PAYLOAD_64_BIT));
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+
+    // Program whose kernels are specialized for the data type, direction of sort and kind of payload
+    cl_program* program = get_bitonic_program(program_cache, array_type, sorting_direction, payload_kind);
+    // Key-value kernels performing merge steps
+    struct Bitonic_Kernels kernels;
+
+    // Generate the kernel runtime with workgroups whose tiles fit within local memory
+    create_bitonic_kernels(program, array_type, payload_kind, program_cache->workgroup_size, &kernels);
+    kernels.workgroup_size = fit_bitonic_workgroup_size(&kernels, program_cache->device, array_type,
+                                                          program_cache->workgroup_size);
+
+    // Notify user sorting starts now
+    printf(NOTIFY_USER_SORT_OPENCL_START, array_type_names[array_type], kernels.workgroup_size,
+                                                  sorting_direction_names[sorting_direction]);
+
+    // Sort and wait for all sorting to be finished
+    kernels.merge_levels_per_launch = program_cache->merge_levels_per_launch;
+    kernels.profile = program_cache->profile;
+    enqueue_bitonic_sort(queue, &kernels, buffer_in, buffer_payload, array_length, array_type, generate_indices);
+    wait_for_queue(queue);
+    release_bitonic_kernels(&kernels);
+
+}
+
 // =================================================================================================
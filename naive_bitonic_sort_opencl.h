@@ -54,67 +54,64 @@
  * - DOUBLE 
  */
 #define ARRAY_TYPE DOUBLE
+// Number of different permitted macro values for ARRAY_TYPE above
+#define NUM_ARRAY_TYPES 5
+// Number of different sorting directions
+#define NUM_SORTING_DIRECTIONS 2
+
+/*
+ * Custom definitions of permitted kinds of payloads moved along with each key (i.e. each
+ * element of the array being sorted) when sorting by key; with "NO_PAYLOAD" only the keys
+ * themselves get sorted.
+ */
+#define NO_PAYLOAD 0
+#define PAYLOAD_32_BIT 1
+#define PAYLOAD_64_BIT 2
+// Number of different permitted kinds of payloads above
+#define NUM_PAYLOAD_KINDS 3
 /*
- * Declared type of each array within OpenCL
- * and host program files. Also customize message
- * to user about what's being sorted based on
- * data type and sorting direction.
+ * Declared type of each array within host program files,
+ * based on the data type selected by ARRAY_TYPE.
  */
 #if(ARRAY_TYPE == CHAR)
   #define ARRAY_TYPE_DECLARED char
-  #define COMPILER_ARRAY_TYPE_OPTION "-DARRAY_TYPE=char"
-  #if(SORTING_DIRECTION == ASCENDING_SORT)
-    #define NOTIFY_USER_SORT_OPENCL_START ">>> Starting OpenCL parallelized bitonic sorting of chars"\
-                                            " with %d work-items per workgroup, sort ascending...\n"
-  #elif(SORTING_DIRECTION == DESCENDING_SORT)
-    #define NOTIFY_USER_SORT_OPENCL_START ">>> Starting OpenCL parallelized bitonic sorting of chars"\
-                                            " with %d work-items per workgroup, sort descending...\n"
-  #endif
 #elif (ARRAY_TYPE == INT)
   #define ARRAY_TYPE_DECLARED int
-  #define COMPILER_ARRAY_TYPE_OPTION "-DARRAY_TYPE=int"
-  #if(SORTING_DIRECTION == ASCENDING_SORT)
-    #define NOTIFY_USER_SORT_OPENCL_START ">>> Starting OpenCL parallelized bitonic sorting of ints"\
-                                             " with %d work-items per workgroup, sort ascending...\n"
-  #elif(SORTING_DIRECTION == DESCENDING_SORT)
-    #define NOTIFY_USER_SORT_OPENCL_START ">>> Starting OpenCL parallelized bitonic sorting of ints"\
-                                             " with %d work-items per workgroup, sort descending...\n"
-  #endif
 #elif (ARRAY_TYPE == LONG)
   #define ARRAY_TYPE_DECLARED long
-  #define COMPILER_ARRAY_TYPE_OPTION "-DARRAY_TYPE=long"
-  #if(SORTING_DIRECTION == ASCENDING_SORT)
-    #define NOTIFY_USER_SORT_OPENCL_START ">>> Starting OpenCL parallelized bitonic sorting of longs"\
-                                              " with %d work-items per workgroup, sort ascending...\n"
-  #elif(SORTING_DIRECTION == DESCENDING_SORT)
-    #define NOTIFY_USER_SORT_OPENCL_START ">>> Starting OpenCL parallelized bitonic sorting of longs"\
-                                              " with %d work-items per workgroup, sort descending...\n"
-  #endif
 #elif (ARRAY_TYPE == FLOAT)
   #define ARRAY_TYPE_DECLARED float
-  #define COMPILER_ARRAY_TYPE_OPTION "-DARRAY_TYPE=float"
-  #if(SORTING_DIRECTION == ASCENDING_SORT)
-    #define NOTIFY_USER_SORT_OPENCL_START ">>> Starting OpenCL parallelized bitonic sorting of floats"\
-                                                " with %d work-items per workgroup, sort ascending...\n"
-  #elif(SORTING_DIRECTION == DESCENDING_SORT)
-    #define NOTIFY_USER_SORT_OPENCL_START ">>> Starting OpenCL parallelized bitonic sorting of floats"\
-                                                " with %d work-items per workgroup, sort descending...\n"
-  #endif
 #elif (ARRAY_TYPE == DOUBLE)
   #define ARRAY_TYPE_DECLARED double
-  #define COMPILER_ARRAY_TYPE_OPTION "-DARRAY_TYPE=double"
-  #if(SORTING_DIRECTION == ASCENDING_SORT)
-    #define NOTIFY_USER_SORT_OPENCL_START ">>> Starting OpenCL parallelized bitonic sorting of doubles"\
-                                                " with %d work-items per workgroup, sort ascending...\n"
-  #elif(SORTING_DIRECTION == DESCENDING_SORT)
-    #define NOTIFY_USER_SORT_OPENCL_START ">>> Starting OpenCL parallelized bitonic sorting of doubles"\
-                                                " with %d work-items per workgroup, sort descending...\n"
-  #endif
 #endif
 
+/*
+ * Message to user about what's being sorted; the data type, number of work-items
+ * and sorting direction are all filled in at runtime.
+ */
+#define NOTIFY_USER_SORT_OPENCL_START ">>> Starting OpenCL parallelized bitonic sorting of %ss"\
+                                            " with %d work-items per workgroup, sort %s...\n"
+// Message to user containing compiler output for each OpenCL program built
+#define NOTIFY_USER_PROGRAM_BUILD_LOG ">>> OpenCL program compiler result message (%ss, sort %s): - %s\n\n"
+/*
+ * Options for compiling the OpenCL program file, specializing the kernels
+ * for a data type (i.e. name of the type and its macro value), a sorting
+ * direction (i.e. 0 for ascending, 1 for descending) and a kind of payload
+ * (i.e. any extra options enabling the key-value kernels); maximum length of
+ * the resulting option string.
+ */
+#define PROGRAM_BUILD_OPTIONS_FORMAT "-DARRAY_TYPE=%s -DARRAY_TYPE_INDEX=%u -DSORT_DESCENDING=%u%s"
+#define MAX_BUILD_OPTIONS_LEN 256
+
 /*
  * Threadblock sizes; 64 - 128 is what Intel recommends for most algorithms I believe
- * DO NOT USE THREAD BLOCKS LARGER THAN 256; it WILL BREAK the algorithm.
+ * MUST be a power of 2, but the array being sorted may be of any length; the number
+ * of work-items launched is always rounded up to a multiple of this value. Larger
+ * workgroups are only limited by the device (CL_DEVICE_MAX_WORK_GROUP_SIZE,
+ * CL_KERNEL_WORK_GROUP_SIZE of the kernels and the local memory their tiles take, refer
+ * to "get_session_max_workgroup_size" within "bitonic_sort_session.h"). This is only the
+ * default of each program cache, which may be changed at runtime (refer to the
+ * "workgroup_size" field of "Bitonic_Program_Cache").
  */
 #define NUM_THREADS_IN_BLOCK 256
 // Amount of offset of starting location of buffer contents in device memory
@@ -127,8 +124,88 @@
 
 // File in which program containing OpenCL kernels is stored
 #define PROGRAM_FILE "bitonic_program.cl"
-// Name of kernel function in OpenCL program file
-#define KERNEL_FUNC_NAME "naive_bitonic_sort_merge_step"
+/*
+ * Flag macro indicating whether to compile the copy of PROGRAM_FILE embedded within the
+ * executable at build time (non-zero value), or to read PROGRAM_FILE from the working
+ * directory at runtime (zero).
+ */
+#define EMBED_PROGRAM_SOURCE 1
+// Null-terminated copy of PROGRAM_FILE embedded within the executable at build time
+extern const char bitonic_program_source[];
+/*
+ * Flag macro indicating whether single merge steps are performed by launching only one
+ * work-item per pair of elements being compared (non-zero value), or by launching one
+ * work-item per element where half of the work-items go idle (zero).
+ */
+#define MERGE_STEP_HALF_LAUNCH 1
+// Name of kernel function in OpenCL program file performing a single merge step
+#if (MERGE_STEP_HALF_LAUNCH)
+  #define KERNEL_FUNC_NAME "half_bitonic_sort_merge_step"
+  // Number of elements of the array handled by each work-item of the kernel
+  #define KERNEL_ELEMENTS_PER_WORK_ITEM 2
+#else
+  #define KERNEL_FUNC_NAME "naive_bitonic_sort_merge_step"
+  #define KERNEL_ELEMENTS_PER_WORK_ITEM 1
+#endif
+/*
+ * Name of kernel function in OpenCL program file which performs all merge steps
+ * whose compare distances fit within a tile of the array held in local memory.
+ */
+#define LOCAL_KERNEL_FUNC_NAME "local_bitonic_sort_merge_steps"
+/*
+ * Number of elements in each tile sorted in local memory by the kernel above, per
+ * work-item of each workgroup; each work-item handles a pair of elements in the tile.
+ */
+#define LOCAL_TILE_ELEMENTS_PER_WORK_ITEM 2
+/*
+ * Names of kernel functions in OpenCL program file which each perform 2, 3 and 4
+ * consecutive merge steps with compare distances too large to fit within a tile,
+ * holding 4, 8 and 16 elements per work-item in private memory respectively.
+ */
+#define REGISTER_KERNEL_4_FUNC_NAME "register_bitonic_sort_merge_steps_4"
+#define REGISTER_KERNEL_8_FUNC_NAME "register_bitonic_sort_merge_steps_8"
+#define REGISTER_KERNEL_16_FUNC_NAME "register_bitonic_sort_merge_steps_16"
+// Maximum number of merge steps collapsed into a single kernel launch by the kernels above
+#define MAX_REGISTER_MERGE_LEVELS 4
+/*
+ * Flag macro indicating whether "enqueue_bitonic_sort" (and so every sort of keys built on it) merges
+ * the sorted tiles of the array pairwise with the merge path kernel below, which doubles the length of
+ * the sorted runs with every launch (non-zero value), or keeps performing the merge steps of every
+ * partition size larger than a tile (zero value), which takes a launch per merge step (or per few
+ * merge steps) of each partition size.
+ */
+#define UPPER_LEVELS_MERGE_PATH 1
+// Name of kernel function in OpenCL program file merging pairs of sorted runs along the merge path
+#define MERGE_PATH_KERNEL_FUNC_NAME "merge_path_merge_runs"
+/*
+ * Number of elements of the merged runs written by each work-item of the kernel above (a power of 2);
+ * each workgroup merges a tile of this many elements per work-item within local memory.
+ */
+#define MERGE_PATH_ELEMENTS_PER_WORK_ITEM 4
+/*
+ * Names of key-value variants of the kernel functions performing a single merge step
+ * (one work-item per pair of elements being compared) and all merge steps within a tile.
+ */
+#define KERNEL_BY_KEY_FUNC_NAME "half_bitonic_sort_merge_step_by_key"
+#define LOCAL_KERNEL_BY_KEY_FUNC_NAME "local_bitonic_sort_merge_steps_by_key"
+
+/*
+ * Flag variable literals indicating how arrays get into and out of the memory of
+ * the OpenCL device (refer to "load_array_bitonic_sort"):
+ *  - COPY_HOST_BUFFER --- copy into a separate device buffer and back again
+ *  - USE_HOST_PTR_BUFFER --- wrap the array itself with CL_MEM_USE_HOST_PTR, and
+ *    only map the buffer to read the sorted array; on devices sharing memory
+ *    with the host (e.g. CPUs and integrated GPUs) nothing is ever copied
+ *  - ALLOC_HOST_PTR_BUFFER --- let the OpenCL implementation allocate host memory
+ *    accessible to the device with CL_MEM_ALLOC_HOST_PTR, and fill and read it by
+ *    mapping the buffer (i.e. pinned memory on discrete GPUs)
+ *  - HOST_BUFFER_AUTO --- USE_HOST_PTR_BUFFER if the device shares memory with the
+ *    host and COPY_HOST_BUFFER otherwise (refer to "get_default_host_buffer_mode")
+ */
+#define COPY_HOST_BUFFER 0
+#define USE_HOST_PTR_BUFFER 1
+#define ALLOC_HOST_PTR_BUFFER 2
+#define HOST_BUFFER_AUTO 3
 
 /*
  * Flag variable literals indicating whether the
@@ -143,12 +220,14 @@
  *  - pointer indicating beginning of array
  *  - actual length of array as "array_len_actual"
  *  - "padded_2n_length" indicating the total number
- *    of elements in the array after the array 
- *    has been padded with extra elements (with
- *    each element of the highest value possible)
- *    so that the array length is a power of 2.
+ *    of elements allocated for the array, including
+ *    any padding. The sorting engines only ever touch
+ *    the "array_len_actual" actual elements of the
+ *    array and handle arrays of any length, so arrays
+ *    no longer need to be padded to a power of 2 (i.e.
+ *    this field may simply equal "array_len_actual").
  *  - flag variable indicating whether or not
- *    the padding of the array occurs at the
+ *    the padding of the array (if any) occurs at the
  *    beginning or the end of the array
  */
 struct Array_With_Length_Padded {
@@ -159,10 +238,249 @@ struct Array_With_Length_Padded {
 };
 
 
+/*
+ * A cache of OpenCL programs compiled from the same OpenCL program source for
+ * one OpenCL device, where each program is specialized for one data type (i.e.
+ * one of the permitted values of ARRAY_TYPE), one sorting direction and one
+ * kind of payload; each program is only compiled the first time it's needed,
+ * and then kept around until the cache is released. Compiled programs are also
+ * saved to disk as binaries, so that later runs can skip compilation altogether
+ * (see "program_binary_cache.h"). Fields are the following:
+ *  - context and device for which the programs are compiled
+ *  - copy of the OpenCL program source owned by the cache
+ *  - directory of cached program binaries on disk (NULL to never use binaries)
+ *  - the programs themselves, indexed by data type, then by sorting
+ *    direction and then by kind of payload (NULL if not compiled yet)
+ *  - number of work-items per workgroup of the merge kernels launched with
+ *    programs of this cache; NUM_THREADS_IN_BLOCK unless changed after
+ *    "init_bitonic_program_cache" (MUST be a power of 2 no larger than the
+ *    device allows, refer to NUM_THREADS_IN_BLOCK)
+ *  - maximum number of consecutive merge steps collapsed into a single launch
+ *    by the register-blocked kernels, choosing which of those kernels perform the
+ *    merge steps too large for a tile; MAX_REGISTER_MERGE_LEVELS unless changed
+ *    after "init_bitonic_program_cache" (MUST be from 1 to MAX_REGISTER_MERGE_LEVELS)
+ *  - profile to which every command enqueued by sorts with programs of this
+ *    cache gets added (refer to "bitonic_profile.h"); NULL unless attached
+ *    after "init_bitonic_program_cache"
+ *  - buffer the merge path kernel writes merged runs into (NULL if not allocated
+ *    yet) along with its size in bytes, shared by every sort with programs of this
+ *    cache that waits for its commands to finish (refer to "use_program_cache_merge_buffer")
+ */
+struct Bitonic_Program_Cache {
+     cl_context context;
+     cl_device_id device;
+     char* program_source;
+     const char* binary_cache_dir;
+     cl_program programs[NUM_ARRAY_TYPES][NUM_SORTING_DIRECTIONS][NUM_PAYLOAD_KINDS];
+     unsigned int workgroup_size;
+     unsigned int merge_levels_per_launch;
+     struct Bitonic_Profile* profile;
+     cl_mem merge_buffer;
+     size_t merge_buffer_size;
+};
+
+/*
+ * Prepares an empty "program_cache" for compiling programs from "program_source"
+ * (which gets copied) for "device" within "context", where program binaries are
+ * cached on disk within "binary_cache_dir" (NULL to always compile from source).
+ * The workgroup size and number of merge steps per launch are those tuned for
+ * "device" within the tuning file of "binary_cache_dir", if any (refer to
+ * "bitonic_tuning.h"), and the defaults otherwise. The tuned workgroup size applies
+ * to every data type and kind of payload, so each sort halves it as far as its tiles
+ * need to fit within local memory (refer to "fit_bitonic_workgroup_size").
+ */
+void init_bitonic_program_cache(struct Bitonic_Program_Cache* program_cache, cl_context context,
+                                  cl_device_id device, const char* program_source,
+                                                          const char* binary_cache_dir);
+
+/*
+ * Returns a pointer to the program specialized for "array_type" (one of the permitted
+ * values of ARRAY_TYPE), "sorting_direction" and "payload_kind" (one of the permitted
+ * kinds of payloads, where only programs for payloads other than "NO_PAYLOAD" contain
+ * the key-value kernels) within "program_cache". Programs not in the cache yet are loaded
+ * from a matching cached program binary on disk if there is one, or else compiled from source
+ * (and then saved as a binary); the compiler output is shown to the user whenever a program
+ * gets compiled from source.
+ */
+cl_program* get_bitonic_program(struct Bitonic_Program_Cache* program_cache,
+                                   const unsigned int array_type, const unsigned int sorting_direction,
+                                                                        const unsigned int payload_kind);
+
+// Releases all programs and the merge buffer within "program_cache" along with its copy of the program source
+void release_bitonic_program_cache(struct Bitonic_Program_Cache* program_cache);
+
+/*
+ * Returns the size in bytes of each element of data type "array_type" (one of the
+ * permitted values of ARRAY_TYPE) as seen by OpenCL devices.
+ */
+size_t get_array_type_size(const unsigned int array_type);
+
+/*
+ * Returns the name of data type "array_type" (one of the permitted values of
+ * ARRAY_TYPE) as seen by OpenCL programs, e.g. "int".
+ */
+const char* get_array_type_name(const unsigned int array_type);
+
+/*
+ * Returns the size in bytes of each payload of kind "payload_kind" (one of the permitted
+ * kinds of payloads other than "NO_PAYLOAD") as seen by OpenCL devices.
+ */
+size_t get_payload_kind_size(const unsigned int payload_kind);
+
+/*
+ * The kernels needed for sorting with a program specialized for one data type,
+ * sorting direction and kind of payload, which may be reused for any number
+ * of sorts with that program. Fields are the following:
+ *  - kind of payload moved along with each key by the kernels
+ *  - kernel performing all merge steps that fit within a tile in local memory
+ *  - kernels performing as many consecutive merge steps as their index within
+ *    the array, where index 1 is the kernel performing a single merge step
+ *    (entries above "max_merge_levels" and at index 0 are NULL)
+ *  - highest index of the kernels above that isn't NULL
+ *  - number of work-items per workgroup of every launch (refer to the field
+ *    of the same name of "Bitonic_Program_Cache"), which may be changed
+ *    between sorts
+ *  - maximum number of consecutive merge steps performed by a single launch
+ *    of the kernels above (refer to the field of the same name of
+ *    "Bitonic_Program_Cache"), which may be changed between sorts; launches
+ *    never perform more than "max_merge_levels" merge steps either way
+ *  - profile to which every command enqueued by "enqueue_bitonic_sort" gets
+ *    added, or NULL (refer to the field of the same name of
+ *    "Bitonic_Program_Cache"), which may be changed between sorts as well
+ *  - kernel merging pairs of sorted runs along the merge path (NULL for kernels
+ *    moving payloads, or if UPPER_LEVELS_MERGE_PATH is disabled)
+ *  - buffer of at least "get_merge_buffer_size" bytes the kernel above writes
+ *    merged runs into, which MUST NOT be used by any other sort until the sort is
+ *    finished; NULL (the default) to sort with the bitonic sorting network
+ *    throughout instead. Set by the caller before each sort.
+ *  - kernels turning floating point numbers into signed integers sorting the
+ *    same way and back again (refer to "sortable_keys.h"); NULL for kernels
+ *    moving payloads, or of any data type other than FLOAT and DOUBLE
+ */
+struct Bitonic_Kernels {
+     unsigned int payload_kind;
+     cl_kernel local_kernel;
+     cl_kernel register_kernels[MAX_REGISTER_MERGE_LEVELS + 1];
+     unsigned int max_merge_levels;
+     unsigned int workgroup_size;
+     unsigned int merge_levels_per_launch;
+     struct Bitonic_Profile* profile;
+     cl_kernel merge_kernel;
+     cl_mem* merge_buffer;
+     cl_kernel float_to_sortable_kernel;
+     cl_kernel sortable_to_float_kernel;
+};
+
+/*
+ * Creates the "kernels" needed for sorting with "program" (which MUST have been
+ * compiled for "array_type" and "payload_kind", refer to "get_bitonic_program"),
+ * launched with "workgroup_size" work-items per workgroup, collapsing as many merge
+ * steps into each launch as the kernels can and without any profile or merge buffer
+ * attached.
+ */
+void create_bitonic_kernels(cl_program* program, const unsigned int array_type, const unsigned int payload_kind,
+                              const unsigned int workgroup_size, struct Bitonic_Kernels* kernels);
+
+// Releases all kernels within "kernels"
+void release_bitonic_kernels(struct Bitonic_Kernels* kernels);
+
+/*
+ * Returns the largest amount of local memory in bytes taken by any launch of "kernels" (created
+ * for sorting keys of data type "array_type") with workgroups of "workgroup_size" work-items.
+ */
+size_t get_bitonic_local_mem_size(const struct Bitonic_Kernels* kernels, const unsigned int array_type,
+                                    const unsigned int workgroup_size);
+
+/*
+ * Returns "workgroup_size", halved as often as needed for the tiles of "kernels" (created for
+ * sorting keys of data type "array_type") to fit within the local memory of "device". The
+ * workgroup size of a program cache (refer to "init_bitonic_program_cache") applies to all data
+ * types and kinds of payload, so larger keys or payloads may have to make do with smaller
+ * workgroups.
+ */
+unsigned int fit_bitonic_workgroup_size(const struct Bitonic_Kernels* kernels, cl_device_id device,
+                                          const unsigned int array_type, unsigned int workgroup_size);
+
+/*
+ * Returns the size in bytes of the merge buffer "kernels" need for sorting an array of
+ * "array_length" elements of data type "array_type" along the merge path with their current
+ * workgroup size, or zero if such an array is sorted by the bitonic sorting network alone.
+ */
+size_t get_merge_buffer_size(const struct Bitonic_Kernels* kernels, const unsigned int array_length,
+                               const unsigned int array_type);
+
+/*
+ * Returns "merge_buffer" (currently of "merge_buffer_size" bytes, or NULL if not allocated yet)
+ * after growing it within "context" to at least "buffer_size" bytes if it's smaller than that.
+ * Returns NULL instead if "buffer_size" is zero, or if the buffer can't be allocated (leaving no
+ * buffer allocated), in which case sorts fall back to the bitonic sorting network. Commands already
+ * enqueued keep using the old buffer, which OpenCL only deletes once they're finished.
+ */
+cl_mem* grow_merge_buffer(cl_context context, cl_mem* merge_buffer, size_t* merge_buffer_size,
+                            const size_t buffer_size);
+
+/*
+ * Attaches the merge buffer of "program_cache" to "kernels" (created from a program of the
+ * cache), grown as needed for sorting an array of "array_length" elements of data type
+ * "array_type" (refer to "get_merge_buffer_size"). Only for sorts of which no two run at the
+ * same time, e.g. sorts waiting for their commands to finish or sorts enqueued into the same
+ * in-order command queue.
+ */
+void use_program_cache_merge_buffer(struct Bitonic_Program_Cache* program_cache, struct Bitonic_Kernels* kernels,
+                                      const unsigned int array_length, const unsigned int array_type);
+
+/*
+ * Enqueues every command needed to sort the array of "array_length" elements of data type
+ * "array_type" within "buffer_in" into "queue" using "kernels", without waiting for any of
+ * the commands to finish and without creating any OpenCL objects; the direction of sort is
+ * that of the program the kernels were created from. "buffer_payload" and "generate_indices"
+ * are only used if the kernels move payloads along with each key, refer to
+ * "opencl_bitonic_sort_by_key" for their meaning ("buffer_payload" may be NULL otherwise).
+ * If a merge buffer is attached to "kernels" and the array is long enough, only runs of the
+ * array get sorted with the bitonic sorting network, and the sorted runs are then merged
+ * pairwise along the merge path (one launch per doubling of the run length), ping-ponging
+ * between "buffer_in" and the merge buffer; should any merge fail to be enqueued (e.g. as
+ * the device ran out of resources), the bitonic sorting network sorts the whole array instead.
+ */
+void enqueue_bitonic_sort(cl_command_queue *queue, struct Bitonic_Kernels* kernels, cl_mem* buffer_in,
+                            cl_mem* buffer_payload, const unsigned int array_length,
+                              const unsigned int array_type, const unsigned int generate_indices);
+
+/*
+ * Same as "enqueue_bitonic_sort", except that every block of "block_length" (a power of 2)
+ * elements of the array is sorted on its own, i.e. only the merge steps of partition sizes up
+ * to and including "block_length" get performed; the last block may be partial. Only for
+ * kernels without payloads.
+ */
+void enqueue_bitonic_sort_blocks(cl_command_queue *queue, struct Bitonic_Kernels* kernels, cl_mem* buffer_in,
+                                   const unsigned int array_length, const unsigned int array_type,
+                                                                   const unsigned int block_length);
+
+/*
+ * Enqueues the half-cleaners (i.e. the merge steps of compare distances "block_length / 2" down to
+ * 1) sorting every block of "block_length" (a power of 2) elements of the array within "buffer_in",
+ * where every block MUST already be a bitonic sequence as left behind by the first merge step of a
+ * partition size (e.g. the winners of comparing mirrored positions of two sorted blocks); the last
+ * block may be partial. Only for kernels without payloads; same parameters otherwise as
+ * "enqueue_bitonic_sort".
+ */
+void enqueue_bitonic_merge_blocks(cl_command_queue *queue, struct Bitonic_Kernels* kernels, cl_mem* buffer_in,
+                                    const unsigned int array_length, const unsigned int array_type,
+                                                                    const unsigned int block_length);
+
+/*
+ * Returns the way of loading arrays best suited to "device" for HOST_BUFFER_AUTO, i.e.
+ * USE_HOST_PTR_BUFFER if the device shares memory with the host (as reported by
+ * CL_DEVICE_HOST_UNIFIED_MEMORY), and COPY_HOST_BUFFER otherwise.
+ */
+unsigned int get_default_host_buffer_mode(cl_device_id device);
+
 /* 
  * Load array to be sorted using bitonic sort into OpenCL device's memory;
  * the data will processed by the kernel later on the OpenCL device.
- * The array HAS TO BE at least of length 1.
+ * The array HAS TO BE at least of length 1. Only the actual elements of
+ * the array get loaded, skipping any padding at its beginning or end, and
+ * "read_array_bitonic_sort" writes them back to the same place.
  * Parameter details:
  *   - context --- the OpenCL execution context for which the load the array
  *   - queue --- the OpenCL command queue created from the aforementioned "context"
@@ -170,40 +488,94 @@ struct Array_With_Length_Padded {
  *                device memory.
  *   - input_array --- A pointer to a struct containing the array to be loaded into
  *                     OpenCL device's memory.
+ *   - array_type --- data type of the elements of "input_array" (which needn't be
+ *                    ARRAY_TYPE); one of the flag variable literals defined above.
  *   - buffer_in --- a pointer to a memory handle where the handle corresponds
  *                      to the array copied over from main memory into the OpenCL
  *                      device's memory.
+ *   - host_buffer_mode --- how the array gets into the device's memory; one of the
+ *                          flag variable literals COPY_HOST_BUFFER, USE_HOST_PTR_BUFFER,
+ *                          ALLOC_HOST_PTR_BUFFER or HOST_BUFFER_AUTO (which is resolved
+ *                          for the device of "context"). With USE_HOST_PTR_BUFFER, the
+ *                          contents of "input_array" MUST stay allocated until "buffer_in"
+ *                          is released, and SHOULD be aligned to ZERO_COPY_ALIGNMENT bytes
+ *                          (refer to "alloc_aligned_array" within "array_utilities.h"),
+ *                          otherwise the OpenCL implementation may copy them anyway.
+ * Returns the mode actually used (i.e. never HOST_BUFFER_AUTO), which MUST be passed on to
+ * "read_array_bitonic_sort".
  */
-void load_array_bitonic_sort(cl_context *context, cl_command_queue* queue, 
-                               struct Array_With_Length_Padded* input_array, cl_mem* buffer_in);
+unsigned int load_array_bitonic_sort(cl_context *context, cl_command_queue* queue,
+                                       struct Array_With_Length_Padded* input_array,
+                                         const unsigned int array_type, cl_mem* buffer_in,
+                                                                  const unsigned int host_buffer_mode);
+
+/*
+ * Reads the sorted array within "buffer_in" back into the contents of "output_array" (which
+ * MUST be the very array loaded by "load_array_bitonic_sort" for USE_HOST_PTR_BUFFER), once
+ * every command previously enqueued into "queue" has finished; "array_type" is the data type
+ * it was loaded as, and "host_buffer_mode" is the mode returned by "load_array_bitonic_sort".
+ * With USE_HOST_PTR_BUFFER, mapping the buffer is all it takes for the contents of
+ * "output_array" to be up to date, so nothing gets copied on devices sharing memory with
+ * the host.
+ */
+void read_array_bitonic_sort(cl_command_queue* queue, struct Array_With_Length_Padded* output_array,
+                               const unsigned int array_type, cl_mem* buffer_in,
+                                                const unsigned int host_buffer_mode);
 
 /* 
  * Parameter details:
  * - queue --- the OpenCL command queue in which to enqueue commands for
  *              sorting an array using bitonic sort.
- * - cl_program* program --- MUST point to a program in memory which has an in-place
- *                           bitonic sort kernel function of signature:
- *                           __kernel void naive_bitonic_sort_merge_step(__global ARRAY_TYPE* input_array,
- *                                                                        const unsigned int compare_distance,
- *                                                                            const unsigned int partition_size,
- *                                                                              const unsigned int sort_direction)
- * - cl_kernel* kernel --- must point to a kernel function in memory whose function signature
- *                         is the "naive_bitonic_sort_merge_step" signature specified above.
- * - input_array --- a struct containing a pointer to the array to be sorted and a field
- *                          storing the array's length; the array is to be sorted using
- *                          bitonic sort.
+ * - program_cache --- cache of programs compiled for the device of "queue"; the program
+ *                     specialized for "array_type" and "sorting_direction" gets compiled
+ *                     if it isn't in the cache yet. Each program has an in-place bitonic
+ *                     sort kernel function of signature (or the same signature named
+ *                     "half_bitonic_sort_merge_step" if MERGE_STEP_HALF_LAUNCH is enabled):
+ *                     __kernel void naive_bitonic_sort_merge_step(__global ARRAY_TYPE* input_array,
+ *                                                                   const unsigned int array_length,
+ *                                                                    const unsigned int compare_distance,
+ *                                                                        const unsigned int partition_size)
+ *                     The "local_bitonic_sort_merge_steps" kernel is used for all merge steps whose
+ *                     compare distances fit within a tile of LOCAL_TILE_ELEMENTS_PER_WORK_ITEM elements
+ *                     per work-item, and the register-blocked kernels are used to collapse up to
+ *                     "merge_levels_per_launch" of "program_cache" of the remaining merge steps of
+ *                     each partition size into a single launch; every kernel is launched with the
+ *                     "workgroup_size" of "program_cache" work-items per workgroup, halved as far as
+ *                     the tiles of "array_type" need to fit within local memory.
  * - buffer_in --- a pointer to a memory handle corresponding to a copy of the array to be sorted
  *                 within the OpenCL device's memory.
+ * - array_length --- number of elements in the array to be sorted; may be any value of at least 1.
+ * - array_type --- data type of each element in the array (one of the permitted values
+ *                  of ARRAY_TYPE), which may differ from ARRAY_TYPE itself.
  * - sorting_direction --- "DESCENDING_SORT" (i.e. non-zero value) indicates to sort descending;
  *                          "ASCENDING_SORT" (i.e. zero) indicates to sort ascending.
  *
  * Custom implementation of bitonic sorting using OpenCL;
  * each sorting step is performed within device memory
  * The array being sorted HAS TO BE at least of length 1.
+ * If UPPER_LEVELS_MERGE_PATH is enabled, the upper levels of the sort are merged along the merge path
+ * (refer to "enqueue_bitonic_sort") using the merge buffer of "program_cache", which only ever grows
+ * and is kept for later sorts; the bitonic sorting network is used throughout instead if that buffer
+ * can't be allocated.
+ */
+void opencl_bitonic_sort(cl_command_queue *queue, struct Bitonic_Program_Cache* program_cache,
+                            cl_mem* buffer_in, const unsigned int array_length,
+                              const unsigned int array_type, const unsigned int sorting_direction);
+
+/*
+ * Key-value variant of "opencl_bitonic_sort" above, sorting the array within "buffer_in" (i.e.
+ * the keys) while moving a payload along with each key, where the payloads are held by a separate
+ * buffer "buffer_payload" of "array_length" payloads of kind "payload_kind" (either
+ * "PAYLOAD_32_BIT" or "PAYLOAD_64_BIT"). If "generate_indices" is non-zero, the payloads initially
+ * within "buffer_payload" are ignored and each key's payload is its index within the unsorted
+ * array instead, i.e. "buffer_payload" ends up holding the permutation that sorts the array
+ * (so other arrays of the same length may be reordered accordingly by gathering their elements).
+ * All other parameters are the same as "opencl_bitonic_sort".
  */
-void opencl_bitonic_sort(cl_command_queue *queue, cl_program *program,
-                           cl_kernel* kernel, struct Array_With_Length_Padded* input_array,
-                                       cl_mem* buffer_in, const unsigned int sorting_direction);
+void opencl_bitonic_sort_by_key(cl_command_queue *queue, struct Bitonic_Program_Cache* program_cache,
+                                  cl_mem* buffer_in, cl_mem* buffer_payload, const unsigned int array_length,
+                                    const unsigned int array_type, const unsigned int payload_kind,
+                                      const unsigned int generate_indices, const unsigned int sorting_direction);
 
 #endif // NAIVE_BITONIC_SORT_OPENCL_H
 // =================================================================================================
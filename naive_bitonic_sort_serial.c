@@ -9,13 +9,38 @@
 #include <stdio.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 
-// Merges pairs of bitonic sequences in an array into bigger bitonic sequences
+/*
+ * Swaps the payloads at indices "first_index" and "second_index" of "payload", which is an
+ * array of payloads of kind "payload_kind" (either "PAYLOAD_32_BIT" or "PAYLOAD_64_BIT").
+ */
+static inline void serial_swap_payloads(void* payload, const unsigned int payload_kind,
+                                          const unsigned int first_index, const unsigned int second_index) {
+   if (payload_kind == PAYLOAD_32_BIT) {
+       uint32_t* payload_32_bit = (uint32_t*)payload;
+       uint32_t temp_var = payload_32_bit[first_index];
+       payload_32_bit[first_index] = payload_32_bit[second_index];
+       payload_32_bit[second_index] = temp_var;
+   } else {
+       uint64_t* payload_64_bit = (uint64_t*)payload;
+       uint64_t temp_var = payload_64_bit[first_index];
+       payload_64_bit[first_index] = payload_64_bit[second_index];
+       payload_64_bit[second_index] = temp_var;
+   }
+}
+
+/*
+ * Merges pairs of bitonic sequences in an array into bigger bitonic sequences; if "payload"
+ * isn't NULL, the payloads of kind "payload_kind" within it are moved along with each number.
+ */
 static inline void serial_bitonic_sort_merge_step(ARRAY_TYPE_DECLARED* input_array,
                                                       const unsigned int array_length,
                                                        const unsigned int compare_distance,
                                                             const unsigned int partition_size,
-                                                                const unsigned int sort_direction) {
+                                                                const unsigned int sort_direction,
+                                                                    void* payload,
+                                                                      const unsigned int payload_kind) {
    // Null pointer not allowed
    assert(input_array != NULL);
    // Array-related and sorting parameters all have to be greater than zero.
@@ -26,95 +51,88 @@ static inline void serial_bitonic_sort_merge_step(ARRAY_TYPE_DECLARED* input_arr
    assert((sort_direction == ASCENDING_SORT) || (sort_direction == DESCENDING_SORT));
 
    /*
-    * Constant flag variable representing the ascending part of a bitonic sequence if sorting
-    * elements in ascending order, the descending part if sorting in descending order.
+    * The first merge step of each partition size compares mirrored positions within each bitonic
+    * sequence being created; refer to notes at top of "bitonic_program.cl" for more info.
     */
-   const unsigned int monotonic_part_indicator = 0;
-   
-   // Iterate over the array and swap numbers as necessary.
-   for (unsigned int array_index = 0; array_index < array_length; ++array_index) {
-
-       /*
-        * Rotate the current array index using XOR to the index of the
-        * other number to compare to as specified by the bitonic sorting
-        * network.
-        */
-       unsigned int compare_distance_rotated_index = compare_distance ^ array_index;
-      /*
-       * Only make comparisons and swap as necessary if compare_distance_rotated_index
-       * is larger to avoid double comparisons; the contents of this "if" control structure
-       * is responsible for creating the monotonic halves of a bitonic sequence by using
-       * a bitmask (i.e. "bitonic_sequence_part_indicator") to determine which numbers
-       * should be swapped.  The bitmask partitions the array into ascending and descending
-       * halves. If the bitmask indicates to sort ascending, then sort ascending by
-       * swapping numbers which are in descending order, and vice versa for bitmasks
-       * indicating to sort descending.
-       */
-       if (compare_distance_rotated_index > array_index) {
-          /*
-           * The next three lines of code determine whether or not to swap
-           * the number at array_index with the number at compare_distance_rotated_index
-           * within the array by identifying which part of the bitonic sequence
-           * each number is supposed to be during the next sorting step (i.e. merging
-           * the ascending and descending halves of a bitonic sequence into a larger
-           * monotonic sequence). This is done through bit-masking the array_index by
-           * the partition_size and then making the appropriate swaps based on where
-           * each number falls under the bit-masked result.
-           */
-          unsigned int bitonic_sequence_part_indicator = array_index & partition_size;
-          // Negate sequence part indicator if sorting elements in descending order.
-          if (sort_direction) {
-               bitonic_sequence_part_indicator = ! bitonic_sequence_part_indicator;
-          }
-          /*
-           * Once the partition_size equals the length of the array being sorted,
-           * then half of the conditional statement as written below (either the half
-           * before the "or" operator or after the "or" operator depending on whether
-           * the array is to be sorted in ascending or descending order respectively)
-           * no longer applies (i.e. gets "cancelled out") to the bitonic sorting
-           * procedure, and so the sorting procedure concludes with using ONLY the other
-           * half of the conditional statement to merge together the ascending and
-           * descending halves of the *final* bitonic sequence in the array into a
-           * sorted array.
-           */
-           bool swap = (bitonic_sequence_part_indicator == monotonic_part_indicator &&
-                              input_array[array_index] > input_array[compare_distance_rotated_index]) ||
-                           (bitonic_sequence_part_indicator != monotonic_part_indicator &&
-                               input_array[array_index] <= input_array[compare_distance_rotated_index]);
+   const bool is_first_merge_step = (2 * compare_distance == partition_size);
+
+   /*
+    * Iterate over the smaller index of each pair of numbers being compared (i.e. all indices where
+    * the bit of the compare distance is cleared), and swap numbers as necessary.
+    */
+   for (unsigned int pair_block_start = 0; pair_block_start < array_length;
+                                               pair_block_start += 2 * compare_distance) {
+       for (unsigned int array_index = pair_block_start;
+               (array_index < pair_block_start + compare_distance) && (array_index < array_length);
+                                                                                 ++array_index) {
+           /*
+            * Get the index of the other number to compare to as specified by the bitonic sorting
+            * network; comparisons with indices at or beyond the array length are skipped, as if the
+            * array were padded with numbers coming after every real number in the sorting order.
+            */
+           unsigned int compare_distance_rotated_index = is_first_merge_step ?
+                                                           (array_index ^ (partition_size - 1)) :
+                                                                (array_index | compare_distance);
+           if (compare_distance_rotated_index >= array_length) {
+               continue;
+           }
+           /*
+            * If sorting in ascending order, the smaller number has to end up at the smaller index;
+            * if sorting in descending order, the larger number has to end up at the smaller index.
+            */
+           bool swap = sort_direction ?
+                          (input_array[array_index] < input_array[compare_distance_rotated_index]) :
+                              (input_array[array_index] > input_array[compare_distance_rotated_index]);
            // Swap numbers as necessary
            if (swap) {
                 ARRAY_TYPE_DECLARED temp_var = input_array[array_index];
                 input_array[array_index] = input_array[compare_distance_rotated_index];
                 input_array[compare_distance_rotated_index] = temp_var;
+                if (payload != NULL) {
+                    serial_swap_payloads(payload, payload_kind, array_index, compare_distance_rotated_index);
+                }
            }
        }
-
    }
 
 }
 
 
-void serial_bitonic_sort(struct Array_With_Length_Padded* input_array, const unsigned int sorting_direction) {
+/*
+ * Sorts "input_array" while moving the payloads within "payload" (if not NULL) along with each
+ * number; both "serial_bitonic_sort" and "serial_bitonic_sort_by_key" are built on this function.
+ */
+static void serial_bitonic_sort_with_payload(struct Array_With_Length_Padded* input_array,
+                                               void* payload, const unsigned int payload_kind,
+                                                           const unsigned int sorting_direction) {
 
     // Parameter cannot be NULL
     assert(input_array != NULL);
     assert(input_array->contents != NULL);
     // Array length has to be non-zero
     assert(input_array->array_len_actual > 0);
-    assert(input_array->padded_2n_length > 0);
+    assert(input_array->padded_2n_length >= input_array->array_len_actual);
     // Check that padding location indicator is of valid value
     assert((input_array->padding_location_indicator == PAD_ARRAY_AT_BEGINNING) ||
                          (input_array->padding_location_indicator == PAD_ARRAY_AT_END));
     // Make sure sort_direction is of valid value
     assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
 
+    // Only the actual elements of the array get sorted; no padding is needed
+    const unsigned int array_len = input_array->array_len_actual;
     /* 
-     * Get padded length of array for bitonic sort, since iterative bitonic
-     * sort requires array lengths to be a power of 2.
+     * Get length of sorting network for bitonic sort, since iterative bitonic
+     * sort requires network lengths to be a power of 2.
      */
-    const unsigned int padded_array_len = input_array->padded_2n_length;
-    // Get pointer to beginning of array to be sorted
+    unsigned int network_len = 1;
+    while (network_len < array_len) {
+        network_len *= 2;
+    }
+    // Get pointer to beginning of array to be sorted, past any padding at the beginning
     ARRAY_TYPE_DECLARED* array_begin = input_array->contents;
+    if (input_array->padding_location_indicator == PAD_ARRAY_AT_BEGINNING) {
+        array_begin += input_array->padded_2n_length - array_len;
+    }
 
     // Notify user serial bitonic sorting starts now
     printf(NOTIFY_USER_SORT_SERIAL_START);
@@ -123,7 +141,7 @@ void serial_bitonic_sort(struct Array_With_Length_Padded* input_array, const uns
      * Iterate over all different partition sizes for array, where each partition is half of the
      * subarray of each of the bitonic sequences being created during each iteration.
      */
-    for (unsigned int partition_size = 2; partition_size <= padded_array_len; partition_size *= 2) {
+    for (unsigned int partition_size = 2; partition_size <= network_len; partition_size *= 2) {
         /*
          * Iterate over all different compare distances, where each compare distance is how far
          * apart the numbers being compared are for constructing the bitonic sequences.
@@ -134,11 +152,37 @@ void serial_bitonic_sort(struct Array_With_Length_Padded* input_array, const uns
              * length = twice the partition size using all possible different compare distances, where
              * each compare distance is a power of 2.
              */
-            serial_bitonic_sort_merge_step(array_begin, padded_array_len, compare_distance,
-                                                           partition_size, sorting_direction);
+            serial_bitonic_sort_merge_step(array_begin, array_len, compare_distance,
+                                             partition_size, sorting_direction, payload, payload_kind);
 
         }
     }
 
 }
 
+void serial_bitonic_sort(struct Array_With_Length_Padded* input_array, const unsigned int sorting_direction) {
+    serial_bitonic_sort_with_payload(input_array, NULL, NO_PAYLOAD, sorting_direction);
+}
+
+void serial_bitonic_sort_by_key(struct Array_With_Length_Padded* input_array, void* payload,
+                                  const unsigned int payload_kind, const unsigned int generate_indices,
+                                                                  const unsigned int sorting_direction) {
+    // Parameters cannot be NULL
+    assert(input_array != NULL);
+    assert(payload != NULL);
+    // Make sure kind of payload is of valid value
+    assert((payload_kind == PAYLOAD_32_BIT) || (payload_kind == PAYLOAD_64_BIT));
+
+    // Give each number its own index within the unsorted array as its payload if requested
+    if (generate_indices) {
+        for (unsigned int array_index = 0; array_index < input_array->array_len_actual; ++array_index) {
+            if (payload_kind == PAYLOAD_32_BIT) {
+                ((uint32_t*)payload)[array_index] = array_index;
+            } else {
+                ((uint64_t*)payload)[array_index] = array_index;
+            }
+        }
+    }
+
+    serial_bitonic_sort_with_payload(input_array, payload, payload_kind, sorting_direction);
+}
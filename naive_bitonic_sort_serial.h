@@ -60,5 +60,18 @@
  */
 void serial_bitonic_sort(struct Array_With_Length_Padded* input_array, const unsigned int sorting_direction);
 
+/*
+ * Key-value variant of "serial_bitonic_sort", sorting "input_array" (i.e. the keys) while moving
+ * a payload along with each key.
+ * - "payload" is a separate array of "input_array->array_len_actual" payloads of kind
+ *   "payload_kind" (either "PAYLOAD_32_BIT" for uint32_t or "PAYLOAD_64_BIT" for uint64_t
+ *   payloads); refer to "naive_bitonic_sort_opencl.h" for more info.
+ * - If "generate_indices" is non-zero, "payload" is first filled with the index of each key within
+ *   the unsorted array, i.e. "payload" ends up holding the permutation that sorts the array.
+ */
+void serial_bitonic_sort_by_key(struct Array_With_Length_Padded* input_array, void* payload,
+                                  const unsigned int payload_kind, const unsigned int generate_indices,
+                                                                  const unsigned int sorting_direction);
+
 #endif // NAIVE_BITONIC_SORT_SERIAL_H
 
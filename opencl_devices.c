@@ -0,0 +1,209 @@
+/*
+ * File description:
+ *   Listing the OpenCL platforms and devices installed on the machine, and selecting
+ *   the device to sort on by index or by part of its name.
+ */
+
+#include "opencl_devices.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <assert.h>
+
+// Names of the types of OpenCL devices, as listed by "list_opencl_devices"
+static const char* get_device_type_name(const cl_device_type device_type) {
+    if (device_type & CL_DEVICE_TYPE_GPU) {
+        return "GPU";
+    } else if (device_type & CL_DEVICE_TYPE_CPU) {
+        return "CPU";
+    } else if (device_type & CL_DEVICE_TYPE_ACCELERATOR) {
+        return "accelerator";
+    }
+    return "other";
+}
+
+// Whether "selector" is missing, i.e. NULL or empty
+static int is_empty_selector(const char* selector) {
+    return (selector == NULL) || (selector[0] == '\0');
+}
+
+// Whether "selector" is an index (i.e. only made up of decimal digits) instead of part of a name
+static int is_index_selector(const char* selector) {
+    if (is_empty_selector(selector)) {
+        return 0;
+    }
+    for (const char* curr_char = selector; *curr_char != '\0'; ++curr_char) {
+        if (!isdigit((unsigned char)*curr_char)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Whether "name" contains "part", without regard to case
+static int name_contains(const char* name, const char* part) {
+    const size_t part_len = strlen(part);
+    for (const char* name_start = name; *name_start != '\0'; ++name_start) {
+        size_t char_index = 0;
+        while ((char_index < part_len) && (name_start[char_index] != '\0') &&
+                 (tolower((unsigned char)name_start[char_index]) == tolower((unsigned char)part[char_index]))) {
+            ++char_index;
+        }
+        if (char_index == part_len) {
+            return 1;
+        }
+    }
+    return part_len == 0;
+}
+
+/*
+ * Returns every platform installed (to be freed by the caller), writing the number
+ * of platforms into "num_platforms".
+ */
+static cl_platform_id* get_platforms(cl_uint* num_platforms) {
+    *num_platforms = 0;
+    if ((clGetPlatformIDs(0, NULL, num_platforms) != CL_SUCCESS) || (*num_platforms == 0)) {
+        *num_platforms = 0;
+        return NULL;
+    }
+    cl_platform_id* platforms = malloc(sizeof(cl_platform_id) * (*num_platforms));
+    clGetPlatformIDs(*num_platforms, platforms, NULL);
+    return platforms;
+}
+
+/*
+ * Returns every device of "platform" (to be freed by the caller), writing the number
+ * of devices into "num_devices".
+ */
+static cl_device_id* get_platform_devices(cl_platform_id platform, cl_uint* num_devices) {
+    *num_devices = 0;
+    if ((clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, 0, NULL, num_devices) != CL_SUCCESS) ||
+           (*num_devices == 0)) {
+        *num_devices = 0;
+        return NULL;
+    }
+    cl_device_id* devices = malloc(sizeof(cl_device_id) * (*num_devices));
+    clGetDeviceIDs(platform, CL_DEVICE_TYPE_ALL, *num_devices, devices, NULL);
+    return devices;
+}
+
+void list_opencl_devices(FILE* output_file) {
+    // No null pointers allowed
+    assert(output_file != NULL);
+
+    cl_uint num_platforms;
+    cl_platform_id* platforms = get_platforms(&num_platforms);
+    if (num_platforms == 0) {
+        fprintf(output_file, LIST_NO_PLATFORMS_MESSAGE);
+        return;
+    }
+
+    for (cl_uint platform_index = 0; platform_index < num_platforms; ++platform_index) {
+        char platform_name[MAX_DEVICE_INFO_LEN];
+        char platform_version[MAX_DEVICE_INFO_LEN];
+        clGetPlatformInfo(platforms[platform_index], CL_PLATFORM_NAME, MAX_DEVICE_INFO_LEN, platform_name, NULL);
+        clGetPlatformInfo(platforms[platform_index], CL_PLATFORM_VERSION, MAX_DEVICE_INFO_LEN,
+                            platform_version, NULL);
+        fprintf(output_file, LIST_PLATFORM_FORMAT, platform_index, platform_name, platform_version);
+
+        cl_device_id default_device = NULL;
+        clGetDeviceIDs(platforms[platform_index], CL_DEVICE_TYPE_DEFAULT, 1, &default_device, NULL);
+        cl_uint num_devices;
+        cl_device_id* devices = get_platform_devices(platforms[platform_index], &num_devices);
+        for (cl_uint device_index = 0; device_index < num_devices; ++device_index) {
+            cl_device_id device = devices[device_index];
+            char device_name[MAX_DEVICE_INFO_LEN];
+            cl_device_type device_type = 0;
+            cl_uint num_compute_units = 0;
+            cl_ulong global_mem_size = 0;
+            cl_ulong max_alloc_size = 0;
+            cl_ulong local_mem_size = 0;
+            size_t max_workgroup_size = 0;
+            clGetDeviceInfo(device, CL_DEVICE_NAME, MAX_DEVICE_INFO_LEN, device_name, NULL);
+            clGetDeviceInfo(device, CL_DEVICE_TYPE, sizeof(device_type), &device_type, NULL);
+            clGetDeviceInfo(device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(num_compute_units), &num_compute_units, NULL);
+            clGetDeviceInfo(device, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(global_mem_size), &global_mem_size, NULL);
+            clGetDeviceInfo(device, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(max_alloc_size), &max_alloc_size, NULL);
+            clGetDeviceInfo(device, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(local_mem_size), &local_mem_size, NULL);
+            clGetDeviceInfo(device, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(max_workgroup_size),
+                              &max_workgroup_size, NULL);
+            fprintf(output_file, LIST_DEVICE_FORMAT, device_index, device_name, get_device_type_name(device_type),
+                      (device == default_device) ? LIST_DEFAULT_DEVICE_MARKER : "", num_compute_units,
+                        global_mem_size / BYTES_IN_MEBIBYTE, max_alloc_size / BYTES_IN_MEBIBYTE,
+                          local_mem_size / 1024.0, max_workgroup_size);
+        }
+        free(devices);
+    }
+    free(platforms);
+}
+
+void select_opencl_device(const char* platform_selector, const char* device_selector,
+                            cl_platform_id* platform, cl_device_id* device) {
+    // No null pointers allowed, except for the selectors
+    assert(platform != NULL);
+    assert(device != NULL);
+
+    // Devices selected by name are searched for on every platform, unless a platform was selected too
+    const int search_all_platforms = is_empty_selector(platform_selector) && !is_empty_selector(device_selector) &&
+                                       !is_index_selector(device_selector);
+    cl_uint num_platforms;
+    cl_platform_id* platforms = get_platforms(&num_platforms);
+    int platform_matched = 0;
+    int device_found = 0;
+
+    for (cl_uint platform_index = 0; (platform_index < num_platforms) && !device_found; ++platform_index) {
+        char platform_name[MAX_DEVICE_INFO_LEN];
+        clGetPlatformInfo(platforms[platform_index], CL_PLATFORM_NAME, MAX_DEVICE_INFO_LEN, platform_name, NULL);
+        int platform_matches;
+        if (search_all_platforms) {
+            platform_matches = 1;
+        } else if (is_empty_selector(platform_selector)) {
+            platform_matches = (platform_index == 0);
+        } else if (is_index_selector(platform_selector)) {
+            platform_matches = (platform_index == strtoul(platform_selector, NULL, 10));
+        } else {
+            platform_matches = name_contains(platform_name, platform_selector);
+        }
+        if (!platform_matches) {
+            continue;
+        }
+        platform_matched = 1;
+        *platform = platforms[platform_index];
+
+        if (is_empty_selector(device_selector)) {
+            device_found = (clGetDeviceIDs(*platform, CL_DEVICE_TYPE_DEFAULT, 1, device, NULL) == CL_SUCCESS);
+        } else {
+            cl_uint num_devices;
+            cl_device_id* devices = get_platform_devices(*platform, &num_devices);
+            for (cl_uint device_index = 0; (device_index < num_devices) && !device_found; ++device_index) {
+                char device_name[MAX_DEVICE_INFO_LEN];
+                clGetDeviceInfo(devices[device_index], CL_DEVICE_NAME, MAX_DEVICE_INFO_LEN, device_name, NULL);
+                if (is_index_selector(device_selector) ? (device_index == strtoul(device_selector, NULL, 10)) :
+                                                           name_contains(device_name, device_selector)) {
+                    *device = devices[device_index];
+                    device_found = 1;
+                }
+            }
+            free(devices);
+        }
+        // Only the first platform matching is searched, unless searching every platform
+        if (!search_all_platforms) {
+            break;
+        }
+    }
+    free(platforms);
+
+    if (!platform_matched) {
+        fprintf(stderr, NO_MATCHING_PLATFORM_MESSAGE, is_empty_selector(platform_selector) ? "0" : platform_selector);
+        exit(EXIT_FAILURE);
+    } else if (!device_found) {
+        fprintf(stderr, NO_MATCHING_DEVICE_MESSAGE, is_empty_selector(device_selector) ? "default" : device_selector);
+        exit(EXIT_FAILURE);
+    }
+
+    char platform_name[MAX_DEVICE_INFO_LEN];
+    char device_name[MAX_DEVICE_INFO_LEN];
+    clGetPlatformInfo(*platform, CL_PLATFORM_NAME, MAX_DEVICE_INFO_LEN, platform_name, NULL);
+    clGetDeviceInfo(*device, CL_DEVICE_NAME, MAX_DEVICE_INFO_LEN, device_name, NULL);
+    printf(NOTIFY_USER_SELECTED_DEVICE, device_name, platform_name);
+}
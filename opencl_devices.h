@@ -0,0 +1,55 @@
+/*
+ * File description:
+ *   Header file for functions listing the OpenCL platforms and devices installed
+ *   on the machine, and selecting the device to sort on at runtime (by index or by
+ *   part of its name) instead of by macros fixed at build time.
+ */
+
+#ifndef OPENCL_DEVICES_H
+#define OPENCL_DEVICES_H
+
+#define CL_TARGET_OPENCL_VERSION 220
+#include <CL/cl.h>
+#include <stdio.h>
+
+// Maximum length of names of platforms and devices
+#define MAX_DEVICE_INFO_LEN 1024
+// Number of bytes in a mebibyte, for reporting sizes of device memory
+#define BYTES_IN_MEBIBYTE (1024.0 * 1024.0)
+
+// Lines printed by "list_opencl_devices" for each platform and for each of its devices
+#define LIST_PLATFORM_FORMAT "Platform %u: %s (%s)\n"
+#define LIST_DEVICE_FORMAT "  Device %u: %s [%s]%s\n"\
+                           "    compute units: %u, global memory: %.1f MiB, max allocation: %.1f MiB,"\
+                           " local memory: %.1f KiB, max workgroup size: %zu\n"
+// Marker appended to the line of the default device of each platform
+#define LIST_DEFAULT_DEVICE_MARKER " (default)"
+#define LIST_NO_PLATFORMS_MESSAGE "No OpenCL platforms found\n"
+
+// Errors when no platform or device matches what was asked for
+#define NO_MATCHING_PLATFORM_MESSAGE "No OpenCL platform matches \"%s\" (run with --list-devices to see all)\n"
+#define NO_MATCHING_DEVICE_MESSAGE "No OpenCL device matches \"%s\" (run with --list-devices to see all)\n"
+// Message to user naming the device selected by "select_opencl_device"
+#define NOTIFY_USER_SELECTED_DEVICE ">>> Sorting on OpenCL device \"%s\" of platform \"%s\"\n\n"
+
+/*
+ * Prints every OpenCL platform installed and every device of each platform to
+ * "output_file", along with the indices by which "select_opencl_device" selects
+ * them; each device is listed with its type, number of compute units, sizes of
+ * global and local memory and the maximum size of each buffer (allocation).
+ */
+void list_opencl_devices(FILE* output_file);
+
+/*
+ * Selects the OpenCL "platform" and "device" to sort on. Each selector is either
+ * an index (as listed by "list_opencl_devices") or any part of the name of the
+ * platform or device, matched without regard to case; the first match is chosen.
+ * A NULL (or empty) "platform_selector" selects the first platform, unless the
+ * device is selected by name, in which case every platform is searched for it;
+ * a NULL (or empty) "device_selector" selects the default device of the platform
+ * (i.e. CL_DEVICE_TYPE_DEFAULT). Exits with an error message if nothing matches.
+ */
+void select_opencl_device(const char* platform_selector, const char* device_selector,
+                            cl_platform_id* platform, cl_device_id* device);
+
+#endif // OPENCL_DEVICES_H
@@ -0,0 +1,225 @@
+/*
+ * File description:
+ *   Parallelized bitonic sorting on the CPU. The sorting network is the same as that of
+ *   "naive_bitonic_sort_serial.c", but performed recursively, so that blocks of the array
+ *   are sorted and merged independently of each other by tasks of a work-stealing pool.
+ */
+
+#include "parallel_bitonic_sort_cpu.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+
+// Name of each sorting direction, indexed by the macro value of each direction
+static const char* const sorting_direction_names[NUM_SORTING_DIRECTIONS] = {"ascending", "descending"};
+
+/*
+ * Everything shared by all tasks of a single sort; fields are the following:
+ *  - pool running the tasks
+ *  - array being sorted, along with its length
+ *  - direction of sort
+ */
+struct Cpu_Sort_Context {
+     struct Work_Stealing_Pool* pool;
+     ARRAY_TYPE_DECLARED* array;
+     unsigned int array_length;
+     unsigned int sorting_direction;
+};
+
+/*
+ * A single task of a sort; fields are the following:
+ *  - context of the sort
+ *  - first index and size (a power of 2) of the block of the sorting network being sorted or merged
+ *  - whether the block is merged starting with the first merge step of its partition size
+ *  - compare distance of the merge step, and range of pairs of elements compared (not including
+ *    "pair_end"); only used by tasks performing part of a single merge step
+ */
+struct Cpu_Sort_Task {
+     struct Cpu_Sort_Context* context;
+     unsigned int block_start;
+     unsigned int block_size;
+     bool is_first_merge_step;
+     unsigned int compare_distance;
+     unsigned int pair_begin;
+     unsigned int pair_end;
+};
+
+/*
+ * Compares (and swaps as necessary) the pairs of elements numbered "pair_begin" up to but not including
+ * "pair_end" within a single merge step of "compare_distance"; pair "k" consists of the element at
+ * the index having a zero bit inserted into "k" at the bit of the compare distance, and the element it
+ * gets compared to as specified by the bitonic sorting network (refer to notes at top of
+ * "bitonic_program.cl"). Comparisons with indices at or beyond the array length are skipped.
+ */
+static void compare_exchange_pairs(struct Cpu_Sort_Context* context, const unsigned int compare_distance,
+                                     const bool is_first_merge_step, const unsigned int pair_begin,
+                                                                       const unsigned int pair_end) {
+    ARRAY_TYPE_DECLARED* array = context->array;
+    const unsigned int array_length = context->array_length;
+    const unsigned int sorting_direction = context->sorting_direction;
+    const unsigned int low_bits_mask = compare_distance - 1;
+
+    for (unsigned int pair_index = pair_begin; pair_index < pair_end; ++pair_index) {
+        const unsigned int lower_index = ((pair_index & ~low_bits_mask) << 1) | (pair_index & low_bits_mask);
+        // Lower indices only grow along with pair numbers, so no later pair is within the array either
+        if (lower_index >= array_length) {
+            break;
+        }
+        const unsigned int upper_index = is_first_merge_step ? (lower_index ^ (2 * compare_distance - 1)) :
+                                                                         (lower_index | compare_distance);
+        if (upper_index >= array_length) {
+            continue;
+        }
+        /*
+         * If sorting in ascending order, the smaller number has to end up at the smaller index;
+         * if sorting in descending order, the larger number has to end up at the smaller index.
+         */
+        const bool swap = sorting_direction ? (array[lower_index] < array[upper_index]) :
+                                                     (array[lower_index] > array[upper_index]);
+        if (swap) {
+            ARRAY_TYPE_DECLARED temp_var = array[lower_index];
+            array[lower_index] = array[upper_index];
+            array[upper_index] = temp_var;
+        }
+    }
+}
+
+// Task function performing part of a single merge step
+static void merge_step_task(void* task_arg) {
+    struct Cpu_Sort_Task* task = (struct Cpu_Sort_Task*)task_arg;
+    compare_exchange_pairs(task->context, task->compare_distance, task->is_first_merge_step,
+                                                          task->pair_begin, task->pair_end);
+}
+
+/*
+ * Merges the bitonic sequence within the block of "block_size" elements at "block_start" into a sorted
+ * sequence; the first merge step of the block is that of its partition size if "is_first_merge_step"
+ * is true (i.e. the block holds two sorted halves), and a regular merge step otherwise.
+ */
+static void merge_block(struct Cpu_Sort_Context* context, const unsigned int block_start,
+                          const unsigned int block_size, const bool is_first_merge_step);
+
+// Task function merging a single block
+static void merge_block_task(void* task_arg) {
+    struct Cpu_Sort_Task* task = (struct Cpu_Sort_Task*)task_arg;
+    merge_block(task->context, task->block_start, task->block_size, task->is_first_merge_step);
+}
+
+static void merge_block(struct Cpu_Sort_Context* context, const unsigned int block_start,
+                          const unsigned int block_size, const bool is_first_merge_step) {
+    // Blocks entirely beyond the array length hold nothing to merge
+    if ((block_start >= context->array_length) || (block_size < 2)) {
+        return;
+    }
+    const unsigned int first_pair = block_start / 2;
+
+    if (block_size <= CPU_SORT_BLOCK_SIZE) {
+        for (unsigned int compare_distance = block_size / 2; compare_distance > 0; compare_distance /= 2) {
+            compare_exchange_pairs(context, compare_distance,
+                                     is_first_merge_step && (2 * compare_distance == block_size),
+                                                        first_pair, first_pair + block_size / 2);
+        }
+        return;
+    }
+
+    // Split the merge step spanning the whole block across several tasks
+    const unsigned int num_pairs = block_size / 2;
+    const unsigned int num_step_tasks = (num_pairs + CPU_MERGE_STEP_PAIRS_PER_TASK - 1) /
+                                                              CPU_MERGE_STEP_PAIRS_PER_TASK;
+    struct Cpu_Sort_Task* step_tasks = malloc(num_step_tasks * sizeof(struct Cpu_Sort_Task));
+    struct Task_Group task_group;
+    init_task_group(&task_group);
+    for (unsigned int task_index = 0; task_index < num_step_tasks; ++task_index) {
+        step_tasks[task_index].context = context;
+        step_tasks[task_index].compare_distance = block_size / 2;
+        step_tasks[task_index].is_first_merge_step = is_first_merge_step;
+        step_tasks[task_index].pair_begin = first_pair + task_index * CPU_MERGE_STEP_PAIRS_PER_TASK;
+        step_tasks[task_index].pair_end = (task_index + 1 == num_step_tasks) ? (first_pair + num_pairs) :
+                                              (step_tasks[task_index].pair_begin + CPU_MERGE_STEP_PAIRS_PER_TASK);
+        if (task_index > 0) {
+            spawn_pool_task(context->pool, &task_group, merge_step_task, &step_tasks[task_index]);
+        }
+    }
+    merge_step_task(&step_tasks[0]);
+    wait_for_task_group(context->pool, &task_group);
+    free(step_tasks);
+
+    // Both halves of the block are now bitonic sequences of their own, which merge independently
+    struct Cpu_Sort_Task lower_half_task = {context, block_start, block_size / 2, false, 0, 0, 0};
+    spawn_pool_task(context->pool, &task_group, merge_block_task, &lower_half_task);
+    merge_block(context, block_start + block_size / 2, block_size / 2, false);
+    wait_for_task_group(context->pool, &task_group);
+}
+
+/*
+ * Sorts the block of "block_size" elements at "block_start" by sorting both of its halves and
+ * then merging them.
+ */
+static void sort_block(struct Cpu_Sort_Context* context, const unsigned int block_start,
+                         const unsigned int block_size);
+
+// Task function sorting a single block
+static void sort_block_task(void* task_arg) {
+    struct Cpu_Sort_Task* task = (struct Cpu_Sort_Task*)task_arg;
+    sort_block(task->context, task->block_start, task->block_size);
+}
+
+static void sort_block(struct Cpu_Sort_Context* context, const unsigned int block_start,
+                         const unsigned int block_size) {
+    // Blocks entirely beyond the array length hold nothing to sort
+    if ((block_start >= context->array_length) || (block_size < 2)) {
+        return;
+    }
+
+    // Blocks fitting in cache are sorted by a single task, one merge step after another
+    if (block_size <= CPU_SORT_BLOCK_SIZE) {
+        const unsigned int first_pair = block_start / 2;
+        for (unsigned int partition_size = 2; partition_size <= block_size; partition_size *= 2) {
+            for (unsigned int compare_distance = partition_size / 2; compare_distance > 0; compare_distance /= 2) {
+                compare_exchange_pairs(context, compare_distance, 2 * compare_distance == partition_size,
+                                                                first_pair, first_pair + block_size / 2);
+            }
+        }
+        return;
+    }
+
+    struct Task_Group task_group;
+    init_task_group(&task_group);
+    struct Cpu_Sort_Task lower_half_task = {context, block_start, block_size / 2, false, 0, 0, 0};
+    spawn_pool_task(context->pool, &task_group, sort_block_task, &lower_half_task);
+    sort_block(context, block_start + block_size / 2, block_size / 2);
+    wait_for_task_group(context->pool, &task_group);
+
+    merge_block(context, block_start, block_size, true);
+}
+
+void parallel_bitonic_sort_cpu(struct Array_With_Length_Padded* input_array,
+                                 const unsigned int sorting_direction, const unsigned int num_threads) {
+    // Parameter cannot be NULL
+    assert(input_array != NULL);
+    assert(input_array->contents != NULL);
+    // Array length has to be non-zero
+    assert(input_array->array_len_actual > 0);
+    assert(input_array->padded_2n_length >= input_array->array_len_actual);
+    // Make sure sort_direction is of valid value
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+
+    const unsigned int array_len = input_array->array_len_actual;
+    // Get length of sorting network for bitonic sort, which has to be a power of 2
+    unsigned int network_len = 1;
+    while (network_len < array_len) {
+        network_len *= 2;
+    }
+
+    struct Work_Stealing_Pool pool;
+    init_work_stealing_pool(&pool, num_threads);
+
+    // Notify user parallelized bitonic sorting on the CPU starts now
+    printf(NOTIFY_USER_SORT_PARALLEL_CPU_START, pool.num_workers, sorting_direction_names[sorting_direction]);
+
+    struct Cpu_Sort_Context context = {&pool, input_array->contents, array_len, sorting_direction};
+    sort_block(&context, 0, network_len);
+
+    release_work_stealing_pool(&pool);
+}
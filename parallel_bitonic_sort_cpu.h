@@ -0,0 +1,58 @@
+/*
+ * File description:
+ *   Header file for bitonic sorting on every core of the CPU, using a pool of worker
+ *   threads with work stealing (refer to "work_stealing_pool.h").
+ */
+
+#ifndef PARALLEL_BITONIC_SORT_CPU_H
+#define PARALLEL_BITONIC_SORT_CPU_H
+
+#include "naive_bitonic_sort_opencl.h"
+#include "work_stealing_pool.h"
+
+/*
+ * Number of elements of each block sorted (or merged) entirely by a single task; blocks of
+ * this size fit within the L2 cache of most CPUs for every permitted data type. MUST be a
+ * power of 2.
+ */
+#define CPU_SORT_BLOCK_SIZE 16384
+/*
+ * Number of pairs of elements compared by each task of a merge step spanning more than
+ * CPU_SORT_BLOCK_SIZE elements, which gets split into several tasks.
+ */
+#define CPU_MERGE_STEP_PAIRS_PER_TASK 65536
+
+// Define message printed out to user signaling start of bitonic sort on all cores of the CPU
+#if (ARRAY_TYPE == CHAR)
+  #define NOTIFY_USER_SORT_PARALLEL_CPU_START ">>> Starting sorting chars with parallelized"\
+                                              " bitonic sort on %u CPU thread(s), sort %s...\n"
+#elif (ARRAY_TYPE == INT)
+  #define NOTIFY_USER_SORT_PARALLEL_CPU_START ">>> Starting sorting ints with parallelized"\
+                                              " bitonic sort on %u CPU thread(s), sort %s...\n"
+#elif (ARRAY_TYPE == LONG)
+  #define NOTIFY_USER_SORT_PARALLEL_CPU_START ">>> Starting sorting longs with parallelized"\
+                                              " bitonic sort on %u CPU thread(s), sort %s...\n"
+#elif (ARRAY_TYPE == FLOAT)
+  #define NOTIFY_USER_SORT_PARALLEL_CPU_START ">>> Starting sorting floats with parallelized"\
+                                              " bitonic sort on %u CPU thread(s), sort %s...\n"
+#elif (ARRAY_TYPE == DOUBLE)
+  #define NOTIFY_USER_SORT_PARALLEL_CPU_START ">>> Starting sorting doubles with parallelized"\
+                                              " bitonic sort on %u CPU thread(s), sort %s...\n"
+#endif
+
+/*
+ * Parallelized implementation of bitonic sort on the CPU, performing the same sorting network
+ * as "serial_bitonic_sort" (refer to "naive_bitonic_sort_serial.h") recursively: both halves of
+ * every bitonic sequence being created are sorted by independent tasks, and each merge step
+ * spanning more than CPU_SORT_BLOCK_SIZE elements is split into tasks of
+ * CPU_MERGE_STEP_PAIRS_PER_TASK pairs, while smaller blocks are sorted and merged by a single task.
+ * - "input_array" is the array to be sorted.
+ * - "sorting_direction" indicates whether or not to sort array in ascending or descending order;
+ *   refer to SORTING_DIRECTION macro within "naive_bitonic_sort_opencl.h" for more info.
+ * - "num_threads" is the number of threads sorting, including the calling thread (or
+ *   NUM_POOL_THREADS_AUTO for one thread per processor online).
+ */
+void parallel_bitonic_sort_cpu(struct Array_With_Length_Padded* input_array,
+                                 const unsigned int sorting_direction, const unsigned int num_threads);
+
+#endif // PARALLEL_BITONIC_SORT_CPU_H
@@ -0,0 +1,281 @@
+/*
+ * File description:
+ *   Saving and loading compiled OpenCL programs to and from disk. Each cached program binary file
+ *   starts with PROGRAM_BINARY_FILE_MAGIC on its own line, followed by the key of the program on
+ *   its own line, the size in bytes of the binary and finally the binary itself. The file name is
+ *   derived from a hash of the key, while the whole key stored within the file gets compared on
+ *   loading, so that hash collisions never result in loading the wrong binary.
+ */
+
+#include "program_binary_cache.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pwd.h>
+#include <sys/stat.h>
+
+// Parameters of the 64-bit FNV-1a hash function used for hashing keys and program sources
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+// Format of the key identifying each cached program binary
+#define PROGRAM_BINARY_KEY_FORMAT "device=%s;driver=%s;options=%s;source=%016llx"
+// Suffix of the template of temporary files, replaced by a unique string by mkstemp
+#define TEMP_FILE_SUFFIX ".XXXXXX"
+
+/*
+ * Creates the directory "dir_path" with permissions for the current user only if it doesn't exist
+ * yet; returns zero if it still isn't a directory owned by the current user that other users can't
+ * access (without following symbolic links, so that the directory can't be redirected elsewhere).
+ */
+static int make_private_dir(const char* dir_path) {
+    struct stat dir_stat;
+    if ((mkdir(dir_path, S_IRWXU) != 0) && (errno != EEXIST)) {
+        return 0;
+    }
+    if ((lstat(dir_path, &dir_stat) != 0) || !S_ISDIR(dir_stat.st_mode) || (dir_stat.st_uid != geteuid())) {
+        return 0;
+    }
+    // Directories left accessible to other users by earlier versions are made private again
+    if (((dir_stat.st_mode & (S_IRWXG | S_IRWXO)) != 0) && (chmod(dir_path, S_IRWXU) != 0)) {
+        return 0;
+    }
+    return 1;
+}
+
+const char* get_program_binary_cache_dir(void) {
+    // The directory is only looked up (and created) once per process
+    static char cache_dir[MAX_PROGRAM_BINARY_INFO_LEN];
+    static int cache_dir_looked_up = 0;
+    static int cache_dir_usable = 0;
+
+    if (!cache_dir_looked_up) {
+        cache_dir_looked_up = 1;
+        const char* xdg_cache_home = getenv("XDG_CACHE_HOME");
+        const char* home_dir = getenv("HOME");
+        char user_cache_dir[MAX_PROGRAM_BINARY_INFO_LEN];
+        int path_len;
+
+        if ((home_dir == NULL) || (home_dir[0] != '/')) {
+            const struct passwd* user_entry = getpwuid(geteuid());
+            home_dir = (user_entry != NULL) ? user_entry->pw_dir : NULL;
+        }
+        // Relative paths within XDG_CACHE_HOME are to be ignored
+        if ((xdg_cache_home != NULL) && (xdg_cache_home[0] == '/')) {
+            path_len = snprintf(user_cache_dir, sizeof(user_cache_dir), "%s", xdg_cache_home);
+        } else if ((home_dir != NULL) && (home_dir[0] == '/')) {
+            path_len = snprintf(user_cache_dir, sizeof(user_cache_dir), "%s/.cache", home_dir);
+        } else {
+            return NULL;
+        }
+        if ((path_len <= 0) || ((size_t)path_len >= sizeof(user_cache_dir))) {
+            return NULL;
+        }
+        path_len = snprintf(cache_dir, sizeof(cache_dir), "%s/%s", user_cache_dir, PROGRAM_BINARY_CACHE_SUBDIR);
+        if ((path_len <= 0) || ((size_t)path_len >= sizeof(cache_dir))) {
+            return NULL;
+        }
+
+        // The user's cache directory itself is created as needed, but may be shared with other programs
+        if ((mkdir(user_cache_dir, S_IRWXU) != 0) && (errno != EEXIST)) {
+            return NULL;
+        }
+        cache_dir_usable = make_private_dir(cache_dir);
+    }
+    return cache_dir_usable ? cache_dir : NULL;
+}
+
+FILE* open_private_cache_file(const char* file_path) {
+    // No null pointers allowed
+    assert(file_path != NULL);
+
+    struct stat file_stat;
+    const int file_descriptor = open(file_path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (file_descriptor < 0) {
+        return NULL;
+    }
+    if ((fstat(file_descriptor, &file_stat) != 0) || !S_ISREG(file_stat.st_mode) ||
+           (file_stat.st_uid != geteuid())) {
+        close(file_descriptor);
+        return NULL;
+    }
+    FILE* file = fdopen(file_descriptor, "rb");
+    if (file == NULL) {
+        close(file_descriptor);
+    }
+    return file;
+}
+
+FILE* create_private_temp_file(const char* file_path, char* temp_file_path) {
+    // No null pointers allowed
+    assert(file_path != NULL);
+    assert(temp_file_path != NULL);
+
+    const int path_len = snprintf(temp_file_path, MAX_PROGRAM_BINARY_INFO_LEN, "%s" TEMP_FILE_SUFFIX, file_path);
+    if ((path_len <= 0) || (path_len >= MAX_PROGRAM_BINARY_INFO_LEN)) {
+        return NULL;
+    }
+    // mkstemp creates the file exclusively with permissions for the current user only
+    const int file_descriptor = mkstemp(temp_file_path);
+    if (file_descriptor < 0) {
+        return NULL;
+    }
+    FILE* file = fdopen(file_descriptor, "wb");
+    if (file == NULL) {
+        close(file_descriptor);
+        remove(temp_file_path);
+    }
+    return file;
+}
+
+// Returns the 64-bit FNV-1a hash of the null-terminated string "text"
+static unsigned long long hash_string(const char* text) {
+    unsigned long long hash = FNV_OFFSET_BASIS;
+    for (const unsigned char* curr_char = (const unsigned char*)text; *curr_char != '\0'; ++curr_char) {
+        hash = (hash ^ *curr_char) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/*
+ * Returns the key of a program compiled from "program_source" with "build_options" for "device"
+ * as a newly malloc'ed string, and writes the path of the corresponding cached program binary
+ * file within "cache_dir" to "cache_file_path".
+ */
+static char* get_program_binary_key(cl_device_id device, const char* cache_dir, const char* program_source,
+                                                      const char* build_options, char* cache_file_path) {
+    char device_name[MAX_PROGRAM_BINARY_INFO_LEN];
+    char driver_version[MAX_PROGRAM_BINARY_INFO_LEN];
+    clGetDeviceInfo(device, CL_DEVICE_NAME, MAX_PROGRAM_BINARY_INFO_LEN, device_name, NULL);
+    clGetDeviceInfo(device, CL_DRIVER_VERSION, MAX_PROGRAM_BINARY_INFO_LEN, driver_version, NULL);
+    // Keys have to fit on a single line of the cached program binary file
+    device_name[strcspn(device_name, "\n")] = '\0';
+    driver_version[strcspn(driver_version, "\n")] = '\0';
+
+    const unsigned long long source_hash = hash_string(program_source);
+    const int key_len = snprintf(NULL, 0, PROGRAM_BINARY_KEY_FORMAT, device_name, driver_version,
+                                                                       build_options, source_hash);
+    char* key = malloc((key_len + 1) * sizeof(char));
+    snprintf(key, key_len + 1, PROGRAM_BINARY_KEY_FORMAT, device_name, driver_version,
+                                                              build_options, source_hash);
+    snprintf(cache_file_path, MAX_PROGRAM_BINARY_INFO_LEN, PROGRAM_BINARY_FILE_FORMAT,
+                                                              cache_dir, hash_string(key));
+    return key;
+}
+
+/*
+ * Reads the next line of "file" into "line" (MUST be able to hold "line_capacity" characters)
+ * without the newline character; returns zero if no complete line could be read.
+ */
+static int read_line(FILE* file, char* line, const size_t line_capacity) {
+    if (fgets(line, line_capacity, file) == NULL) {
+        return 0;
+    }
+    const size_t line_len = strlen(line);
+    if ((line_len == 0) || (line[line_len - 1] != '\n')) {
+        return 0;
+    }
+    line[line_len - 1] = '\0';
+    return 1;
+}
+
+cl_program load_cached_program_binary(cl_context context, cl_device_id device, const char* cache_dir,
+                                        const char* program_source, const char* build_options,
+                                                                            char* cache_file_path) {
+    // No null pointers allowed, except for the directory and path of cached program binaries
+    assert(program_source != NULL);
+    assert(build_options != NULL);
+
+    if (cache_dir == NULL) {
+        return NULL;
+    }
+
+    char file_path[MAX_PROGRAM_BINARY_INFO_LEN];
+    char* key = get_program_binary_key(device, cache_dir, program_source, build_options, file_path);
+    const size_t key_len = strlen(key);
+    FILE* binary_file = open_private_cache_file(file_path);
+    cl_program program = NULL;
+
+    if (binary_file != NULL) {
+        // Room for the key and its newline character, plus one more character to detect longer lines
+        const size_t line_capacity = key_len + 3;
+        char* line = malloc(line_capacity * sizeof(char));
+        size_t binary_size = 0;
+        unsigned char* binary = NULL;
+
+        // Only use the binary if the whole file is intact and the key matches exactly
+        if (read_line(binary_file, line, line_capacity) && (strcmp(line, PROGRAM_BINARY_FILE_MAGIC) == 0) &&
+               read_line(binary_file, line, line_capacity) && (strcmp(line, key) == 0) &&
+               (fread(&binary_size, sizeof(binary_size), 1, binary_file) == 1) && (binary_size > 0)) {
+            binary = malloc(binary_size);
+            if (fread(binary, 1, binary_size, binary_file) == binary_size) {
+                cl_int binary_status;
+                cl_int error_code;
+                const unsigned char* binaries[] = { binary };
+                program = clCreateProgramWithBinary(context, 1, &device, &binary_size, binaries,
+                                                                  &binary_status, &error_code);
+                if ((program != NULL) && ((error_code != CL_SUCCESS) || (binary_status != CL_SUCCESS) ||
+                                  (clBuildProgram(program, 1, &device, build_options, NULL, NULL) != CL_SUCCESS))) {
+                    clReleaseProgram(program);
+                    program = NULL;
+                }
+            }
+            free(binary);
+        }
+        free(line);
+        fclose(binary_file);
+    }
+
+    if ((program != NULL) && (cache_file_path != NULL)) {
+        strcpy(cache_file_path, file_path);
+    }
+    free(key);
+    return program;
+}
+
+void store_cached_program_binary(cl_program program, cl_device_id device, const char* cache_dir,
+                                    const char* program_source, const char* build_options) {
+    // No null pointers allowed, except for the directory of cached program binaries
+    assert(program_source != NULL);
+    assert(build_options != NULL);
+
+    if (cache_dir == NULL) {
+        return;
+    }
+
+    // Programs are only ever built for a single device, so there's exactly one binary
+    size_t binary_size = 0;
+    clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(binary_size), &binary_size, NULL);
+    if (binary_size == 0) {
+        return;
+    }
+    unsigned char* binary = malloc(binary_size);
+    unsigned char* binaries[] = { binary };
+    clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(binaries), binaries, NULL);
+
+    char file_path[MAX_PROGRAM_BINARY_INFO_LEN];
+    char temp_file_path[MAX_PROGRAM_BINARY_INFO_LEN];
+    char* key = get_program_binary_key(device, cache_dir, program_source, build_options, file_path);
+    /*
+     * Write to a temporary file first and then rename it, so that other processes
+     * never load a partially written binary.
+     */
+    FILE* binary_file = create_private_temp_file(file_path, temp_file_path);
+
+    if (binary_file != NULL) {
+        const int write_succeeded = (fprintf(binary_file, "%s\n%s\n", PROGRAM_BINARY_FILE_MAGIC, key) > 0) &&
+                                     (fwrite(&binary_size, sizeof(binary_size), 1, binary_file) == 1) &&
+                                     (fwrite(binary, 1, binary_size, binary_file) == binary_size);
+        if ((fclose(binary_file) == 0) && write_succeeded) {
+            rename(temp_file_path, file_path);
+        } else {
+            remove(temp_file_path);
+        }
+    }
+
+    free(key);
+    free(binary);
+}
@@ -0,0 +1,89 @@
+/*
+ * File description:
+ *   Header file for functions saving compiled OpenCL programs to disk as
+ *   binaries (i.e. CL_PROGRAM_BINARIES) and loading them back on later runs,
+ *   so that OpenCL programs don't have to be compiled from source every time
+ *   the executable starts.
+ */
+
+#ifndef PROGRAM_BINARY_CACHE_H
+#define PROGRAM_BINARY_CACHE_H
+
+#define CL_TARGET_OPENCL_VERSION 220
+#include <CL/cl.h>
+#include <stdio.h>
+
+/*
+ * Directory in which cached program binaries are stored; set to NULL
+ * to always compile OpenCL programs from source instead. Binaries are only
+ * ever loaded from a directory private to the current user (refer to
+ * "get_program_binary_cache_dir"), as loading a binary planted by another
+ * user would run their code on the device.
+ */
+#define PROGRAM_BINARY_CACHE_DIR get_program_binary_cache_dir()
+/*
+ * Name of the directory of cached program binaries within the user's cache directory,
+ * i.e. $XDG_CACHE_HOME if set to an absolute path, or else the ".cache" directory of
+ * the user's home directory.
+ */
+#define PROGRAM_BINARY_CACHE_SUBDIR "bitonic_sort"
+/*
+ * Format of the name of each cached program binary file within PROGRAM_BINARY_CACHE_DIR,
+ * where the hexadecimal number is a hash of the key of the cached program binary.
+ */
+#define PROGRAM_BINARY_FILE_FORMAT "%s/bitonic_program_%016llx.bin"
+// Marker at the start of each cached program binary file identifying the format of the file
+#define PROGRAM_BINARY_FILE_MAGIC "BITONIC_PROGRAM_BINARY_V1"
+// Maximum length of device names, driver versions and paths of cached program binary files
+#define MAX_PROGRAM_BINARY_INFO_LEN 1024
+// Message to user when a program is loaded from a cached program binary file
+#define NOTIFY_USER_PROGRAM_BINARY_LOADED ">>> Loaded OpenCL program (%ss, sort %s) from cached binary %s\n\n"
+
+/*
+ * Returns the directory of cached program binaries (PROGRAM_BINARY_CACHE_SUBDIR within
+ * the user's cache directory), creating it with permissions for the current user only
+ * if it doesn't exist yet. Returns NULL if there's no such directory that is owned by
+ * the current user, isn't a symbolic link and isn't accessible to other users, in which
+ * case nothing should be cached.
+ */
+const char* get_program_binary_cache_dir(void);
+
+/*
+ * Opens "file_path" within the cache directory for reading, if and only if it's a regular
+ * file (not a symbolic link) owned by the current user; returns NULL otherwise.
+ */
+FILE* open_private_cache_file(const char* file_path);
+
+/*
+ * Creates a new uniquely named temporary file next to "file_path" (within the cache directory)
+ * that is only accessible to the current user, opened for writing, and writes its path to
+ * "temp_file_path" (MUST be able to hold MAX_PROGRAM_BINARY_INFO_LEN characters); returns NULL
+ * if it can't be created. Renaming the temporary file over "file_path" once it has been written
+ * replaces the file atomically, so that other processes never read a partially written file.
+ */
+FILE* create_private_temp_file(const char* file_path, char* temp_file_path);
+
+/*
+ * Returns a program for "device" within "context" built from a program binary
+ * previously cached within "cache_dir", if and only if the key of the cached
+ * binary matches; the key consists of the name and driver version of "device",
+ * "build_options" and a hash of "program_source". Returns NULL if no matching
+ * binary is found (or "cache_dir" is NULL), or if the binary fails to build;
+ * the program then has to be compiled from source instead. If "cache_file_path"
+ * isn't NULL, it receives the path of the cached binary file (MUST be able to
+ * hold MAX_PROGRAM_BINARY_INFO_LEN characters).
+ */
+cl_program load_cached_program_binary(cl_context context, cl_device_id device, const char* cache_dir,
+                                        const char* program_source, const char* build_options,
+                                                                            char* cache_file_path);
+
+/*
+ * Saves the binary of "program" (compiled from "program_source" with "build_options"
+ * for "device") within "cache_dir" so that "load_cached_program_binary" finds it on
+ * later runs; does nothing if "cache_dir" is NULL. Failing to save the binary isn't an
+ * error, as the program can always be compiled from source again.
+ */
+void store_cached_program_binary(cl_program program, cl_device_id device, const char* cache_dir,
+                                    const char* program_source, const char* build_options);
+
+#endif // PROGRAM_BINARY_CACHE_H
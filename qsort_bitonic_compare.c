@@ -17,6 +17,8 @@
 #include <assert.h>
 #include <errno.h>
 #include <float.h>
+#include <getopt.h>
+#include <limits.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -26,9 +28,61 @@
 #include "array_utilities.h"
 #include "naive_bitonic_sort_opencl.h"
 #include "naive_bitonic_sort_serial.h"
+#include "program_binary_cache.h"
+#include "bitonic_sort_session.h"
+#include "multiway_merge.h"
+#include "parallel_bitonic_sort_cpu.h"
+#include "simd_bitonic_sort_cpu.h"
+#include "hybrid_sort_cpu.h"
+#include "reference_sorts_cpu.h"
+#include "radix_sort_opencl.h"
+#include "sortable_keys.h"
+#include "bitonic_profile.h"
+#include "opencl_devices.h"
+#include "top_k_cpu.h"
 
 // =================================================================================================
 
+// Names of the ways of loading arrays, indexed by the value of each flag variable literal
+static const char* const host_buffer_mode_names[] = {
+    "copies into a separate buffer", "CL_MEM_USE_HOST_PTR (zero-copy)",
+    "CL_MEM_ALLOC_HOST_PTR with map/unmap"};
+// Names of the engines as given to --engines, indexed by the macro value of each
+static const char* const engine_names[NUM_COMPARE_ENGINES] = {
+    "opencl_bitonic",       "opencl_argsort",       "opencl_chunked",
+    "opencl_radix",         "opencl_multi_device",  "opencl_async_batches",
+    "opencl_segmented",     "opencl_top_k",         "serial_bitonic",
+    "serial_argsort",       "parallel_bitonic_cpu", "simd_bitonic",
+    "hybrid",               "introsort",            "radix_cpu",
+    "top_k_cpu"};
+// Names of the ways of choosing devices for --multi-device, indexed by the macro value of each
+static const char* const multi_device_mode_names[NUM_MULTI_DEVICE_MODES] = {
+    "auto", "sub-devices", "platform"};
+
+// Command line options, along with the values returned by getopt_long for each
+enum Compare_Option {
+  SIZE_OPTION = 1,
+  ENGINES_OPTION,
+  PLATFORM_OPTION,
+  DEVICE_OPTION,
+  REPETITIONS_OPTION,
+  MULTI_DEVICE_OPTION,
+  TOP_K_OPTION,
+  LIST_DEVICES_OPTION,
+  HELP_OPTION
+};
+static const struct option compare_options[] = {
+    {"size", required_argument, NULL, SIZE_OPTION},
+    {"engines", required_argument, NULL, ENGINES_OPTION},
+    {"platform", required_argument, NULL, PLATFORM_OPTION},
+    {"device", required_argument, NULL, DEVICE_OPTION},
+    {"repetitions", required_argument, NULL, REPETITIONS_OPTION},
+    {"multi-device", required_argument, NULL, MULTI_DEVICE_OPTION},
+    {"top-k", required_argument, NULL, TOP_K_OPTION},
+    {"list-devices", no_argument, NULL, LIST_DEVICES_OPTION},
+    {"help", no_argument, NULL, HELP_OPTION},
+    {NULL, 0, NULL, 0}};
+
 /*
  * Given a specified file location containing an OpenCL program
  * reads the entire contents of the file into memory and returns
@@ -66,60 +120,183 @@ char* get_opencl_program_code(char* opencl_program_file_location) {
 
 /*
  * Setup procedure for executing OpenCL programs.  The procedure involves
- * creating an execution context to be used by the OpenCL-programmed device
- * (in this case the GPU or CPU), setting up the queue which is used to store
- * the kernels to be executed by the device within the execution context, and
- * then dynamically compiling the program containing the kernels which are to be
- * executed once the kernels (or even multiple copies of each kernel) gets added
- * to the queue.
+ * starting a persistent sorting session on the device selected by "config",
+ * which creates an execution context to be used by the OpenCL-programmed device
+ * (in this case the GPU or CPU), sets up the queue which is used to store the
+ * kernels to be executed by the device within the execution context, and then
+ * prepares a cache of programs containing the kernels which are to be executed;
+ * each program in the cache gets dynamically compiled for one data type and
+ * sorting direction the first time it's needed.
  */
-void configure_opencl_env(cl_context* context,
-                          cl_command_queue* queue,
-                          cl_program* program) {
+void configure_opencl_env(struct Bitonic_Sort_Session* session,
+                          const struct Compare_Config* config) {
   // No null pointers allowed
-  assert(context != NULL);
-  assert(queue != NULL);
-  assert(program != NULL);
-
-  cl_device_id device;
-  char deviceName[MAX_LEN];
-  cl_queue_properties queue_properties[] = {CL_QUEUE_PROPERTIES,
-                                            CL_QUEUE_PROFILING_ENABLE, 0};
-  cl_platform_id* platforms = malloc(sizeof(cl_platform_id) * NUM_CL_PLATFORMS);
-
-  clGetPlatformIDs(NUM_CL_PLATFORMS, platforms, NULL);
-  clGetDeviceIDs(platforms[DESIRED_PLATFORM_INDEX], CL_DEVICE_TYPE_DEFAULT,
-                 NUM_CL_DEVICES, &device, NULL);
-  *context = clCreateContext(NULL, NUM_CL_DEVICES, &device, NULL, NULL, NULL);
-  *queue = clCreateCommandQueueWithProperties(*context, device,
-                                              queue_properties, NULL);
-
-  // read OpenCL program file into string
-  const char* opencl_program_string = get_opencl_program_code(PROGRAM_FILE);
-
-  clGetDeviceInfo(device, CL_DEVICE_NAME, MAX_LEN, deviceName, NULL);
-
-  if (opencl_program_string != NULL) {
-    // Compile the opencl_program
-    *program = clCreateProgramWithSource(*context, OPENCL_PROGS,
-                                         &opencl_program_string, NULL, NULL);
-    clBuildProgram(*program, 0, NULL, COMPILER_ARRAY_TYPE_OPTION, NULL, NULL);
-
-    // Get info generated by compiler and output any compiler-generated messages
-    // to user
-    size_t logSize;
-    clGetProgramBuildInfo(*program, device, CL_PROGRAM_BUILD_LOG, 0, NULL,
-                          &logSize);
-    char* messages = (char*)malloc((1 + logSize) * sizeof(char));
-    clGetProgramBuildInfo(*program, device, CL_PROGRAM_BUILD_LOG, logSize,
-                          messages, NULL);
-    messages[logSize] = TEXT_FILE_DELIM;
-    printf(">>> OpenCL program compiler result message: - %s\n\n", messages);
-    free(messages);
-  }
-
-  // Platforms already acquired; free malloc'ed memory
-  free(platforms);
+  assert(session != NULL);
+  assert(config != NULL);
+
+  /*
+   * Use the OpenCL program embedded within the executable, or read OpenCL
+   * program file into string; the session keeps its own copy of the program
+   * source.
+   */
+#if (EMBED_PROGRAM_SOURCE)
+  init_bitonic_sort_session(session, config->platform_selector,
+                            config->device_selector, bitonic_program_source,
+                            PROGRAM_BINARY_CACHE_DIR);
+#else
+  char* opencl_program_string = get_opencl_program_code(PROGRAM_FILE);
+  init_bitonic_sort_session(session, config->platform_selector,
+                            config->device_selector, opencl_program_string,
+                            PROGRAM_BINARY_CACHE_DIR);
+  free(opencl_program_string);
+#endif
+}
+
+// Prints the usage message along with the invalid value of "option_name", then exits
+void exit_invalid_option(const char* option_name, const char* value) {
+  fprintf(stderr, COMPARE_INVALID_OPTION_MESSAGE, option_name, value);
+  fprintf(stderr, COMPARE_USAGE_MESSAGE, "qsort_bitonic_compare");
+  exit(EXIT_FAILURE);
+}
+
+// Parses "value" of "option_name" as a positive number, exiting if it isn't one
+unsigned int parse_positive_number(const char* option_name, const char* value) {
+  char* value_end;
+  errno = 0;
+  const unsigned long number = strtoul(value, &value_end, 10);
+  if ((errno != 0) || (value_end == value) || (*value_end != '\0') ||
+      (value[0] == '-') || (number == 0) || (number > UINT_MAX)) {
+    exit_invalid_option(option_name, value);
+  }
+  return (unsigned int)number;
+}
+
+/*
+ * Parses the comma-separated list of engine names "value" into "engines", such that
+ * only the engines listed sort copies of the array; exits if any name is unknown.
+ */
+void parse_engine_list(const char* value, unsigned char* engines) {
+  if (strcmp(value, ALL_COMPARE_ENGINES) == 0) {
+    memset(engines, 1, NUM_COMPARE_ENGINES);
+    return;
+  }
+  memset(engines, 0, NUM_COMPARE_ENGINES);
+  const char* name_start = value;
+  while (1) {
+    const size_t name_len = strcspn(name_start, ",");
+    unsigned int engine = 0;
+    while ((engine < NUM_COMPARE_ENGINES) &&
+           ((strlen(engine_names[engine]) != name_len) ||
+            (strncmp(engine_names[engine], name_start, name_len) != 0))) {
+      ++engine;
+    }
+    if (engine == NUM_COMPARE_ENGINES) {
+      exit_invalid_option("engines", value);
+    }
+    engines[engine] = 1;
+    if (name_start[name_len] == '\0') {
+      break;
+    }
+    name_start += name_len + 1;
+  }
+}
+
+// Applies the value of "option" to "config"; exits if the value isn't valid
+void apply_compare_option(const int option, const char* value,
+                          struct Compare_Config* config) {
+  switch (option) {
+    case SIZE_OPTION:
+      config->array_len = parse_positive_number("size", value);
+      break;
+    case ENGINES_OPTION:
+      parse_engine_list(value, config->engines);
+      break;
+    case PLATFORM_OPTION:
+      config->platform_selector = value;
+      break;
+    case DEVICE_OPTION:
+      config->device_selector = value;
+      break;
+    case REPETITIONS_OPTION:
+      config->repetitions = parse_positive_number("repetitions", value);
+      break;
+    case MULTI_DEVICE_OPTION:
+      config->multi_device_mode = 0;
+      while ((config->multi_device_mode < NUM_MULTI_DEVICE_MODES) &&
+             (strcmp(multi_device_mode_names[config->multi_device_mode],
+                     value) != 0)) {
+        ++config->multi_device_mode;
+      }
+      if (config->multi_device_mode == NUM_MULTI_DEVICE_MODES) {
+        exit_invalid_option("multi-device", value);
+      }
+      break;
+    case TOP_K_OPTION:
+      config->top_k = parse_positive_number("top-k", value);
+      break;
+  }
+}
+
+/*
+ * Fills "config" with the defaults, overridden by the environment variables
+ * set and then by the options given on the command line.
+ */
+void parse_compare_options(int argc, char* argv[],
+                           struct Compare_Config* config) {
+  // Environment variables, along with the option each one stands for
+  const char* const option_envs[] = {ARRAY_LEN_ENV,   ENGINES_ENV,
+                                     PLATFORM_ENV,    DEVICE_ENV,
+                                     REPETITIONS_ENV, MULTI_DEVICE_ENV,
+                                     TOP_K_ENV};
+  const int env_options[] = {SIZE_OPTION,        ENGINES_OPTION,
+                             PLATFORM_OPTION,    DEVICE_OPTION,
+                             REPETITIONS_OPTION, MULTI_DEVICE_OPTION,
+                             TOP_K_OPTION};
+
+  config->array_len = ARRAY_LEN;
+  memset(config->engines, 1, NUM_COMPARE_ENGINES);
+  config->platform_selector = DESIRED_PLATFORM;
+  config->device_selector = DESIRED_DEVICE;
+  config->repetitions = DEFAULT_REPETITIONS;
+  config->multi_device_mode = MULTI_DEVICE_MODE;
+  config->top_k = DEFAULT_TOP_K;
+
+  for (unsigned int env_index = 0;
+       env_index < sizeof(env_options) / sizeof(env_options[0]); ++env_index) {
+    const char* env_value = getenv(option_envs[env_index]);
+    if ((env_value != NULL) && (env_value[0] != '\0')) {
+      apply_compare_option(env_options[env_index], env_value, config);
+    }
+  }
+
+  int option;
+  while ((option = getopt_long(argc, argv, "", compare_options, NULL)) != -1) {
+    switch (option) {
+      case LIST_DEVICES_OPTION:
+        list_opencl_devices(stdout);
+        exit(EXIT_SUCCESS);
+      case HELP_OPTION:
+        printf(COMPARE_USAGE_MESSAGE, argv[0]);
+        exit(EXIT_SUCCESS);
+      case '?':
+        fprintf(stderr, COMPARE_USAGE_MESSAGE, argv[0]);
+        exit(EXIT_FAILURE);
+      default:
+        apply_compare_option(option, optarg, config);
+    }
+  }
+  if (optind < argc) {
+    fprintf(stderr, COMPARE_USAGE_MESSAGE, argv[0]);
+    exit(EXIT_FAILURE);
+  }
+}
+
+// Returns the current time in seconds
+double get_current_seconds(void) {
+  struct timespec current_time;
+  timespec_get(&current_time, TIME_UTC);
+  return (double)current_time.tv_sec +
+         ((double)current_time.tv_nsec) / NANOSECS_IN_SEC;
 }
 
 // Element comparision function for qsort
@@ -131,6 +308,24 @@ int compare_elements_qsort(const void* first_arg, const void* second_arg) {
   // Cast to appropriate data types as determined by "control" macros
   ARRAY_TYPE_DECLARED first_element = *(const ARRAY_TYPE_DECLARED*)first_arg;
   ARRAY_TYPE_DECLARED second_element = *(const ARRAY_TYPE_DECLARED*)second_arg;
+#if (ARRAY_TYPE == FLOAT) || (ARRAY_TYPE == DOUBLE)
+  /*
+   * Floating point numbers are compared by their keys instead, which give a
+   * total order with NaNs last (refer to "sortable_keys.h"); keys of numbers
+   * which compare equal only differ for -0.0 and +0.0.
+   */
+#if (ARRAY_TYPE == FLOAT)
+  const uint32_t first_key = float_to_key(first_element, SORTING_DIRECTION);
+  const uint32_t second_key = float_to_key(second_element, SORTING_DIRECTION);
+#else
+  const uint64_t first_key = double_to_key(first_element, SORTING_DIRECTION);
+  const uint64_t second_key = double_to_key(second_element, SORTING_DIRECTION);
+#endif
+  if (SORTING_DIRECTION) {
+    return (first_key < second_key) - (first_key > second_key);
+  }
+  return (first_key > second_key) - (first_key < second_key);
+#else
   // Compare result as defined in the C standard library documentation for qsort
   int compare_result;
 
@@ -144,145 +339,596 @@ int compare_elements_qsort(const void* first_arg, const void* second_arg) {
   }
 
   return compare_result;
+#endif
 }
 
-// Testing bitonic sorting using a custom OpenCL opencl_program.
-int main(int argc, char* argv[]) {
+/*
+ * Splits an array of "array_len" elements into segments whose lengths vary between
+ * SEGMENTED_SORT_MIN_SEGMENT_LEN and SEGMENTED_SORT_MAX_SEGMENT_LEN (the last one may
+ * be shorter), writing the number of segments into "num_segments"; returns the offsets
+ * of the segments (refer to "bitonic_session_sort_segmented"), to be freed by the caller.
+ */
+unsigned int* get_segment_offsets(const unsigned int array_len,
+                                  unsigned int* num_segments) {
+  const unsigned int max_num_segments =
+      (array_len + SEGMENTED_SORT_MIN_SEGMENT_LEN - 1) /
+      SEGMENTED_SORT_MIN_SEGMENT_LEN;
+  unsigned int* segment_offsets =
+      malloc((max_num_segments + 1) * sizeof(unsigned int));
+
+  // Lengths follow a hash of the index of each segment, so every round splits alike
+  *num_segments = 0;
+  segment_offsets[0] = 0;
+  while (segment_offsets[*num_segments] < array_len) {
+    const unsigned int segment_len =
+        SEGMENTED_SORT_MIN_SEGMENT_LEN +
+        (*num_segments * 2654435761u) % (SEGMENTED_SORT_MAX_SEGMENT_LEN -
+                                         SEGMENTED_SORT_MIN_SEGMENT_LEN + 1);
+    const unsigned int remaining_len =
+        array_len - segment_offsets[*num_segments];
+    segment_offsets[*num_segments + 1] =
+        segment_offsets[*num_segments] +
+        ((segment_len < remaining_len) ? segment_len : remaining_len);
+    ++*num_segments;
+  }
+  return segment_offsets;
+}
+
+/*
+ * Verifies "sorted_array" (a copy of the array sorted by one of the engines)
+ * against "reference_array" after printing "verify_msg", then frees it.
+ */
+void verify_and_free_sorted_copy(
+    const char* verify_msg, struct Array_With_Length_Padded* sorted_array,
+    struct Array_With_Length_Padded* reference_array) {
+  printf("%s", verify_msg);
+  assert_padded_arrays_equality(sorted_array, reference_array);
+  free(sorted_array->contents);
+  free(sorted_array);
+}
+
+/*
+ * Sorts a copy of "unsorted_array" with every engine selected by "config" (on the
+ * OpenCL device of "session" for the OpenCL engines, in which case "session" MUST
+ * have been configured, and across the devices of "multi_sort" for the multi-device
+ * engine), reporting the time each one took, and verifies the result of every
+ * engine against the result of qsort. The array is sorted with qsort first, and
+ * every other engine copies the array just before sorting and frees its copy
+ * right after it's been verified, so that no more than three copies of the array
+ * (the unsorted array, the result of qsort and the copy of the engine running)
+ * are held in host memory at once.
+ */
+void compare_sorts(const struct Compare_Config* config,
+                   struct Bitonic_Sort_Session* session,
+                   struct Multi_Device_Sort* multi_sort,
+                   struct Array_With_Length_Padded* unsorted_array) {
+  // No null pointers allowed
+  assert(config != NULL);
+  assert(unsorted_array != NULL);
+
   // All variable declarations
-  cl_context context;
-  cl_command_queue queue;
-  cl_program program;
-  cl_kernel kernel;
-  cl_mem buffer_in;
-  struct timespec current_time;
   double sort_start_time_no_cp, sort_end_time_no_cp;
   double sort_start_time, sort_end_time;
-  struct Array_With_Length_Padded* sample_array =
-      get_rand_padded_array(ARRAY_LEN);
+  const unsigned int array_len = unsorted_array->array_len_actual;
+
   /*
-   * Copy of array we wish to sort, to be sorted by serial bitonic sorting for
-   * comparing performance to OpenCL parallelized bitonic sorting.
+   * Create another copy of the array we wish to sort so that we may generate
+   * the correct sorted result using the C standard library's built-in qsort
+   * function.
    */
-  struct Array_With_Length_Padded* sample_array_cp =
-      deep_cp_padded_array(sample_array);
+  struct Array_With_Length_Padded* qsort_array =
+      deep_cp_padded_array(unsorted_array);
 
-  configure_opencl_env(&context, &queue, &program);
+  // Signal to user start of Qsort
+  printf(NOTIFY_USER_QSORT_START);
 
-  // Get time of when parallel bitonic sort algorithm starts executing
-  timespec_get(&current_time, TIME_UTC);
-  sort_start_time = (double)current_time.tv_sec +
-                    ((double)current_time.tv_nsec) / NANOSECS_IN_SEC;
+  // Get time of when qsort starts executing
+  sort_start_time = get_current_seconds();
 
-  load_array_bitonic_sort(&context, &queue, sample_array, &buffer_in);
+  qsort(qsort_array->contents, array_len, sizeof(*(qsort_array->contents)),
+        compare_elements_qsort);
 
-  timespec_get(&current_time, TIME_UTC);
-  sort_start_time_no_cp = (double)current_time.tv_sec +
-                          ((double)current_time.tv_nsec) / NANOSECS_IN_SEC;
+  // Get time of when qsort finishes executing
+  sort_end_time = get_current_seconds();
 
-  opencl_bitonic_sort(&queue, &program, &kernel, sample_array, &buffer_in,
-                      SORTING_DIRECTION);
+  // Report to user time spent on sorting using qsort
+  printf(QSORT_MESSAGE, array_len, sort_end_time - sort_start_time);
+
+  // Top-K engines are verified against the first K elements sorted by qsort
+  const unsigned int num_top_k =
+      (config->top_k < array_len) ? config->top_k : array_len;
+  struct Array_With_Length_Padded qsort_top_k = *qsort_array;
+  qsort_top_k.array_len_actual = num_top_k;
+  qsort_top_k.padded_2n_length = num_top_k;
+
+  if (config->engines[COMPARE_OPENCL_BITONIC]) {
+    struct Array_With_Length_Padded* sample_array =
+        deep_cp_padded_array(unsorted_array);
+    cl_mem buffer_in;
+    /*
+     * Data type the OpenCL device sorts as, i.e. signed integers of the same
+     * size for floating point numbers if SORT_FLOATS_AS_INTEGERS is enabled.
+     */
+    const unsigned int opencl_sort_type =
+        SORT_FLOATS_AS_INTEGERS ? get_sortable_key_type(ARRAY_TYPE)
+                                : ARRAY_TYPE;
+
+    // Profile every command of the parallelized bitonic sort, if so configured
+    struct Bitonic_Profile profile;
+    if (PROFILE_OPENCL_SORT) {
+      init_bitonic_profile(&profile);
+      session->program_cache.profile = &profile;
+    }
 
-  timespec_get(&current_time, TIME_UTC);
-  sort_end_time_no_cp = (double)current_time.tv_sec +
-                        ((double)current_time.tv_nsec) / NANOSECS_IN_SEC;
+    // Kernels of the session turning floating point numbers into integers and back
+    const struct Bitonic_Kernels* float_key_kernels =
+        SORT_FLOATS_AS_INTEGERS ? get_session_kernels(session, ARRAY_TYPE,
+                                                      SORTING_DIRECTION,
+                                                      NO_PAYLOAD)
+                                : NULL;
 
-  // Copy the sorted array back to the CPU memory
-  clEnqueueReadBuffer(
-      queue, buffer_in, CL_BLOCKING, CL_BUFFER_OFFSET,
-      sample_array->padded_2n_length * sizeof(ARRAY_TYPE_DECLARED),
-      sample_array->contents, 0, NULL, NULL);
+    // Get time of when parallel bitonic sort algorithm starts executing
+    sort_start_time = get_current_seconds();
 
-  // Get time of when parallel bitonic sort finishes executing
-  timespec_get(&current_time, TIME_UTC);
-  sort_end_time = (double)current_time.tv_sec +
-                  ((double)current_time.tv_nsec) / NANOSECS_IN_SEC;
+    const unsigned int host_buffer_mode =
+        load_array_bitonic_sort(&session->context, &session->queue, sample_array,
+                                ARRAY_TYPE, &buffer_in, HOST_BUFFER_MODE);
+
+    sort_start_time_no_cp = get_current_seconds();
+
+    if (SORT_FLOATS_AS_INTEGERS) {
+      opencl_float_keys_to_sortable(&session->queue, float_key_kernels,
+                                    &buffer_in, array_len, ARRAY_TYPE);
+    }
+    opencl_bitonic_sort(&session->queue, &session->program_cache, &buffer_in,
+                        array_len, opencl_sort_type, SORTING_DIRECTION);
+    if (SORT_FLOATS_AS_INTEGERS) {
+      opencl_sortable_to_float_keys(&session->queue, float_key_kernels,
+                                    &buffer_in, array_len, ARRAY_TYPE);
+    }
 
-  // Report to user time spent on sorting using parallelized bitonic sort in
-  // OpenCL
-  printf(BITONIC_PARALLEL_SORT_MESSAGE, sample_array->array_len_actual,
-         sort_end_time - sort_start_time);
-  printf(BITONIC_PARALLEL_SORT_MESSAGE_NO_CP, sample_array->array_len_actual,
-         sort_end_time_no_cp - sort_start_time_no_cp);
+    sort_end_time_no_cp = get_current_seconds();
+
+    // Copy (or just map, if sorted in place) the sorted array back to CPU memory
+    read_array_bitonic_sort(&session->queue, sample_array, ARRAY_TYPE,
+                            &buffer_in, host_buffer_mode);
+
+    // Get time of when parallel bitonic sort finishes executing
+    sort_end_time = get_current_seconds();
+    clReleaseMemObject(buffer_in);
+
+    // Report to user time spent on sorting using parallelized bitonic sort in
+    // OpenCL
+    printf(BITONIC_HOST_BUFFER_MODE_MESSAGE,
+           host_buffer_mode_names[host_buffer_mode]);
+    printf(BITONIC_PARALLEL_SORT_MESSAGE, array_len,
+           sort_end_time - sort_start_time);
+    printf(BITONIC_PARALLEL_SORT_MESSAGE_NO_CP, array_len,
+           sort_end_time_no_cp - sort_start_time_no_cp);
+    if (PROFILE_OPENCL_SORT) {
+      print_bitonic_profile(&profile, stdout);
+      session->program_cache.profile = NULL;
+      release_bitonic_profile(&profile);
+    }
+
+    verify_and_free_sorted_copy(BITONIC_PARALLEL_SORT_VERIFY_MSG, sample_array,
+                                qsort_array);
+  }
 
   /*
-   * Cleanup host and device memory of OpenCL
-   * objects as we are done with sorting using
-   * OpenCL runtime.
+   * Compute the permutation that sorts another unsorted copy of the array by
+   * sorting by key with indices generated on the fly as payloads, on the OpenCL
+   * device within the sorting session and/or serially, and verify each one
+   * against the unsorted array.
    */
-  clReleaseMemObject(buffer_in);
-  clReleaseCommandQueue(queue);
-  clReleaseContext(context);
-  clReleaseProgram(program);
-  clReleaseKernel(kernel);
+  if (config->engines[COMPARE_OPENCL_ARGSORT]) {
+    struct Array_With_Length_Padded* keys_array =
+        deep_cp_padded_array(unsorted_array);
+    unsigned int* permutation = malloc(array_len * sizeof(cl_uint));
+    bitonic_session_sort_by_key(session, keys_array->contents, permutation,
+                                array_len, ARRAY_TYPE, PAYLOAD_32_BIT, 1,
+                                SORTING_DIRECTION);
+
+    printf(BITONIC_PARALLEL_ARGSORT_VERIFY_MSG);
+    assert_padded_array_permutation(qsort_array, unsorted_array, permutation);
+    free(permutation);
+    free(keys_array->contents);
+    free(keys_array);
+  }
+  if (config->engines[COMPARE_SERIAL_ARGSORT]) {
+    struct Array_With_Length_Padded* keys_array =
+        deep_cp_padded_array(unsorted_array);
+    unsigned int* permutation = malloc(array_len * sizeof(cl_uint));
+    serial_bitonic_sort_by_key(keys_array, permutation, PAYLOAD_32_BIT, 1,
+                               SORTING_DIRECTION);
+
+    printf(BITONIC_SERIAL_ARGSORT_VERIFY_MSG);
+    assert_padded_array_permutation(qsort_array, unsorted_array, permutation);
+    free(permutation);
+    free(keys_array->contents);
+    free(keys_array);
+  }
 
   /*
-   * Now that we have cleaned up objects no longer needed in main memory, create
-   * another copy of the array we wish to sort so that we may generate the
-   * correct sorted result using the C standard library's built-in qsort
-   * function.
+   * Sort yet another copy of the array in runs, as if the array didn't fit
+   * within the device's memory, and merge the sorted runs on the host.
    */
-  struct Array_With_Length_Padded* sample_array_2nd_cp =
-      deep_cp_padded_array(sample_array_cp);
+  if (config->engines[COMPARE_OPENCL_CHUNKED]) {
+    struct Array_With_Length_Padded* chunked_array =
+        deep_cp_padded_array(unsorted_array);
+    const size_t chunked_run_length =
+        (array_len + CHUNKED_SORT_NUM_RUNS - 1) / CHUNKED_SORT_NUM_RUNS;
 
-  // Get time of when serial bitonic sort algorithm starts executing
-  timespec_get(&current_time, TIME_UTC);
-  sort_start_time = (double)current_time.tv_sec +
-                    ((double)current_time.tv_nsec) / NANOSECS_IN_SEC;
+    sort_start_time = get_current_seconds();
 
-  serial_bitonic_sort(sample_array_cp, SORTING_DIRECTION);
+    bitonic_session_sort_chunked(session, chunked_array->contents, array_len,
+                                 ARRAY_TYPE, SORTING_DIRECTION,
+                                 chunked_run_length, NUM_MERGE_THREADS_AUTO);
 
-  // Get time of when serial bitonic sort finishes executing
-  timespec_get(&current_time, TIME_UTC);
-  sort_end_time = (double)current_time.tv_sec +
-                  ((double)current_time.tv_nsec) / NANOSECS_IN_SEC;
+    sort_end_time = get_current_seconds();
 
-  // Report to user time spent on sorting using serial bitonic sort on CPU
-  printf(BITONIC_SERIAL_SORT_MESSAGE, sample_array_cp->array_len_actual,
-         sort_end_time - sort_start_time);
+    printf(BITONIC_CHUNKED_SORT_MESSAGE, array_len,
+           (int)((array_len + chunked_run_length - 1) / chunked_run_length),
+           sort_end_time - sort_start_time);
+    verify_and_free_sorted_copy(BITONIC_CHUNKED_SORT_VERIFY_MSG, chunked_array,
+                                qsort_array);
+  }
 
-  // Signal to user start of Qsort
-  printf(NOTIFY_USER_QSORT_START);
+  // Sort one more copy with the LSD radix sort engine on the same device
+  if (config->engines[COMPARE_OPENCL_RADIX]) {
+    struct Array_With_Length_Padded* opencl_radix_array =
+        deep_cp_padded_array(unsorted_array);
+    cl_mem radix_buffer;
+
+    sort_start_time = get_current_seconds();
+
+    const unsigned int radix_host_buffer_mode = load_array_bitonic_sort(
+        &session->context, &session->queue, opencl_radix_array, ARRAY_TYPE,
+        &radix_buffer, HOST_BUFFER_MODE);
+    opencl_radix_sort(&session->queue, &session->program_cache, &radix_buffer,
+                      array_len, ARRAY_TYPE, SORTING_DIRECTION);
+    read_array_bitonic_sort(&session->queue, opencl_radix_array, ARRAY_TYPE,
+                            &radix_buffer, radix_host_buffer_mode);
+
+    sort_end_time = get_current_seconds();
+    clReleaseMemObject(radix_buffer);
+
+    printf(OPENCL_RADIX_SORT_MESSAGE, array_len,
+           sort_end_time - sort_start_time);
+    verify_and_free_sorted_copy(OPENCL_RADIX_SORT_VERIFY_MSG,
+                                opencl_radix_array, qsort_array);
+  }
 
-  // Get time of when qsort starts executing
-  timespec_get(&current_time, TIME_UTC);
-  sort_start_time = (double)current_time.tv_sec +
-                    ((double)current_time.tv_nsec) / NANOSECS_IN_SEC;
+  // Sort another copy by sharing it out across several devices at once
+  if (config->engines[COMPARE_OPENCL_MULTI_DEVICE]) {
+    struct Array_With_Length_Padded* multi_device_array =
+        deep_cp_padded_array(unsorted_array);
 
-  qsort(sample_array_2nd_cp->contents, sample_array_2nd_cp->padded_2n_length,
-        sizeof(*(sample_array_2nd_cp->contents)), compare_elements_qsort);
+    sort_start_time = get_current_seconds();
 
-  // Get time of when qsort finishes executing
-  timespec_get(&current_time, TIME_UTC);
-  sort_end_time = (double)current_time.tv_sec +
-                  ((double)current_time.tv_nsec) / NANOSECS_IN_SEC;
+    multi_device_sort(multi_sort, multi_device_array->contents, array_len,
+                      ARRAY_TYPE, SORTING_DIRECTION, NUM_MERGE_THREADS_AUTO);
 
-  // Report to user time spent on sorting using qsort
-  printf(QSORT_MESSAGE, sample_array_2nd_cp->array_len_actual,
-         sort_end_time - sort_start_time);
+    sort_end_time = get_current_seconds();
+
+    printf(BITONIC_MULTI_DEVICE_SORT_MESSAGE, array_len,
+           multi_sort->num_devices, sort_end_time - sort_start_time);
+    verify_and_free_sorted_copy(BITONIC_MULTI_DEVICE_SORT_VERIFY_MSG,
+                                multi_device_array, qsort_array);
+  }
 
   /*
-   * if sorting direction was descending, have padding location indicator be
-   * adjusted to indicate padding at beginning of the array.
+   * Sort another copy as independent batches, enqueueing every batch without
+   * waiting for the earlier ones, and merge the sorted batches on the host
+   * afterwards (untimed) so that the result may be verified like the others.
    */
-  if (SORTING_DIRECTION) {
-    sample_array->padding_location_indicator = PAD_ARRAY_AT_BEGINNING;
-    sample_array_cp->padding_location_indicator = PAD_ARRAY_AT_BEGINNING;
-    sample_array_2nd_cp->padding_location_indicator = PAD_ARRAY_AT_BEGINNING;
+  if (config->engines[COMPARE_OPENCL_ASYNC_BATCHES]) {
+    struct Array_With_Length_Padded* batches_array =
+        deep_cp_padded_array(unsorted_array);
+    const unsigned int num_batches = (array_len < ASYNC_SORT_NUM_BATCHES)
+                                         ? array_len
+                                         : ASYNC_SORT_NUM_BATCHES;
+    const size_t element_size = get_array_type_size(ARRAY_TYPE);
+    char* batches_data = (char*)batches_array->contents;
+    size_t batch_offsets[ASYNC_SORT_NUM_BATCHES + 1];
+    cl_event batch_events[ASYNC_SORT_NUM_BATCHES];
+    for (unsigned int batch = 0; batch <= num_batches; ++batch) {
+      batch_offsets[batch] = (size_t)array_len * batch / num_batches;
+    }
+
+    sort_start_time = get_current_seconds();
+
+    for (unsigned int batch = 0; batch < num_batches; ++batch) {
+      batch_events[batch] = bitonic_session_sort_async(
+          session, batches_data + batch_offsets[batch] * element_size,
+          batch_offsets[batch + 1] - batch_offsets[batch], ARRAY_TYPE,
+          SORTING_DIRECTION, 0, NULL);
+    }
+    // The host is free to do other work until here
+    const double enqueue_end_time = get_current_seconds();
+    clWaitForEvents(num_batches, batch_events);
+
+    sort_end_time = get_current_seconds();
+
+    for (unsigned int batch = 0; batch < num_batches; ++batch) {
+      clReleaseEvent(batch_events[batch]);
+    }
+    printf(BITONIC_ASYNC_SORT_MESSAGE, array_len, num_batches,
+           sort_end_time - sort_start_time,
+           enqueue_end_time - sort_start_time);
+
+    void* merged_data = malloc(array_len * element_size);
+    multiway_merge(batches_data, batch_offsets, num_batches, merged_data,
+                   ARRAY_TYPE, SORTING_DIRECTION, NUM_MERGE_THREADS_AUTO);
+    memcpy(batches_data, merged_data, array_len * element_size);
+    free(merged_data);
+    verify_and_free_sorted_copy(BITONIC_ASYNC_SORT_VERIFY_MSG, batches_array,
+                                qsort_array);
+  }
+
+  /*
+   * Sort another copy as many independent segments of varying lengths at once,
+   * and sort the same segments of yet another copy with qsort (untimed) for
+   * verifying every segment.
+   */
+  if (config->engines[COMPARE_OPENCL_SEGMENTED]) {
+    struct Array_With_Length_Padded* segmented_array =
+        deep_cp_padded_array(unsorted_array);
+    unsigned int num_segments;
+    unsigned int* segment_offsets =
+        get_segment_offsets(array_len, &num_segments);
+
+    sort_start_time = get_current_seconds();
+
+    bitonic_session_sort_segmented(session, segmented_array->contents,
+                                   segment_offsets, num_segments, ARRAY_TYPE,
+                                   SORTING_DIRECTION);
+
+    sort_end_time = get_current_seconds();
+
+    printf(BITONIC_SEGMENTED_SORT_MESSAGE, array_len, num_segments,
+           sort_end_time - sort_start_time);
+
+    struct Array_With_Length_Padded* segmented_qsort_array =
+        deep_cp_padded_array(unsorted_array);
+    for (unsigned int segment = 0; segment < num_segments; ++segment) {
+      qsort(segmented_qsort_array->contents + segment_offsets[segment],
+            segment_offsets[segment + 1] - segment_offsets[segment],
+            sizeof(*(segmented_qsort_array->contents)), compare_elements_qsort);
+    }
+    free(segment_offsets);
+    verify_and_free_sorted_copy(BITONIC_SEGMENTED_SORT_VERIFY_MSG,
+                                segmented_array, segmented_qsort_array);
+    free(segmented_qsort_array->contents);
+    free(segmented_qsort_array);
+  }
+
+  /*
+   * Select the first K elements in the sorting order out of the array, writing
+   * the winners to the beginning of another copy; only those are verified.
+   */
+  if (config->engines[COMPARE_OPENCL_TOP_K]) {
+    struct Array_With_Length_Padded* top_k_array =
+        deep_cp_padded_array(unsorted_array);
+
+    sort_start_time = get_current_seconds();
+
+    bitonic_session_top_k(session, unsorted_array->contents, array_len,
+                          config->top_k, ARRAY_TYPE, SORTING_DIRECTION,
+                          top_k_array->contents);
+
+    sort_end_time = get_current_seconds();
+
+    printf(BITONIC_TOP_K_MESSAGE, num_top_k, array_len,
+           sort_end_time - sort_start_time);
+    top_k_array->array_len_actual = num_top_k;
+    top_k_array->padded_2n_length = num_top_k;
+    verify_and_free_sorted_copy(BITONIC_TOP_K_VERIFY_MSG, top_k_array,
+                                &qsort_top_k);
+  }
+
+  if (config->engines[COMPARE_SERIAL_BITONIC]) {
+    struct Array_With_Length_Padded* serial_array =
+        deep_cp_padded_array(unsorted_array);
+
+    // Get time of when serial bitonic sort algorithm starts executing
+    sort_start_time = get_current_seconds();
+
+    serial_bitonic_sort(serial_array, SORTING_DIRECTION);
+
+    // Get time of when serial bitonic sort finishes executing
+    sort_end_time = get_current_seconds();
+
+    // Report to user time spent on sorting using serial bitonic sort on CPU
+    printf(BITONIC_SERIAL_SORT_MESSAGE, array_len,
+           sort_end_time - sort_start_time);
+    verify_and_free_sorted_copy(BITONIC_SERIAL_SORT_VERIFY_MSG, serial_array,
+                                qsort_array);
+  }
+
+  if (config->engines[COMPARE_PARALLEL_BITONIC_CPU]) {
+    struct Array_With_Length_Padded* parallel_cpu_array =
+        deep_cp_padded_array(unsorted_array);
+
+    // Get time of when parallelized bitonic sort on the CPU starts executing
+    sort_start_time = get_current_seconds();
+
+    parallel_bitonic_sort_cpu(parallel_cpu_array, SORTING_DIRECTION,
+                              CPU_SORT_NUM_THREADS);
+
+    // Get time of when parallelized bitonic sort on the CPU finishes executing
+    sort_end_time = get_current_seconds();
+
+    printf(BITONIC_PARALLEL_CPU_SORT_MESSAGE, array_len,
+           sort_end_time - sort_start_time);
+    verify_and_free_sorted_copy(BITONIC_PARALLEL_CPU_SORT_VERIFY_MSG,
+                                parallel_cpu_array, qsort_array);
+  }
+
+  if (config->engines[COMPARE_SIMD_BITONIC]) {
+    struct Array_With_Length_Padded* simd_array =
+        deep_cp_padded_array(unsorted_array);
+
+    // Get time of when vectorised bitonic sort on the CPU starts executing
+    sort_start_time = get_current_seconds();
+
+    simd_bitonic_sort_cpu(simd_array, SORTING_DIRECTION, CPU_SORT_SIMD_ISA);
+
+    // Get time of when vectorised bitonic sort on the CPU finishes executing
+    sort_end_time = get_current_seconds();
+
+    printf(BITONIC_SIMD_SORT_MESSAGE, array_len,
+           sort_end_time - sort_start_time);
+    verify_and_free_sorted_copy(BITONIC_SIMD_SORT_VERIFY_MSG, simd_array,
+                                qsort_array);
+  }
+
+  if (config->engines[COMPARE_HYBRID]) {
+    struct Array_With_Length_Padded* hybrid_array =
+        deep_cp_padded_array(unsorted_array);
+
+    // Get time of when the hybrid sort on the CPU starts executing
+    sort_start_time = get_current_seconds();
+
+    hybrid_sort_cpu(hybrid_array, SORTING_DIRECTION, CPU_SORT_NUM_THREADS);
+
+    // Get time of when the hybrid sort on the CPU finishes executing
+    sort_end_time = get_current_seconds();
+
+    printf(BITONIC_HYBRID_SORT_MESSAGE, array_len,
+           sort_end_time - sort_start_time);
+    verify_and_free_sorted_copy(BITONIC_HYBRID_SORT_VERIFY_MSG, hybrid_array,
+                                qsort_array);
+  }
+
+  // Time the reference sorts, whose comparisons are inlined unlike qsort's
+  if (config->engines[COMPARE_INTROSORT]) {
+    struct Array_With_Length_Padded* introsort_array =
+        deep_cp_padded_array(unsorted_array);
+
+    sort_start_time = get_current_seconds();
+
+    if (SORT_FLOATS_AS_INTEGERS) {
+      float_keys_to_sortable(introsort_array->contents, array_len, ARRAY_TYPE,
+                             SORTING_DIRECTION);
+      introsort_cpu(introsort_array->contents, array_len,
+                    get_sortable_key_type(ARRAY_TYPE), SORTING_DIRECTION);
+      sortable_to_float_keys(introsort_array->contents, array_len, ARRAY_TYPE,
+                             SORTING_DIRECTION);
+    } else {
+      introsort_cpu(introsort_array->contents, array_len, ARRAY_TYPE,
+                    SORTING_DIRECTION);
+    }
+
+    sort_end_time = get_current_seconds();
+
+    printf(INTROSORT_MESSAGE, array_len, sort_end_time - sort_start_time);
+    verify_and_free_sorted_copy(INTROSORT_VERIFY_MSG, introsort_array,
+                                qsort_array);
   }
 
-  // Assert that all sorting was done correctly
-  printf(BITONIC_PARALLEL_SORT_VERIFY_MSG);
-  assert_padded_arrays_equality(sample_array, sample_array_2nd_cp);
-  printf(BITONIC_SERIAL_SORT_VERIFY_MSG);
-  assert_padded_arrays_equality(sample_array_cp, sample_array_2nd_cp);
+  if (config->engines[COMPARE_RADIX_CPU]) {
+    struct Array_With_Length_Padded* radix_array =
+        deep_cp_padded_array(unsorted_array);
+
+    sort_start_time = get_current_seconds();
+
+    radix_sort_cpu(radix_array->contents, array_len, ARRAY_TYPE,
+                   SORTING_DIRECTION);
+
+    sort_end_time = get_current_seconds();
+
+    printf(RADIX_SORT_MESSAGE, array_len, sort_end_time - sort_start_time);
+    verify_and_free_sorted_copy(RADIX_SORT_VERIFY_MSG, radix_array,
+                                qsort_array);
+  }
+
+  if (config->engines[COMPARE_TOP_K_CPU]) {
+    struct Array_With_Length_Padded* top_k_array =
+        deep_cp_padded_array(unsorted_array);
+
+    sort_start_time = get_current_seconds();
+
+    top_k_cpu(unsorted_array->contents, array_len, config->top_k, ARRAY_TYPE,
+              SORTING_DIRECTION, top_k_array->contents);
+
+    sort_end_time = get_current_seconds();
+
+    printf(TOP_K_CPU_MESSAGE, num_top_k, array_len,
+           sort_end_time - sort_start_time);
+    top_k_array->array_len_actual = num_top_k;
+    top_k_array->padded_2n_length = num_top_k;
+    verify_and_free_sorted_copy(TOP_K_CPU_VERIFY_MSG, top_k_array,
+                                &qsort_top_k);
+  }
 
   // Free the host memory objects
-  free(sample_array->contents);
-  free(sample_array);
-  free(sample_array_cp->contents);
-  free(sample_array_cp);
-  free(sample_array_2nd_cp->contents);
-  free(sample_array_2nd_cp);
+  free(qsort_array->contents);
+  free(qsort_array);
+}
+
+// Testing bitonic sorting using a custom OpenCL opencl_program.
+int main(int argc, char* argv[]) {
+  struct Compare_Config config;
+  struct Bitonic_Sort_Session session;
+  struct Multi_Device_Sort multi_sort;
+
+  parse_compare_options(argc, argv, &config);
+  struct Array_With_Length_Padded* unsorted_array =
+      get_rand_padded_array(config.array_len);
+
+  // Only set up an OpenCL device if any engine sorts on one
+  int uses_opencl = 0;
+  for (unsigned int engine = 0; engine < NUM_OPENCL_COMPARE_ENGINES; ++engine) {
+    uses_opencl = uses_opencl || config.engines[engine];
+  }
+  if (uses_opencl) {
+    configure_opencl_env(&session, &config);
+
+    /*
+     * Compile the program specialized for the data type and direction of sort
+     * ahead of time, so that compilation isn't counted as part of the sort.
+     */
+    get_bitonic_program(&session.program_cache, ARRAY_TYPE, SORTING_DIRECTION,
+                        NO_PAYLOAD);
+    if (SORT_FLOATS_AS_INTEGERS) {
+      get_bitonic_program(&session.program_cache,
+                          get_sortable_key_type(ARRAY_TYPE), SORTING_DIRECTION,
+                          NO_PAYLOAD);
+    }
+  }
+  // The multi-device engine sorts within sessions of its own, one per device
+  if (config.engines[COMPARE_OPENCL_MULTI_DEVICE]) {
+    init_multi_device_sort(&multi_sort, session.platform, session.device,
+                           config.multi_device_mode, 0,
+                           session.program_cache.program_source,
+                           PROGRAM_BINARY_CACHE_DIR);
+  }
+
+  for (unsigned int round = 1; round <= config.repetitions; ++round) {
+    if (config.repetitions > 1) {
+      printf(COMPARE_ROUND_MESSAGE, round, config.repetitions,
+             config.array_len);
+    }
+    compare_sorts(&config, uses_opencl ? &session : NULL,
+                  config.engines[COMPARE_OPENCL_MULTI_DEVICE] ? &multi_sort
+                                                               : NULL,
+                  unsorted_array);
+  }
+
+  /*
+   * Cleanup host and device memory of OpenCL
+   * objects as we are done with sorting using
+   * OpenCL runtime.
+   */
+  if (config.engines[COMPARE_OPENCL_MULTI_DEVICE]) {
+    release_multi_device_sort(&multi_sort);
+  }
+  if (uses_opencl) {
+    release_bitonic_sort_session(&session);
+  }
+  free(unsorted_array->contents);
+  free(unsorted_array);
 
   return EXIT_SUCCESS;
 }
@@ -16,27 +16,172 @@
 #define QSORT_BITONIC_COMPARE_H 
 
 #include "naive_bitonic_sort_opencl.h"
+#include "work_stealing_pool.h"
+#include "simd_bitonic_sort_cpu.h"
+#include "multi_device_sort.h"
 
 /*
- * Size of array to be sorted via bitonic sort; 
+ * Default size of array to be sorted via bitonic sort, unless given at runtime
+ * (refer to COMPARE_USAGE_MESSAGE);
  * The following number has to be greater than 0!
  */
 #define ARRAY_LEN 134217728
 
-// Number of OpenCL platforms on host machine
-#define NUM_CL_PLATFORMS 3
 /*
- * Index of desired OpenCL platform (e.g. Portable Computing
- *    Language, AMD Accelerated Parallel Processing) in
- *    list of platforms returned.
+ * Default OpenCL platform (e.g. Portable Computing Language, AMD Accelerated
+ *    Parallel Processing) and device to sort on, unless given at runtime; each
+ *    is either an index into the list printed by --list-devices or any part of
+ *    the name of the platform or device (refer to "select_opencl_device" within
+ *    "opencl_devices.h"). NULL selects the default device of the first platform.
  */
-#define DESIRED_PLATFORM_INDEX 1
-// Number of OpenCL devices per OpenCL platform
-#define NUM_CL_DEVICES 1
-// Number of OpenCL programs to be loaded
-#define OPENCL_PROGS 1
-// OpenCL device name max length
-#define MAX_LEN 1024
+#define DESIRED_PLATFORM NULL
+#define DESIRED_DEVICE NULL
+// Default number of times every engine sorts its own copy of the same array
+#define DEFAULT_REPETITIONS 1
+/*
+ * Environment variables configuring the executable at runtime, each holding the
+ * value of the command line option of the same meaning (refer to COMPARE_USAGE_MESSAGE);
+ * options given on the command line take precedence over environment variables.
+ */
+#define ARRAY_LEN_ENV "BITONIC_ARRAY_LEN"
+#define ENGINES_ENV "BITONIC_ENGINES"
+#define PLATFORM_ENV "BITONIC_PLATFORM"
+#define DEVICE_ENV "BITONIC_DEVICE"
+#define REPETITIONS_ENV "BITONIC_REPETITIONS"
+#define MULTI_DEVICE_ENV "BITONIC_MULTI_DEVICE"
+#define TOP_K_ENV "BITONIC_TOP_K"
+/*
+ * Default way of choosing the devices the array is sorted across by the multi-device
+ * engine, unless given at runtime; one of MULTI_DEVICE_AUTO, MULTI_DEVICE_SUB_DEVICES
+ * or MULTI_DEVICE_PLATFORM_DEVICES (refer to "multi_device_sort.h").
+ */
+#define MULTI_DEVICE_MODE MULTI_DEVICE_AUTO
+/*
+ * Default number of elements coming first in the sorting order which the top-K engines
+ * select out of the array, unless given at runtime; has to be greater than 0, and all
+ * elements are selected if it exceeds the array length.
+ */
+#define DEFAULT_TOP_K 1024
+
+/*
+ * Engines sorting copies of the array, each of which may be left out at runtime;
+ * qsort always runs, as every other engine is verified against its result. Engines
+ * numbered below NUM_OPENCL_COMPARE_ENGINES sort on the OpenCL device.
+ */
+#define COMPARE_OPENCL_BITONIC 0
+#define COMPARE_OPENCL_ARGSORT 1
+#define COMPARE_OPENCL_CHUNKED 2
+#define COMPARE_OPENCL_RADIX 3
+#define COMPARE_OPENCL_MULTI_DEVICE 4
+#define COMPARE_OPENCL_ASYNC_BATCHES 5
+#define COMPARE_OPENCL_SEGMENTED 6
+#define COMPARE_OPENCL_TOP_K 7
+#define COMPARE_SERIAL_BITONIC 8
+#define COMPARE_SERIAL_ARGSORT 9
+#define COMPARE_PARALLEL_BITONIC_CPU 10
+#define COMPARE_SIMD_BITONIC 11
+#define COMPARE_HYBRID 12
+#define COMPARE_INTROSORT 13
+#define COMPARE_RADIX_CPU 14
+#define COMPARE_TOP_K_CPU 15
+#define NUM_COMPARE_ENGINES 16
+#define NUM_OPENCL_COMPARE_ENGINES 8
+// Value of --engines selecting every engine
+#define ALL_COMPARE_ENGINES "all"
+
+#define COMPARE_USAGE_MESSAGE "Usage: %s [options]\n"\
+  "  --size=N                  number of elements of the array (default ARRAY_LEN)\n"\
+  "  --engines=E,...           all, or any of opencl_bitonic, opencl_argsort, opencl_chunked,\n"\
+  "                            opencl_radix, opencl_multi_device, opencl_async_batches,\n"\
+  "                            opencl_segmented, opencl_top_k, serial_bitonic, serial_argsort,\n"\
+  "                            parallel_bitonic_cpu, simd_bitonic, hybrid, introsort, radix_cpu\n"\
+  "                            and top_k_cpu (default all)\n"\
+  "  --platform=P              index or part of the name of the OpenCL platform\n"\
+  "  --device=D                index or part of the name of the OpenCL device\n"\
+  "  --repetitions=N           times every engine sorts a fresh copy of the array (default 1)\n"\
+  "  --multi-device=M          devices opencl_multi_device sorts across: sub-devices (of the\n"\
+  "                            device selected), platform (every device of the platform selected)\n"\
+  "                            or auto (sub-devices if possible, default)\n"\
+  "  --top-k=K                 elements coming first the top-K engines select (default 1024)\n"\
+  "  --list-devices            list every OpenCL platform and device, then exit\n"\
+  "Each option may also be given by the environment variable " ARRAY_LEN_ENV ", " ENGINES_ENV ",\n"\
+  PLATFORM_ENV ", " DEVICE_ENV ", " REPETITIONS_ENV ", " MULTI_DEVICE_ENV " or " TOP_K_ENV "\n"\
+  "respectively.\n"
+#define COMPARE_INVALID_OPTION_MESSAGE "Invalid value of option --%s: %s\n"
+#define COMPARE_ROUND_MESSAGE ">>> Round %u of %u of sorting %u element(s)\n\n"
+
+/*
+ * Configuration of the executable given at runtime; fields are the following:
+ *  - number of elements of the array to be sorted
+ *  - whether each engine sorts a copy of the array (non-zero) or not (zero),
+ *    indexed by the macro value of each
+ *  - selectors of the OpenCL platform and device (NULL for the defaults)
+ *  - number of times every engine sorts its own copy of the array
+ *  - way of choosing the devices the multi-device engine sorts across
+ *  - number of elements coming first in the sorting order the top-K engines select
+ */
+struct Compare_Config {
+     unsigned int array_len;
+     unsigned char engines[NUM_COMPARE_ENGINES];
+     const char* platform_selector;
+     const char* device_selector;
+     unsigned int repetitions;
+     unsigned int multi_device_mode;
+     unsigned int top_k;
+};
+
+/*
+ * Number of runs into which the array is split for the chunked (i.e. out-of-core)
+ * OpenCL bitonic sort, as if the array were too large for the device's memory;
+ * the sorted runs are merged on the host using all processors online.
+ */
+#define CHUNKED_SORT_NUM_RUNS 4
+/*
+ * Number of independent batches into which the array is split for the asynchronous
+ * OpenCL bitonic sort, each of which gets enqueued without waiting for the previous
+ * ones to finish (refer to "bitonic_session_sort_async" within "bitonic_sort_session.h");
+ * the sorted batches are merged on the host afterwards for verification.
+ */
+#define ASYNC_SORT_NUM_BATCHES 4
+/*
+ * Shortest and longest segments into which the array is split for the segmented OpenCL
+ * bitonic sort, which sorts every segment independently (refer to "bitonic_session_sort_segmented"
+ * within "bitonic_sort_session.h"); segment lengths vary between the two, and every sorted segment
+ * is verified against the same segment sorted with qsort.
+ */
+#define SEGMENTED_SORT_MIN_SEGMENT_LEN 32
+#define SEGMENTED_SORT_MAX_SEGMENT_LEN 4096
+/*
+ * Number of threads sorting with parallelized bitonic sort and with the hybrid sort
+ * (bitonic block sort with multiway merge) on the CPU, including the main thread;
+ * NUM_POOL_THREADS_AUTO uses one thread per processor online.
+ */
+#define CPU_SORT_NUM_THREADS NUM_POOL_THREADS_AUTO
+/*
+ * Instruction set used by vectorised bitonic sort on the CPU; one of SIMD_ISA_PORTABLE,
+ * SIMD_ISA_AVX2, SIMD_ISA_AVX512 or SIMD_ISA_AUTO (refer to "simd_bitonic_sort_cpu.h").
+ */
+#define CPU_SORT_SIMD_ISA SIMD_ISA_AUTO
+/*
+ * How the array gets into and out of the OpenCL device's memory for the parallelized
+ * bitonic sort; one of COPY_HOST_BUFFER, USE_HOST_PTR_BUFFER, ALLOC_HOST_PTR_BUFFER or
+ * HOST_BUFFER_AUTO (refer to "load_array_bitonic_sort" within "naive_bitonic_sort_opencl.h").
+ */
+#define HOST_BUFFER_MODE HOST_BUFFER_AUTO
+/*
+ * Flag macro indicating whether floating point numbers get turned into signed integers
+ * sorting the same way before being sorted by the parallelized bitonic sort on the OpenCL
+ * device and by introsort (and back again afterwards), so that they're sorted by integer
+ * comparisons in a total order with NaNs last (non-zero value), or sorted as they are
+ * (zero); refer to "sortable_keys.h". Has no effect on arrays of integers.
+ */
+#define SORT_FLOATS_AS_INTEGERS 0
+/*
+ * Flag macro indicating whether every command of the parallelized bitonic sort on the
+ * OpenCL device gets profiled, printing the time and bandwidth of each partition size and
+ * compare distance after sorting (non-zero value), or not (zero); refer to "bitonic_profile.h".
+ */
+#define PROFILE_OPENCL_SORT 0
 // Delimiter for reading text files
 #define TEXT_FILE_DELIM '\0'
 
@@ -92,12 +237,57 @@
 #define BITONIC_PARALLEL_SORT_MESSAGE_NO_CP "Parallelized bitonic sort of %d element(s)"\
                                             " on OpenCL device took %lf seconds \n"\
                                             "WITHOUT TRANSFER TO AND FROM HOST \n\n"
+#define BITONIC_HOST_BUFFER_MODE_MESSAGE "Array transferred to and from OpenCL device using %s\n"
+#define BITONIC_CHUNKED_SORT_MESSAGE "Chunked parallelized bitonic sort of %d element(s) in %d run(s)"\
+                                     " on OpenCL device with merging in main memory took %lf seconds\n\n"
+#define BITONIC_MULTI_DEVICE_SORT_MESSAGE "Parallelized bitonic sort of %d element(s) across %u OpenCL device(s)"\
+                                          " with merging in main memory took %lf seconds\n\n"
+#define BITONIC_ASYNC_SORT_MESSAGE "Asynchronous parallelized bitonic sort of %d element(s) in %u batch(es)"\
+                                   " on OpenCL device took %lf seconds (%lf seconds of it enqueueing)\n\n"
+#define BITONIC_SEGMENTED_SORT_MESSAGE "Segmented parallelized bitonic sort of %d element(s) in %u segment(s)"\
+                                       " on OpenCL device took %lf seconds\n\n"
+#define BITONIC_TOP_K_MESSAGE "Parallelized bitonic selection of the first %u of %d element(s)"\
+                              " on OpenCL device took %lf seconds\n\n"
+#define OPENCL_RADIX_SORT_MESSAGE "LSD radix sort of %d element(s) on OpenCL device took %lf seconds\n\n"
 #define BITONIC_SERIAL_SORT_MESSAGE "Serial bitonic sort on CPU of %d element(s) in main memory took %lf seconds\n\n"
+#define BITONIC_PARALLEL_CPU_SORT_MESSAGE "Parallelized bitonic sort on CPU of %d element(s) in main memory"\
+                                          " took %lf seconds\n\n"
+#define BITONIC_SIMD_SORT_MESSAGE "Vectorised bitonic sort on CPU of %d element(s) in main memory"\
+                                  " took %lf seconds\n\n"
+#define BITONIC_HYBRID_SORT_MESSAGE "Bitonic block sort with multiway merge on CPU of %d element(s)"\
+                                    " in main memory took %lf seconds\n\n"
+#define TOP_K_CPU_MESSAGE "Bitonic selection on CPU of the first %u of %d element(s) in main memory"\
+                          " took %lf seconds\n\n"
 #define QSORT_MESSAGE "Qsort on CPU of %d element(s) in main memory took %lf seconds\n\n"
+#define INTROSORT_MESSAGE "Introsort on CPU of %d element(s) in main memory took %lf seconds\n\n"
+#define RADIX_SORT_MESSAGE "LSD radix sort on CPU of %d element(s) in main memory took %lf seconds\n\n"
 
 // Messages informing user what kind of sorting result verification program is performing
 #define BITONIC_PARALLEL_SORT_VERIFY_MSG ">>> Verifying correctness of parallelized bitonic sort on OpenCL device...\n"
 #define BITONIC_SERIAL_SORT_VERIFY_MSG ">>> Verifying correctness of serial bitonic sort in main memory...\n"
+#define BITONIC_PARALLEL_CPU_SORT_VERIFY_MSG ">>> Verifying correctness of parallelized bitonic sort"\
+                                             " in main memory...\n"
+#define BITONIC_SIMD_SORT_VERIFY_MSG ">>> Verifying correctness of vectorised bitonic sort in main memory...\n"
+#define BITONIC_HYBRID_SORT_VERIFY_MSG ">>> Verifying correctness of bitonic block sort with multiway merge"\
+                                       " in main memory...\n"
+#define INTROSORT_VERIFY_MSG ">>> Verifying correctness of introsort in main memory...\n"
+#define RADIX_SORT_VERIFY_MSG ">>> Verifying correctness of LSD radix sort in main memory...\n"
+#define OPENCL_RADIX_SORT_VERIFY_MSG ">>> Verifying correctness of LSD radix sort on OpenCL device...\n"
+#define BITONIC_CHUNKED_SORT_VERIFY_MSG ">>> Verifying correctness of chunked parallelized bitonic sort"\
+                                        " on OpenCL device...\n"
+#define BITONIC_MULTI_DEVICE_SORT_VERIFY_MSG ">>> Verifying correctness of parallelized bitonic sort across"\
+                                             " OpenCL devices...\n"
+#define BITONIC_ASYNC_SORT_VERIFY_MSG ">>> Verifying correctness of asynchronous parallelized bitonic sort"\
+                                      " in batches on OpenCL device...\n"
+#define BITONIC_SEGMENTED_SORT_VERIFY_MSG ">>> Verifying correctness of segmented parallelized bitonic sort"\
+                                          " on OpenCL device...\n"
+#define BITONIC_TOP_K_VERIFY_MSG ">>> Verifying correctness of parallelized bitonic selection"\
+                                 " on OpenCL device...\n"
+#define TOP_K_CPU_VERIFY_MSG ">>> Verifying correctness of bitonic selection in main memory...\n"
+#define BITONIC_PARALLEL_ARGSORT_VERIFY_MSG ">>> Verifying correctness of permutation computed by"\
+                                            " parallelized bitonic sort by key on OpenCL device...\n"
+#define BITONIC_SERIAL_ARGSORT_VERIFY_MSG ">>> Verifying correctness of permutation computed by"\
+                                          " serial bitonic sort by key in main memory...\n"
 
 #endif // QSORT_BITONIC_COMPARE_H
 // =================================================================================================
@@ -0,0 +1,105 @@
+/*
+ * File description:
+ *   Host side of the LSD radix sort engine on OpenCL devices; all kernels live within
+ *   the same OpenCL program file as the bitonic sorting kernels.
+ */
+
+#include "radix_sort_opencl.h"
+#include <stdio.h>
+#include <assert.h>
+
+// Name of each sorting direction, indexed by the macro value of each direction
+static const char* const sorting_direction_names[NUM_SORTING_DIRECTIONS] = {"ascending", "descending"};
+
+void opencl_radix_sort(cl_command_queue *queue, struct Bitonic_Program_Cache* program_cache,
+                          cl_mem* buffer_in, const unsigned int array_length,
+                            const unsigned int array_type, const unsigned int sorting_direction) {
+    // No null pointers allowed
+    assert(queue != NULL);
+    assert(program_cache != NULL);
+    assert(buffer_in != NULL);
+    // Array length HAS to be at least 1
+    assert(array_length >= 1);
+    // Make sure data type and sort_direction are of valid values
+    assert(array_type < NUM_ARRAY_TYPES);
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+
+    cl_int func_error_code;
+    cl_program* program = get_bitonic_program(program_cache, array_type, sorting_direction, NO_PAYLOAD);
+
+    // Notify user sorting starts now
+    printf(NOTIFY_USER_SORT_OPENCL_RADIX_START, get_array_type_name(array_type), OPENCL_RADIX_WORKGROUP_SIZE,
+                                                                     sorting_direction_names[sorting_direction]);
+
+    /*
+     * Split the array into tiles of one number per work-item, and spread the tiles evenly across
+     * as many workgroups as allowed, each going through a contiguous run of tiles.
+     */
+    const unsigned int num_tiles = (array_length + OPENCL_RADIX_WORKGROUP_SIZE - 1) / OPENCL_RADIX_WORKGROUP_SIZE;
+    const unsigned int tiles_per_group = (num_tiles + OPENCL_RADIX_MAX_WORKGROUPS - 1) / OPENCL_RADIX_MAX_WORKGROUPS;
+    const unsigned int num_groups = (num_tiles + tiles_per_group - 1) / tiles_per_group;
+    const size_t local[OPERAND_DIMS] = { OPENCL_RADIX_WORKGROUP_SIZE };
+    const size_t global[OPERAND_DIMS] = { (size_t)num_groups * OPENCL_RADIX_WORKGROUP_SIZE };
+    // Each key has as many digits as the number has bytes
+    const size_t element_size = get_array_type_size(array_type);
+    const unsigned int num_passes = (unsigned int)(element_size * 8 / OPENCL_RADIX_DIGIT_BITS);
+
+    // Numbers move back and forth between the array and a temporary buffer, one pass at a time
+    cl_mem temp_buffer = clCreateBuffer(program_cache->context, CL_MEM_READ_WRITE, array_length * element_size,
+                                                                                    NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    cl_mem digit_counts_buffer = clCreateBuffer(program_cache->context, CL_MEM_READ_WRITE,
+                                                  (size_t)num_groups * OPENCL_RADIX_WORKGROUP_SIZE * sizeof(cl_uint),
+                                                                                    NULL, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+
+    cl_kernel count_kernel = clCreateKernel(*program, RADIX_COUNT_KERNEL_FUNC_NAME, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    cl_kernel scan_kernel = clCreateKernel(*program, RADIX_SCAN_KERNEL_FUNC_NAME, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    cl_kernel scatter_kernel = clCreateKernel(*program, RADIX_SCATTER_KERNEL_FUNC_NAME, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+
+    // Arguments other than the buffers and the digit being sorted are the same for every pass
+    clSetKernelArg(count_kernel, 1, sizeof(array_length), (void*)&array_length);
+    clSetKernelArg(count_kernel, 3, sizeof(tiles_per_group), (void*)&tiles_per_group);
+    clSetKernelArg(count_kernel, 4, sizeof(digit_counts_buffer), (void*)&digit_counts_buffer);
+    clSetKernelArg(scan_kernel, 0, sizeof(digit_counts_buffer), (void*)&digit_counts_buffer);
+    clSetKernelArg(scan_kernel, 1, sizeof(num_groups), (void*)&num_groups);
+    clSetKernelArg(scatter_kernel, 2, sizeof(array_length), (void*)&array_length);
+    clSetKernelArg(scatter_kernel, 4, sizeof(tiles_per_group), (void*)&tiles_per_group);
+    clSetKernelArg(scatter_kernel, 5, sizeof(digit_counts_buffer), (void*)&digit_counts_buffer);
+
+    cl_mem* source_buffer = buffer_in;
+    cl_mem* destination_buffer = &temp_buffer;
+    for (unsigned int pass = 0; pass < num_passes; ++pass) {
+        const unsigned int shift = pass * OPENCL_RADIX_DIGIT_BITS;
+
+        clSetKernelArg(count_kernel, 0, sizeof(*source_buffer), (void*)source_buffer);
+        clSetKernelArg(count_kernel, 2, sizeof(shift), (void*)&shift);
+        clEnqueueNDRangeKernel(*queue, count_kernel, OPERAND_DIMS, NULL, global, local, 0, NULL, NULL);
+        clEnqueueNDRangeKernel(*queue, scan_kernel, OPERAND_DIMS, NULL, local, local, 0, NULL, NULL);
+        clSetKernelArg(scatter_kernel, 0, sizeof(*source_buffer), (void*)source_buffer);
+        clSetKernelArg(scatter_kernel, 1, sizeof(*destination_buffer), (void*)destination_buffer);
+        clSetKernelArg(scatter_kernel, 3, sizeof(shift), (void*)&shift);
+        clEnqueueNDRangeKernel(*queue, scatter_kernel, OPERAND_DIMS, NULL, global, local, 0, NULL, NULL);
+
+        cl_mem* sorted_buffer = destination_buffer;
+        destination_buffer = source_buffer;
+        source_buffer = sorted_buffer;
+    }
+
+    // The sorted array ends up in the temporary buffer after an odd number of passes (i.e. for chars)
+    if (source_buffer != buffer_in) {
+        clEnqueueCopyBuffer(*queue, *source_buffer, *buffer_in, CL_BUFFER_OFFSET, CL_BUFFER_OFFSET,
+                                                       array_length * element_size, 0, NULL, NULL);
+    }
+
+    // Wait for all sorting to be finished before releasing anything it uses
+    clFinish(*queue);
+    clReleaseKernel(count_kernel);
+    clReleaseKernel(scan_kernel);
+    clReleaseKernel(scatter_kernel);
+    clReleaseMemObject(temp_buffer);
+    clReleaseMemObject(digit_counts_buffer);
+}
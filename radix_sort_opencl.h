@@ -0,0 +1,50 @@
+/*
+ * File description:
+ *   Header file for the LSD radix sort engine on OpenCL devices, an alternative to the
+ *   bitonic sort for large arrays: every pass over the array sorts by one 8-bit digit of
+ *   each number, so sorting takes as many passes as there are bytes in each number rather
+ *   than a number of merge steps growing with the square of the logarithm of the length.
+ */
+
+#ifndef RADIX_SORT_OPENCL_H
+#define RADIX_SORT_OPENCL_H
+
+#include "naive_bitonic_sort_opencl.h"
+
+/*
+ * Number of bits of the digit sorted by each pass, and number of work-items per workgroup
+ * (one per digit value); MUST match RADIX_DIGIT_BITS within PROGRAM_FILE.
+ */
+#define OPENCL_RADIX_DIGIT_BITS 8
+#define OPENCL_RADIX_WORKGROUP_SIZE (1 << OPENCL_RADIX_DIGIT_BITS)
+/*
+ * Maximum number of workgroups launched by each pass; each workgroup goes through a
+ * contiguous part of the array, and the digit counts of all workgroups get scanned by a
+ * single workgroup, so more workgroups than needed to fill the device only slow the scan down.
+ */
+#define OPENCL_RADIX_MAX_WORKGROUPS 1024
+// Names of the kernel functions in OpenCL program file performing each pass of the radix sort
+#define RADIX_COUNT_KERNEL_FUNC_NAME "radix_sort_count_digits"
+#define RADIX_SCAN_KERNEL_FUNC_NAME "radix_sort_scan_digits"
+#define RADIX_SCATTER_KERNEL_FUNC_NAME "radix_sort_scatter"
+
+// Message to user about what's being sorted; data type and sorting direction are filled in at runtime
+#define NOTIFY_USER_SORT_OPENCL_RADIX_START ">>> Starting OpenCL LSD radix sorting of %ss"\
+                                                  " with %d work-items per workgroup, sort %s...\n"
+
+/*
+ * LSD radix sort on an OpenCL device, with the same parameters as "opencl_bitonic_sort"
+ * (refer to "naive_bitonic_sort_opencl.h"). Each pass launches three kernels of the program
+ * specialized for "array_type" and "sorting_direction": one counting the digits within the
+ * part of the array of each workgroup, one scanning the counts of all workgroups, and one moving
+ * every number to its place in a stable way. Numbers are sorted by unsigned integer keys ordering
+ * the same way (refer to "sortable_keys.h", so NaNs come last whichever the sorting direction),
+ * inverted when sorting descending.
+ * A temporary buffer as large as "buffer_in" is allocated within the context of "program_cache"
+ * for the duration of the sort; the sorted array always ends up in "buffer_in".
+ */
+void opencl_radix_sort(cl_command_queue *queue, struct Bitonic_Program_Cache* program_cache,
+                          cl_mem* buffer_in, const unsigned int array_length,
+                            const unsigned int array_type, const unsigned int sorting_direction);
+
+#endif // RADIX_SORT_OPENCL_H
@@ -0,0 +1,116 @@
+/*
+ * File description:
+ *   Reference sorting algorithms on a single core of the CPU, specialised at compile time for each
+ *   permitted data type and sorting direction, so that comparisons are inlined rather than made
+ *   through a function pointer (as with qsort).
+ */
+
+#include "reference_sorts_cpu.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include "sortable_keys.h"
+
+// Specialisations of the reference sorts for each permitted data type and sorting direction
+#define REFERENCE_ELEMENT_TYPE cl_char
+#define REFERENCE_KEY_TYPE uint8_t
+#define REFERENCE_TO_KEY char_to_key
+#define REFERENCE_DESCENDING 0
+#define REFERENCE_FUNC(func_name) func_name##_char_ascending
+#include "reference_sorts_impl.h"
+#define REFERENCE_ELEMENT_TYPE cl_char
+#define REFERENCE_KEY_TYPE uint8_t
+#define REFERENCE_TO_KEY char_to_key
+#define REFERENCE_DESCENDING 1
+#define REFERENCE_FUNC(func_name) func_name##_char_descending
+#include "reference_sorts_impl.h"
+#define REFERENCE_ELEMENT_TYPE cl_int
+#define REFERENCE_KEY_TYPE uint32_t
+#define REFERENCE_TO_KEY int_to_key
+#define REFERENCE_DESCENDING 0
+#define REFERENCE_FUNC(func_name) func_name##_int_ascending
+#include "reference_sorts_impl.h"
+#define REFERENCE_ELEMENT_TYPE cl_int
+#define REFERENCE_KEY_TYPE uint32_t
+#define REFERENCE_TO_KEY int_to_key
+#define REFERENCE_DESCENDING 1
+#define REFERENCE_FUNC(func_name) func_name##_int_descending
+#include "reference_sorts_impl.h"
+#define REFERENCE_ELEMENT_TYPE cl_long
+#define REFERENCE_KEY_TYPE uint64_t
+#define REFERENCE_TO_KEY long_to_key
+#define REFERENCE_DESCENDING 0
+#define REFERENCE_FUNC(func_name) func_name##_long_ascending
+#include "reference_sorts_impl.h"
+#define REFERENCE_ELEMENT_TYPE cl_long
+#define REFERENCE_KEY_TYPE uint64_t
+#define REFERENCE_TO_KEY long_to_key
+#define REFERENCE_DESCENDING 1
+#define REFERENCE_FUNC(func_name) func_name##_long_descending
+#include "reference_sorts_impl.h"
+#define REFERENCE_ELEMENT_TYPE cl_float
+#define REFERENCE_KEY_TYPE uint32_t
+#define REFERENCE_TO_KEY float_to_key
+#define REFERENCE_DESCENDING 0
+#define REFERENCE_FUNC(func_name) func_name##_float_ascending
+#include "reference_sorts_impl.h"
+#define REFERENCE_ELEMENT_TYPE cl_float
+#define REFERENCE_KEY_TYPE uint32_t
+#define REFERENCE_TO_KEY float_to_key
+#define REFERENCE_DESCENDING 1
+#define REFERENCE_FUNC(func_name) func_name##_float_descending
+#include "reference_sorts_impl.h"
+#define REFERENCE_ELEMENT_TYPE cl_double
+#define REFERENCE_KEY_TYPE uint64_t
+#define REFERENCE_TO_KEY double_to_key
+#define REFERENCE_DESCENDING 0
+#define REFERENCE_FUNC(func_name) func_name##_double_ascending
+#include "reference_sorts_impl.h"
+#define REFERENCE_ELEMENT_TYPE cl_double
+#define REFERENCE_KEY_TYPE uint64_t
+#define REFERENCE_TO_KEY double_to_key
+#define REFERENCE_DESCENDING 1
+#define REFERENCE_FUNC(func_name) func_name##_double_descending
+#include "reference_sorts_impl.h"
+
+// Specialisations of each sort, indexed by the macro value of each data type and then of each direction
+static void (*const introsort_funcs[NUM_ARRAY_TYPES][NUM_SORTING_DIRECTIONS])(void*, const size_t) = {
+    {introsort_char_ascending, introsort_char_descending},
+    {introsort_int_ascending, introsort_int_descending},
+    {introsort_long_ascending, introsort_long_descending},
+    {introsort_float_ascending, introsort_float_descending},
+    {introsort_double_ascending, introsort_double_descending}
+};
+static void (*const radix_sort_funcs[NUM_ARRAY_TYPES][NUM_SORTING_DIRECTIONS])(void*, const size_t) = {
+    {radix_sort_char_ascending, radix_sort_char_descending},
+    {radix_sort_int_ascending, radix_sort_int_descending},
+    {radix_sort_long_ascending, radix_sort_long_descending},
+    {radix_sort_float_ascending, radix_sort_float_descending},
+    {radix_sort_double_ascending, radix_sort_double_descending}
+};
+
+void introsort_cpu(void* data, const size_t array_length, const unsigned int array_type,
+                                                            const unsigned int sorting_direction) {
+    // No null pointers allowed
+    assert(data != NULL);
+    // Make sure data type and sort_direction are of valid values
+    assert(array_type < NUM_ARRAY_TYPES);
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+
+    introsort_funcs[array_type][sorting_direction](data, array_length);
+}
+
+void radix_sort_cpu(void* data, const size_t array_length, const unsigned int array_type,
+                                                             const unsigned int sorting_direction) {
+    // No null pointers allowed
+    assert(data != NULL);
+    // Make sure data type and sort_direction are of valid values
+    assert(array_type < NUM_ARRAY_TYPES);
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+
+    if (array_length < 2) {
+        return;
+    }
+    radix_sort_funcs[array_type][sorting_direction](data, array_length);
+}
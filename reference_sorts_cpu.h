@@ -0,0 +1,40 @@
+/*
+ * File description:
+ *   Header file for reference sorting algorithms on a single core of the CPU (introsort
+ *   and LSD radix sort), serving as realistic baselines for the bitonic sorting engines:
+ *   unlike qsort, every comparison is inlined, as each permitted data type and sorting
+ *   direction gets its own specialisation of each algorithm at compile time.
+ */
+
+#ifndef REFERENCE_SORTS_CPU_H
+#define REFERENCE_SORTS_CPU_H
+
+#include <stddef.h>
+#include "naive_bitonic_sort_opencl.h"
+
+// Arrays shorter than this many elements are sorted by insertion sort within introsort
+#define INTROSORT_INSERTION_SORT_THRESHOLD 16
+// Number of bits of the digit sorted by each pass of LSD radix sort
+#define RADIX_SORT_DIGIT_BITS 8
+
+/*
+ * Sorts the "array_length" elements of data type "array_type" at "data" in "sorting_direction"
+ * in place with introsort: quicksort with median-of-three pivots, falling back to heapsort
+ * once recursing deeper than twice the log2 of the array length, with insertion sort for short
+ * subarrays. Not stable.
+ */
+void introsort_cpu(void* data, const size_t array_length, const unsigned int array_type,
+                                                            const unsigned int sorting_direction);
+
+/*
+ * Sorts the "array_length" elements of data type "array_type" at "data" in "sorting_direction"
+ * with a stable LSD radix sort of RADIX_SORT_DIGIT_BITS bits per pass, using a temporary array
+ * as large as "data". Every element is turned into an unsigned integer key ordering the same way
+ * (refer to "sortable_keys.h", so NaNs come last and -0.0 comes before +0.0 when sorting
+ * ascending), inverted when sorting in descending order. Passes over digits that are the same
+ * for every element are skipped.
+ */
+void radix_sort_cpu(void* data, const size_t array_length, const unsigned int array_type,
+                                                             const unsigned int sorting_direction);
+
+#endif // REFERENCE_SORTS_CPU_H
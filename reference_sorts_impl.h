@@ -0,0 +1,194 @@
+/*
+ * File description:
+ *   Type and direction specialised parts of the reference sorts in "reference_sorts_cpu.c"; this
+ *   file is included once per permitted data type and sorting direction, with the following macros
+ *   defined beforehand:
+ *   - REFERENCE_ELEMENT_TYPE --- data type of each element being sorted
+ *   - REFERENCE_KEY_TYPE --- unsigned integer type of the same size, used for radix sort keys
+ *   - REFERENCE_TO_KEY --- function turning an element and the sorting direction into its unsigned
+ *     integer key (refer to "sortable_keys.h")
+ *   - REFERENCE_DESCENDING --- 1 if sorting in descending order, 0 otherwise
+ *   - REFERENCE_FUNC --- macro turning a function name into the name of its specialisation
+ *   All five macros are undefined again at the end of this file.
+ */
+
+/*
+ * Whether "first" comes strictly before "second" in the sorting order; the direction is fixed when
+ * compiling, so this boils down to a single comparison instruction.
+ */
+#if (REFERENCE_DESCENDING)
+  #define REFERENCE_PRECEDES(first, second) ((first) > (second))
+#else
+  #define REFERENCE_PRECEDES(first, second) ((first) < (second))
+#endif
+
+static inline void REFERENCE_FUNC(swap)(REFERENCE_ELEMENT_TYPE* first, REFERENCE_ELEMENT_TYPE* second) {
+    const REFERENCE_ELEMENT_TYPE temp_var = *first;
+    *first = *second;
+    *second = temp_var;
+}
+
+static void REFERENCE_FUNC(insertion_sort)(REFERENCE_ELEMENT_TYPE* array, const size_t array_length) {
+    for (size_t sorted_end = 1; sorted_end < array_length; ++sorted_end) {
+        const REFERENCE_ELEMENT_TYPE inserted = array[sorted_end];
+        size_t insert_index = sorted_end;
+        while ((insert_index > 0) && REFERENCE_PRECEDES(inserted, array[insert_index - 1])) {
+            array[insert_index] = array[insert_index - 1];
+            --insert_index;
+        }
+        array[insert_index] = inserted;
+    }
+}
+
+// Moves the element at "root" down the heap of "heap_length" elements until both its children come first
+static void REFERENCE_FUNC(sift_down)(REFERENCE_ELEMENT_TYPE* array, size_t root, const size_t heap_length) {
+    const REFERENCE_ELEMENT_TYPE sifted = array[root];
+    while (2 * root + 1 < heap_length) {
+        size_t child = 2 * root + 1;
+        if ((child + 1 < heap_length) && REFERENCE_PRECEDES(array[child], array[child + 1])) {
+            ++child;
+        }
+        if (!REFERENCE_PRECEDES(sifted, array[child])) {
+            break;
+        }
+        array[root] = array[child];
+        root = child;
+    }
+    array[root] = sifted;
+}
+
+static void REFERENCE_FUNC(heapsort)(REFERENCE_ELEMENT_TYPE* array, const size_t array_length) {
+    for (size_t root = array_length / 2; root > 0; --root) {
+        REFERENCE_FUNC(sift_down)(array, root - 1, array_length);
+    }
+    for (size_t heap_length = array_length; heap_length > 1; --heap_length) {
+        REFERENCE_FUNC(swap)(&array[0], &array[heap_length - 1]);
+        REFERENCE_FUNC(sift_down)(array, 0, heap_length - 1);
+    }
+}
+
+/*
+ * Sorts "array" with quicksort until "depth_limit" runs out, recursing into the shorter side of each
+ * partition and looping over the longer one, so the stack never grows beyond O(log n) frames.
+ */
+static void REFERENCE_FUNC(introsort_loop)(REFERENCE_ELEMENT_TYPE* array, size_t array_length,
+                                                                      unsigned int depth_limit) {
+    while (array_length >= INTROSORT_INSERTION_SORT_THRESHOLD) {
+        if (depth_limit == 0) {
+            REFERENCE_FUNC(heapsort)(array, array_length);
+            return;
+        }
+        --depth_limit;
+
+        // Order the first, middle and last elements, then use the middle one as the pivot
+        const size_t middle = array_length / 2;
+        const size_t last = array_length - 1;
+        if (REFERENCE_PRECEDES(array[middle], array[0])) {
+            REFERENCE_FUNC(swap)(&array[middle], &array[0]);
+        }
+        if (REFERENCE_PRECEDES(array[last], array[middle])) {
+            REFERENCE_FUNC(swap)(&array[last], &array[middle]);
+            if (REFERENCE_PRECEDES(array[middle], array[0])) {
+                REFERENCE_FUNC(swap)(&array[middle], &array[0]);
+            }
+        }
+        const REFERENCE_ELEMENT_TYPE pivot = array[middle];
+
+        // Hoare partition; the first and last elements act as sentinels for both scans
+        size_t lower = 0;
+        size_t upper = last;
+        while (1) {
+            while (REFERENCE_PRECEDES(array[++lower], pivot)) {
+            }
+            while (REFERENCE_PRECEDES(pivot, array[--upper])) {
+            }
+            if (lower >= upper) {
+                break;
+            }
+            REFERENCE_FUNC(swap)(&array[lower], &array[upper]);
+        }
+
+        // Elements before "lower" don't come after the pivot, and the rest don't come before it
+        if (lower < array_length - lower) {
+            REFERENCE_FUNC(introsort_loop)(array, lower, depth_limit);
+            array += lower;
+            array_length -= lower;
+        } else {
+            REFERENCE_FUNC(introsort_loop)(array + lower, array_length - lower, depth_limit);
+            array_length = lower;
+        }
+    }
+    REFERENCE_FUNC(insertion_sort)(array, array_length);
+}
+
+static void REFERENCE_FUNC(introsort)(void* data, const size_t array_length) {
+    unsigned int depth_limit = 0;
+    for (size_t remaining_length = array_length; remaining_length > 1; remaining_length /= 2) {
+        depth_limit += 2;
+    }
+    REFERENCE_FUNC(introsort_loop)((REFERENCE_ELEMENT_TYPE*)data, array_length, depth_limit);
+}
+
+// Key of "element" such that keys sorted in ascending order put elements in the sorting order
+static inline REFERENCE_KEY_TYPE REFERENCE_FUNC(radix_key)(const REFERENCE_ELEMENT_TYPE element) {
+#if (REFERENCE_DESCENDING)
+    return (REFERENCE_KEY_TYPE)~REFERENCE_TO_KEY(element, DESCENDING_SORT);
+#else
+    return REFERENCE_TO_KEY(element, ASCENDING_SORT);
+#endif
+}
+
+static void REFERENCE_FUNC(radix_sort)(void* data, const size_t array_length) {
+    enum { num_digit_values = 1 << RADIX_SORT_DIGIT_BITS };
+    const unsigned int num_passes = (unsigned int)(sizeof(REFERENCE_KEY_TYPE) * 8 / RADIX_SORT_DIGIT_BITS);
+    const REFERENCE_KEY_TYPE digit_mask = (REFERENCE_KEY_TYPE)(num_digit_values - 1);
+    REFERENCE_ELEMENT_TYPE* source = (REFERENCE_ELEMENT_TYPE*)data;
+    REFERENCE_ELEMENT_TYPE* destination = malloc(array_length * sizeof(REFERENCE_ELEMENT_TYPE));
+    REFERENCE_ELEMENT_TYPE* temp_array = destination;
+    size_t* digit_counts = calloc((size_t)num_passes * num_digit_values, sizeof(size_t));
+
+    // Count the digits of every pass within a single read of the array
+    for (size_t element_index = 0; element_index < array_length; ++element_index) {
+        const REFERENCE_KEY_TYPE key = REFERENCE_FUNC(radix_key)(source[element_index]);
+        for (unsigned int pass = 0; pass < num_passes; ++pass) {
+            ++digit_counts[pass * num_digit_values + ((key >> (pass * RADIX_SORT_DIGIT_BITS)) & digit_mask)];
+        }
+    }
+
+    for (unsigned int pass = 0; pass < num_passes; ++pass) {
+        size_t* pass_counts = digit_counts + pass * num_digit_values;
+        const unsigned int shift = pass * RADIX_SORT_DIGIT_BITS;
+        // Every element having the same digit leaves the order as it is
+        if (pass_counts[(REFERENCE_FUNC(radix_key)(source[0]) >> shift) & digit_mask] == array_length) {
+            continue;
+        }
+        // Turn the counts into the position of the first element of each digit
+        size_t digit_offset = 0;
+        for (unsigned int digit = 0; digit < num_digit_values; ++digit) {
+            const size_t digit_count = pass_counts[digit];
+            pass_counts[digit] = digit_offset;
+            digit_offset += digit_count;
+        }
+        for (size_t element_index = 0; element_index < array_length; ++element_index) {
+            const REFERENCE_KEY_TYPE key = REFERENCE_FUNC(radix_key)(source[element_index]);
+            destination[pass_counts[(key >> shift) & digit_mask]++] = source[element_index];
+        }
+        REFERENCE_ELEMENT_TYPE* sorted_array = destination;
+        destination = source;
+        source = sorted_array;
+    }
+
+    // The sorted array ends up in the temporary array after an odd number of passes
+    if (source != data) {
+        memcpy(data, source, array_length * sizeof(REFERENCE_ELEMENT_TYPE));
+    }
+    free(temp_array);
+    free(digit_counts);
+}
+
+#undef REFERENCE_PRECEDES
+#undef REFERENCE_ELEMENT_TYPE
+#undef REFERENCE_KEY_TYPE
+#undef REFERENCE_TO_KEY
+#undef REFERENCE_DESCENDING
+#undef REFERENCE_FUNC
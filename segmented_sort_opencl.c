@@ -0,0 +1,196 @@
+/*
+ * File description:
+ *   Host side of sorting many segments of an array at once on OpenCL devices with the
+ *   bitonic sort; all kernels live within the same OpenCL program file as the other
+ *   bitonic sorting kernels.
+ */
+
+#include "segmented_sort_opencl.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+
+// Name of each sorting direction, indexed by the macro value of each direction
+static const char* const sorting_direction_names[NUM_SORTING_DIRECTIONS] = {"ascending", "descending"};
+
+/*
+ * Largest number of positions of the virtual array of slots (refer to "bitonic_program.cl") handled
+ * by a single launch, so that positions always fit within an unsigned int; groups of segments taking
+ * up more positions than this get sorted by several launches, each starting at a later slot.
+ */
+#define MAX_SEGMENT_POSITIONS_PER_LAUNCH 0x80000000u
+
+// Returns the class of a segment of "segment_length" (at least 2) elements, i.e. log2 of its network length
+static unsigned int get_segment_class(const unsigned int segment_length) {
+    unsigned int segment_class = 1;
+    while ((segment_class < NUM_SEGMENT_CLASSES) && ((1ul << segment_class) < segment_length)) {
+        ++segment_class;
+    }
+    return segment_class;
+}
+
+/*
+ * Enqueues into "queue" every launch sorting the "num_slots" segments listed from "first_slot"
+ * onwards, all of which are of class "segment_class", using "local_kernel" and "merge_kernel"
+ * whose arguments other than the slots, the compare distance and the partition sizes have to
+ * be set already; tiles in local memory are "2 * workgroup_size" elements long.
+ */
+static void enqueue_segment_class_sort(cl_command_queue *queue, cl_kernel local_kernel, cl_kernel merge_kernel,
+                                         const unsigned int workgroup_size, const unsigned int segment_class,
+                                           const unsigned int first_slot, const unsigned int num_slots,
+                                                                            const size_t array_type_size) {
+    const unsigned int slot_length = 1u << segment_class;
+    const unsigned int tile_size = LOCAL_TILE_ELEMENTS_PER_WORK_ITEM * workgroup_size;
+    const unsigned int tile_num_slots = (slot_length < tile_size) ? (tile_size / slot_length) : 1;
+    const unsigned int last_tile_partition_size = (slot_length < tile_size) ? slot_length : tile_size;
+    const size_t num_positions = (size_t)num_slots * slot_length;
+    const size_t local[OPERAND_DIMS] = { workgroup_size };
+    const size_t global_tile[OPERAND_DIMS] = { ((num_positions + tile_size - 1) / tile_size) * workgroup_size };
+    const size_t global[OPERAND_DIMS] = { ((num_positions / 2 + workgroup_size - 1) / workgroup_size) *
+                                                                                       workgroup_size };
+
+    clSetKernelArg(local_kernel, 1, tile_size * array_type_size, NULL);
+    clSetKernelArg(local_kernel, 2, tile_num_slots * sizeof(cl_uint), NULL);
+    clSetKernelArg(local_kernel, 5, sizeof(first_slot), (void*)&first_slot);
+    clSetKernelArg(local_kernel, 6, sizeof(num_slots), (void*)&num_slots);
+    clSetKernelArg(local_kernel, 7, sizeof(slot_length), (void*)&slot_length);
+    clSetKernelArg(merge_kernel, 3, sizeof(first_slot), (void*)&first_slot);
+    clSetKernelArg(merge_kernel, 4, sizeof(num_slots), (void*)&num_slots);
+    clSetKernelArg(merge_kernel, 5, sizeof(slot_length), (void*)&slot_length);
+
+    // Sort every tile from scratch, i.e. every segment no longer than a tile in a single launch
+    unsigned int first_compare_distance = 1;
+    unsigned int first_partition_size = 2;
+    clSetKernelArg(local_kernel, 8, sizeof(first_compare_distance), (void*)&first_compare_distance);
+    clSetKernelArg(local_kernel, 9, sizeof(first_partition_size), (void*)&first_partition_size);
+    clSetKernelArg(local_kernel, 10, sizeof(last_tile_partition_size), (void*)&last_tile_partition_size);
+    clEnqueueNDRangeKernel(*queue, local_kernel, OPERAND_DIMS, NULL, global_tile, local, 0, NULL, NULL);
+
+    /*
+     * Merge steps of segments longer than a tile follow the same order as those of a whole array
+     * (refer to "enqueue_bitonic_merge_network"), except that all merge steps in global memory
+     * are performed one at a time.
+     */
+    for (unsigned int partition_size = 2 * tile_size; partition_size <= slot_length; partition_size *= 2) {
+        for (unsigned int compare_distance = partition_size / 2; compare_distance >= tile_size;
+                                                                  compare_distance /= 2) {
+            clSetKernelArg(merge_kernel, 6, sizeof(compare_distance), (void*)&compare_distance);
+            clSetKernelArg(merge_kernel, 7, sizeof(partition_size), (void*)&partition_size);
+            clEnqueueNDRangeKernel(*queue, merge_kernel, OPERAND_DIMS, NULL, global, local, 0, NULL, NULL);
+        }
+        const unsigned int tile_compare_distance = tile_size / 2;
+        clSetKernelArg(local_kernel, 8, sizeof(tile_compare_distance), (void*)&tile_compare_distance);
+        clSetKernelArg(local_kernel, 9, sizeof(partition_size), (void*)&partition_size);
+        clSetKernelArg(local_kernel, 10, sizeof(partition_size), (void*)&partition_size);
+        clEnqueueNDRangeKernel(*queue, local_kernel, OPERAND_DIMS, NULL, global_tile, local, 0, NULL, NULL);
+    }
+}
+
+void opencl_segmented_bitonic_sort(cl_command_queue *queue, struct Bitonic_Program_Cache* program_cache,
+                                      cl_mem* buffer_in, const unsigned int* segment_offsets,
+                                        const unsigned int num_segments, const unsigned int array_type,
+                                                                          const unsigned int sorting_direction) {
+    // No null pointers allowed
+    assert(queue != NULL);
+    assert(program_cache != NULL);
+    assert(buffer_in != NULL);
+    assert(segment_offsets != NULL);
+    // There HAS to be at least one segment, and the first one HAS to start at the beginning of the array
+    assert(num_segments >= 1);
+    assert(segment_offsets[0] == 0);
+    // Make sure data type and sort_direction are of valid values
+    assert(array_type < NUM_ARRAY_TYPES);
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+
+    /*
+     * List the segments needing sorting (i.e. of at least 2 elements) grouped by class, by
+     * counting the segments of each class first; "class_starts[c]" is the index within the
+     * list of the first segment of class "c".
+     */
+    unsigned int class_starts[NUM_SEGMENT_CLASSES + 2] = {0};
+    for (unsigned int segment = 0; segment < num_segments; ++segment) {
+        assert(segment_offsets[segment] <= segment_offsets[segment + 1]);
+        const unsigned int segment_length = segment_offsets[segment + 1] - segment_offsets[segment];
+        assert(segment_length <= MAX_SEGMENT_POSITIONS_PER_LAUNCH);
+        if (segment_length >= 2) {
+            ++class_starts[get_segment_class(segment_length) + 1];
+        }
+    }
+    for (unsigned int segment_class = 1; segment_class <= NUM_SEGMENT_CLASSES; ++segment_class) {
+        class_starts[segment_class + 1] += class_starts[segment_class];
+    }
+    const unsigned int num_listed = class_starts[NUM_SEGMENT_CLASSES + 1];
+    if (num_listed == 0) {
+        return;
+    }
+    unsigned int* segment_list = malloc(num_listed * sizeof(unsigned int));
+    unsigned int next_listed[NUM_SEGMENT_CLASSES + 1];
+    for (unsigned int segment_class = 0; segment_class <= NUM_SEGMENT_CLASSES; ++segment_class) {
+        next_listed[segment_class] = class_starts[segment_class];
+    }
+    for (unsigned int segment = 0; segment < num_segments; ++segment) {
+        const unsigned int segment_length = segment_offsets[segment + 1] - segment_offsets[segment];
+        if (segment_length >= 2) {
+            segment_list[next_listed[get_segment_class(segment_length)]++] = segment;
+        }
+    }
+
+    cl_int func_error_code;
+    cl_program* program = get_bitonic_program(program_cache, array_type, sorting_direction, NO_PAYLOAD);
+    const size_t array_type_size = get_array_type_size(array_type);
+
+    // Tiles hold their elements along with the lengths of at most one segment per two elements
+    cl_ulong local_mem_size;
+    func_error_code = clGetDeviceInfo(program_cache->device, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(local_mem_size),
+                                        &local_mem_size, NULL);
+    assert(func_error_code == CL_SUCCESS);
+    unsigned int workgroup_size = program_cache->workgroup_size;
+    while ((workgroup_size > 1) && (LOCAL_TILE_ELEMENTS_PER_WORK_ITEM * (size_t)workgroup_size *
+                                      (array_type_size + sizeof(cl_uint) / 2) > local_mem_size)) {
+        workgroup_size /= 2;
+    }
+
+    // Notify user sorting starts now
+    printf(NOTIFY_USER_SORT_OPENCL_SEGMENTED_START, num_segments, get_array_type_name(array_type), workgroup_size,
+                                                                       sorting_direction_names[sorting_direction]);
+
+    // Both kernels only ever read the offsets and the list of segments
+    cl_mem offsets_buffer = clCreateBuffer(program_cache->context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                             (num_segments + 1) * sizeof(cl_uint), (void*)segment_offsets,
+                                                                                   &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    cl_mem list_buffer = clCreateBuffer(program_cache->context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                          num_listed * sizeof(cl_uint), segment_list, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+
+    cl_kernel local_kernel = clCreateKernel(*program, SEGMENTED_LOCAL_KERNEL_FUNC_NAME, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    cl_kernel merge_kernel = clCreateKernel(*program, SEGMENTED_KERNEL_FUNC_NAME, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+    clSetKernelArg(local_kernel, 0, sizeof(*buffer_in), (void*)buffer_in);
+    clSetKernelArg(local_kernel, 3, sizeof(offsets_buffer), (void*)&offsets_buffer);
+    clSetKernelArg(local_kernel, 4, sizeof(list_buffer), (void*)&list_buffer);
+    clSetKernelArg(merge_kernel, 0, sizeof(*buffer_in), (void*)buffer_in);
+    clSetKernelArg(merge_kernel, 1, sizeof(offsets_buffer), (void*)&offsets_buffer);
+    clSetKernelArg(merge_kernel, 2, sizeof(list_buffer), (void*)&list_buffer);
+
+    // Sort all segments of each class together, in as few launches as the positions of their slots allow
+    for (unsigned int segment_class = 1; segment_class <= NUM_SEGMENT_CLASSES; ++segment_class) {
+        const unsigned int max_slots_per_launch = MAX_SEGMENT_POSITIONS_PER_LAUNCH >> segment_class;
+        for (unsigned int first_slot = class_starts[segment_class]; first_slot < class_starts[segment_class + 1];
+                                                                               first_slot += max_slots_per_launch) {
+            const unsigned int num_remaining = class_starts[segment_class + 1] - first_slot;
+            enqueue_segment_class_sort(queue, local_kernel, merge_kernel, workgroup_size, segment_class, first_slot,
+                                         (num_remaining < max_slots_per_launch) ? num_remaining : max_slots_per_launch,
+                                                                                              array_type_size);
+        }
+    }
+
+    // Wait for all sorting to be finished before releasing anything it uses
+    clFinish(*queue);
+    clReleaseKernel(local_kernel);
+    clReleaseKernel(merge_kernel);
+    clReleaseMemObject(offsets_buffer);
+    clReleaseMemObject(list_buffer);
+    free(segment_list);
+}
@@ -0,0 +1,52 @@
+/*
+ * File description:
+ *   Header file for sorting many short independent arrays (i.e. segments of a single
+ *   array) on an OpenCL device at once with the bitonic sort, so that sorting millions of
+ *   short arrays takes a few kernel launches in total rather than a few per array.
+ */
+
+#ifndef SEGMENTED_SORT_OPENCL_H
+#define SEGMENTED_SORT_OPENCL_H
+
+#include "naive_bitonic_sort_opencl.h"
+
+/*
+ * Names of the kernel functions in OpenCL program file performing all merge steps that fit
+ * within a tile in local memory and a single merge step in global memory for many segments
+ * at once, respectively.
+ */
+#define SEGMENTED_LOCAL_KERNEL_FUNC_NAME "segmented_bitonic_sort_merge_steps"
+#define SEGMENTED_KERNEL_FUNC_NAME "segmented_bitonic_sort_merge_step"
+/*
+ * Number of different lengths of the sorting networks of segments, i.e. every power of 2
+ * the length of a segment may be rounded up to (2^1 ... 2^31).
+ */
+#define NUM_SEGMENT_CLASSES 31
+
+// Message to user about what's being sorted; data type and sorting direction are filled in at runtime
+#define NOTIFY_USER_SORT_OPENCL_SEGMENTED_START ">>> Starting OpenCL segmented bitonic sorting of %u array(s)"\
+                                                  " of %ss with %d work-items per workgroup, sort %s...\n"
+
+/*
+ * Sorts every one of the "num_segments" (at least 1) segments of the array of data type
+ * "array_type" within "buffer_in" independently in "sorting_direction", where segment "i"
+ * consists of the numbers at indices "segment_offsets[i]" up to but not including
+ * "segment_offsets[i + 1]" (i.e. "segment_offsets" is a host array of "num_segments + 1"
+ * non-decreasing offsets, starting at 0); segments may be of any length up to 2^31, including
+ * empty.
+ * Segments are grouped by the length of their sorting networks (i.e. their lengths rounded up
+ * to the next power of 2), and all segments of the same group are sorted together:
+ *  - segments no longer than a tile in local memory are sorted by a single launch, in which
+ *    every workgroup sorts as many whole segments as fit within its tile
+ *  - longer segments are sorted by as many launches as an array of the same length would be
+ *    (refer to "enqueue_bitonic_sort"), in which several workgroups cooperate on each segment
+ * so the number of launches depends on the lengths of the segments rather than on their number.
+ * Workgroups are as large as the "workgroup_size" of "program_cache"; the segment offsets are
+ * copied to the device for the duration of the sort, which has finished upon returning.
+ */
+void opencl_segmented_bitonic_sort(cl_command_queue *queue, struct Bitonic_Program_Cache* program_cache,
+                                      cl_mem* buffer_in, const unsigned int* segment_offsets,
+                                        const unsigned int num_segments, const unsigned int array_type,
+                                                                          const unsigned int sorting_direction);
+
+#endif // SEGMENTED_SORT_OPENCL_H
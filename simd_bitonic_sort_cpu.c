@@ -0,0 +1,160 @@
+/*
+ * File description:
+ *   Vectorised bitonic sorting on the CPU. The sorting network is the same as that of
+ *   "naive_bitonic_sort_serial.c", but every compare-and-swap is done without branching on the
+ *   numbers being compared, whole vectors at a time: merge steps comparing numbers within the
+ *   same vector shuffle each vector against itself in registers, and all other merge steps
+ *   compare vectors against each other. The vectorised sort is specialised for each instruction
+ *   set through the compiler's generic vector extensions, and picked at runtime.
+ */
+
+#include "simd_bitonic_sort_cpu.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+/*
+ * Integer type of the same size as each number, used for comparison masks and shuffle patterns
+ * (the vector extensions require both to be vectors of integers of the same size as each number).
+ */
+#if (ARRAY_TYPE == CHAR)
+  #define SIMD_MASK_ELEMENT_TYPE signed char
+#elif (ARRAY_TYPE == INT) || (ARRAY_TYPE == FLOAT)
+  #define SIMD_MASK_ELEMENT_TYPE int
+#elif (ARRAY_TYPE == LONG) || (ARRAY_TYPE == DOUBLE)
+  #define SIMD_MASK_ELEMENT_TYPE long
+#endif
+
+// Only x86 CPUs get instruction sets beyond the baseline of the target
+#if defined(__x86_64__) || defined(__i386__)
+  #define SIMD_X86_ISAS_AVAILABLE 1
+#else
+  #define SIMD_X86_ISAS_AVAILABLE 0
+#endif
+/*
+ * Features of the CPU making up the AVX-512 instruction set; shuffling vectors of 64 chars
+ * across lanes is only a single instruction with VBMI, without which AVX2 is faster for chars.
+ */
+#if (ARRAY_TYPE == CHAR)
+  #define SIMD_AVX512_FEATURES "avx512f,avx512bw,avx512vbmi"
+#else
+  #define SIMD_AVX512_FEATURES "avx512f,avx512bw"
+#endif
+
+// Name of each sorting direction, indexed by the macro value of each direction
+static const char* const sorting_direction_names[NUM_SORTING_DIRECTIONS] = {"ascending", "descending"};
+
+/*
+ * Compares (and swaps as necessary) every pair of numbers of a single merge step of "compare_distance"
+ * whose lower index is at least "lower_begin" and less than "lower_end", one pair at a time; used for
+ * numbers near the end of the array, where whole vectors would reach beyond the array length. The
+ * compare-and-swap is written as a select rather than a branch, so that it compiles to conditional moves.
+ */
+static void scalar_merge_step_pairs(ARRAY_TYPE_DECLARED* array, const unsigned int array_length,
+                                      const unsigned int lower_begin, const unsigned int lower_end,
+                                        const unsigned int compare_distance, const int is_first_merge_step,
+                                                                     const unsigned int sorting_direction) {
+    for (unsigned int lower_index = lower_begin; (lower_index < lower_end) && (lower_index < array_length);
+                                                                                      ++lower_index) {
+        if (lower_index & compare_distance) {
+            continue;
+        }
+        const unsigned int upper_index = is_first_merge_step ? (lower_index ^ (2 * compare_distance - 1)) :
+                                                                         (lower_index | compare_distance);
+        if (upper_index >= array_length) {
+            continue;
+        }
+        const ARRAY_TYPE_DECLARED lower = array[lower_index];
+        const ARRAY_TYPE_DECLARED upper = array[upper_index];
+        const int keep_order = sorting_direction ? (lower > upper) : (lower < upper);
+        array[lower_index] = keep_order ? lower : upper;
+        array[upper_index] = keep_order ? upper : lower;
+    }
+}
+
+// Specialisations of the vectorised sort for each instruction set
+#define SIMD_VECTOR_BYTES 16
+#define SIMD_TARGET
+#define SIMD_FUNC(func_name) func_name##_portable
+#include "simd_bitonic_sort_impl.h"
+#if (SIMD_X86_ISAS_AVAILABLE)
+  #define SIMD_VECTOR_BYTES 32
+  #define SIMD_TARGET __attribute__((target("avx2")))
+  #define SIMD_FUNC(func_name) func_name##_avx2
+  #include "simd_bitonic_sort_impl.h"
+  #define SIMD_VECTOR_BYTES 64
+  #define SIMD_TARGET __attribute__((target(SIMD_AVX512_FEATURES)))
+  #define SIMD_FUNC(func_name) func_name##_avx512
+  #include "simd_bitonic_sort_impl.h"
+#endif
+
+unsigned int get_simd_isa(const unsigned int simd_isa) {
+    assert(simd_isa <= SIMD_ISA_AUTO);
+#if (SIMD_X86_ISAS_AVAILABLE)
+    __builtin_cpu_init();
+    const int avx512_supported = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+                                   ((ARRAY_TYPE != CHAR) || __builtin_cpu_supports("avx512vbmi"));
+    const int avx2_supported = __builtin_cpu_supports("avx2");
+    if (((simd_isa == SIMD_ISA_AUTO) || (simd_isa == SIMD_ISA_AVX512)) && avx512_supported) {
+        return SIMD_ISA_AVX512;
+    }
+    if ((simd_isa != SIMD_ISA_PORTABLE) && avx2_supported) {
+        return SIMD_ISA_AVX2;
+    }
+#endif
+    return SIMD_ISA_PORTABLE;
+}
+
+const char* get_simd_isa_name(const unsigned int simd_isa) {
+    assert(simd_isa < NUM_SIMD_ISAS);
+    static const char* const simd_isa_names[NUM_SIMD_ISAS] = {
+#if (SIMD_X86_ISAS_AVAILABLE)
+        "SSE2",
+#else
+        "portable 16-byte vectors",
+#endif
+        "AVX2", "AVX-512"
+    };
+    return simd_isa_names[simd_isa];
+}
+
+void simd_bitonic_sort_block(ARRAY_TYPE_DECLARED* array, const unsigned int array_length,
+                               const unsigned int sorting_direction, const unsigned int simd_isa) {
+    // No null pointers allowed
+    assert(array != NULL);
+    // Array length has to be non-zero
+    assert(array_length > 0);
+    // Make sure sort_direction is of valid value
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+
+    switch (get_simd_isa(simd_isa)) {
+#if (SIMD_X86_ISAS_AVAILABLE)
+        case SIMD_ISA_AVX512:
+            bitonic_sort_avx512(array, array_length, sorting_direction);
+            break;
+        case SIMD_ISA_AVX2:
+            bitonic_sort_avx2(array, array_length, sorting_direction);
+            break;
+#endif
+        default:
+            bitonic_sort_portable(array, array_length, sorting_direction);
+            break;
+    }
+}
+
+void simd_bitonic_sort_cpu(struct Array_With_Length_Padded* input_array,
+                             const unsigned int sorting_direction, const unsigned int simd_isa) {
+    // Parameter cannot be NULL
+    assert(input_array != NULL);
+    assert(input_array->contents != NULL);
+    assert(input_array->padded_2n_length >= input_array->array_len_actual);
+    // Make sure sort_direction is of valid value
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+
+    // Notify user vectorised bitonic sorting starts now
+    printf(NOTIFY_USER_SORT_SIMD_START, get_simd_isa_name(get_simd_isa(simd_isa)),
+                                          sorting_direction_names[sorting_direction]);
+
+    simd_bitonic_sort_block(input_array->contents, input_array->array_len_actual, sorting_direction, simd_isa);
+}
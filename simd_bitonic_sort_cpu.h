@@ -0,0 +1,80 @@
+/*
+ * File description:
+ *   Header file for bitonic sorting on the CPU using SIMD instructions, i.e. comparing
+ *   whole vectors of numbers at once; the instruction set used is chosen at runtime
+ *   by detecting the features of the CPU.
+ */
+
+#ifndef SIMD_BITONIC_SORT_CPU_H
+#define SIMD_BITONIC_SORT_CPU_H
+
+#include "naive_bitonic_sort_opencl.h"
+
+/*
+ * Flag variable literals indicating the instruction set used for sorting:
+ *  - SIMD_ISA_PORTABLE --- 16-byte vectors built from the compiler's generic vector
+ *    extensions, compiled for the baseline of the target (i.e. SSE2 on x86-64), so
+ *    it runs on every CPU
+ *  - SIMD_ISA_AVX2 --- 32-byte vectors with AVX2 instructions
+ *  - SIMD_ISA_AVX512 --- 64-byte vectors with AVX-512 (F and BW, plus VBMI for
+ *    chars) instructions
+ *  - SIMD_ISA_AUTO --- the widest instruction set supported by the CPU
+ */
+#define SIMD_ISA_PORTABLE 0
+#define SIMD_ISA_AVX2 1
+#define SIMD_ISA_AVX512 2
+#define SIMD_ISA_AUTO 3
+// Number of different instruction sets above, not including SIMD_ISA_AUTO
+#define NUM_SIMD_ISAS 3
+
+// Define message printed out to user signaling start of bitonic sort with SIMD instructions
+#if (ARRAY_TYPE == CHAR)
+  #define NOTIFY_USER_SORT_SIMD_START ">>> Starting sorting chars with vectorised bitonic sort"\
+                                      " on CPU using %s, sort %s...\n"
+#elif (ARRAY_TYPE == INT)
+  #define NOTIFY_USER_SORT_SIMD_START ">>> Starting sorting ints with vectorised bitonic sort"\
+                                      " on CPU using %s, sort %s...\n"
+#elif (ARRAY_TYPE == LONG)
+  #define NOTIFY_USER_SORT_SIMD_START ">>> Starting sorting longs with vectorised bitonic sort"\
+                                      " on CPU using %s, sort %s...\n"
+#elif (ARRAY_TYPE == FLOAT)
+  #define NOTIFY_USER_SORT_SIMD_START ">>> Starting sorting floats with vectorised bitonic sort"\
+                                      " on CPU using %s, sort %s...\n"
+#elif (ARRAY_TYPE == DOUBLE)
+  #define NOTIFY_USER_SORT_SIMD_START ">>> Starting sorting doubles with vectorised bitonic sort"\
+                                      " on CPU using %s, sort %s...\n"
+#endif
+
+/*
+ * Returns the instruction set actually used when "simd_isa" is requested, i.e. the widest
+ * instruction set supported by the CPU for SIMD_ISA_AUTO; instruction sets not supported by
+ * the CPU (or not available when compiling for CPUs other than x86) fall back to narrower ones.
+ */
+unsigned int get_simd_isa(const unsigned int simd_isa);
+
+// Returns the name of "simd_isa" (MUST NOT be SIMD_ISA_AUTO) for displaying to the user
+const char* get_simd_isa_name(const unsigned int simd_isa);
+
+/*
+ * Sorts the "array_length" (at least 1) numbers at "array" in "sorting_direction" with
+ * the same bitonic sorting network as "serial_bitonic_sort", using the instruction set
+ * "simd_isa" (refer to "get_simd_isa") without printing anything. Every merge step first
+ * sorts each vector entirely within a register, i.e. all merge steps comparing numbers
+ * within the same vector are performed without going through memory; merge steps of larger
+ * compare distances compare whole vectors against each other with min/max, so no step ever
+ * branches on the numbers being compared.
+ */
+void simd_bitonic_sort_block(ARRAY_TYPE_DECLARED* array, const unsigned int array_length,
+                               const unsigned int sorting_direction, const unsigned int simd_isa);
+
+/*
+ * Vectorised implementation of bitonic sort on a single core of the CPU.
+ * - "input_array" is the array to be sorted.
+ * - "sorting_direction" indicates whether or not to sort array in ascending or descending order;
+ *   refer to SORTING_DIRECTION macro within "naive_bitonic_sort_opencl.h" for more info.
+ * - "simd_isa" is the instruction set to sort with, or SIMD_ISA_AUTO.
+ */
+void simd_bitonic_sort_cpu(struct Array_With_Length_Padded* input_array,
+                             const unsigned int sorting_direction, const unsigned int simd_isa);
+
+#endif // SIMD_BITONIC_SORT_CPU_H
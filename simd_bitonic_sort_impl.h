@@ -0,0 +1,201 @@
+/*
+ * File description:
+ *   Instruction set specialised parts of the vectorised bitonic sort in "simd_bitonic_sort_cpu.c";
+ *   this file is included once per instruction set, with the following macros defined beforehand:
+ *   - SIMD_VECTOR_BYTES --- size in bytes of each vector
+ *   - SIMD_TARGET --- function attribute enabling the instruction set (empty for the baseline)
+ *   - SIMD_FUNC --- macro turning a function (or type) name into the name of its specialisation
+ *   All three macros are undefined again at the end of this file. Refer to "simd_bitonic_sort_cpu.c"
+ *   for SIMD_MASK_ELEMENT_TYPE and the scalar helpers shared by all specialisations.
+ */
+
+// Vector of numbers, and vector of integers of the same size as each number (e.g. comparison results)
+typedef ARRAY_TYPE_DECLARED SIMD_FUNC(vector) __attribute__((vector_size(SIMD_VECTOR_BYTES)));
+typedef SIMD_MASK_ELEMENT_TYPE SIMD_FUNC(mask) __attribute__((vector_size(SIMD_VECTOR_BYTES)));
+// Number of numbers within each vector
+#define SIMD_LANES ((unsigned int)(SIMD_VECTOR_BYTES / sizeof(ARRAY_TYPE_DECLARED)))
+// Number of different merge steps comparing numbers within the same vector (i.e. log2 of SIMD_LANES)
+#define SIMD_MAX_IN_REGISTER_STEPS 6
+
+/*
+ * Shuffle patterns of every merge step comparing numbers within the same vector, indexed by the
+ * log2 of the compare distance; fields are the following:
+ *  - lane holding the number each lane gets compared to within regular merge steps, and within the
+ *    first merge step of each partition size (which compares mirrored positions)
+ *  - all bits set in every lane ending up with the number coming later in the sorting order
+ *  - lane of each number once the vector is reversed
+ */
+struct SIMD_FUNC(Shuffle_Patterns) {
+     SIMD_FUNC(mask) partner_lanes[SIMD_MAX_IN_REGISTER_STEPS];
+     SIMD_FUNC(mask) mirrored_partner_lanes[SIMD_MAX_IN_REGISTER_STEPS];
+     SIMD_FUNC(mask) upper_lanes[SIMD_MAX_IN_REGISTER_STEPS];
+     SIMD_FUNC(mask) reversed_lanes;
+};
+
+SIMD_TARGET static void SIMD_FUNC(init_shuffle_patterns)(struct SIMD_FUNC(Shuffle_Patterns)* patterns) {
+    for (unsigned int lane = 0; lane < SIMD_LANES; ++lane) {
+        patterns->reversed_lanes[lane] = (SIMD_MASK_ELEMENT_TYPE)(SIMD_LANES - 1 - lane);
+        unsigned int step_index = 0;
+        for (unsigned int compare_distance = 1; compare_distance < SIMD_LANES; compare_distance *= 2) {
+            patterns->partner_lanes[step_index][lane] = (SIMD_MASK_ELEMENT_TYPE)(lane ^ compare_distance);
+            patterns->mirrored_partner_lanes[step_index][lane] =
+                                              (SIMD_MASK_ELEMENT_TYPE)(lane ^ (2 * compare_distance - 1));
+            patterns->upper_lanes[step_index][lane] = (lane & compare_distance) ? -1 : 0;
+            ++step_index;
+        }
+    }
+}
+
+SIMD_TARGET static inline SIMD_FUNC(vector) SIMD_FUNC(load)(const ARRAY_TYPE_DECLARED* source) {
+    SIMD_FUNC(vector) loaded;
+    memcpy(&loaded, source, sizeof(loaded));
+    return loaded;
+}
+
+SIMD_TARGET static inline void SIMD_FUNC(store)(ARRAY_TYPE_DECLARED* destination, const SIMD_FUNC(vector) stored) {
+    memcpy(destination, &stored, sizeof(stored));
+}
+
+/*
+ * Compares every lane of "lower" against the same lane of "upper", leaving the number coming first in
+ * the sorting order within "lower" and the other one within "upper" (i.e. a min/max of whole vectors,
+ * as a blend through a single comparison mask so that both numbers of each lane are always kept).
+ */
+SIMD_TARGET static inline void SIMD_FUNC(compare_exchange)(SIMD_FUNC(vector)* lower, SIMD_FUNC(vector)* upper,
+                                                             const unsigned int sorting_direction) {
+    const SIMD_FUNC(mask) keep_order = sorting_direction ? (SIMD_FUNC(mask))(*lower > *upper) :
+                                                                   (SIMD_FUNC(mask))(*lower < *upper);
+    const SIMD_FUNC(mask) lower_bits = (SIMD_FUNC(mask))(*lower);
+    const SIMD_FUNC(mask) upper_bits = (SIMD_FUNC(mask))(*upper);
+    *lower = (SIMD_FUNC(vector))((lower_bits & keep_order) | (upper_bits & ~keep_order));
+    *upper = (SIMD_FUNC(vector))((upper_bits & keep_order) | (lower_bits & ~keep_order));
+}
+
+/*
+ * Performs a single merge step comparing numbers within "numbers" (i.e. of a compare distance smaller
+ * than SIMD_LANES, whose log2 is "step_index"): each lane gets compared to its partner lane brought in
+ * by a shuffle, and then keeps either the first or the second number of its pair depending on its side.
+ */
+SIMD_TARGET static inline SIMD_FUNC(vector) SIMD_FUNC(in_register_step)(const SIMD_FUNC(vector) numbers,
+                                               const struct SIMD_FUNC(Shuffle_Patterns)* patterns,
+                                                 const unsigned int step_index, const int is_first_merge_step,
+                                                                          const unsigned int sorting_direction) {
+    const SIMD_FUNC(vector) partners = __builtin_shuffle(numbers, is_first_merge_step ?
+                                                           patterns->mirrored_partner_lanes[step_index] :
+                                                                     patterns->partner_lanes[step_index]);
+    SIMD_FUNC(vector) first = numbers;
+    SIMD_FUNC(vector) second = partners;
+    SIMD_FUNC(compare_exchange)(&first, &second, sorting_direction);
+    const SIMD_FUNC(mask) upper_lanes = patterns->upper_lanes[step_index];
+    return (SIMD_FUNC(vector))(((SIMD_FUNC(mask))second & upper_lanes) | ((SIMD_FUNC(mask))first & ~upper_lanes));
+}
+
+/*
+ * Performs every merge step of "partition_size" comparing numbers within the same vector, starting
+ * from a compare distance of "first_compare_distance" (the first merge step of the partition size
+ * if twice the compare distance is the partition size), on each whole vector of the array; merge
+ * steps on numbers within the last vector (if only partly within the array) are performed one
+ * pair at a time.
+ */
+SIMD_TARGET static void SIMD_FUNC(in_register_steps)(ARRAY_TYPE_DECLARED* array, const unsigned int array_length,
+                                                      const struct SIMD_FUNC(Shuffle_Patterns)* patterns,
+                                                        const unsigned int partition_size,
+                                                          const unsigned int first_compare_distance,
+                                                                 const unsigned int sorting_direction) {
+    const unsigned int vectors_end = array_length - array_length % SIMD_LANES;
+    for (unsigned int vector_start = 0; vector_start < vectors_end; vector_start += SIMD_LANES) {
+        SIMD_FUNC(vector) numbers = SIMD_FUNC(load)(array + vector_start);
+        unsigned int step_index = 0;
+        while ((2u << step_index) <= first_compare_distance) {
+            ++step_index;
+        }
+        for (unsigned int compare_distance = first_compare_distance; compare_distance > 0; compare_distance /= 2) {
+            numbers = SIMD_FUNC(in_register_step)(numbers, patterns, step_index,
+                                                    2 * compare_distance == partition_size, sorting_direction);
+            --step_index;
+        }
+        SIMD_FUNC(store)(array + vector_start, numbers);
+    }
+    for (unsigned int compare_distance = first_compare_distance; compare_distance > 0; compare_distance /= 2) {
+        scalar_merge_step_pairs(array, array_length, vectors_end, array_length, compare_distance,
+                                          2 * compare_distance == partition_size, sorting_direction);
+    }
+}
+
+/*
+ * Performs a single merge step of a compare distance of at least SIMD_LANES by comparing whole vectors
+ * against each other; numbers being compared to mirrored positions (i.e. the first merge step of each
+ * partition size) are loaded as reversed vectors. Vectors of pairs partly beyond the array length are
+ * compared one pair at a time.
+ */
+SIMD_TARGET static void SIMD_FUNC(vector_step)(ARRAY_TYPE_DECLARED* array, const unsigned int array_length,
+                                                const struct SIMD_FUNC(Shuffle_Patterns)* patterns,
+                                                  const unsigned int compare_distance,
+                                                    const int is_first_merge_step,
+                                                      const unsigned int sorting_direction) {
+    for (unsigned int block_start = 0; block_start < array_length; block_start += 2 * compare_distance) {
+        for (unsigned int offset = 0; offset < compare_distance; offset += SIMD_LANES) {
+            const unsigned int lower_start = block_start + offset;
+            if (lower_start >= array_length) {
+                break;
+            }
+            // Index of the last number of the vector of numbers being compared to
+            const unsigned int upper_last = is_first_merge_step ? (block_start + 2 * compare_distance - 1 - offset) :
+                                                               (block_start + compare_distance + offset + SIMD_LANES - 1);
+            if (upper_last >= array_length) {
+                scalar_merge_step_pairs(array, array_length, lower_start, lower_start + SIMD_LANES,
+                                          compare_distance, is_first_merge_step, sorting_direction);
+                continue;
+            }
+            SIMD_FUNC(vector) lower = SIMD_FUNC(load)(array + lower_start);
+            if (is_first_merge_step) {
+                const unsigned int upper_start = upper_last + 1 - SIMD_LANES;
+                SIMD_FUNC(vector) upper = __builtin_shuffle(SIMD_FUNC(load)(array + upper_start),
+                                                              patterns->reversed_lanes);
+                SIMD_FUNC(compare_exchange)(&lower, &upper, sorting_direction);
+                SIMD_FUNC(store)(array + upper_start, __builtin_shuffle(upper, patterns->reversed_lanes));
+            } else {
+                const unsigned int upper_start = block_start + compare_distance + offset;
+                SIMD_FUNC(vector) upper = SIMD_FUNC(load)(array + upper_start);
+                SIMD_FUNC(compare_exchange)(&lower, &upper, sorting_direction);
+                SIMD_FUNC(store)(array + upper_start, upper);
+            }
+            SIMD_FUNC(store)(array + lower_start, lower);
+        }
+    }
+}
+
+// Vectorised bitonic sort of "array"; refer to "simd_bitonic_sort_block"
+SIMD_TARGET static void SIMD_FUNC(bitonic_sort)(ARRAY_TYPE_DECLARED* array, const unsigned int array_length,
+                                                                     const unsigned int sorting_direction) {
+    struct SIMD_FUNC(Shuffle_Patterns) patterns;
+    SIMD_FUNC(init_shuffle_patterns)(&patterns);
+
+    unsigned int network_len = 1;
+    while (network_len < array_length) {
+        network_len *= 2;
+    }
+
+    // Partition sizes up to the vector size only ever compare numbers within the same vector
+    for (unsigned int partition_size = 2; (partition_size <= SIMD_LANES) && (partition_size <= network_len);
+                                                                                    partition_size *= 2) {
+        SIMD_FUNC(in_register_steps)(array, array_length, &patterns, partition_size, partition_size / 2,
+                                                                                        sorting_direction);
+    }
+
+    for (unsigned int partition_size = 2 * SIMD_LANES; partition_size <= network_len; partition_size *= 2) {
+        for (unsigned int compare_distance = partition_size / 2; compare_distance >= SIMD_LANES;
+                                                                                compare_distance /= 2) {
+            SIMD_FUNC(vector_step)(array, array_length, &patterns, compare_distance,
+                                     2 * compare_distance == partition_size, sorting_direction);
+        }
+        SIMD_FUNC(in_register_steps)(array, array_length, &patterns, partition_size, SIMD_LANES / 2,
+                                                                                        sorting_direction);
+    }
+}
+
+#undef SIMD_LANES
+#undef SIMD_MAX_IN_REGISTER_STEPS
+#undef SIMD_VECTOR_BYTES
+#undef SIMD_TARGET
+#undef SIMD_FUNC
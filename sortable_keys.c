@@ -0,0 +1,118 @@
+/*
+ * File description:
+ *   Passes turning arrays of floating point numbers into arrays of signed integers sorting
+ *   the same way and back again, on the host and on OpenCL devices.
+ */
+
+#include "sortable_keys.h"
+#include <assert.h>
+
+unsigned int get_sortable_key_type(const unsigned int array_type) {
+    // Make sure data type is of valid value
+    assert(array_type < NUM_ARRAY_TYPES);
+
+    if (array_type == FLOAT) {
+        return INT;
+    }
+    if (array_type == DOUBLE) {
+        return LONG;
+    }
+    return array_type;
+}
+
+/*
+ * Flipping the top bit of an unsigned key gives a signed integer of the same order, and the
+ * other way around; the conversions between signed and unsigned integers keep all bits.
+ */
+void float_keys_to_sortable(void* data, const size_t array_length, const unsigned int array_type,
+                                                                const unsigned int sorting_direction) {
+    // No null pointers allowed
+    assert(data != NULL);
+    // Make sure data type and sort_direction are of valid values
+    assert(array_type < NUM_ARRAY_TYPES);
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+
+    if (array_type == FLOAT) {
+        cl_float* elements = (cl_float*)data;
+        for (size_t element_index = 0; element_index < array_length; ++element_index) {
+            const cl_int sortable = (cl_int)(float_to_key(elements[element_index], sorting_direction) ^
+                                                                               UINT32_C(0x80000000));
+            memcpy(&elements[element_index], &sortable, sizeof(sortable));
+        }
+    } else if (array_type == DOUBLE) {
+        cl_double* elements = (cl_double*)data;
+        for (size_t element_index = 0; element_index < array_length; ++element_index) {
+            const cl_long sortable = (cl_long)(double_to_key(elements[element_index], sorting_direction) ^
+                                                                          UINT64_C(0x8000000000000000));
+            memcpy(&elements[element_index], &sortable, sizeof(sortable));
+        }
+    }
+}
+
+void sortable_to_float_keys(void* data, const size_t array_length, const unsigned int array_type,
+                                                                const unsigned int sorting_direction) {
+    // No null pointers allowed
+    assert(data != NULL);
+    // Make sure data type and sort_direction are of valid values
+    assert(array_type < NUM_ARRAY_TYPES);
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+
+    if (array_type == FLOAT) {
+        cl_int* sortables = (cl_int*)data;
+        for (size_t element_index = 0; element_index < array_length; ++element_index) {
+            const cl_float element = key_to_float((uint32_t)sortables[element_index] ^ UINT32_C(0x80000000));
+            memcpy(&sortables[element_index], &element, sizeof(element));
+        }
+    } else if (array_type == DOUBLE) {
+        cl_long* sortables = (cl_long*)data;
+        for (size_t element_index = 0; element_index < array_length; ++element_index) {
+            const cl_double element = key_to_double((uint64_t)sortables[element_index] ^
+                                                              UINT64_C(0x8000000000000000));
+            memcpy(&sortables[element_index], &element, sizeof(element));
+        }
+    }
+}
+
+/*
+ * Enqueues "kernel" (one of the kernels turning floating point numbers into integers and back, of
+ * "kernels") over the array of "array_length" numbers within "buffer_in", with one work-item per
+ * number.
+ */
+static void enqueue_float_key_pass(cl_command_queue *queue, const struct Bitonic_Kernels* kernels, cl_kernel kernel,
+                                     cl_mem* buffer_in, const unsigned int array_length) {
+    // No null pointers allowed
+    assert(queue != NULL);
+    assert(kernels != NULL);
+    assert(kernel != NULL);
+    assert(buffer_in != NULL);
+
+    const size_t workgroup_size = kernels->workgroup_size;
+    const size_t local[OPERAND_DIMS] = { workgroup_size };
+    const size_t global[OPERAND_DIMS] = { ((array_length + workgroup_size - 1) / workgroup_size) * workgroup_size };
+    clSetKernelArg(kernel, 0, sizeof(*buffer_in), (void*)buffer_in);
+    clSetKernelArg(kernel, 1, sizeof(array_length), (void*)&array_length);
+    clEnqueueNDRangeKernel(*queue, kernel, OPERAND_DIMS, NULL, global, local, 0, NULL, NULL);
+}
+
+void opencl_float_keys_to_sortable(cl_command_queue *queue, const struct Bitonic_Kernels* kernels,
+                                     cl_mem* buffer_in, const unsigned int array_length,
+                                                             const unsigned int array_type) {
+    // Make sure data type is of valid value
+    assert(array_type < NUM_ARRAY_TYPES);
+
+    // Only floating point numbers need to be turned into integers
+    if ((array_type == FLOAT) || (array_type == DOUBLE)) {
+        enqueue_float_key_pass(queue, kernels, kernels->float_to_sortable_kernel, buffer_in, array_length);
+    }
+}
+
+void opencl_sortable_to_float_keys(cl_command_queue *queue, const struct Bitonic_Kernels* kernels,
+                                     cl_mem* buffer_in, const unsigned int array_length,
+                                                             const unsigned int array_type) {
+    // Make sure data type is of valid value
+    assert(array_type < NUM_ARRAY_TYPES);
+
+    if ((array_type == FLOAT) || (array_type == DOUBLE)) {
+        enqueue_float_key_pass(queue, kernels, kernels->sortable_to_float_kernel, buffer_in, array_length);
+    }
+}
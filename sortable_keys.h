@@ -0,0 +1,120 @@
+/*
+ * File description:
+ *   Header file for order-preserving unsigned integer keys of each permitted data type,
+ *   shared by every engine sorting by key bits (e.g. LSD radix sort) or comparing keys
+ *   instead of numbers, and for passes turning arrays of floating point numbers into
+ *   arrays of signed integers sorting the same way (and back again), on the host and on
+ *   OpenCL devices, so that engines comparing numbers may sort integers instead.
+ *
+ *   Keys of floating point numbers give a total order: NaNs come last whichever the
+ *   sorting direction (keeping their payload but not their sign), and -0.0 comes before
+ *   +0.0 when sorting ascending (i.e. after it when sorting descending).
+ */
+
+#ifndef SORTABLE_KEYS_H
+#define SORTABLE_KEYS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "naive_bitonic_sort_opencl.h"
+
+// Names of the kernel functions in OpenCL program file turning floating point numbers into keys and back
+#define FLOAT_TO_SORTABLE_KERNEL_FUNC_NAME "float_keys_to_sortable"
+#define SORTABLE_TO_FLOAT_KERNEL_FUNC_NAME "sortable_to_float_keys"
+
+/*
+ * Unsigned integer keys of each permitted data type, ordered the same way as the elements when
+ * sorting ascending (keys MUST be inverted to sort descending): the sign bit of signed integers
+ * gets flipped, and the bits of floating point numbers get flipped entirely if negative (as larger
+ * magnitudes come first) and only their sign bit otherwise. NaNs are made positive when sorting
+ * ascending and negative when sorting descending beforehand, so that they come last either way.
+ */
+static inline uint8_t char_to_key(const cl_char element, const unsigned int sorting_direction) {
+    (void)sorting_direction;
+    return (uint8_t)element ^ (uint8_t)0x80;
+}
+
+static inline uint32_t int_to_key(const cl_int element, const unsigned int sorting_direction) {
+    (void)sorting_direction;
+    return (uint32_t)element ^ UINT32_C(0x80000000);
+}
+
+static inline uint64_t long_to_key(const cl_long element, const unsigned int sorting_direction) {
+    (void)sorting_direction;
+    return (uint64_t)element ^ UINT64_C(0x8000000000000000);
+}
+
+static inline uint32_t float_to_key(const cl_float element, const unsigned int sorting_direction) {
+    uint32_t bits;
+    memcpy(&bits, &element, sizeof(bits));
+    if ((bits & UINT32_C(0x7FFFFFFF)) > UINT32_C(0x7F800000)) {
+        bits = sorting_direction ? (bits | UINT32_C(0x80000000)) : (bits & UINT32_C(0x7FFFFFFF));
+    }
+    return bits ^ ((bits >> 31) ? UINT32_MAX : UINT32_C(0x80000000));
+}
+
+static inline uint64_t double_to_key(const cl_double element, const unsigned int sorting_direction) {
+    uint64_t bits;
+    memcpy(&bits, &element, sizeof(bits));
+    if ((bits & UINT64_C(0x7FFFFFFFFFFFFFFF)) > UINT64_C(0x7FF0000000000000)) {
+        bits = sorting_direction ? (bits | UINT64_C(0x8000000000000000)) : (bits & UINT64_C(0x7FFFFFFFFFFFFFFF));
+    }
+    return bits ^ ((bits >> 63) ? UINT64_MAX : UINT64_C(0x8000000000000000));
+}
+
+// Floating point numbers of the keys above; keys with the top bit set belong to positive numbers
+static inline cl_float key_to_float(const uint32_t key) {
+    const uint32_t bits = key ^ ((key >> 31) ? UINT32_C(0x80000000) : UINT32_MAX);
+    cl_float element;
+    memcpy(&element, &bits, sizeof(element));
+    return element;
+}
+
+static inline cl_double key_to_double(const uint64_t key) {
+    const uint64_t bits = key ^ ((key >> 63) ? UINT64_C(0x8000000000000000) : UINT64_MAX);
+    cl_double element;
+    memcpy(&element, &bits, sizeof(element));
+    return element;
+}
+
+/*
+ * Returns the data type to sort arrays of data type "array_type" with after
+ * "float_keys_to_sortable" (or "opencl_float_keys_to_sortable"), i.e. INT for
+ * FLOAT, LONG for DOUBLE and "array_type" itself for all other data types.
+ */
+unsigned int get_sortable_key_type(const unsigned int array_type);
+
+/*
+ * Turns the "array_length" floating point numbers of data type "array_type" at "data" in place
+ * into signed integers of the same size, which sort in "sorting_direction" the same way as the
+ * total order of the numbers described at the top of this file; arrays of any other data type
+ * are left as they are. The array is then sorted as data type "get_sortable_key_type(array_type)"
+ * in "sorting_direction", and turned back with "sortable_to_float_keys" (with the same direction,
+ * which decides where NaNs go).
+ */
+void float_keys_to_sortable(void* data, const size_t array_length, const unsigned int array_type,
+                                                                const unsigned int sorting_direction);
+
+// Turns the signed integers of "float_keys_to_sortable" back into floating point numbers in place
+void sortable_to_float_keys(void* data, const size_t array_length, const unsigned int array_type,
+                                                                const unsigned int sorting_direction);
+
+/*
+ * Same passes as the two functions above on the array of "array_length" numbers within
+ * "buffer_in" on an OpenCL device, using the kernels of "kernels" (created for "array_type"
+ * without payload, refer to "create_bitonic_kernels"), which sort in the direction of their
+ * program and are launched with their workgroup size. Commands are only enqueued into "queue"
+ * and not waited for, so the sort of the integers may be enqueued right after into the same
+ * (in-order) queue; e.g. "opencl_bitonic_sort" with a data type of
+ * "get_sortable_key_type(array_type)".
+ */
+void opencl_float_keys_to_sortable(cl_command_queue *queue, const struct Bitonic_Kernels* kernels,
+                                     cl_mem* buffer_in, const unsigned int array_length,
+                                                             const unsigned int array_type);
+
+void opencl_sortable_to_float_keys(cl_command_queue *queue, const struct Bitonic_Kernels* kernels,
+                                     cl_mem* buffer_in, const unsigned int array_length,
+                                                             const unsigned int array_type);
+
+#endif // SORTABLE_KEYS_H
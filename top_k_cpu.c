@@ -0,0 +1,83 @@
+/*
+ * File description:
+ *   Selection of the K elements coming first in the sorting order of an array on a single core of
+ *   the CPU with bitonic merges, specialised at compile time for each permitted data type and
+ *   sorting direction (refer to "reference_sorts_cpu.c").
+ */
+
+#include "top_k_cpu.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// Specialisations of the top-K selection for each permitted data type and sorting direction
+#define TOP_K_ELEMENT_TYPE cl_char
+#define TOP_K_DESCENDING 0
+#define TOP_K_FUNC(func_name) func_name##_char_ascending
+#include "top_k_cpu_impl.h"
+#define TOP_K_ELEMENT_TYPE cl_char
+#define TOP_K_DESCENDING 1
+#define TOP_K_FUNC(func_name) func_name##_char_descending
+#include "top_k_cpu_impl.h"
+#define TOP_K_ELEMENT_TYPE cl_int
+#define TOP_K_DESCENDING 0
+#define TOP_K_FUNC(func_name) func_name##_int_ascending
+#include "top_k_cpu_impl.h"
+#define TOP_K_ELEMENT_TYPE cl_int
+#define TOP_K_DESCENDING 1
+#define TOP_K_FUNC(func_name) func_name##_int_descending
+#include "top_k_cpu_impl.h"
+#define TOP_K_ELEMENT_TYPE cl_long
+#define TOP_K_DESCENDING 0
+#define TOP_K_FUNC(func_name) func_name##_long_ascending
+#include "top_k_cpu_impl.h"
+#define TOP_K_ELEMENT_TYPE cl_long
+#define TOP_K_DESCENDING 1
+#define TOP_K_FUNC(func_name) func_name##_long_descending
+#include "top_k_cpu_impl.h"
+#define TOP_K_ELEMENT_TYPE cl_float
+#define TOP_K_DESCENDING 0
+#define TOP_K_FUNC(func_name) func_name##_float_ascending
+#include "top_k_cpu_impl.h"
+#define TOP_K_ELEMENT_TYPE cl_float
+#define TOP_K_DESCENDING 1
+#define TOP_K_FUNC(func_name) func_name##_float_descending
+#include "top_k_cpu_impl.h"
+#define TOP_K_ELEMENT_TYPE cl_double
+#define TOP_K_DESCENDING 0
+#define TOP_K_FUNC(func_name) func_name##_double_ascending
+#include "top_k_cpu_impl.h"
+#define TOP_K_ELEMENT_TYPE cl_double
+#define TOP_K_DESCENDING 1
+#define TOP_K_FUNC(func_name) func_name##_double_descending
+#include "top_k_cpu_impl.h"
+
+// Specialisations of the selection, indexed by the macro value of each data type and then of each direction
+static void (*const top_k_funcs[NUM_ARRAY_TYPES][NUM_SORTING_DIRECTIONS])(const void*, const size_t, const size_t,
+                                                                           const size_t, void*) = {
+    {top_k_char_ascending, top_k_char_descending},
+    {top_k_int_ascending, top_k_int_descending},
+    {top_k_long_ascending, top_k_long_descending},
+    {top_k_float_ascending, top_k_float_descending},
+    {top_k_double_ascending, top_k_double_descending}
+};
+
+void top_k_cpu(const void* data, const size_t array_length, const size_t k, const unsigned int array_type,
+                 const unsigned int sorting_direction, void* top_k) {
+    // No null pointers allowed
+    assert(data != NULL);
+    assert(top_k != NULL);
+    // Array length and number of winners HAVE to be at least 1
+    assert(array_length >= 1);
+    assert(k >= 1);
+    // Make sure data type and sort_direction are of valid values
+    assert(array_type < NUM_ARRAY_TYPES);
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+
+    const size_t num_winners = (k < array_length) ? k : array_length;
+    size_t block_length = 1;
+    while (block_length < num_winners) {
+        block_length *= 2;
+    }
+    top_k_funcs[array_type][sorting_direction](data, array_length, num_winners, block_length, top_k);
+}
@@ -0,0 +1,31 @@
+/*
+ * File description:
+ *   Header file for selecting the K numbers coming first in the sorting order (i.e. the K
+ *   largest or smallest numbers) of an array on a single core of the CPU with bitonic merges,
+ *   the counterpart of "top_k_opencl.h": the K winners so far are kept sorted, and every block
+ *   of K candidates gets sorted and merged into them, throwing away the losing half.
+ */
+
+#ifndef TOP_K_CPU_H
+#define TOP_K_CPU_H
+
+#include <stddef.h>
+#include "naive_bitonic_sort_opencl.h"
+
+/*
+ * Writes the "k" (at least 1) elements of the "array_length" (at least 1) elements of data type
+ * "array_type" at "data" that come first when sorting in "sorting_direction" (i.e. the largest "k"
+ * when descending, the smallest when ascending) into "top_k", sorted in "sorting_direction"; only
+ * "array_length" of them are written if "k" exceeds the array length, and "data" is left untouched.
+ * The winners so far are held in a block of "k" elements (rounded up to the next power of 2), sorted
+ * with the bitonic sorting network. Only elements coming before the last winner can become winners,
+ * so every other element is passed over after a single comparison; the others are gathered into
+ * another block, which once full gets sorted and merged into the winners by keeping the winner of
+ * each pair of mirrored elements (the first merge step of a bitonic merge) and then sorting the
+ * winners with the half-cleaners of the block length. Work is O(n log^2 k) at worst, and close to
+ * O(n) when few elements beat the winners so far (e.g. for random data).
+ */
+void top_k_cpu(const void* data, const size_t array_length, const size_t k, const unsigned int array_type,
+                 const unsigned int sorting_direction, void* top_k);
+
+#endif // TOP_K_CPU_H
@@ -0,0 +1,106 @@
+/*
+ * File description:
+ *   Type and direction specialised parts of the top-K selection in "top_k_cpu.c"; this file is
+ *   included once per permitted data type and sorting direction, with the following macros
+ *   defined beforehand:
+ *   - TOP_K_ELEMENT_TYPE --- data type of each element
+ *   - TOP_K_DESCENDING --- 1 if selecting the largest elements (sorting in descending order),
+ *     0 otherwise
+ *   - TOP_K_FUNC --- macro turning a function name into the name of its specialisation
+ *   All three macros are undefined again at the end of this file.
+ */
+
+// Whether "first" comes strictly before "second" in the sorting order
+#if (TOP_K_DESCENDING)
+  #define TOP_K_PRECEDES(first, second) ((first) > (second))
+#else
+  #define TOP_K_PRECEDES(first, second) ((first) < (second))
+#endif
+
+/*
+ * Performs the merge step of "compare_distance" and "partition_size" of the bitonic sorting network
+ * (the same variant as the OpenCL kernels, refer to "bitonic_program.cl") on the first "array_length"
+ * elements of "block"; comparators touching elements at or beyond the array length are skipped.
+ */
+static void TOP_K_FUNC(merge_step)(TOP_K_ELEMENT_TYPE* block, const size_t array_length,
+                                     const size_t compare_distance, const size_t partition_size) {
+    for (size_t lower_index = 0; lower_index < array_length; ++lower_index) {
+        if ((lower_index & compare_distance) != 0) {
+            continue;
+        }
+        const size_t upper_index = (2 * compare_distance == partition_size) ?
+                                     (lower_index ^ (partition_size - 1)) : (lower_index | compare_distance);
+        if ((upper_index < array_length) && TOP_K_PRECEDES(block[upper_index], block[lower_index])) {
+            const TOP_K_ELEMENT_TYPE temp_var = block[lower_index];
+            block[lower_index] = block[upper_index];
+            block[upper_index] = temp_var;
+        }
+    }
+}
+
+// Sorts the first "array_length" elements of "block" with the sorting network of "block_length" elements
+static void TOP_K_FUNC(sort_block)(TOP_K_ELEMENT_TYPE* block, const size_t array_length, const size_t block_length) {
+    for (size_t partition_size = 2; partition_size <= block_length; partition_size *= 2) {
+        for (size_t compare_distance = partition_size / 2; compare_distance > 0; compare_distance /= 2) {
+            TOP_K_FUNC(merge_step)(block, array_length, compare_distance, partition_size);
+        }
+    }
+}
+
+/*
+ * Merges the first "num_candidates" elements of "candidates" into the sorted block of "block_length"
+ * winners, keeping the "block_length" elements coming first sorted within "winners"; the contents of
+ * "candidates" are undefined afterwards.
+ */
+static void TOP_K_FUNC(merge_candidates)(TOP_K_ELEMENT_TYPE* winners, TOP_K_ELEMENT_TYPE* candidates,
+                                           const size_t num_candidates, const size_t block_length) {
+    TOP_K_FUNC(sort_block)(candidates, num_candidates, block_length);
+
+    // Compare mirrored positions of both blocks, where candidates beyond "num_candidates" always lose
+    for (size_t candidate_index = 0; candidate_index < num_candidates; ++candidate_index) {
+        const size_t winner_index = block_length - 1 - candidate_index;
+        if (TOP_K_PRECEDES(candidates[candidate_index], winners[winner_index])) {
+            winners[winner_index] = candidates[candidate_index];
+        }
+    }
+    // The winners are now a bitonic sequence, sorted by the half-cleaners of the block length
+    for (size_t compare_distance = block_length / 2; compare_distance > 0; compare_distance /= 2) {
+        TOP_K_FUNC(merge_step)(winners, block_length, compare_distance, 2 * block_length);
+    }
+}
+
+static void TOP_K_FUNC(top_k)(const void* data, const size_t array_length, const size_t num_winners,
+                                const size_t block_length, void* top_k) {
+    const TOP_K_ELEMENT_TYPE* array = (const TOP_K_ELEMENT_TYPE*)data;
+    TOP_K_ELEMENT_TYPE* winners = malloc(block_length * sizeof(TOP_K_ELEMENT_TYPE));
+    TOP_K_ELEMENT_TYPE* candidates = malloc(block_length * sizeof(TOP_K_ELEMENT_TYPE));
+
+    // The first block of the array are the winners to begin with
+    const size_t first_block_length = (array_length < block_length) ? array_length : block_length;
+    memcpy(winners, array, first_block_length * sizeof(TOP_K_ELEMENT_TYPE));
+    TOP_K_FUNC(sort_block)(winners, first_block_length, block_length);
+
+    // Every block of the winners is full from here on, so the last winner is the one to beat
+    size_t num_candidates = 0;
+    for (size_t element_index = first_block_length; element_index < array_length; ++element_index) {
+        if (TOP_K_PRECEDES(array[element_index], winners[block_length - 1])) {
+            candidates[num_candidates++] = array[element_index];
+            if (num_candidates == block_length) {
+                TOP_K_FUNC(merge_candidates)(winners, candidates, num_candidates, block_length);
+                num_candidates = 0;
+            }
+        }
+    }
+    if (num_candidates > 0) {
+        TOP_K_FUNC(merge_candidates)(winners, candidates, num_candidates, block_length);
+    }
+
+    memcpy(top_k, winners, num_winners * sizeof(TOP_K_ELEMENT_TYPE));
+    free(winners);
+    free(candidates);
+}
+
+#undef TOP_K_PRECEDES
+#undef TOP_K_ELEMENT_TYPE
+#undef TOP_K_DESCENDING
+#undef TOP_K_FUNC
@@ -0,0 +1,117 @@
+/*
+ * File description:
+ *   Host side of selecting the K numbers coming first in the sorting order of an array on
+ *   OpenCL devices with bitonic merges; all kernels live within the same OpenCL program file
+ *   as the bitonic sorting kernels.
+ */
+
+#include "top_k_opencl.h"
+#include <stdio.h>
+#include <assert.h>
+#include "bitonic_profile.h"
+
+// Name of each sorting direction, indexed by the macro value of each direction
+static const char* const sorting_direction_names[NUM_SORTING_DIRECTIONS] = {"ascending", "descending"};
+
+/*
+ * Returns the number of elements left after keeping the winning half of each pair of blocks of
+ * "block_length" elements of an array of "array_length" elements (refer to the "top_k_bitonic_reduce"
+ * kernel), i.e. a whole block per pair of blocks, plus the last block if it has no partner.
+ */
+static unsigned int get_reduced_length(const unsigned int array_length, const unsigned int block_length) {
+    const unsigned int num_blocks = (array_length + block_length - 1) / block_length;
+    if (num_blocks % 2 == 0) {
+        return (num_blocks / 2) * block_length;
+    }
+    return ((num_blocks - 1) / 2) * block_length + (array_length - (num_blocks - 1) * block_length);
+}
+
+unsigned int get_top_k_block_length(const unsigned int num_winners) {
+    unsigned int block_length = 1;
+    while (block_length < num_winners) {
+        block_length *= 2;
+    }
+    return block_length;
+}
+
+void opencl_bitonic_top_k(cl_command_queue *queue, struct Bitonic_Program_Cache* program_cache,
+                            cl_mem* buffer_in, const unsigned int array_length, const unsigned int k,
+                              const unsigned int array_type, const unsigned int sorting_direction, void* top_k) {
+    // No null pointers allowed
+    assert(queue != NULL);
+    assert(program_cache != NULL);
+    assert(buffer_in != NULL);
+    assert(top_k != NULL);
+    // Array length and number of winners HAVE to be at least 1
+    assert(array_length >= 1);
+    assert(k >= 1);
+    // Make sure data type and sort_direction are of valid values
+    assert(array_type < NUM_ARRAY_TYPES);
+    assert((sorting_direction == ASCENDING_SORT) || (sorting_direction == DESCENDING_SORT));
+
+    cl_int func_error_code;
+    const unsigned int num_winners = (k < array_length) ? k : array_length;
+    const unsigned int block_length = get_top_k_block_length(num_winners);
+    const size_t element_size = get_array_type_size(array_type);
+    cl_program* program = get_bitonic_program(program_cache, array_type, sorting_direction, NO_PAYLOAD);
+    struct Bitonic_Kernels kernels;
+
+    // Workgroups of all kernels are as large as the tiles of this data type allow
+    create_bitonic_kernels(program, array_type, NO_PAYLOAD, program_cache->workgroup_size, &kernels);
+    const unsigned int workgroup_size = fit_bitonic_workgroup_size(&kernels, program_cache->device, array_type,
+                                                                     program_cache->workgroup_size);
+    const size_t local[OPERAND_DIMS] = { workgroup_size };
+    kernels.workgroup_size = workgroup_size;
+
+    // Notify user selection starts now
+    printf(NOTIFY_USER_TOP_K_OPENCL_START, num_winners, get_array_type_name(array_type), workgroup_size,
+                                                             sorting_direction_names[sorting_direction]);
+
+    kernels.merge_levels_per_launch = program_cache->merge_levels_per_launch;
+    kernels.profile = program_cache->profile;
+    cl_kernel reduce_kernel = clCreateKernel(*program, TOP_K_REDUCE_KERNEL_FUNC_NAME, &func_error_code);
+    assert(func_error_code == CL_SUCCESS);
+
+    // Numbers left move back and forth between the array and a temporary buffer, one level at a time
+    cl_mem temp_buffer = NULL;
+    if (array_length > block_length) {
+        temp_buffer = clCreateBuffer(program_cache->context, CL_MEM_READ_WRITE,
+                                       get_reduced_length(array_length, block_length) * element_size,
+                                                                             NULL, &func_error_code);
+        assert(func_error_code == CL_SUCCESS);
+    }
+
+    enqueue_bitonic_sort_blocks(queue, &kernels, buffer_in, array_length, array_type, block_length);
+    cl_mem* source_buffer = buffer_in;
+    cl_mem* destination_buffer = &temp_buffer;
+    for (unsigned int remaining_length = array_length; remaining_length > block_length; ) {
+        const unsigned int reduced_length = get_reduced_length(remaining_length, block_length);
+        const size_t global[OPERAND_DIMS] = {
+            ((reduced_length + workgroup_size - 1) / workgroup_size) * workgroup_size };
+
+        clSetKernelArg(reduce_kernel, 0, sizeof(*source_buffer), (void*)source_buffer);
+        clSetKernelArg(reduce_kernel, 1, sizeof(*destination_buffer), (void*)destination_buffer);
+        clSetKernelArg(reduce_kernel, 2, sizeof(remaining_length), (void*)&remaining_length);
+        clSetKernelArg(reduce_kernel, 3, sizeof(block_length), (void*)&block_length);
+        clEnqueueNDRangeKernel(*queue, reduce_kernel, OPERAND_DIMS, NULL, global, local, 0, NULL,
+                                 add_profiled_command(kernels.profile, PROFILED_GLOBAL_MERGE_STEPS, 2 * block_length,
+                                                        block_length, 1,
+                                                          ((size_t)remaining_length + reduced_length) * element_size));
+        enqueue_bitonic_merge_blocks(queue, &kernels, destination_buffer, reduced_length, array_type, block_length);
+
+        cl_mem* reduced_buffer = destination_buffer;
+        destination_buffer = source_buffer;
+        source_buffer = reduced_buffer;
+        remaining_length = reduced_length;
+    }
+
+    // Only the winners get read back, which also waits for the selection to be finished
+    clEnqueueReadBuffer(*queue, *source_buffer, CL_BLOCKING, CL_BUFFER_OFFSET, num_winners * element_size, top_k,
+                          0, NULL, add_profiled_command(kernels.profile, PROFILED_READBACK, 0, 0, 0,
+                                                          num_winners * element_size));
+    clReleaseKernel(reduce_kernel);
+    release_bitonic_kernels(&kernels);
+    if (temp_buffer != NULL) {
+        clReleaseMemObject(temp_buffer);
+    }
+}
@@ -0,0 +1,44 @@
+/*
+ * File description:
+ *   Header file for selecting the K numbers coming first in the sorting order (i.e. the K
+ *   largest or smallest numbers) of an array on an OpenCL device, without sorting the whole
+ *   array: the array is sorted in blocks of K numbers only, and pairs of sorted blocks are then
+ *   merged with bitonic merges throwing away the losing half, until a single block is left.
+ */
+
+#ifndef TOP_K_OPENCL_H
+#define TOP_K_OPENCL_H
+
+#include "naive_bitonic_sort_opencl.h"
+
+// Name of the kernel function in OpenCL program file keeping the winning half of each pair of blocks
+#define TOP_K_REDUCE_KERNEL_FUNC_NAME "top_k_bitonic_reduce"
+
+// Message to user about what's being selected; K, data type and sorting direction are filled in at runtime
+#define NOTIFY_USER_TOP_K_OPENCL_START ">>> Starting OpenCL bitonic selection of the first %u of %ss"\
+                                         " with %d work-items per workgroup, sort %s...\n"
+
+/*
+ * Returns the length of the blocks in which the K numbers coming first in the sorting order are
+ * selected, i.e. "num_winners" (at least 1) rounded up to the next power of 2.
+ */
+unsigned int get_top_k_block_length(const unsigned int num_winners);
+
+/*
+ * Writes the "k" (at least 1) numbers of the array of "array_length" (at least 1) elements of data
+ * type "array_type" within "buffer_in" that come first when sorting in "sorting_direction" (i.e. the
+ * largest "k" numbers when descending, the smallest when ascending) into the host array "top_k",
+ * sorted in "sorting_direction"; only the first "array_length" of them are written if "k" exceeds
+ * the array length. Blocks of "k" numbers (rounded up to the next power of 2) are sorted on their
+ * own, and then each level keeps the winning half of each pair of blocks (one launch) and sorts
+ * the bitonic blocks left (the half-cleaners of the block length), halving the numbers left per
+ * level; only the winners get read back. Work is about O(n log^2 k) rather than O(n log^2 n).
+ * The contents of "buffer_in" are undefined afterwards. A temporary buffer of about half the size
+ * of "buffer_in" is allocated within the context of "program_cache" for the duration of the
+ * selection, which has finished upon returning.
+ */
+void opencl_bitonic_top_k(cl_command_queue *queue, struct Bitonic_Program_Cache* program_cache,
+                            cl_mem* buffer_in, const unsigned int array_length, const unsigned int k,
+                              const unsigned int array_type, const unsigned int sorting_direction, void* top_k);
+
+#endif // TOP_K_OPENCL_H
@@ -0,0 +1,227 @@
+/*
+ * File description:
+ *   Pool of worker threads scheduling fork-join tasks with work stealing. Every deque has its own
+ *   lock, which is only ever contended when a worker steals from it; owners push and pop at the
+ *   bottom of their deques (i.e. most recently spawned task first, which keeps its data in cache),
+ *   while thieves take from the top (i.e. the task spawned earliest, which for recursive divide and
+ *   conquer is the largest one left, so steals are rare).
+ */
+
+#include "work_stealing_pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sched.h>
+#include <unistd.h>
+
+/*
+ * Pool the calling thread works for (NULL if none), and the index of the worker within it; lets
+ * "spawn_pool_task" find the deque of the calling thread.
+ */
+static _Thread_local struct Work_Stealing_Pool* current_pool = NULL;
+static _Thread_local unsigned int current_worker = 0;
+
+/*
+ * The part of a pool handed to each thread of the pool upon creation; fields are the following:
+ *  - pool the thread works for
+ *  - index of the worker run by the thread
+ */
+struct Pool_Worker {
+     struct Work_Stealing_Pool* pool;
+     unsigned int worker_index;
+};
+
+unsigned int get_num_pool_threads(const unsigned int num_threads) {
+    if (num_threads != NUM_POOL_THREADS_AUTO) {
+        return num_threads;
+    }
+    const long num_processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return (num_processors > 0) ? (unsigned int)num_processors : 1;
+}
+
+// Pushes "task" onto the bottom of "deque", growing the deque first if it's full
+static void push_task(struct Task_Deque* deque, const struct Pool_Task* task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom - deque->top == deque->capacity) {
+        struct Pool_Task* grown_tasks = malloc(2 * deque->capacity * sizeof(struct Pool_Task));
+        assert(grown_tasks != NULL);
+        for (size_t task_index = deque->top; task_index < deque->bottom; ++task_index) {
+            grown_tasks[task_index & (2 * deque->capacity - 1)] = deque->tasks[task_index & (deque->capacity - 1)];
+        }
+        free(deque->tasks);
+        deque->tasks = grown_tasks;
+        deque->capacity *= 2;
+    }
+    deque->tasks[deque->bottom & (deque->capacity - 1)] = *task;
+    ++deque->bottom;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+/*
+ * Takes a task off "deque" into "task", from the bottom if "from_bottom" is non-zero (i.e. by the
+ * owner of the deque) and from the top otherwise (i.e. by a thief); returns zero if it's empty.
+ */
+static int take_task(struct Task_Deque* deque, struct Pool_Task* task, const int from_bottom) {
+    int task_taken = 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom != deque->top) {
+        if (from_bottom) {
+            --deque->bottom;
+            *task = deque->tasks[deque->bottom & (deque->capacity - 1)];
+        } else {
+            *task = deque->tasks[deque->top & (deque->capacity - 1)];
+            ++deque->top;
+        }
+        task_taken = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return task_taken;
+}
+
+/*
+ * Runs a single task queued within "pool", preferring the most recent task of "worker_index"'s
+ * own deque, and otherwise stealing from the other workers in turn; returns zero if there was none.
+ */
+static int run_one_task(struct Work_Stealing_Pool* pool, const unsigned int worker_index) {
+    struct Pool_Task task;
+    int task_found = take_task(&pool->deques[worker_index], &task, 1);
+    for (unsigned int offset = 1; (offset < pool->num_workers) && !task_found; ++offset) {
+        task_found = take_task(&pool->deques[(worker_index + offset) % pool->num_workers], &task, 0);
+    }
+    if (!task_found) {
+        return 0;
+    }
+    atomic_fetch_sub(&pool->num_queued_tasks, 1);
+    task.task_func(task.task_arg);
+    atomic_fetch_sub(&task.task_group->num_pending_tasks, 1);
+    return 1;
+}
+
+// Thread function of every worker but worker 0; sleeps whenever no tasks are queued anywhere
+static void* worker_main(void* worker_arg) {
+    struct Pool_Worker* worker = (struct Pool_Worker*)worker_arg;
+    struct Work_Stealing_Pool* pool = worker->pool;
+    current_pool = pool;
+    current_worker = worker->worker_index;
+
+    while (!atomic_load(&pool->shutting_down)) {
+        if (run_one_task(pool, current_worker)) {
+            continue;
+        }
+        pthread_mutex_lock(&pool->idle_lock);
+        while ((atomic_load(&pool->num_queued_tasks) == 0) && !atomic_load(&pool->shutting_down)) {
+            pthread_cond_wait(&pool->idle_cond, &pool->idle_lock);
+        }
+        pthread_mutex_unlock(&pool->idle_lock);
+    }
+
+    free(worker);
+    return NULL;
+}
+
+void init_work_stealing_pool(struct Work_Stealing_Pool* pool, const unsigned int num_threads) {
+    // No null pointers allowed
+    assert(pool != NULL);
+    // Only a single pool may be driven by each thread at once
+    assert(current_pool == NULL);
+
+    pool->num_workers = get_num_pool_threads(num_threads);
+    assert(pool->num_workers >= 1);
+    pool->deques = malloc(pool->num_workers * sizeof(struct Task_Deque));
+    pool->threads = malloc(pool->num_workers * sizeof(pthread_t));
+    atomic_init(&pool->num_queued_tasks, 0);
+    atomic_init(&pool->shutting_down, 0);
+    pthread_mutex_init(&pool->idle_lock, NULL);
+    pthread_cond_init(&pool->idle_cond, NULL);
+
+    for (unsigned int worker_index = 0; worker_index < pool->num_workers; ++worker_index) {
+        struct Task_Deque* deque = &pool->deques[worker_index];
+        pthread_mutex_init(&deque->lock, NULL);
+        deque->capacity = INITIAL_TASK_DEQUE_CAPACITY;
+        deque->tasks = malloc(deque->capacity * sizeof(struct Pool_Task));
+        deque->top = 0;
+        deque->bottom = 0;
+    }
+
+    // The calling thread is worker 0, so only the other workers get threads of their own
+    current_pool = pool;
+    current_worker = 0;
+    for (unsigned int worker_index = 1; worker_index < pool->num_workers; ++worker_index) {
+        struct Pool_Worker* worker = malloc(sizeof(struct Pool_Worker));
+        worker->pool = pool;
+        worker->worker_index = worker_index;
+        const int create_result = pthread_create(&pool->threads[worker_index], NULL, worker_main, worker);
+        assert(create_result == 0);
+    }
+}
+
+void release_work_stealing_pool(struct Work_Stealing_Pool* pool) {
+    // No null pointers allowed
+    assert(pool != NULL);
+    assert(current_pool == pool);
+    assert(atomic_load(&pool->num_queued_tasks) == 0);
+
+    pthread_mutex_lock(&pool->idle_lock);
+    atomic_store(&pool->shutting_down, 1);
+    pthread_cond_broadcast(&pool->idle_cond);
+    pthread_mutex_unlock(&pool->idle_lock);
+    for (unsigned int worker_index = 1; worker_index < pool->num_workers; ++worker_index) {
+        pthread_join(pool->threads[worker_index], NULL);
+    }
+
+    for (unsigned int worker_index = 0; worker_index < pool->num_workers; ++worker_index) {
+        pthread_mutex_destroy(&pool->deques[worker_index].lock);
+        free(pool->deques[worker_index].tasks);
+    }
+    pthread_mutex_destroy(&pool->idle_lock);
+    pthread_cond_destroy(&pool->idle_cond);
+    free(pool->deques);
+    free(pool->threads);
+    current_pool = NULL;
+}
+
+void init_task_group(struct Task_Group* task_group) {
+    assert(task_group != NULL);
+    atomic_init(&task_group->num_pending_tasks, 0);
+}
+
+void spawn_pool_task(struct Work_Stealing_Pool* pool, struct Task_Group* task_group,
+                       void (*task_func)(void*), void* task_arg) {
+    // No null pointers allowed
+    assert(pool != NULL);
+    assert(task_group != NULL);
+    assert(task_func != NULL);
+    // Tasks may only be spawned by the threads of the pool
+    assert(current_pool == pool);
+
+    const struct Pool_Task task = {task_func, task_arg, task_group};
+    atomic_fetch_add(&task_group->num_pending_tasks, 1);
+    push_task(&pool->deques[current_worker], &task);
+
+    /*
+     * Wake up a sleeping worker to steal the task; the count is raised before taking the lock,
+     * so a worker about to sleep either sees the task queued or gets woken up afterwards.
+     */
+    if (atomic_fetch_add(&pool->num_queued_tasks, 1) < pool->num_workers) {
+        pthread_mutex_lock(&pool->idle_lock);
+        pthread_cond_signal(&pool->idle_cond);
+        pthread_mutex_unlock(&pool->idle_lock);
+    }
+}
+
+void wait_for_task_group(struct Work_Stealing_Pool* pool, struct Task_Group* task_group) {
+    // No null pointers allowed
+    assert(pool != NULL);
+    assert(task_group != NULL);
+    assert(current_pool == pool);
+
+    /*
+     * Tasks of the group that are still queued sit at the bottom of the deque of the calling
+     * thread unless stolen, so working on tasks instead of blocking finishes them soonest.
+     */
+    while (atomic_load(&task_group->num_pending_tasks) > 0) {
+        if (!run_one_task(pool, current_worker)) {
+            sched_yield();
+        }
+    }
+}
@@ -0,0 +1,107 @@
+/*
+ * File description:
+ *   Header file for a pool of worker threads scheduling fork-join tasks with work stealing:
+ *   each worker owns a deque of tasks, pushing and popping tasks it spawns at the bottom of its
+ *   own deque, while idle workers steal the oldest (i.e. largest) tasks from the top of the
+ *   deques of other workers.
+ */
+
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+/*
+ * Flag macro value for "num_threads" indicating to use as many threads as
+ * there are processors online.
+ */
+#define NUM_POOL_THREADS_AUTO 0
+// Number of tasks each deque of tasks has room for initially; deques grow as needed
+#define INITIAL_TASK_DEQUE_CAPACITY 64
+
+/*
+ * A group of tasks waited upon together (refer to "wait_for_task_group"); MUST be
+ * initialised with "init_task_group" before spawning any task into it.
+ */
+struct Task_Group {
+     atomic_size_t num_pending_tasks;
+};
+
+/*
+ * A task spawned into a pool; fields are the following:
+ *  - function performing the task, and the argument passed on to it
+ *  - group of tasks the task belongs to
+ */
+struct Pool_Task {
+     void (*task_func)(void*);
+     void* task_arg;
+     struct Task_Group* task_group;
+};
+
+/*
+ * Deque of tasks owned by a single worker; "bottom" and "top" only ever grow, and
+ * index "tasks" modulo "capacity" (a power of 2).
+ */
+struct Task_Deque {
+     pthread_mutex_t lock;
+     struct Pool_Task* tasks;
+     size_t capacity;
+     size_t top;
+     size_t bottom;
+};
+
+/*
+ * A pool of worker threads; fields are the following:
+ *  - number of workers, including the thread which created the pool (worker 0), which
+ *    works on tasks whenever it waits for a group of tasks
+ *  - deque of tasks of each worker, indexed by worker
+ *  - threads of every worker but worker 0
+ *  - number of tasks queued within all deques, along with a lock and a condition variable
+ *    upon which idle workers sleep while there are no tasks queued
+ *  - whether workers have to exit
+ */
+struct Work_Stealing_Pool {
+     unsigned int num_workers;
+     struct Task_Deque* deques;
+     pthread_t* threads;
+     atomic_size_t num_queued_tasks;
+     pthread_mutex_t idle_lock;
+     pthread_cond_t idle_cond;
+     atomic_int shutting_down;
+};
+
+/*
+ * Returns the number of threads to actually use when "num_threads" threads are
+ * requested, i.e. the number of processors online for NUM_POOL_THREADS_AUTO.
+ */
+unsigned int get_num_pool_threads(const unsigned int num_threads);
+
+/*
+ * Starts "pool" with "num_threads" workers (or NUM_POOL_THREADS_AUTO) including the calling
+ * thread; only the calling thread may then spawn tasks from outside of tasks, and wait for them.
+ */
+void init_work_stealing_pool(struct Work_Stealing_Pool* pool, const unsigned int num_threads);
+
+// Stops every worker of "pool" and releases everything owned by it; no tasks may be left pending
+void release_work_stealing_pool(struct Work_Stealing_Pool* pool);
+
+// Sets up "task_group" to hold no pending tasks
+void init_task_group(struct Task_Group* task_group);
+
+/*
+ * Spawns a task calling "task_func" with "task_arg" into "task_group"; the calling thread MUST be
+ * either the thread which created "pool" or a task running within "pool". "task_arg" MUST stay
+ * valid until the task finishes, e.g. by pointing into the stack frame which waits for the group.
+ */
+void spawn_pool_task(struct Work_Stealing_Pool* pool, struct Task_Group* task_group,
+                       void (*task_func)(void*), void* task_arg);
+
+/*
+ * Returns once every task spawned into "task_group" (including those spawned after waiting
+ * starts) has finished, working on any task of "pool" in the meantime instead of blocking.
+ */
+void wait_for_task_group(struct Work_Stealing_Pool* pool, struct Task_Group* task_group);
+
+#endif // WORK_STEALING_POOL_H